@@ -72,6 +72,8 @@ static void ssd1306_interface_init(void)
 	config.pinmux_pad2 = SSD1306_SPI_PINMUX_PAD2;
 	config.pinmux_pad3 = SSD1306_SPI_PINMUX_PAD3;
 	config.mode_specific.master.baudrate = SSD1306_CLOCK_SPEED;
+	/* The controller cannot be read in serial mode, only transmit */
+	config.receiver_enable = false;
 
 	spi_init(&ssd1306_master, SSD1306_SPI, &config);
 	spi_enable(&ssd1306_master);
@@ -105,6 +107,33 @@ void ssd1306_init(void)
 	// Set the reset pin to the default state
 	port_pin_set_output_level(SSD1306_RES_PIN, true);
 
+	ssd1306_configure();
+}
+
+/**
+ * \brief Start initializing the OLED controller without waiting
+ *
+ * Initializes the hardware interface and pulls the reset pin low. The caller
+ * times the reset: after \ref SSD1306_RESET_USEC it calls
+ * ssd1306_reset_release(), and after \ref SSD1306_RESET_USEC more
+ * ssd1306_configure().
+ */
+void ssd1306_init_start(void)
+{
+	// Initialize delay routine
+	delay_init();
+
+	// Initialize the interface
+	ssd1306_interface_init();
+
+	port_pin_set_output_level(SSD1306_RES_PIN, false);
+}
+
+/**
+ * \brief Configure the OLED controller after its reset and turn it on
+ */
+void ssd1306_configure(void)
+{
 	// 1/32 Duty (0x0F~0x3F)
 	ssd1306_write_command(SSD1306_CMD_SET_MULTIPLEX_RATIO);
 	ssd1306_write_command(0x1F);
@@ -162,10 +191,10 @@ void ssd1306_init(void)
  */
 void ssd1306_write_command(uint8_t command)
 {
-	spi_select_slave(&ssd1306_master, &ssd1306_slave, true);
-	port_pin_set_output_level(SSD1306_DC_PIN, false);
+	SSD1306_CS_SELECT();
+	SSD1306_DC_COMMAND();
 	spi_write_buffer_wait(&ssd1306_master, &command, 1);
-	spi_select_slave(&ssd1306_master, &ssd1306_slave, false);
+	SSD1306_CS_DESELECT();
 }
 
 /**
@@ -178,8 +207,8 @@ void ssd1306_write_command(uint8_t command)
  */
 void ssd1306_write_data(uint8_t data)
 {
-	spi_select_slave(&ssd1306_master, &ssd1306_slave, true);
-	port_pin_set_output_level(SSD1306_DC_PIN, true);
+	SSD1306_CS_SELECT();
+	SSD1306_DC_DATA();
 	spi_write_buffer_wait(&ssd1306_master, &data, 1);
-	spi_select_slave(&ssd1306_master, &ssd1306_slave, false);
+	SSD1306_CS_DESELECT();
 }
@@ -155,6 +155,27 @@ extern "C" {
 extern struct spi_module ssd1306_master;
 extern struct spi_slave_inst ssd1306_slave;
 
+/**
+ * \name Chip select and D/C# control
+ *
+ * conf_ssd1306.h may define these to drive the pins some faster way, by
+ * default they go through the SPI and PORT drivers.
+ */
+//@{
+#ifndef SSD1306_CS_SELECT
+#  define SSD1306_CS_SELECT()   spi_select_slave(&ssd1306_master, &ssd1306_slave, true)
+#endif
+#ifndef SSD1306_CS_DESELECT
+#  define SSD1306_CS_DESELECT() spi_select_slave(&ssd1306_master, &ssd1306_slave, false)
+#endif
+#ifndef SSD1306_DC_COMMAND
+#  define SSD1306_DC_COMMAND()  port_pin_set_output_level(SSD1306_DC_PIN, false)
+#endif
+#ifndef SSD1306_DC_DATA
+#  define SSD1306_DC_DATA()     port_pin_set_output_level(SSD1306_DC_PIN, true)
+#endif
+//@}
+
 //! \name OLED controller write and read functions
 //@{
 void ssd1306_write_command(uint8_t command);
@@ -189,6 +210,9 @@ static inline uint8_t ssd1306_get_status(void)
 //! \name OLED Controller reset
 //@{
 
+//! Time the reset pin is held low, and the controller is left alone after it
+#define SSD1306_RESET_USEC      10
+
 /**
  * \brief Perform a hard reset of the OLED controller
  *
@@ -196,12 +220,23 @@ static inline uint8_t ssd1306_get_status(void)
  */
 static inline void ssd1306_hard_reset(void)
 {
-	uint32_t delay_10us = 10 * (system_gclk_gen_get_hz(0)/1000000);
+	uint32_t delay_10us = SSD1306_RESET_USEC * (system_gclk_gen_get_hz(0)/1000000);
 	port_pin_set_output_level(SSD1306_RES_PIN, false);
 	delay_cycles(delay_10us); // At lest 10us
 	port_pin_set_output_level(SSD1306_RES_PIN, true);
 	delay_cycles(delay_10us); // At lest 10us
 }
+
+/**
+ * \brief End the hard reset started by ssd1306_init_start()
+ *
+ * The reset pin must have been low for \ref SSD1306_RESET_USEC, and
+ * ssd1306_configure() must wait as long again after this.
+ */
+static inline void ssd1306_reset_release(void)
+{
+	port_pin_set_output_level(SSD1306_RES_PIN, true);
+}
 //@}
 
 //! \name Sleep control
@@ -329,6 +364,8 @@ static inline void ssd1306_display_invert_disable(void)
 //! \name Initialization
 //@{
 void ssd1306_init(void);
+void ssd1306_init_start(void);
+void ssd1306_configure(void);
 //@}
 
 /** @} */
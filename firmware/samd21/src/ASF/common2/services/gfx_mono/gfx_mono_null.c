@@ -44,6 +44,7 @@
  * Support and FAQ: visit <a href="http://www.atmel.com/design-support/">Atmel Support</a>
  */
 #include "gfx_mono_null.h"
+#include <string.h>
 
 /**
  * \ingroup asfdoc_common2_gfx_mono_null
@@ -53,12 +54,254 @@
 /* Memory for the framebuffer */
 static uint8_t framebuffer[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
 
+/* Bus traffic a SSD1306 in page addressing mode would have seen */
+static struct gfx_mono_null_stats null_stats;
+
+/* Command bytes to address a page and column, as sent by the SSD1306 driver */
+#define NULL_ADDRESS_COMMAND_BYTES      3
+
 /**
  * \brief Initialize NULL driver.
+ *
+ * Clears the framebuffer and the bus statistics.
  */
 void gfx_mono_null_init(void)
 {
 	gfx_mono_set_framebuffer(framebuffer);
+	memset(framebuffer, 0, sizeof(framebuffer));
+	gfx_mono_null_reset_stats();
+}
+
+/**
+ * \brief Put framebuffer to the simulated controller
+ *
+ * Accounted as the four full page writes the SSD1306 driver would make.
+ */
+void gfx_mono_null_put_framebuffer(void)
+{
+	uint8_t page;
+
+	for (page = 0; page < GFX_MONO_LCD_PAGES; page++) {
+		null_stats.transactions++;
+		null_stats.command_bytes += NULL_ADDRESS_COMMAND_BYTES;
+		null_stats.data_bytes += GFX_MONO_LCD_WIDTH;
+	}
+}
+
+/**
+ * \brief Count a presented frame
+ */
+void gfx_mono_null_present(void)
+{
+	null_stats.frames++;
+}
+
+/**
+ * \brief Put a page from RAM to the simulated controller
+ *
+ * \param[in] data   Pointer to data to be written
+ * \param[in] page   Page address
+ * \param[in] column Offset into page (x coordinate)
+ * \param[in] width  Number of bytes to be written
+ */
+void gfx_mono_null_put_page(gfx_mono_color_t *data, gfx_coord_t page,
+		gfx_coord_t column, gfx_coord_t width)
+{
+	gfx_mono_framebuffer_put_page(data, page, column, width);
+
+	null_stats.transactions++;
+	null_stats.command_bytes += NULL_ADDRESS_COMMAND_BYTES;
+	null_stats.data_bytes += width;
+}
+
+/**
+ * \brief Read a page from the simulated controller
+ *
+ * \param[out] data   Pointer where to store the read data
+ * \param[in]  page   Page address
+ * \param[in]  column Offset into page (x coordinate)
+ * \param[in]  width  Number of bytes to be read
+ */
+void gfx_mono_null_get_page(gfx_mono_color_t *data, gfx_coord_t page,
+		gfx_coord_t column, gfx_coord_t width)
+{
+	gfx_mono_framebuffer_get_page(data, page, column, width);
+
+	null_stats.read_bytes += width;
+}
+
+/**
+ * \brief Put a byte to the simulated controller
+ *
+ * Like the SSD1306 driver with a framebuffer, bytes equal to the current
+ * contents are not sent.
+ *
+ * \param[in] page   Page address
+ * \param[in] column Page offset (x coordinate)
+ * \param[in] data   Data to be written
+ */
+void gfx_mono_null_put_byte(gfx_coord_t page, gfx_coord_t column,
+		uint8_t data)
+{
+	if (data == gfx_mono_framebuffer_get_byte(page, column)) {
+		null_stats.skipped_bytes++;
+		return;
+	}
+
+	gfx_mono_framebuffer_put_byte(page, column, data);
+
+	null_stats.transactions++;
+	null_stats.command_bytes += NULL_ADDRESS_COMMAND_BYTES;
+	null_stats.data_bytes++;
+}
+
+/**
+ * \brief Get a byte from the simulated controller
+ *
+ * \param[in] page   Page address
+ * \param[in] column Page offset (x coordinate)
+ *
+ * \return Data from the framebuffer
+ */
+uint8_t gfx_mono_null_get_byte(gfx_coord_t page, gfx_coord_t column)
+{
+	null_stats.read_bytes++;
+
+	return gfx_mono_framebuffer_get_byte(page, column);
+}
+
+/**
+ * \brief Read/Modify/Write a byte on the simulated controller
+ *
+ * \param[in] page       Page address
+ * \param[in] column     Page offset (x coordinate)
+ * \param[in] pixel_mask Mask for pixel operation
+ * \param[in] color      Pixel operation
+ */
+void gfx_mono_null_mask_byte(gfx_coord_t page, gfx_coord_t column,
+		gfx_mono_color_t pixel_mask, gfx_mono_color_t color)
+{
+	gfx_mono_color_t temp = gfx_mono_null_get_byte(page, column);
+
+	switch (color) {
+	case GFX_PIXEL_SET:
+		temp |= pixel_mask;
+		break;
+
+	case GFX_PIXEL_CLR:
+		temp &= ~pixel_mask;
+		break;
+
+	case GFX_PIXEL_XOR:
+		temp ^= pixel_mask;
+		break;
+
+	default:
+		break;
+	}
+
+	gfx_mono_null_put_byte(page, column, temp);
+}
+
+/**
+ * \brief Draw pixel to the simulated controller
+ *
+ * \param[in] x     X coordinate of the pixel
+ * \param[in] y     Y coordinate of the pixel
+ * \param[in] color Pixel operation
+ */
+void gfx_mono_null_draw_pixel(gfx_coord_t x, gfx_coord_t y,
+		gfx_coord_t color)
+{
+	uint8_t page;
+
+	/* Discard pixels drawn outside the screen */
+	if ((x > GFX_MONO_LCD_WIDTH - 1) || (y > GFX_MONO_LCD_HEIGHT - 1)) {
+		return;
+	}
+
+	page = y / GFX_MONO_LCD_PIXELS_PER_BYTE;
+	gfx_mono_null_mask_byte(page, x, 1 << (y - (page * 8)), color);
+}
+
+/**
+ * \brief Get the pixel value at x,y
+ *
+ * \param[in] x X coordinate of the pixel
+ * \param[in] y Y coordinate of the pixel
+ *
+ * \return Non zero value if pixel is set.
+ */
+uint8_t gfx_mono_null_get_pixel(gfx_coord_t x, gfx_coord_t y)
+{
+	uint8_t page;
+
+	if ((x > GFX_MONO_LCD_WIDTH - 1) || (y > GFX_MONO_LCD_HEIGHT - 1)) {
+		return 0;
+	}
+
+	page = y / GFX_MONO_LCD_PIXELS_PER_BYTE;
+
+	return gfx_mono_null_get_byte(page, x) & (1 << (y - (page * 8)));
+}
+
+/**
+ * \brief Get the bus statistics collected since the last reset
+ *
+ * \return Pointer to the statistics
+ */
+const struct gfx_mono_null_stats *gfx_mono_null_get_stats(void)
+{
+	return &null_stats;
+}
+
+/**
+ * \brief Clear the bus statistics
+ */
+void gfx_mono_null_reset_stats(void)
+{
+	memset(&null_stats, 0, sizeof(null_stats));
+}
+
+/**
+ * \brief Export the framebuffer as a binary PBM (P4) image
+ *
+ * Lit pixels are black in the image. The result can be written to a file
+ * as is, or compared against a golden image.
+ *
+ * \param[out] buffer Where to store the image
+ * \param[in]  size   Size of buffer, at least \ref GFX_MONO_NULL_PBM_SIZE
+ *
+ * \return Length of the image, 0 if the buffer is too small
+ */
+uint16_t gfx_mono_null_export_pbm(uint8_t *buffer, uint16_t size)
+{
+	static const char header[] = "P4\n128 32\n";
+	uint8_t *row = buffer + sizeof(header) - 1;
+	gfx_coord_t x;
+	gfx_coord_t y;
+	uint8_t bit;
+
+	if (size < GFX_MONO_NULL_PBM_SIZE) {
+		return 0;
+	}
+
+	memcpy(buffer, header, sizeof(header) - 1);
+
+	for (y = 0; y < GFX_MONO_LCD_HEIGHT; y++) {
+		for (x = 0; x < GFX_MONO_LCD_WIDTH; x += 8) {
+			*row = 0;
+			for (bit = 0; bit < 8; bit++) {
+				if (framebuffer[(y / 8) * GFX_MONO_LCD_WIDTH + x + bit]
+						& (1 << (y % 8))) {
+					*row |= 0x80 >> bit;
+				}
+			}
+			row++;
+		}
+	}
+
+	return GFX_MONO_NULL_PBM_SIZE;
 }
 
 /** @} */
@@ -58,10 +58,16 @@ extern "C" {
  * \ingroup asfdoc_common2_gfx_mono
  * \defgroup asfdoc_common2_gfx_mono_null NULL display device
  *
- * This module provides empty read/write functions to a null device
+ * This module provides read/write functions to a null device
  * (framebuffer in RAM), removing the need for an actual display or
  * controller during testing, and enabling the use of most XMEGA boards.
  *
+ * All accesses are counted as the bus traffic a SSD1306 controller in page
+ * addressing mode would have seen, see gfx_mono_null_get_stats(), and the
+ * display contents can be exported as an image with
+ * gfx_mono_null_export_pbm(). This allows the drawing code to be run and
+ * measured on a host.
+ *
  * @{
  */
 
@@ -101,34 +107,112 @@ extern "C" {
 	gfx_mono_generic_put_bitmap(bitmap, x, y)
 
 #define gfx_mono_draw_pixel(x, y, color) \
-	gfx_mono_framebuffer_draw_pixel(x, y, color)
+	gfx_mono_null_draw_pixel(x, y, color)
 
 #define gfx_mono_get_pixel(x, y) \
-	gfx_mono_framebuffer_get_pixel(x, y)
+	gfx_mono_null_get_pixel(x, y)
 
 #define gfx_mono_init()	\
 	gfx_mono_null_init()
 
+#define gfx_mono_init_start() \
+	gfx_mono_null_init()
+
+#define gfx_mono_init_release() \
+	;
+
+#define gfx_mono_init_finish() \
+	;
+
 #define gfx_mono_put_page(data, page, column, width) \
-	gfx_mono_framebuffer_put_page(data, page, column, width)
+	gfx_mono_null_put_page(data, page, column, width)
 
 #define gfx_mono_get_page(data, page, column, width) \
-	gfx_mono_framebuffer_get_page(data, page, column, width)
+	gfx_mono_null_get_page(data, page, column, width)
 
 #define gfx_mono_put_byte(page, column, data) \
-	gfx_mono_framebuffer_put_byte(page, column, data)
+	gfx_mono_null_put_byte(page, column, data)
 
 #define gfx_mono_get_byte(page, column)	\
-	gfx_mono_framebuffer_get_byte(page, column)
+	gfx_mono_null_get_byte(page, column)
 
 #define gfx_mono_mask_byte(page, column, pixel_mask, color) \
-	gfx_mono_framebuffer_mask_byte(page, column, pixel_mask, color)
+	gfx_mono_null_mask_byte(page, column, pixel_mask, color)
 
 #define gfx_mono_put_framebuffer() \
+	gfx_mono_null_put_framebuffer()
+
+#define gfx_mono_present() \
+	gfx_mono_null_present()
+
+#define gfx_mono_present_wait() \
+	;
+
+#define gfx_mono_flush() \
+	false
+
+#define gfx_mono_set_flush_budget(bytes) \
+	;
+
+#define gfx_mono_set_compose_callback(callback) \
+	;
+
+#define gfx_mono_invalidate(page, column, width) \
 	;
 
+#define gfx_mono_compose(data, page, column, width) \
+	;
+
+/** Size of the image written by gfx_mono_null_export_pbm() */
+#define GFX_MONO_NULL_PBM_SIZE          (10 + GFX_MONO_LCD_FRAMEBUFFER_SIZE)
+
+/** Bus traffic a SSD1306 in page addressing mode would have seen */
+struct gfx_mono_null_stats {
+	/** Page and column address setups */
+	uint32_t transactions;
+	/** Command bytes sent */
+	uint32_t command_bytes;
+	/** Display data bytes sent */
+	uint32_t data_bytes;
+	/** Byte writes dropped because the data was already displayed */
+	uint32_t skipped_bytes;
+	/** Bytes read back from the framebuffer */
+	uint32_t read_bytes;
+	/** Frames presented with gfx_mono_present() */
+	uint32_t frames;
+};
+
 void gfx_mono_null_init(void);
 
+void gfx_mono_null_put_framebuffer(void);
+
+void gfx_mono_null_present(void);
+
+void gfx_mono_null_put_page(gfx_mono_color_t *data, gfx_coord_t page,
+		gfx_coord_t column, gfx_coord_t width);
+
+void gfx_mono_null_get_page(gfx_mono_color_t *data, gfx_coord_t page,
+		gfx_coord_t column, gfx_coord_t width);
+
+void gfx_mono_null_put_byte(gfx_coord_t page, gfx_coord_t column,
+		uint8_t data);
+
+uint8_t gfx_mono_null_get_byte(gfx_coord_t page, gfx_coord_t column);
+
+void gfx_mono_null_mask_byte(gfx_coord_t page, gfx_coord_t column,
+		gfx_mono_color_t pixel_mask, gfx_mono_color_t color);
+
+void gfx_mono_null_draw_pixel(gfx_coord_t x, gfx_coord_t y,
+		gfx_coord_t color);
+
+uint8_t gfx_mono_null_get_pixel(gfx_coord_t x, gfx_coord_t y);
+
+const struct gfx_mono_null_stats *gfx_mono_null_get_stats(void);
+
+void gfx_mono_null_reset_stats(void);
+
+uint16_t gfx_mono_null_export_pbm(uint8_t *buffer, uint16_t size);
+
 /** @} */
 
 #ifdef __cplusplus
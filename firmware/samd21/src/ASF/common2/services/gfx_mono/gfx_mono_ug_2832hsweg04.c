@@ -44,30 +44,132 @@
  * Support and FAQ: visit <a href="http://www.atmel.com/design-support/">Atmel Support</a>
  */
 #include "gfx_mono_ug_2832hsweg04.h"
+#include <string.h>
 
 /* If we are using a serial interface without readback, use framebuffer */
 
 #ifdef CONFIG_SSD1306_FRAMEBUFFER
+# ifdef CONFIG_SSD1306_DOUBLE_BUFFER
+#  if !defined(SPI_CALLBACK_MODE) || (SPI_CALLBACK_MODE == false)
+#   error "CONFIG_SSD1306_DOUBLE_BUFFER requires SPI_CALLBACK_MODE"
+#  endif
+static uint8_t framebuffer_pool[2][GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+/* Back buffer, the one the graphic primitives draw into */
+static uint8_t *framebuffer = framebuffer_pool[0];
+/* Front buffer, the one last handed to the display controller */
+static uint8_t *front_buffer = framebuffer_pool[1];
+/* Set while a part of the front buffer is being sent to the controller */
+static volatile bool present_busy;
+/* Set when the back buffer differs from the front buffer */
+static bool back_buffer_dirty;
+/* Set when gfx_mono_present() was called but the back buffer not swapped yet */
+static bool present_pending;
+/* Columns [start, end) of each page changed in the back buffer */
+static uint8_t dirty_start[GFX_MONO_LCD_PAGES];
+static uint8_t dirty_end[GFX_MONO_LCD_PAGES];
+/* Columns [start, end) of each page of the front buffer still to be sent */
+static uint8_t flush_start[GFX_MONO_LCD_PAGES];
+static uint8_t flush_end[GFX_MONO_LCD_PAGES];
+/* Page the incremental flush resumes from */
+static uint8_t flush_page;
+/* Bytes of the front buffer still to be sent */
+static uint16_t flush_remaining;
+/* Largest number of bytes sent per flush step, 0 for no limit */
+static uint16_t flush_budget;
+/* Called on the front buffer before it is sent, NULL for none */
+static gfx_mono_ssd1306_compose_t compose_callback;
+# else
 static uint8_t framebuffer[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+# endif
 #endif
 
+#ifdef CONFIG_SSD1306_DOUBLE_BUFFER
 /**
- * \brief Initialize SSD1306 controller and LCD display.
- * It will also write the graphic controller RAM to all zeroes.
+ * \internal
+ * \brief SPI callback releasing the controller once a frame is transmitted
  *
- * \note This function will clear the contents of the display.
+ * \param[in] module SPI module the frame was sent on
  */
-void gfx_mono_ssd1306_init(void)
+static void gfx_mono_ssd1306_present_done(struct spi_module *const module)
+{
+	spi_select_slave(module, &ssd1306_slave, false);
+	present_busy = false;
+}
+
+/**
+ * \internal
+ * \brief Record a changed area of the back buffer
+ *
+ * \param[in] page   Page of the change
+ * \param[in] column First column changed
+ * \param[in] width  Number of columns changed
+ */
+static void gfx_mono_ssd1306_mark_dirty(gfx_coord_t page, gfx_coord_t column,
+		gfx_coord_t width)
+{
+	if (dirty_start[page] >= dirty_end[page]) {
+		dirty_start[page] = column;
+		dirty_end[page] = column + width;
+	} else {
+		dirty_start[page] = min(dirty_start[page], column);
+		dirty_end[page] = max(dirty_end[page], column + width);
+	}
+	back_buffer_dirty = true;
+}
+
+/**
+ * \internal
+ * \brief Start sending part of the front buffer to the controller
+ *
+ * \param[in] page   First page to write
+ * \param[in] column First column to write
+ * \param[in] pages  Number of pages to write
+ * \param[in] length Number of bytes to write
+ */
+static void gfx_mono_ssd1306_send(uint8_t page, uint8_t column, uint8_t pages,
+		uint16_t length)
+{
+	/* Horizontal addressing wraps within the column and page windows */
+	ssd1306_write_command(SSD1306_CMD_SET_COLUMN_ADDRESS);
+	ssd1306_write_command(column);
+	ssd1306_write_command(GFX_MONO_LCD_WIDTH - 1);
+	ssd1306_write_command(SSD1306_CMD_SET_PAGE_ADDRESS);
+	ssd1306_write_command(page);
+	ssd1306_write_command(page + pages - 1);
+
+	present_busy = true;
+	spi_select_slave(&ssd1306_master, &ssd1306_slave, true);
+	SSD1306_DC_DATA();
+	if (spi_write_buffer_job(&ssd1306_master,
+			front_buffer + (page * GFX_MONO_LCD_WIDTH) + column,
+			length) != STATUS_OK) {
+		spi_select_slave(&ssd1306_master, &ssd1306_slave, false);
+		present_busy = false;
+	}
+}
+#endif
+
+/**
+ * \internal
+ * \brief Set up the controller after its reset and clear the framebuffer
+ *
+ * With double buffering only the back buffer is cleared, the caller presents
+ * it.
+ */
+static void gfx_mono_ssd1306_setup(void)
 {
 	uint8_t page;
 	uint8_t column;
 
-#ifdef CONFIG_SSD1306_FRAMEBUFFER
-	gfx_mono_set_framebuffer(framebuffer);
-#endif
+#ifdef CONFIG_SSD1306_DOUBLE_BUFFER
+	spi_register_callback(&ssd1306_master, gfx_mono_ssd1306_present_done,
+			SPI_CALLBACK_BUFFER_TRANSMITTED);
+	spi_enable_callback(&ssd1306_master, SPI_CALLBACK_BUFFER_TRANSMITTED);
 
-	/* Initialize the low-level display controller. */
-	ssd1306_init();
+	/* Frames are written through column and page windows */
+	ssd1306_write_command(SSD1306_CMD_SET_MEMORY_ADDRESSING_MODE);
+	ssd1306_write_command(0x00);
+#endif
 
 	/* Set display to output data from line 0 */
 	ssd1306_set_display_start_line_address(0);
@@ -83,6 +185,63 @@ void gfx_mono_ssd1306_init(void)
 	}
 }
 
+/**
+ * \brief Initialize SSD1306 controller and LCD display.
+ * It will also write the graphic controller RAM to all zeroes.
+ *
+ * \note This function will clear the contents of the display.
+ */
+void gfx_mono_ssd1306_init(void)
+{
+#ifdef CONFIG_SSD1306_FRAMEBUFFER
+	gfx_mono_set_framebuffer(framebuffer);
+#endif
+
+	/* Initialize the low-level display controller. */
+	ssd1306_init();
+
+	gfx_mono_ssd1306_setup();
+
+#ifdef CONFIG_SSD1306_DOUBLE_BUFFER
+	/* The primitives only reach the back buffer; push the cleared frame */
+	gfx_mono_ssd1306_present();
+	gfx_mono_ssd1306_present_wait();
+#endif
+}
+
+/**
+ * \brief Start initializing the display without waiting
+ *
+ * Does the same as gfx_mono_ssd1306_init() in steps the caller times, so
+ * other work runs during the controller reset and the first frame:
+ * - gfx_mono_ssd1306_init_start() pulls the reset pin low,
+ * - ssd1306_reset_release() after \ref SSD1306_RESET_USEC,
+ * - gfx_mono_ssd1306_init_finish() after \ref SSD1306_RESET_USEC more,
+ * - with double buffering, gfx_mono_ssd1306_present() of the cleared back
+ *   buffer, with anything drawn into it since, then
+ *   gfx_mono_ssd1306_flush() until it returns false.
+ */
+void gfx_mono_ssd1306_init_start(void)
+{
+#ifdef CONFIG_SSD1306_FRAMEBUFFER
+	gfx_mono_set_framebuffer(framebuffer);
+#endif
+
+	ssd1306_init_start();
+}
+
+/**
+ * \brief Configure the controller and clear the framebuffer
+ *
+ * See gfx_mono_ssd1306_init_start().
+ */
+void gfx_mono_ssd1306_init_finish(void)
+{
+	ssd1306_configure();
+
+	gfx_mono_ssd1306_setup();
+}
+
 #ifdef CONFIG_SSD1306_FRAMEBUFFER
 /**
  * \brief Put framebuffer to LCD controller
@@ -95,6 +254,15 @@ void gfx_mono_ssd1306_init(void)
  */
 void gfx_mono_ssd1306_put_framebuffer(void)
 {
+#ifdef CONFIG_SSD1306_DOUBLE_BUFFER
+	uint8_t page;
+
+	for (page = 0; page < GFX_MONO_LCD_PAGES; page++) {
+		gfx_mono_ssd1306_mark_dirty(page, 0, GFX_MONO_LCD_WIDTH);
+	}
+	gfx_mono_ssd1306_present();
+	gfx_mono_ssd1306_present_wait();
+#else
 	uint8_t page;
 
 	for (page = 0; page < GFX_MONO_LCD_PAGES; page++) {
@@ -104,6 +272,215 @@ void gfx_mono_ssd1306_put_framebuffer(void)
 				+ (page * GFX_MONO_LCD_WIDTH), page, 0,
 				GFX_MONO_LCD_WIDTH);
 	}
+#endif
+}
+#endif
+
+#ifdef CONFIG_SSD1306_DOUBLE_BUFFER
+/**
+ * \brief Present the back buffer on the display
+ *
+ * With double buffering the graphic primitives only update the back buffer
+ * in MCU RAM. This function queues the back buffer for display; when the
+ * previous frame is completely sent, the back and front buffers are swapped
+ * with gfx_mono_set_framebuffer() and the changed areas of the new front
+ * buffer are streamed to the controller in the background. Drawing
+ * continues in the back buffer, which starts as a copy of the presented
+ * frame. Frames presented while the previous one is still being sent are
+ * merged into one.
+ *
+ * Without a flush budget the frame is sent right away as one SPI job.
+ * With a budget set by gfx_mono_ssd1306_set_flush_budget() nothing is sent
+ * here; the application calls gfx_mono_ssd1306_flush() from its main loop.
+ *
+ * \code
+	gfx_mono_draw_string("Hello", 0, 0, &sysfont);
+	gfx_mono_present();
+\endcode
+ */
+void gfx_mono_ssd1306_present(void)
+{
+	if (!back_buffer_dirty) {
+		return;
+	}
+
+	present_pending = true;
+	if (flush_budget == 0) {
+		gfx_mono_ssd1306_flush();
+	}
+}
+
+/**
+ * \brief Send the next part of the presented frames to the controller
+ *
+ * Sends at most the flush budget of bytes, resuming where the previous call
+ * left off. Returns immediately if the previous part is still being sent,
+ * so calling it once per main loop iteration bounds the time spent on the
+ * display regardless of how much was drawn.
+ *
+ * \retval true  There is still data to send
+ * \retval false The display shows the last presented frame
+ */
+bool gfx_mono_ssd1306_flush(void)
+{
+	uint8_t *buffer;
+	uint8_t page;
+	uint16_t length;
+
+	if (present_busy) {
+		return true;
+	}
+
+	if (flush_remaining == 0) {
+		if (!present_pending) {
+			return false;
+		}
+
+		buffer = front_buffer;
+		front_buffer = framebuffer;
+		framebuffer = buffer;
+		memcpy(framebuffer, front_buffer, GFX_MONO_LCD_FRAMEBUFFER_SIZE);
+		gfx_mono_set_framebuffer(framebuffer);
+
+		for (page = 0; page < GFX_MONO_LCD_PAGES; page++) {
+			flush_start[page] = dirty_start[page];
+			flush_end[page] = dirty_end[page];
+			if (dirty_start[page] < dirty_end[page]) {
+				flush_remaining += dirty_end[page] - dirty_start[page];
+			}
+			dirty_start[page] = 0;
+			dirty_end[page] = 0;
+		}
+		flush_page = 0;
+		back_buffer_dirty = false;
+		present_pending = false;
+
+		if (flush_remaining == 0) {
+			return false;
+		}
+
+		if (flush_budget == 0) {
+			/* Whole frame in a single stream */
+			if (compose_callback) {
+				for (page = 0; page < GFX_MONO_LCD_PAGES; page++) {
+					compose_callback(front_buffer + (page * GFX_MONO_LCD_WIDTH),
+							page, 0, GFX_MONO_LCD_WIDTH);
+				}
+			}
+			memset(flush_end, 0, sizeof(flush_end));
+			flush_remaining = 0;
+			gfx_mono_ssd1306_send(0, 0, GFX_MONO_LCD_PAGES,
+					GFX_MONO_LCD_FRAMEBUFFER_SIZE);
+			return true;
+		}
+
+		if (compose_callback) {
+			for (page = 0; page < GFX_MONO_LCD_PAGES; page++) {
+				if (flush_start[page] < flush_end[page]) {
+					compose_callback(front_buffer + (page * GFX_MONO_LCD_WIDTH)
+							+ flush_start[page], page, flush_start[page],
+							flush_end[page] - flush_start[page]);
+				}
+			}
+		}
+	}
+
+	while (flush_start[flush_page] >= flush_end[flush_page]) {
+		flush_page = (flush_page + 1) % GFX_MONO_LCD_PAGES;
+	}
+
+	length = flush_end[flush_page] - flush_start[flush_page];
+	if (flush_budget != 0) {
+		length = min(length, flush_budget);
+	}
+
+	gfx_mono_ssd1306_send(flush_page, flush_start[flush_page], 1, length);
+	flush_start[flush_page] += length;
+	flush_remaining -= length;
+
+	return true;
+}
+
+/**
+ * \brief Set the number of bytes sent per call to gfx_mono_ssd1306_flush()
+ *
+ * At \ref SSD1306_CLOCK_SPEED each byte keeps the SPI interrupt busy for
+ * 8 clock cycles, so the budget also bounds the time spent per call.
+ *
+ * \param[in] bytes Bytes per flush step, 0 to send presented frames at once
+ */
+void gfx_mono_ssd1306_set_flush_budget(uint16_t bytes)
+{
+	flush_budget = bytes;
+}
+
+/**
+ * \brief Set a function combining other content into each presented frame
+ *
+ * The callback is called on the front buffer after the buffers are swapped,
+ * for every area about to be sent. It can add content such as overlays to
+ * the display without changing the back buffer the graphic primitives draw
+ * into. Areas it changes on its own must be reported with
+ * gfx_mono_ssd1306_invalidate().
+ *
+ * \param[in] callback Function to call, NULL to disable
+ */
+void gfx_mono_ssd1306_set_compose_callback(gfx_mono_ssd1306_compose_t callback)
+{
+	compose_callback = callback;
+}
+
+/**
+ * \brief Mark an area to be sent with the next presented frame
+ *
+ * \param[in] page   Page of the area
+ * \param[in] column First column of the area
+ * \param[in] width  Number of columns
+ */
+void gfx_mono_ssd1306_invalidate(gfx_coord_t page, gfx_coord_t column,
+		gfx_coord_t width)
+{
+	gfx_mono_ssd1306_mark_dirty(page, column, width);
+}
+
+/**
+ * \brief Combine the other content into a copy of an area of the display
+ *
+ * Runs the function set with gfx_mono_ssd1306_set_compose_callback() on
+ * data, so code reading the back buffer, such as a stream of the display to
+ * a host, sees the frame as it is sent to the controller.
+ *
+ * \param[in,out] data   Back buffer contents of the area
+ * \param[in]     page   Page of the area
+ * \param[in]     column First column of the area
+ * \param[in]     width  Number of columns
+ */
+void gfx_mono_ssd1306_compose(uint8_t *data, gfx_coord_t page,
+		gfx_coord_t column, gfx_coord_t width)
+{
+	if (compose_callback) {
+		compose_callback(data, page, column, width);
+	}
+}
+
+/**
+ * \brief Wait until all presented frames are sent to the controller
+ */
+void gfx_mono_ssd1306_present_wait(void)
+{
+	while (gfx_mono_ssd1306_flush()) {
+	}
+}
+
+/**
+ * \brief Check if a presented frame is still being sent to the controller
+ *
+ * \retval true  A presented frame is not completely sent yet
+ * \retval false The controller is idle
+ */
+bool gfx_mono_ssd1306_is_presenting(void)
+{
+	return present_busy || present_pending || (flush_remaining != 0);
 }
 #endif
 
@@ -222,12 +599,16 @@ void gfx_mono_ssd1306_put_page(gfx_mono_color_t *data, gfx_coord_t page,
 #ifdef CONFIG_SSD1306_FRAMEBUFFER
 	gfx_mono_framebuffer_put_page(data, page, column, width);
 #endif
+#ifdef CONFIG_SSD1306_DOUBLE_BUFFER
+	gfx_mono_ssd1306_mark_dirty(page, column, width);
+#else
 	ssd1306_set_page_address(page);
 	ssd1306_set_column_address(column);
 
 	do {
 		ssd1306_write_data(*data++);
 	} while (--width);
+#endif
 }
 
 /**
@@ -291,10 +672,14 @@ void gfx_mono_ssd1306_get_page(gfx_mono_color_t *data, gfx_coord_t page,
 	gfx_mono_framebuffer_put_byte(page, column, data);
 #endif
 
+#ifdef CONFIG_SSD1306_DOUBLE_BUFFER
+	gfx_mono_ssd1306_mark_dirty(page, column, 1);
+#else
 	ssd1306_set_page_address(page);
 	ssd1306_set_column_address(column);
 
 	ssd1306_write_data(data);
+#endif
 }
 
 /**
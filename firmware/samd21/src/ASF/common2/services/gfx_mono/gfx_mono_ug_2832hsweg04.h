@@ -118,6 +118,15 @@ extern "C" {
 #define gfx_mono_init()	\
 	gfx_mono_ssd1306_init()
 
+#define gfx_mono_init_start() \
+	gfx_mono_ssd1306_init_start()
+
+#define gfx_mono_init_release() \
+	ssd1306_reset_release()
+
+#define gfx_mono_init_finish() \
+	gfx_mono_ssd1306_init_finish()
+
 #define gfx_mono_put_page(data, page, column, width) \
 	gfx_mono_ssd1306_put_page(data, page, column, width)
 
@@ -136,6 +145,79 @@ extern "C" {
 #define gfx_mono_put_framebuffer() \
 	gfx_mono_ssd1306_put_framebuffer()
 
+#ifdef CONFIG_SSD1306_DOUBLE_BUFFER
+#define gfx_mono_present() \
+	gfx_mono_ssd1306_present()
+
+#define gfx_mono_present_wait() \
+	gfx_mono_ssd1306_present_wait()
+
+#define gfx_mono_flush() \
+	gfx_mono_ssd1306_flush()
+
+#define gfx_mono_set_flush_budget(bytes) \
+	gfx_mono_ssd1306_set_flush_budget(bytes)
+
+#define gfx_mono_set_compose_callback(callback) \
+	gfx_mono_ssd1306_set_compose_callback(callback)
+
+#define gfx_mono_invalidate(page, column, width) \
+	gfx_mono_ssd1306_invalidate(page, column, width)
+
+#define gfx_mono_compose(data, page, column, width) \
+	gfx_mono_ssd1306_compose(data, page, column, width)
+
+/**
+ * \brief Function combining other content into a frame about to be sent
+ *
+ * \param[in,out] data   Front buffer contents of the area
+ * \param[in]     page   Page of the area
+ * \param[in]     column First column of the area
+ * \param[in]     width  Number of columns
+ */
+typedef void (*gfx_mono_ssd1306_compose_t)(uint8_t *data, gfx_coord_t page,
+		gfx_coord_t column, gfx_coord_t width);
+
+void gfx_mono_ssd1306_present(void);
+
+void gfx_mono_ssd1306_present_wait(void);
+
+bool gfx_mono_ssd1306_flush(void);
+
+void gfx_mono_ssd1306_set_flush_budget(uint16_t bytes);
+
+void gfx_mono_ssd1306_set_compose_callback(gfx_mono_ssd1306_compose_t callback);
+
+void gfx_mono_ssd1306_invalidate(gfx_coord_t page, gfx_coord_t column,
+		gfx_coord_t width);
+
+void gfx_mono_ssd1306_compose(uint8_t *data, gfx_coord_t page,
+		gfx_coord_t column, gfx_coord_t width);
+
+bool gfx_mono_ssd1306_is_presenting(void);
+#else
+#define gfx_mono_present() \
+	;
+
+#define gfx_mono_present_wait() \
+	;
+
+#define gfx_mono_flush() \
+	false
+
+#define gfx_mono_set_flush_budget(bytes) \
+	;
+
+#define gfx_mono_set_compose_callback(callback) \
+	;
+
+#define gfx_mono_invalidate(page, column, width) \
+	;
+
+#define gfx_mono_compose(data, page, column, width) \
+	;
+#endif
+
 void gfx_mono_ssd1306_put_framebuffer(void);
 
 void gfx_mono_ssd1306_put_page(gfx_mono_color_t *data, gfx_coord_t page,
@@ -146,6 +228,10 @@ void gfx_mono_ssd1306_get_page(gfx_mono_color_t *data, gfx_coord_t page,
 
 void gfx_mono_ssd1306_init(void);
 
+void gfx_mono_ssd1306_init_start(void);
+
+void gfx_mono_ssd1306_init_finish(void);
+
 void gfx_mono_ssd1306_draw_pixel(gfx_coord_t x, gfx_coord_t y,
 		gfx_mono_color_t color);
 
@@ -0,0 +1,175 @@
+##
+# \file
+#
+# \brief Compile monochrome images into page-major display assets
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+# The generated display_asset structures are drawn with display_asset_blit()
+# from display_asset.c. Pixel data is stored the way the SSD1306 controller
+# stores it: one byte per column of every 8 pixel page, least significant bit
+# at the top. The page masks tell the blitter which rows of the last page
+# belong to the image.
+import os
+import re
+import sys
+import argparse
+
+from stream_display_over_serial import rle_encode
+
+MAX_WIDTH = 128
+
+def read_pbm(file_name):
+	with open(file_name, "rb") as input_file:
+		content = input_file.read()
+
+	# Header tokens, skipping comments
+	tokens = []
+	for match in re.finditer(rb"#[^\n]*\n|\S+", content):
+		if not match.group(0).startswith(b"#"):
+			tokens.append(match.group(0))
+			position = match.end()
+		if len(tokens) == 3:
+			break
+	if len(tokens) < 3:
+		raise ValueError("%s: truncated PBM header" % file_name)
+	magic, width, height = tokens[0], int(tokens[1]), int(tokens[2])
+
+	if magic == b"P4":
+		data = content[position + 1:]
+		row_bytes = (width + 7) // 8
+		return width, height, [[(data[y * row_bytes + x // 8] >> (7 - x % 8)) & 1
+				for x in range(width)] for y in range(height)]
+	if magic == b"P1":
+		bits = [int(bit) for bit in re.findall(rb"[01]", content[position:])]
+		return width, height, [bits[y * width:(y + 1) * width] for y in range(height)]
+	raise ValueError("%s: only P1 and P4 PBM files are supported" % file_name)
+
+def read_image(file_name):
+	if file_name.lower().endswith(".pbm"):
+		return read_pbm(file_name)
+
+	from PIL import Image
+	image = Image.open(file_name).convert("1")
+	pixels = image.load()
+	width, height = image.size
+	# Dark pixels are lit on the display, like PBM
+	return width, height, [[0 if pixels[x, y] else 1 for x in range(width)]
+			for y in range(height)]
+
+def to_pages(width, height, rows):
+	pages = (height + 7) // 8
+	data = bytearray()
+	for page in range(pages):
+		for x in range(width):
+			byte = 0
+			for bit in range(8):
+				y = page * 8 + bit
+				if y < height and rows[y][x]:
+					byte |= 1 << bit
+			data.append(byte)
+	masks = bytearray()
+	for page in range(pages):
+		masks.append((1 << min(8, height - page * 8)) - 1)
+	return bytes(data), bytes(masks)
+
+def c_array(data, indent = "    "):
+	lines = []
+	for start in range(0, len(data), 12):
+		lines.append(indent + " ".join("0x%02x," % byte for byte in data[start:start + 12]))
+	return "\n".join(lines)
+
+def asset_name(file_name):
+	name = os.path.splitext(os.path.basename(file_name))[0]
+	return re.sub(r"\W", "_", name).lower() + "_asset"
+
+def compile_assets(file_names, output, use_rle):
+	header_name = os.path.basename(output) + ".h"
+	guard = re.sub(r"\W", "_", header_name).upper() + "_"
+	source = []
+	header = []
+	banner = ("/**\n * \\file\n * \\brief  Display assets generated by asset_compiler.py from\n"
+			+ "".join(" *         %s\n" % os.path.basename(file_name) for file_name in file_names)
+			+ " *\n * Do not edit, run asset_compiler.py again instead.\n */\n")
+
+	for file_name in file_names:
+		width, height, rows = read_image(file_name)
+		if width > MAX_WIDTH:
+			raise ValueError("%s: wider than %u pixels" % (file_name, MAX_WIDTH))
+		name = asset_name(file_name)
+		data, masks = to_pages(width, height, rows)
+
+		flags = "0"
+		if use_rle:
+			encoded = rle_encode(data)
+			if len(encoded) < len(data):
+				data = encoded
+				flags = "DISPLAY_ASSET_RLE"
+
+		source.append("//%s, %ux%u pixels, %u bytes\n" % (os.path.basename(file_name),
+				width, height, len(data)))
+		source.append("static const uint8_t %s_masks[] =\n{\n%s\n};\n\n" % (name, c_array(masks)))
+		source.append("static const uint8_t %s_data[] =\n{\n%s\n};\n\n" % (name, c_array(data)))
+		source.append("const display_asset %s =\n{\n" % name)
+		source.append("    .width = %u,\n    .height = %u,\n    .flags = %s,\n" % (width, height, flags))
+		source.append("    .page_masks = %s_masks,\n    .data = %s_data,\n};\n\n" % (name, name))
+		header.append("extern const display_asset %s;\n" % name)
+
+		sys.stderr.write("%s: %ux%u, %u bytes%s\n" % (name, width, height, len(data),
+				" (RLE)" if flags != "0" else ""))
+
+	with open(output + ".c", "w") as output_file:
+		output_file.write(banner + "\n#include \"%s\"\n\n" % header_name)
+		output_file.write("".join(source).rstrip("\n") + "\n")
+
+	with open(output + ".h", "w") as output_file:
+		output_file.write(banner + "\n\n#ifndef %s\n#define %s\n\n" % (guard, guard))
+		output_file.write("#include \"display_asset.h\"\n\n")
+		output_file.write("".join(header))
+		output_file.write("\n#endif /* %s */\n" % guard)
+
+def main():
+	parser = argparse.ArgumentParser(description="This script converts "
+			"monochrome images into page-major display assets for "
+			"display_asset_blit(). Set pixels in PBM files, or dark "
+			"pixels in other formats (requires PIL), are lit on the "
+			"display. All images are written to one C source and "
+			"header pair named after the output option.")
+	parser.add_argument("images", nargs="+", metavar="IMAGE",
+			help="images to convert, at most 128 pixels wide")
+	parser.add_argument("-o", "--output", dest="output",
+			help="write OUTPUT.c and OUTPUT.h. Default is display_assets.",
+			default="display_assets")
+	parser.add_argument("-r", "--rle", action="store_true", dest="rle",
+			help="RLE compress images that get smaller", default=False)
+
+	arguments = parser.parse_args()
+
+	try:
+		compile_assets(arguments.images, arguments.output, arguments.rle)
+	except (IOError, ValueError) as e:
+		print("error: %s" % (str(e)))
+		sys.exit(1)
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,304 @@
+##
+# \file
+#
+# \brief Receive RLE delta frames of the display over a serial line
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+# The firmware side is display_stream.c. The host sends 'K' for a complete
+# frame or 'S' for the pages changed since the last frame, and the target
+# answers with:
+#
+#   0xA5, sequence, page mask, {length lo, length hi, RLE data} per page,
+#   XOR of all bytes after 0xA5
+#
+# RLE control byte c: c < 128 copies the next c + 1 bytes, c >= 128 repeats
+# the next byte c - 125 times.
+import sys
+import time
+import zlib
+import struct
+import argparse
+
+WIDTH = 128
+HEIGHT = 32
+PAGES = HEIGHT // 8
+
+FRAME_START = 0xA5
+REQ_DELTA = b"S"
+REQ_KEY = b"K"
+
+class StreamError(Exception):
+	pass
+
+def rle_encode(data):
+	out = bytearray()
+	literal_start = 0
+	pos = 0
+	while pos < len(data):
+		run = 1
+		while pos + run < len(data) and run < 130 and data[pos + run] == data[pos]:
+			run += 1
+		if run < 3 and pos + run < len(data):
+			pos += run
+			continue
+		if run < 3:
+			pos += run
+			run = 0
+		while literal_start < pos:
+			length = min(pos - literal_start, 128)
+			out.append(length - 1)
+			out += data[literal_start:literal_start + length]
+			literal_start += length
+		if run:
+			out += bytes((run + 125, data[pos]))
+			pos += run
+			literal_start = pos
+	return bytes(out)
+
+def rle_decode(data, expected_length):
+	out = bytearray()
+	pos = 0
+	while pos < len(data):
+		control = data[pos]
+		if control < 128:
+			out += data[pos + 1:pos + 2 + control]
+			pos += 2 + control
+		else:
+			out += bytes((data[pos + 1],)) * (control - 125)
+			pos += 2
+	if len(out) != expected_length:
+		raise StreamError("page decodes to %u bytes" % len(out))
+	return bytes(out)
+
+class Display(object):
+	def __init__(self):
+		self.framebuffer = bytearray(WIDTH * PAGES)
+		self.sequence = None
+		self.frames = 0
+		self.received_bytes = 0
+
+	def read_exact(self, port, length):
+		data = port.read(length)
+		if len(data) != length:
+			raise StreamError("timeout waiting for the target")
+		self.received_bytes += length
+		return data
+
+	def receive(self, port, request):
+		port.write(request)
+
+		# Skip console text printed before the frame
+		while self.read_exact(port, 1)[0] != FRAME_START:
+			pass
+
+		header = self.read_exact(port, 2)
+		checksum = header[0] ^ header[1]
+		sequence, page_mask = header[0], header[1]
+		for page in range(PAGES):
+			if not page_mask & (1 << page):
+				continue
+			length_bytes = self.read_exact(port, 2)
+			length = struct.unpack("<H", length_bytes)[0]
+			encoded = self.read_exact(port, length)
+			for byte in length_bytes + encoded:
+				checksum ^= byte
+			start = page * WIDTH
+			self.framebuffer[start:start + WIDTH] = rle_decode(encoded, WIDTH)
+		if self.read_exact(port, 1)[0] != checksum:
+			raise StreamError("checksum mismatch in frame %u" % sequence)
+		if self.sequence is not None and sequence != (self.sequence + 1) & 0xFF:
+			raise StreamError("frame %u lost" % ((self.sequence + 1) & 0xFF))
+		self.sequence = sequence
+		self.frames += 1
+		return page_mask
+
+	def pixel(self, x, y):
+		return (self.framebuffer[(y // 8) * WIDTH + x] >> (y % 8)) & 1
+
+	def rows(self):
+		return [[self.pixel(x, y) for x in range(WIDTH)] for y in range(HEIGHT)]
+
+	def render_text(self):
+		# Two display lines per terminal line using half blocks
+		rows = self.rows()
+		glyphs = {(0, 0): " ", (1, 0): "▀", (0, 1): "▄", (1, 1): "█"}
+		lines = []
+		for y in range(0, HEIGHT, 2):
+			lines.append("".join(glyphs[(rows[y][x], rows[y + 1][x])]
+					for x in range(WIDTH)))
+		return "\n".join(lines)
+
+	def write_pbm(self, file_name):
+		with open(file_name, "wb") as output_file:
+			output_file.write(b"P4\n%u %u\n" % (WIDTH, HEIGHT))
+			for row in self.rows():
+				output_file.write(bytes(int("".join(map(str, row[x:x + 8])), 2)
+						for x in range(0, WIDTH, 8)))
+
+	def write_png(self, file_name):
+		raw = bytearray()
+		for row in self.rows():
+			raw.append(0)
+			raw += bytes(int("".join(str(1 - pixel) for pixel in row[x:x + 8]), 2)
+					for x in range(0, WIDTH, 8))
+
+		def chunk(kind, data):
+			return (struct.pack(">I", len(data)) + kind + data
+					+ struct.pack(">I", zlib.crc32(kind + data) & 0xFFFFFFFF))
+
+		with open(file_name, "wb") as output_file:
+			output_file.write(b"\x89PNG\r\n\x1a\n")
+			output_file.write(chunk(b"IHDR", struct.pack(">IIBBBBB", WIDTH, HEIGHT, 1, 0, 0, 0, 0)))
+			output_file.write(chunk(b"IDAT", zlib.compress(bytes(raw))))
+			output_file.write(chunk(b"IEND", b""))
+
+	def write_snapshot(self, file_name):
+		if file_name.lower().endswith(".png"):
+			self.write_png(file_name)
+		else:
+			self.write_pbm(file_name)
+
+def read_pbm(file_name):
+	with open(file_name, "rb") as input_file:
+		tokens = []
+		while len(tokens) < 3:
+			line = input_file.readline()
+			tokens += line.split(b"#")[0].split()
+		if tokens[0] != b"P4" or int(tokens[1]) != WIDTH or int(tokens[2]) != HEIGHT:
+			raise StreamError("%s is not a %ux%u PBM image" % (file_name, WIDTH, HEIGHT))
+		rows = input_file.read()
+	framebuffer = bytearray(WIDTH * PAGES)
+	for y in range(HEIGHT):
+		for x in range(WIDTH):
+			if rows[y * (WIDTH // 8) + x // 8] & (0x80 >> (x % 8)):
+				framebuffer[(y // 8) * WIDTH + x] |= 1 << (y % 8)
+	return framebuffer
+
+def compression_ratio(file_names):
+	total_raw = 0
+	total_encoded = 0
+	for file_name in file_names:
+		framebuffer = read_pbm(file_name)
+		# Key frame: header, length and data of every page, checksum
+		encoded = 4 + sum(2 + len(rle_encode(framebuffer[page * WIDTH:(page + 1) * WIDTH]))
+				for page in range(PAGES))
+		total_raw += len(framebuffer)
+		total_encoded += encoded
+		print("%s: %u bytes, ratio %.2f" % (file_name, encoded, len(framebuffer) / float(encoded)))
+	if len(file_names) > 1:
+		print("total: %u bytes, ratio %.2f" % (total_encoded, total_raw / float(total_encoded)))
+
+def open_port(serial_port, baud_rate):
+	import serial
+	return serial.Serial(port = serial_port, baudrate = baud_rate, timeout = 1)
+
+def stream(arguments):
+	try:
+		port = open_port(arguments.serial_port, arguments.baudrate)
+	except (ValueError, ImportError) as e:
+		print("error: invalid serial port parameters. %s" % (str(e)))
+		return -1
+	except Exception as e:
+		print("error: could not open serial port. %s" % (str(e)))
+		return -1
+
+	display = Display()
+	started = time.time()
+	request = REQ_KEY
+	try:
+		while arguments.frames == 0 or display.frames < arguments.frames:
+			page_mask = display.receive(port, request)
+			request = REQ_DELTA
+			if arguments.live and (page_mask or display.frames == 1):
+				sys.stdout.write("\x1b[H\x1b[2J" + display.render_text() + "\n")
+				sys.stdout.flush()
+			if arguments.interval:
+				time.sleep(arguments.interval)
+	except StreamError as e:
+		print("error: %s" % (str(e)))
+		return -1
+	except KeyboardInterrupt:
+		pass
+	finally:
+		port.close()
+
+	elapsed = time.time() - started
+	if arguments.benchmark and display.frames:
+		raw_bytes = display.frames * WIDTH * PAGES
+		print("%u frames in %.2f s, %.1f frames/s" % (display.frames, elapsed, display.frames / elapsed))
+		print("%u bytes received for %u raw bytes, ratio %.2f" % (display.received_bytes,
+				raw_bytes, raw_bytes / float(display.received_bytes)))
+
+	if arguments.output_file:
+		print("Writing display to file %s" % (arguments.output_file))
+		display.write_snapshot(arguments.output_file)
+	return 0
+
+def main():
+	parser = argparse.ArgumentParser(description="This script requests "
+			"RLE compressed frames of the display from the target over "
+			"the serial port and rebuilds the display contents. Only "
+			"the pages that changed since the last frame are sent. "
+			"The display can be shown live in the terminal and the "
+			"last frame written as a PBM or PNG snapshot.")
+	parser.add_argument("-p", "--port", dest="serial_port",
+			help="which serial port to open")
+	parser.add_argument("-b", "--baud", dest="baudrate", type=int,
+			help="baud rate to use for serial communication",
+			default=115200)
+	parser.add_argument("-o", "--output", dest="output_file",
+			help="write the last frame to FILE, PNG if the name ends "
+			"in .png, PBM otherwise", metavar="FILE")
+	parser.add_argument("-n", "--frames", dest="frames", type=int,
+			help="number of frames to receive, 0 to run until "
+			"interrupted", default=1)
+	parser.add_argument("-i", "--interval", dest="interval", type=float,
+			help="seconds to wait between frame requests", default=0)
+	parser.add_argument("-l", "--live", action="store_true", dest="live",
+			help="show the display in the terminal", default=False)
+	parser.add_argument("--benchmark", action="store_true", dest="benchmark",
+			help="report frames per second and compression ratio",
+			default=False)
+	parser.add_argument("--ratio", nargs="+", dest="ratio_files",
+			metavar="PBM", help="report the key frame compression "
+			"ratio of saved snapshots and exit")
+
+	arguments = parser.parse_args()
+
+	if arguments.ratio_files:
+		try:
+			compression_ratio(arguments.ratio_files)
+		except (IOError, StreamError) as e:
+			print("error: %s" % (str(e)))
+			sys.exit(1)
+		sys.exit()
+
+	if arguments.serial_port is None:
+		parser.print_usage()
+		sys.exit()
+
+	sys.exit(stream(arguments))
+
+if __name__ == "__main__":
+	main()
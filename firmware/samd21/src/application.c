@@ -45,7 +45,13 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "application.h"
+#include "configuration.h"
 #include "console.h"
+#include "display_assets.h"
+#include "display_layer.h"
+#include "display_list.h"
+#include "display_stream.h"
+#include "fast_gpio.h"
 #include "main.h"
 
 /* Size of a square */
@@ -85,6 +91,12 @@
 /* Length of strings */
 #define STRING_LENGTH 20
 
+/* Authentication status box */
+#define STATUS_X      STRING_X
+#define STATUS_Y      8
+#define STATUS_WIDTH  (GFX_MONO_LCD_WIDTH - STRING_X - 8)
+#define STATUS_HEIGHT 16
+
 /* X and Y coordinates for squares */
 const uint8_t square_coord[9][2] = {
     { SQUARE0_X, SQUARE0_Y, },
@@ -133,29 +145,34 @@ char win_string[STRING_LENGTH];
  */
 static void setup_board(void)
 {
+    display_list_begin();
+
     /* Clear screen */
-    gfx_mono_draw_filled_rect(0, 0, LCD_WIDTH_PIXELS, LCD_HEIGHT_PIXELS,
-                              GFX_PIXEL_CLR);
+    display_list_fill_rect(0, 0, LCD_WIDTH_PIXELS, LCD_HEIGHT_PIXELS,
+                           GFX_PIXEL_CLR);
 
     /* Draw vertical lines */
-    gfx_mono_draw_line(SQUARE_SIZE, 0, SQUARE_SIZE, SQUARE_SIZE * 3,
-                       GFX_PIXEL_SET);
-    gfx_mono_draw_line(SQUARE_SIZE * 2, 0, SQUARE_SIZE * 2, SQUARE_SIZE * 3,
-                       GFX_PIXEL_SET);
+    display_list_line(SQUARE_SIZE, 0, SQUARE_SIZE, SQUARE_SIZE * 3,
+                      GFX_PIXEL_SET);
+    display_list_line(SQUARE_SIZE * 2, 0, SQUARE_SIZE * 2, SQUARE_SIZE * 3,
+                      GFX_PIXEL_SET);
 
     /* Draw horizontal lines */
-    gfx_mono_draw_line(0, SQUARE_SIZE, SQUARE_SIZE * 3, SQUARE_SIZE,
-                       GFX_PIXEL_SET);
-    gfx_mono_draw_line(0, SQUARE_SIZE * 2, SQUARE_SIZE * 3, SQUARE_SIZE * 2,
-                       GFX_PIXEL_SET);
+    display_list_line(0, SQUARE_SIZE, SQUARE_SIZE * 3, SQUARE_SIZE,
+                      GFX_PIXEL_SET);
+    display_list_line(0, SQUARE_SIZE * 2, SQUARE_SIZE * 3, SQUARE_SIZE * 2,
+                      GFX_PIXEL_SET);
 
     /* Print number of games */
     snprintf(win_string, STRING_LENGTH, "Games: %d", games);
-    gfx_mono_draw_string(win_string, STRING_X, SQUARE0_Y, &sysfont);
+    display_list_string(win_string, STRING_X, SQUARE0_Y, &sysfont);
 
     /* Print number of wins */
     snprintf(win_string, STRING_LENGTH, "Wins: %d", wins);
-    gfx_mono_draw_string(win_string, STRING_X, SQUARE3_Y, &sysfont);
+    display_list_string(win_string, STRING_X, SQUARE3_Y, &sysfont);
+
+    display_list_execute();
+    gfx_mono_present();
 
     /* Clear occupied squares */
     for (uint8_t i = 0; i < 3; i++)
@@ -172,35 +189,54 @@ static void setup_board(void)
  */
 static enum button get_button(void)
 {
-    if (port_pin_get_input_level(WING_BUTTON_1) == false)
+    uint8_t buttons = fast_gpio_read_buttons();
+    uint8_t pushed_bit;
+    enum button pushed;
+
+    if (buttons & FAST_GPIO_BUTTON_1)
     {
-        /* Wait for button to be released */
-        while (!port_pin_get_input_level(WING_BUTTON_1))
-        {
-        }
-        return BUTTON_1;
+        pushed_bit = FAST_GPIO_BUTTON_1;
+        pushed = BUTTON_1;
     }
-    else if (port_pin_get_input_level(WING_BUTTON_2) == false)
+    else if (buttons & FAST_GPIO_BUTTON_2)
     {
-        /* Wait for button to be released */
-        while (!port_pin_get_input_level(WING_BUTTON_2))
-        {
-        }
-        return BUTTON_2;
+        pushed_bit = FAST_GPIO_BUTTON_2;
+        pushed = BUTTON_2;
     }
-    else if (port_pin_get_input_level(WING_BUTTON_3) == false)
+    else if (buttons & FAST_GPIO_BUTTON_3)
     {
-        /* Wait for button to be released */
-        while (!port_pin_get_input_level(WING_BUTTON_3))
-        {
-        }
-        return BUTTON_3;
+        pushed_bit = FAST_GPIO_BUTTON_3;
+        pushed = BUTTON_3;
     }
     else
     {
         /* No button pushed */
         return BUTTON_NONE;
     }
+
+    /* Wait for button to be released */
+    while (fast_gpio_read_buttons() & pushed_bit)
+    {
+    }
+    return pushed;
+}
+
+/**
+ * \brief Shows a status box over the game while authentication fails
+ * The game screen is left untouched and reappears when the box is hidden.
+ */
+static void show_auth_status(state status)
+{
+    bool failed = (status != AUTHENTICATED);
+
+    if (failed == display_layer_is_visible(DISPLAY_LAYER_STATUS))
+    {
+        return;
+    }
+
+    display_layer_set_visible(DISPLAY_LAYER_STATUS, failed);
+    display_layer_commit();
+    gfx_mono_present();
 }
 
 /**
@@ -208,19 +244,21 @@ static enum button get_button(void)
  */
 void init_display(void)
 {
-    gfx_mono_draw_filled_rect(0, 0, GFX_MONO_LCD_WIDTH, GFX_MONO_LCD_HEIGHT, GFX_PIXEL_CLR);
-    /* Draw buttons */
-    gfx_mono_draw_circle(10, SQUARE3_Y, CIRCLE_SIZE, GFX_PIXEL_SET, GFX_WHOLE);
-    gfx_mono_draw_circle((LCD_WIDTH_PIXELS / 3) + 10, SQUARE3_Y, CIRCLE_SIZE,
-                         GFX_PIXEL_SET, GFX_WHOLE);
-    gfx_mono_draw_circle((LCD_WIDTH_PIXELS / 3) * 2 + 10, SQUARE3_Y,
-                         CIRCLE_SIZE, GFX_PIXEL_SET, GFX_WHOLE);
-
-    /* Print text */
-    gfx_mono_draw_string("LEFT", 0, SQUARE6_Y, &sysfont);
-    gfx_mono_draw_string("OK", (LCD_WIDTH_PIXELS / 3), SQUARE6_Y, &sysfont);
-    gfx_mono_draw_string("RIGHT", (LCD_WIDTH_PIXELS / 3) * 2, SQUARE6_Y,
-                         &sysfont);
+    /* From here on the main loop sends the display updates in slices */
+    gfx_mono_set_flush_budget(DISPLAY_FLUSH_BUDGET_BYTES);
+
+    /* Status box, hidden until authentication fails */
+    display_layer_init();
+    display_layer_fill_rect(DISPLAY_LAYER_STATUS, STATUS_X, STATUS_Y, STATUS_WIDTH,
+                            STATUS_HEIGHT, GFX_PIXEL_SET);
+    display_layer_fill_rect(DISPLAY_LAYER_STATUS, STATUS_X + 1, STATUS_Y + 1, STATUS_WIDTH - 2,
+                            STATUS_HEIGHT - 2, GFX_PIXEL_CLR);
+    display_layer_draw_string(DISPLAY_LAYER_STATUS, "AUTH FAILED", STATUS_X + 4, STATUS_Y + 4,
+                              &sysfont);
+
+    /* Draw buttons and their text, compiled from assets/button_legend.pbm */
+    display_asset_blit(&button_legend_asset, 0, 0);
+    gfx_mono_present();
 }
 
 /**
@@ -234,6 +272,7 @@ static void draw_cross(uint8_t square_num)
     /* Draw cross in selected square */
     gfx_mono_draw_line(x, y, x + CROSS_SIZE, y + CROSS_SIZE, GFX_PIXEL_SET);
     gfx_mono_draw_line(x + CROSS_SIZE, y, x, y + CROSS_SIZE, GFX_PIXEL_SET);
+    gfx_mono_present();
 }
 
 /**
@@ -247,6 +286,7 @@ static void draw_circle(uint8_t square_num)
     /* Draw circle in selected square */
     gfx_mono_draw_circle(x + CIRCLE_SIZE, y + CIRCLE_SIZE, CIRCLE_SIZE,
                          GFX_PIXEL_SET, GFX_WHOLE);
+    gfx_mono_present();
 }
 
 /**
@@ -260,16 +300,19 @@ static void highlight_square(uint8_t square_num)
     uint8_t x = square_coord[last_square][0];
     uint8_t y = square_coord[last_square][1];
 
-    gfx_mono_draw_rect(x + 1, y + 1, SQUARE_SIZE - 2, SQUARE_SIZE - 2,
-                       GFX_PIXEL_CLR);
+    display_list_begin();
+    display_list_rect(x + 1, y + 1, SQUARE_SIZE - 2, SQUARE_SIZE - 2,
+                      GFX_PIXEL_CLR);
 
     last_square = square_num;
 
     /* Highlight new square */
     x = square_coord[square_num][0];
     y = square_coord[square_num][1];
-    gfx_mono_draw_rect(x + 1, y + 1, SQUARE_SIZE - 2, SQUARE_SIZE - 2,
-                       GFX_PIXEL_SET);
+    display_list_rect(x + 1, y + 1, SQUARE_SIZE - 2, SQUARE_SIZE - 2,
+                      GFX_PIXEL_SET);
+    display_list_execute();
+    gfx_mono_present();
 }
 
 /**
@@ -290,7 +333,11 @@ static state user_turn(void)
         /* Wait for button interaction */
         do
         {
-            if ((run_status = authenticate_application()) != AUTHENTICATED)
+            gfx_mono_flush();
+            display_stream_poll();
+            run_status = authenticate_application();
+            show_auth_status(run_status);
+            if (run_status != AUTHENTICATED)
             {
                 break;
             }
@@ -450,6 +497,9 @@ void init_buttons(void)
     port_pin_set_config(WING_BUTTON_1, &conf);
     port_pin_set_config(WING_BUTTON_2, &conf);
     port_pin_set_config(WING_BUTTON_3, &conf);
+
+    /* fast_gpio_read_buttons() reads them over the IOBUS, which needs continuous sampling */
+    PORT->Group[FAST_GPIO_BUTTON_GROUP].CTRL.reg |= FAST_GPIO_BUTTON_MASK;
 }
 
 
@@ -463,7 +513,11 @@ void run_application(void)
     /* Wait for button interaction */
     while (get_button() == BUTTON_NONE)
     {
-        if ((run_status = authenticate_application()) != AUTHENTICATED)
+        gfx_mono_flush();
+        display_stream_poll();
+        run_status = authenticate_application();
+        show_auth_status(run_status);
+        if (run_status != AUTHENTICATED)
         {
             break;
         }
@@ -523,6 +577,7 @@ void run_application(void)
     }
 
     gfx_mono_draw_string("Press a button", STRING_X, SQUARE3_Y, &sysfont);
+    gfx_mono_present();
     games++;
 
 
@@ -0,0 +1,78 @@
+/**
+ * \file
+ * \brief  Boot record kept in the last flash row to skip provisioning queries
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#include <string.h>
+#include <stddef.h>
+#include <asf.h>
+#include "boot_cache.h"
+#include "crc16.h"
+#include "flash_row.h"
+
+static uint16_t boot_cache_crc(const boot_cache_record *record);
+
+static uint16_t boot_cache_crc(const boot_cache_record *record)
+{
+    return crc16_update(CRC16_INIT, (const uint8_t*)record, offsetof(boot_cache_record, record_crc));
+}
+
+//Function to read the boot record, fails when it is missing, corrupt or written for another configuration
+bool boot_cache_load(boot_cache_record *record, uint16_t config_crc)
+{
+    memcpy(record, (const void*)BOOT_CACHE_ADDRESS, sizeof(*record));
+
+    return record->magic == BOOT_CACHE_MAGIC &&
+           record->version == BOOT_CACHE_VERSION &&
+           record->config_crc == config_crc &&
+           record->record_crc == boot_cache_crc(record);
+}
+
+//Function to write the boot record, flash is only erased when the record changed
+bool boot_cache_store(boot_cache_record *record)
+{
+    record->magic = BOOT_CACHE_MAGIC;
+    record->version = BOOT_CACHE_VERSION;
+    record->record_crc = boot_cache_crc(record);
+
+    if (memcmp((const void*)BOOT_CACHE_ADDRESS, record, sizeof(*record)) == 0)
+    {
+        return true;
+    }
+
+    return flash_row_erase(BOOT_CACHE_ADDRESS) &&
+           flash_row_write(BOOT_CACHE_ADDRESS, (const uint8_t*)record, sizeof(*record));
+}
+
+//Function to erase the boot record, the next boot runs the full provisioning checks
+void boot_cache_invalidate(void)
+{
+    if (((const boot_cache_record*)BOOT_CACHE_ADDRESS)->magic != 0xFFFFFFFF)
+    {
+        flash_row_erase(BOOT_CACHE_ADDRESS);
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * \file
+ * \brief  Boot record kept in the last flash row to skip provisioning queries
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#ifndef BOOT_CACHE_H_
+#define BOOT_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <compiler.h>
+#include "flash_row.h"
+
+//The linker script keeps the last row of flash free for the record
+#define BOOT_CACHE_ADDRESS          (FLASH_ADDR + FLASH_SIZE - FLASH_ROW_SIZE)
+
+#define BOOT_CACHE_MAGIC            0x31524342  //"BCR1" in flash
+#define BOOT_CACHE_VERSION          1
+
+#define BOOT_CACHE_SERIAL_SIZE      9
+
+//Lock state bits
+#define BOOT_CACHE_CONFIG_LOCKED    0x01
+#define BOOT_CACHE_DATA_LOCKED      0x02
+
+typedef struct
+{
+    uint32_t magic;                                 //BOOT_CACHE_MAGIC
+    uint8_t version;                                //BOOT_CACHE_VERSION
+    uint8_t device;                                 //CRYPTOAUTH_DEVICE the record was written for
+    uint8_t i2c_address;                            //8 bit I2C address the device answered at
+    uint8_t lock_state;                             //BOOT_CACHE_CONFIG_LOCKED and BOOT_CACHE_DATA_LOCKED
+    uint8_t serial_number[BOOT_CACHE_SERIAL_SIZE];  //Serial number of the provisioned device
+    uint8_t slot;                                   //Slot holding the diversified key
+    uint16_t config_crc;                            //CRC-16 of the configuration zone data the firmware writes
+    uint16_t record_crc;                            //CRC-16 of all fields above
+} boot_cache_record;
+
+bool boot_cache_load(boot_cache_record *record, uint16_t config_crc);
+bool boot_cache_store(boot_cache_record *record);
+void boot_cache_invalidate(void);
+
+#endif /* BOOT_CACHE_H_ */
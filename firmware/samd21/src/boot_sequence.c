@@ -0,0 +1,140 @@
+/**
+ * \file
+ * \brief  Cooperative boot sequence running independent initializations side by side
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#include <stdio.h>
+#include <asf.h>
+#include "boot_sequence.h"
+
+/*
+ * There are no threads: every stage is a step function that starts hardware
+ * work, or checks on it, and returns instead of waiting. The sequence calls
+ * the steps of all stages whose dependencies are done in turn, so the ADC
+ * conversions, the display transfers and the secure element start-up time
+ * overlap. A step that has to wait for the user, like provisioning, holds
+ * the other stages until it returns.
+ */
+
+static volatile uint32_t g_boot_msec;
+
+//Function to be called from the 1 ms SysTick interrupt
+void boot_sequence_tick(void)
+{
+    g_boot_msec++;
+}
+
+//Function to get the time since SysTick was started in microseconds
+uint32_t boot_time_usec(void)
+{
+    uint32_t msec;
+    uint32_t count;
+
+    do
+    {
+        msec = g_boot_msec;
+        count = SysTick->VAL;
+    }
+    while (msec != g_boot_msec);
+
+    return msec * 1000 + (SysTick->LOAD - count) / (system_cpu_clock_get_hz() / 1000000);
+}
+
+//Function to run the stages until all of them are done
+void boot_sequence_run(boot_stage *stages, uint8_t count)
+{
+    uint32_t all = (count < BOOT_STAGE_MAX) ? BOOT_STAGE_BIT(count) - 1 : 0xFFFFFFFF;
+    uint32_t done = 0;
+    uint32_t now;
+    uint8_t i;
+
+    while (done != all)
+    {
+        for (i = 0; i < count; i++)
+        {
+            if ((done & BOOT_STAGE_BIT(i)) || (stages[i].depends & all & ~done))
+            {
+                continue;
+            }
+
+            now = boot_time_usec();
+            if (stages[i].steps == 0)
+            {
+                stages[i].start_usec = now;
+            }
+            stages[i].steps++;
+
+            if (stages[i].step())
+            {
+                done |= BOOT_STAGE_BIT(i);
+            }
+            stages[i].end_usec = boot_time_usec();
+            stages[i].busy_usec += stages[i].end_usec - now;
+        }
+    }
+}
+
+//Function to print the timing of every stage and the chain of stages that decided the boot time
+void boot_sequence_print_timing(const boot_stage *stages, uint8_t count)
+{
+    uint8_t i;
+    uint8_t dep;
+    int16_t last = -1;
+
+    for (i = 0; i < count; i++)
+    {
+        printf("%-12s start %7lu us, end %7lu us, busy %7lu us, %u steps\r\n", stages[i].name,
+               (unsigned long)stages[i].start_usec, (unsigned long)stages[i].end_usec,
+               (unsigned long)stages[i].busy_usec, stages[i].steps);
+        if (last < 0 || stages[i].end_usec > stages[last].end_usec)
+        {
+            last = i;
+        }
+    }
+
+    //Walk back through the dependency that finished last
+    printf("critical path:");
+    while (last >= 0)
+    {
+        printf(" %s", stages[last].name);
+        i = last;
+        last = -1;
+        for (dep = 0; dep < count; dep++)
+        {
+            if ((stages[i].depends & BOOT_STAGE_BIT(dep)) &&
+                (last < 0 || stages[dep].end_usec > stages[last].end_usec))
+            {
+                last = dep;
+            }
+        }
+        if (last >= 0)
+        {
+            printf(" <-");
+        }
+    }
+    printf("\r\n");
+}
@@ -0,0 +1,60 @@
+/**
+ * \file
+ * \brief  Cooperative boot sequence running independent initializations side by side
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#ifndef BOOT_SEQUENCE_H_
+#define BOOT_SEQUENCE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Largest number of stages, one bit each in the dependency masks
+#define BOOT_STAGE_MAX          32
+
+#define BOOT_STAGE_BIT(stage)   (1UL << (stage))
+
+//Does one step of a stage without waiting on hardware, returns true when the stage is done
+typedef bool (*boot_stage_step_t)(void);
+
+typedef struct
+{
+    const char *name;
+    boot_stage_step_t step;
+    uint32_t depends;       //BOOT_STAGE_BIT() of the stages to finish first
+    uint32_t start_usec;    //Time of the first step
+    uint32_t end_usec;      //Time the last step returned
+    uint32_t busy_usec;     //Time spent inside the steps
+    uint16_t steps;         //Number of steps
+} boot_stage;
+
+void boot_sequence_tick(void);
+uint32_t boot_time_usec(void);
+void boot_sequence_run(boot_stage *stages, uint8_t count);
+void boot_sequence_print_timing(const boot_stage *stages, uint8_t count);
+
+#endif /* BOOT_SEQUENCE_H_ */
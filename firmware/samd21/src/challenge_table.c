@@ -0,0 +1,224 @@
+/**
+ * \file
+ * \brief  Challenge/MAC table in flash for authenticating without host side SHA-256
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <asf.h>
+#include "host/atca_host.h"
+#include "crypto/atca_crypto_sw_sha2.h"
+#include "main.h"
+#include "challenge_table.h"
+#include "crc16.h"
+
+/*
+ * symmetric_authenticate() derives the device key from the master key and
+ * calculates the Nonce TempKey and the MAC on the host, five SHA-256 blocks
+ * in software. The Nonce command mixes the device's random number into
+ * TempKey, so those MACs cannot be known in advance. The table holds
+ * challenges the factory station picked and the MACs it calculated with the
+ * board's diversified key, for MAC commands in mode 0x00 that take the
+ * challenge in the command. Authenticating is one MAC command with an entry
+ * picked by rand(), its challenge sent straight from flash, and a constant
+ * time compare with the stored MAC.
+ *
+ * Before the first entry is drawn, challenge_table_load() checks that the
+ * table belongs to this device and was made by the holder of the master key:
+ * the serial number in the header has to be the one of the device, and the
+ * header holds a MAC in mode 0x00 with the board's diversified key over the
+ * SHA-256 of the header fields in front of it and of the entries. The key is
+ * derived here like provisioning does, so a table a clone board made with
+ * the key of its own secure element does not pass. This costs about 130
+ * software SHA-256 blocks for a full table, once per boot.
+ * ATCA_INVALID_ID tells the caller that no table here can ever pass, a
+ * missing, empty, foreign or forged one.
+ *
+ * A finite table can be recorded: a clone answering every entry of a board
+ * passes as that board. More entries make recording longer, not impossible.
+ */
+
+static uint16_t challenge_table_crc(const challenge_table_header *header);
+static bool challenge_table_valid(const challenge_table_header *header, uint8_t slot);
+static bool challenge_table_equal(const uint8_t *a, const uint8_t *b, uint8_t size);
+static ATCA_STATUS challenge_table_check_mac(const challenge_table_header *header);
+
+static bool g_table_loaded;
+
+//Function to calculate the CRC-16 of the header fields in front of header_crc
+static uint16_t challenge_table_crc(const challenge_table_header *header)
+{
+    return crc16_update(CRC16_INIT, (const uint8_t*)header, offsetof(challenge_table_header, header_crc));
+}
+
+//Function to check the header the station wrote, the entries are checked by the MACs they hold
+static bool challenge_table_valid(const challenge_table_header *header, uint8_t slot)
+{
+    return header->magic == CHALLENGE_TABLE_MAGIC &&
+           header->version == CHALLENGE_TABLE_VERSION &&
+           header->slot == slot &&
+           header->count != 0 &&
+           header->count <= CHALLENGE_TABLE_MAX_ENTRIES &&
+           header->mac_size == CHALLENGE_TABLE_MAC_SIZE &&
+           header->header_crc == challenge_table_crc(header);
+}
+
+//Function to compare every byte, so the time does not tell where a response differs
+static bool challenge_table_equal(const uint8_t *a, const uint8_t *b, uint8_t size)
+{
+    uint8_t difference = 0;
+    uint8_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        difference |= a[i] ^ b[i];
+    }
+    return difference == 0;
+}
+
+//Function to check the MAC of the header with the diversified key of the device
+static ATCA_STATUS challenge_table_check_mac(const challenge_table_header *header)
+{
+    uint8_t master_key[ATCA_KEY_SIZE];
+    uint8_t key[ATCA_KEY_SIZE];
+    uint8_t digest[ATCA_SHA2_256_DIGEST_SIZE];
+    uint8_t mac[MAC_SIZE];
+    atca_temp_key_t temp_key;
+    struct atca_derive_key_in_out derive_params;
+    struct atca_mac_in_out mac_params;
+    atcac_sha2_256_ctx sha;
+    ATCA_STATUS status;
+
+    //Diversified key of the slot, TempKey holds the serial number padded with zeros like in provisioning
+    get_master_key(master_key);
+    memset(&temp_key, 0, sizeof(temp_key));
+    temp_key.valid = 1;
+    memcpy(temp_key.value, header->serial_number, CHALLENGE_TABLE_SERIAL_SIZE);
+    derive_params.mode = 0;
+    derive_params.target_key_id = header->slot;
+    derive_params.parent_key = master_key;
+    derive_params.sn = header->serial_number;
+    derive_params.target_key = key;
+    derive_params.temp_key = &temp_key;
+    status = atcah_derive_key(&derive_params);
+    memset(master_key, 0, sizeof(master_key));
+    if (status != ATCA_SUCCESS)
+    {
+        return status;
+    }
+
+    //Entries are hashed in place, flash is memory mapped
+    atcac_sw_sha2_256_init(&sha);
+    atcac_sw_sha2_256_update(&sha, (const uint8_t*)header, offsetof(challenge_table_header, table_mac));
+    atcac_sw_sha2_256_update(&sha, (const uint8_t*)(header + 1), header->count * sizeof(challenge_table_entry));
+    atcac_sw_sha2_256_finish(&sha, digest);
+
+    memset(&mac_params, 0, sizeof(mac_params));
+    mac_params.mode = MAC_MODE_CHALLENGE;
+    mac_params.key_id = header->slot;
+    mac_params.challenge = digest;
+    mac_params.key = key;
+    mac_params.sn = header->serial_number;
+    mac_params.response = mac;
+    mac_params.temp_key = &temp_key;
+    status = atcah_mac(&mac_params);
+    memset(key, 0, sizeof(key));
+    if (status != ATCA_SUCCESS)
+    {
+        return status;
+    }
+
+    return challenge_table_equal(mac, header->table_mac, MAC_SIZE) ? ATCA_SUCCESS : ATCA_INVALID_ID;
+}
+
+//Function to check once that the table was made for this device and slot by the holder of the master key
+ATCA_STATUS challenge_table_load(uint8_t slot)
+{
+    const challenge_table_header *header = (const challenge_table_header*)CHALLENGE_TABLE_ADDRESS;
+    uint8_t serial_number[ATCA_SERIAL_NUM_SIZE];
+    ATCA_STATUS status;
+
+    g_table_loaded = false;
+    if (!challenge_table_valid(header, slot))
+    {
+        return ATCA_INVALID_ID;
+    }
+
+    if ((status = atcab_read_serial_number(serial_number)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+    if (memcmp(serial_number, header->serial_number, CHALLENGE_TABLE_SERIAL_SIZE) != 0)
+    {
+        return ATCA_INVALID_ID;
+    }
+
+    if ((status = challenge_table_check_mac(header)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+
+    g_table_loaded = true;
+    return ATCA_SUCCESS;
+}
+
+//Function to authenticate the device with a random entry of the table, loading it on the first call
+ATCA_STATUS challenge_table_authenticate(uint8_t slot)
+{
+    const challenge_table_header *header = (const challenge_table_header*)CHALLENGE_TABLE_ADDRESS;
+    const challenge_table_entry *entry;
+    uint8_t response[MAC_SIZE];
+    ATCA_STATUS status;
+
+    if (!g_table_loaded && (status = challenge_table_load(slot)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+
+    //Entries are read in place, flash is memory mapped
+    entry = (const challenge_table_entry*)(header + 1) + (rand() % header->count);
+    if ((status = atcab_mac(MAC_MODE_CHALLENGE, slot, entry->challenge, response)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+
+    return challenge_table_equal(response, entry->mac, CHALLENGE_TABLE_MAC_SIZE) ? ATCA_SUCCESS : ATCA_CHECKMAC_VERIFY_FAILED;
+}
+
+//Function to erase and write one row of the table region, for the factory station
+bool challenge_table_write_row(uint16_t offset, const uint8_t *data, uint16_t length)
+{
+    if (offset % FLASH_ROW_SIZE != 0 || length == 0 || length > FLASH_ROW_SIZE ||
+        offset + length > CHALLENGE_TABLE_REGION_SIZE)
+    {
+        return false;
+    }
+
+    g_table_loaded = false;
+    return flash_row_erase(CHALLENGE_TABLE_ADDRESS + offset) &&
+           flash_row_write(CHALLENGE_TABLE_ADDRESS + offset, data, length);
+}
@@ -0,0 +1,76 @@
+/**
+ * \file
+ * \brief  Challenge/MAC table in flash for authenticating without host side SHA-256
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#ifndef CHALLENGE_TABLE_H_
+#define CHALLENGE_TABLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <compiler.h>
+#include "cryptoauthlib.h"
+#include "flash_row.h"
+#include "boot_cache.h"
+
+//The linker script keeps these rows below the boot record free for the table
+#define CHALLENGE_TABLE_REGION_SIZE (FLASH_ROW_SIZE * 32)
+#define CHALLENGE_TABLE_ADDRESS     (BOOT_CACHE_ADDRESS - CHALLENGE_TABLE_REGION_SIZE)
+
+#define CHALLENGE_TABLE_MAGIC       0x31544352  //"RCT1" in flash
+#define CHALLENGE_TABLE_VERSION     2
+
+#define CHALLENGE_TABLE_SERIAL_SIZE     9
+#define CHALLENGE_TABLE_CHALLENGE_SIZE  32
+//Leading bytes of every MAC that are stored, a forged response passes with probability 2^-128
+#define CHALLENGE_TABLE_MAC_SIZE        16
+
+typedef struct
+{
+    uint32_t magic;                                     //CHALLENGE_TABLE_MAGIC
+    uint8_t version;                                    //CHALLENGE_TABLE_VERSION
+    uint8_t slot;                                       //Key slot the MACs were calculated with
+    uint16_t count;                                     //Number of entries after the header
+    uint8_t serial_number[CHALLENGE_TABLE_SERIAL_SIZE]; //Device the table was made for
+    uint8_t mac_size;                                   //CHALLENGE_TABLE_MAC_SIZE
+    uint8_t reserved[12];
+    uint8_t table_mac[MAC_SIZE];                        //MAC in mode 0x00 with the slot key, see challenge_table.c
+    uint16_t header_crc;                                //CRC-16 of all fields above
+} challenge_table_header;
+
+typedef struct
+{
+    uint8_t challenge[CHALLENGE_TABLE_CHALLENGE_SIZE];  //Challenge of a MAC command in mode 0x00
+    uint8_t mac[CHALLENGE_TABLE_MAC_SIZE];              //Leading bytes of the response
+} challenge_table_entry;
+
+#define CHALLENGE_TABLE_MAX_ENTRIES ((CHALLENGE_TABLE_REGION_SIZE - sizeof(challenge_table_header)) / sizeof(challenge_table_entry))
+
+ATCA_STATUS challenge_table_load(uint8_t slot);
+ATCA_STATUS challenge_table_authenticate(uint8_t slot);
+bool challenge_table_write_row(uint16_t offset, const uint8_t *data, uint16_t length);
+
+#endif /* CHALLENGE_TABLE_H_ */
@@ -0,0 +1,123 @@
+/**
+ * \file
+ * \brief  Learned CryptoAuth command execution times for response polling
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include "cmd_timing.h"
+
+static cmd_timing_stats g_entries[CMD_TIMING_ENTRIES];
+static uint8_t g_entry_count;
+
+static cmd_timing_stats* cmd_timing_find(uint8_t devtype, uint8_t opcode);
+
+static cmd_timing_stats* cmd_timing_find(uint8_t devtype, uint8_t opcode)
+{
+    uint8_t i;
+
+    for (i = 0; i < g_entry_count; i++)
+    {
+        if (g_entries[i].devtype == devtype && g_entries[i].opcode == opcode)
+        {
+            return &g_entries[i];
+        }
+    }
+    return NULL;
+}
+
+//Function to get the fastest completion of a command seen, 0 when it has not been seen yet
+uint32_t cmd_timing_expected_usec(uint8_t devtype, uint8_t opcode)
+{
+    cmd_timing_stats *entry = cmd_timing_find(devtype, opcode);
+
+    return (entry != NULL) ? entry->min_usec : 0;
+}
+
+//Function to add the observed completion time of a command to its statistics
+void cmd_timing_record(uint8_t devtype, uint8_t opcode, uint32_t elapsed_usec, uint16_t polls)
+{
+    cmd_timing_stats *entry = cmd_timing_find(devtype, opcode);
+
+    if (entry == NULL)
+    {
+        if (g_entry_count >= CMD_TIMING_ENTRIES)
+        {
+            return;
+        }
+        entry = &g_entries[g_entry_count++];
+        entry->devtype = devtype;
+        entry->opcode = opcode;
+        entry->average_usec = elapsed_usec;
+        entry->min_usec = elapsed_usec;
+        entry->max_usec = elapsed_usec;
+    }
+
+    if (entry->count != UINT16_MAX)
+    {
+        entry->count++;
+    }
+
+    //A response found on the first read may have been ready earlier, the
+    //next command then starts polling earlier by the early fraction
+    entry->average_usec = entry->average_usec - (entry->average_usec >> CMD_TIMING_AVERAGE_SHIFT) +
+                          (elapsed_usec >> CMD_TIMING_AVERAGE_SHIFT);
+    if (elapsed_usec < entry->min_usec)
+    {
+        entry->min_usec = elapsed_usec;
+    }
+    if (elapsed_usec > entry->max_usec)
+    {
+        entry->max_usec = elapsed_usec;
+    }
+    entry->polls += polls;
+}
+
+const cmd_timing_stats* cmd_timing_get_stats(uint8_t *count)
+{
+    *count = g_entry_count;
+    return g_entries;
+}
+
+void cmd_timing_reset(void)
+{
+    memset(g_entries, 0, sizeof(g_entries));
+    g_entry_count = 0;
+}
+
+//Function to print the statistics on the EDBG COM Port
+void cmd_timing_print_stats(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < g_entry_count; i++)
+    {
+        printf("dev %u op 0x%02X: %u runs, avg %lu us, min %lu us, max %lu us, %lu polls\r\n",
+               g_entries[i].devtype, g_entries[i].opcode, g_entries[i].count,
+               (unsigned long)g_entries[i].average_usec, (unsigned long)g_entries[i].min_usec,
+               (unsigned long)g_entries[i].max_usec, (unsigned long)g_entries[i].polls);
+    }
+}
@@ -0,0 +1,68 @@
+/**
+ * \file
+ * \brief  Learned CryptoAuth command execution times for response polling
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#ifndef CMD_TIMING_H_
+#define CMD_TIMING_H_
+
+#include <stdint.h>
+
+//Number of device type and opcode pairs tracked
+#define CMD_TIMING_ENTRIES          16
+
+//Start polling this fraction of the fastest completion seen early, as a power of two. Starting
+//at the fastest completion keeps a command that varies from waiting out the slow runs of the average
+#define CMD_TIMING_EARLY_SHIFT      3
+
+//First polling interval, doubled after every NACK
+#define CMD_TIMING_MIN_STEP_USEC    25
+
+//Longest polling interval
+#define CMD_TIMING_MAX_STEP_USEC    250
+
+//Weight of a new observation in the moving average, as a power of two
+#define CMD_TIMING_AVERAGE_SHIFT    3
+
+typedef struct
+{
+    uint8_t devtype;        //ATCADeviceType of the device
+    uint8_t opcode;         //Command opcode
+    uint16_t count;         //Completed commands
+    uint32_t average_usec;  //Moving average of the completion time
+    uint32_t min_usec;      //Fastest completion seen
+    uint32_t max_usec;      //Slowest completion seen
+    uint32_t polls;         //Reads the device NACKed while executing
+} cmd_timing_stats;
+
+uint32_t cmd_timing_expected_usec(uint8_t devtype, uint8_t opcode);
+void cmd_timing_record(uint8_t devtype, uint8_t opcode, uint32_t elapsed_usec, uint16_t polls);
+const cmd_timing_stats* cmd_timing_get_stats(uint8_t *count);
+void cmd_timing_reset(void);
+void cmd_timing_print_stats(void);
+
+#endif /* CMD_TIMING_H_ */
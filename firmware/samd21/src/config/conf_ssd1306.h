@@ -52,6 +52,8 @@
 /* Interface configuration for SAM Xplained Pro */
 #  define SSD1306_SPI                 EXT3_SPI_MODULE
 #  define CONFIG_SSD1306_FRAMEBUFFER
+/* Draw into a back buffer and send whole frames with gfx_mono_present() */
+#  define CONFIG_SSD1306_DOUBLE_BUFFER
 
 #  define SSD1306_DC_PIN              EXT3_PIN_5
 #  define SSD1306_RES_PIN             EXT3_PIN_10
@@ -62,6 +64,14 @@
 #  define SSD1306_SPI_PINMUX_PAD1     PINMUX_UNUSED
 #  define SSD1306_SPI_PINMUX_PAD2     EXT3_SPI_SERCOM_PINMUX_PAD2
 #  define SSD1306_SPI_PINMUX_PAD3     EXT3_SPI_SERCOM_PINMUX_PAD3
+
+/* Chip select and D/C# change around every byte, drive them with single
+ * stores to the IOBUS port alias instead of spi_select_slave() */
+#  include "fast_gpio.h"
+#  define SSD1306_CS_SELECT()         FAST_GPIO_CLR(SSD1306_CS_PIN)
+#  define SSD1306_CS_DESELECT()       FAST_GPIO_SET(SSD1306_CS_PIN)
+#  define SSD1306_DC_COMMAND()        FAST_GPIO_CLR(SSD1306_DC_PIN)
+#  define SSD1306_DC_DATA()           FAST_GPIO_SET(SSD1306_DC_PIN)
 #else
 /* Dummy Interface configuration */
 #  define SSD1306_SPI                 0
@@ -0,0 +1,236 @@
+/**
+ * \file
+ * \brief  Configuration zone writer sending only the words that differ
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#include <string.h>
+#include "config_writer.h"
+
+/*
+ * atcab_write_config_zone() sends every writable word of the configuration
+ * zone. Here the first block is read; when most of its writable words differ
+ * from the wanted configuration the part is taken as fresh from the factory
+ * and every writable word is written without reading the rest or reading
+ * back, like atcab_write_config_zone(), for one read more than the library.
+ * Otherwise the rest of the zone is read and only the words that differ are
+ * written, and a second read of the zone verifies the result. A block that
+ * is writable as a whole and has CONFIG_WRITER_BLOCK_THRESHOLD or more words
+ * to write is written with one 32 byte command. The first 16 bytes (serial
+ * number and revision) and the word holding UserExtra, Selector and the lock
+ * bytes are not written; UserExtra and Selector are set with UpdateExtra,
+ * which only works while they are zero.
+ */
+
+#define CONFIG_WORD_SIZE        4
+#define CONFIG_FIRST_WORD       4
+#define CONFIG_EXTRA_WORD       (CONFIG_WRITER_EXTRA_OFFSET / CONFIG_WORD_SIZE)
+#define CONFIG_WORDS_PER_BLOCK  (ATCA_BLOCK_SIZE / CONFIG_WORD_SIZE)
+
+static bool config_word_writable(uint8_t word, size_t config_size);
+static bool config_block_writable(uint8_t block, size_t config_size);
+static bool config_word_differs(const uint8_t *current, const uint8_t *config_data, uint8_t word, size_t config_size);
+static uint8_t config_block_differing(const uint8_t *current, const uint8_t *config_data, uint8_t block,
+                                      size_t config_size, uint8_t *writable);
+static bool config_matches(const uint8_t *current, const uint8_t *config_data, size_t config_size);
+
+static bool config_word_writable(uint8_t word, size_t config_size)
+{
+    return word >= CONFIG_FIRST_WORD && word != CONFIG_EXTRA_WORD &&
+           (size_t)(word + 1) * CONFIG_WORD_SIZE <= config_size;
+}
+
+static bool config_block_writable(uint8_t block, size_t config_size)
+{
+    uint8_t word;
+
+    for (word = block * CONFIG_WORDS_PER_BLOCK; word < (block + 1) * CONFIG_WORDS_PER_BLOCK; word++)
+    {
+        if (!config_word_writable(word, config_size))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool config_word_differs(const uint8_t *current, const uint8_t *config_data, uint8_t word, size_t config_size)
+{
+    return config_word_writable(word, config_size) &&
+           memcmp(&current[word * CONFIG_WORD_SIZE], &config_data[word * CONFIG_WORD_SIZE], CONFIG_WORD_SIZE) != 0;
+}
+
+//Function to count the writable words of a block that differ, writable may be NULL
+static uint8_t config_block_differing(const uint8_t *current, const uint8_t *config_data, uint8_t block,
+                                      size_t config_size, uint8_t *writable)
+{
+    uint8_t word;
+    uint8_t differing = 0;
+
+    if (writable != NULL)
+    {
+        *writable = 0;
+    }
+    for (word = block * CONFIG_WORDS_PER_BLOCK; word < (block + 1) * CONFIG_WORDS_PER_BLOCK; word++)
+    {
+        if (writable != NULL && config_word_writable(word, config_size))
+        {
+            (*writable)++;
+        }
+        if (config_word_differs(current, config_data, word, config_size))
+        {
+            differing++;
+        }
+    }
+    return differing;
+}
+
+//Function to compare the writable words and the UserExtra and Selector bytes
+static bool config_matches(const uint8_t *current, const uint8_t *config_data, size_t config_size)
+{
+    uint8_t word;
+
+    for (word = 0; word < config_size / CONFIG_WORD_SIZE; word++)
+    {
+        if (config_word_differs(current, config_data, word, config_size))
+        {
+            return false;
+        }
+    }
+
+    return memcmp(&current[CONFIG_WRITER_EXTRA_OFFSET], &config_data[CONFIG_WRITER_EXTRA_OFFSET], 2) == 0;
+}
+
+//Function to write the configuration zone with as few commands as possible, config_size
+//is ATCA_SHA_CONFIG_SIZE or ATCA_ECC_CONFIG_SIZE. stats may be NULL.
+ATCA_STATUS config_writer_write(const uint8_t *config_data, size_t config_size, config_writer_stats *stats)
+{
+    ATCA_STATUS status;
+    uint8_t current[ATCA_ECC_CONFIG_SIZE];
+    config_writer_stats counts;
+    uint8_t block;
+    uint8_t word;
+    uint8_t differing;
+    uint8_t writable;
+    size_t i;
+    bool fresh;
+
+    if (config_size > sizeof(current))
+    {
+        return ATCA_BAD_PARAM;
+    }
+    memset(&counts, 0, sizeof(counts));
+
+    if ((status = atcab_read_bytes_zone(ATCA_ZONE_CONFIG, 0, 0, current, ATCA_BLOCK_SIZE)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+    differing = config_block_differing(current, config_data, 0, config_size, &writable);
+    fresh = (differing * 2 > writable);
+    if (fresh)
+    {
+        //Every word after the first block counts as differing, UserExtra and Selector are zero like on a new part
+        for (i = ATCA_BLOCK_SIZE; i < config_size; i++)
+        {
+            current[i] = (uint8_t)~config_data[i];
+        }
+        current[CONFIG_WRITER_EXTRA_OFFSET] = 0;
+        current[CONFIG_WRITER_EXTRA_OFFSET + 1] = 0;
+    }
+    else if ((status = atcab_read_bytes_zone(ATCA_ZONE_CONFIG, 0, ATCA_BLOCK_SIZE, &current[ATCA_BLOCK_SIZE],
+                                             config_size - ATCA_BLOCK_SIZE)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+
+    for (block = 0; block * ATCA_BLOCK_SIZE < config_size; block++)
+    {
+        differing = config_block_differing(current, config_data, block, config_size, NULL);
+        if (differing == 0)
+        {
+            continue;
+        }
+
+        if (differing >= CONFIG_WRITER_BLOCK_THRESHOLD && config_block_writable(block, config_size))
+        {
+            if ((status = atcab_write_zone(ATCA_ZONE_CONFIG, 0, block, 0,
+                                           &config_data[block * ATCA_BLOCK_SIZE], ATCA_BLOCK_SIZE)) != ATCA_SUCCESS)
+            {
+                return status;
+            }
+            counts.block_writes++;
+            counts.bytes_written += ATCA_BLOCK_SIZE;
+            continue;
+        }
+
+        for (word = block * CONFIG_WORDS_PER_BLOCK; word < (block + 1) * CONFIG_WORDS_PER_BLOCK; word++)
+        {
+            if (!config_word_differs(current, config_data, word, config_size))
+            {
+                continue;
+            }
+            if ((status = atcab_write_zone(ATCA_ZONE_CONFIG, 0, block, word % CONFIG_WORDS_PER_BLOCK,
+                                           &config_data[word * CONFIG_WORD_SIZE], CONFIG_WORD_SIZE)) != ATCA_SUCCESS)
+            {
+                return status;
+            }
+            counts.word_writes++;
+            counts.bytes_written += CONFIG_WORD_SIZE;
+        }
+    }
+
+    //UserExtra, then Selector (UserExtraAdd on the ECC608A)
+    for (i = 0; i < 2; i++)
+    {
+        if (current[CONFIG_WRITER_EXTRA_OFFSET + i] != config_data[CONFIG_WRITER_EXTRA_OFFSET + i])
+        {
+            if ((status = atcab_updateextra(i == 0 ? UPDATE_MODE_USER_EXTRA : UPDATE_MODE_SELECTOR,
+                                            config_data[CONFIG_WRITER_EXTRA_OFFSET + i])) != ATCA_SUCCESS)
+            {
+                return status;
+            }
+            counts.extra_updates++;
+        }
+    }
+
+    if (stats != NULL)
+    {
+        *stats = counts;
+    }
+
+    //A fresh part is written like the library does, the Write responses report the result
+    if (fresh || (counts.word_writes == 0 && counts.block_writes == 0 && counts.extra_updates == 0))
+    {
+        return ATCA_SUCCESS;
+    }
+
+    //One read of the whole zone verifies all writes
+    if ((status = atcab_read_config_zone(current)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+    return config_matches(current, config_data, config_size) ? ATCA_SUCCESS : ATCA_GEN_FAIL;
+}
@@ -0,0 +1,53 @@
+/**
+ * \file
+ * \brief  Configuration zone writer sending only the words that differ
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#ifndef CONFIG_WRITER_H_
+#define CONFIG_WRITER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "cryptoauthlib.h"
+
+//Differing words in a fully writable block from which one 32 byte write replaces the 4 byte writes
+#define CONFIG_WRITER_BLOCK_THRESHOLD   2
+
+//Bytes of the UserExtra and Selector (UserExtraAdd) word, set with UpdateExtra only
+#define CONFIG_WRITER_EXTRA_OFFSET      84
+
+typedef struct
+{
+    uint8_t word_writes;    //4 byte Write commands
+    uint8_t block_writes;   //32 byte Write commands
+    uint8_t extra_updates;  //UpdateExtra commands
+    uint16_t bytes_written; //Configuration bytes sent
+} config_writer_stats;
+
+ATCA_STATUS config_writer_write(const uint8_t *config_data, size_t config_size, config_writer_stats *stats);
+
+#endif /* CONFIG_WRITER_H_ */
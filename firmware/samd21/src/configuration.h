@@ -48,5 +48,17 @@
 //The Maximum wait time is random value between AUTHENTICATION_MIN_MSEC and  AUTHENTICATION_MIN_MSEC + AUTHENTICATION_RANGE_MSEC
 #define AUTHENTICATION_RANGE_MSEC 3000
 
+//Authenticate with the challenge/MAC table the factory station stored in flash, see challenge_table.c,
+//instead of calculating the MAC on the host with symmetric_authenticate()
+#define CHALLENGE_TABLE_MODE 0
+
+//Bytes sent to the display per main loop iteration while the game runs, 0 to send whole frames
+//at once. At the 1MHz display clock each byte takes 8us.
+#define DISPLAY_FLUSH_BUDGET_BYTES 32
+
+//Print the command timings cmd_timing.c learned after the first authentication and the time of every
+//boot stage, for measuring only. Printing takes milliseconds of console time on every boot.
+#define TIMING_DEBUG 0
+
 
 #endif /* CONFIGURATION_H_ */
\ No newline at end of file
@@ -47,16 +47,38 @@
 #define TERMINAL_BUFFER_COLUMNS (1 + TERMINAL_COLUMNS)
 
 
+//! Time the OLED reset pin is held low and the controller is left alone after it, like ssd1306_hard_reset()
+#define CONSOLE_OLED_RESET_USEC 10
+
 // Global variable
 static struct usart_module g_usart_instance;  // The USART module instance
 static OLED1_CREATE_INSTANCE(oled1, OLED1_EXT_HEADER);
 static uint8_t terminal_buffer[TERMINAL_BUFFER_LINES][TERMINAL_BUFFER_COLUMNS];
 char console_log[CONSOLE_LOG_MAX_SIZE];
 
+static void console_oled_clear(void);
+
+//Function to clear the part of the OLED showing the console log
+static void console_oled_clear(void)
+{
+    oled1_init(&oled1);
+    gfx_mono_draw_filled_rect(0, 0, GFX_MONO_LCD_WIDTH, GFX_MONO_LCD_HEIGHT / 2, GFX_PIXEL_CLR);
+    gfx_mono_present();
+}
+
 /**
- * \brief Initializes the console EDBG USART interface.
+ * \brief Initializes the console EDBG USART interface and the OLED.
  */
 void console_init(void)
+{
+    console_uart_init();
+    console_oled_init();
+}
+
+/**
+ * \brief Initializes the console EDBG USART interface.
+ */
+void console_uart_init(void)
 {
     struct usart_config usart_configuration;
 
@@ -69,11 +91,59 @@ void console_init(void)
     usart_configuration.pinmux_pad3 = EDBG_CDC_SERCOM_PINMUX_PAD3;
     stdio_serial_init(&g_usart_instance, EDBG_CDC_MODULE, &usart_configuration);
     usart_enable(&g_usart_instance);
+}
 
-
+/**
+ * \brief Initializes the OLED that shows the console log.
+ */
+void console_oled_init(void)
+{
     gfx_mono_init();
-    oled1_init(&oled1);
-    gfx_mono_draw_filled_rect(0, 0, GFX_MONO_LCD_WIDTH, GFX_MONO_LCD_HEIGHT / 2, GFX_PIXEL_CLR);
+    console_oled_clear();
+}
+
+//Function to advance the OLED initialization without waiting, now_usec times the reset of the controller,
+//returns true once the cleared console is on the display
+bool console_oled_poll(uint32_t now_usec)
+{
+    static uint8_t step;
+    static uint32_t deadline_usec;
+
+    //The reset pin is held low, then the controller is left alone, for CONSOLE_OLED_RESET_USEC each
+    if (step != 0 && step < 3 && (int32_t)(now_usec - deadline_usec) < 0)
+    {
+        return false;
+    }
+
+    switch (step)
+    {
+    case 0:
+        gfx_mono_init_start();
+        break;
+
+    case 1:
+        gfx_mono_init_release();
+        break;
+
+    case 2:
+        //The console is drawn into the cleared frame, which is then sent in the background
+        gfx_mono_init_finish();
+        console_oled_clear();
+        break;
+
+    default:
+        return !gfx_mono_flush();
+    }
+
+    deadline_usec = now_usec + CONSOLE_OLED_RESET_USEC;
+    step++;
+    return false;
+}
+
+//Function to get the USART instance used by the console, for binary transfers
+struct usart_module* console_get_usart(void)
+{
+    return &g_usart_instance;
 }
 
 void print_on_oled(const char *data)
@@ -162,6 +232,8 @@ void print_on_oled(const char *data)
         current_line %= TERMINAL_BUFFER_LINES;
 
     }
+
+    gfx_mono_present();
 }
 
 
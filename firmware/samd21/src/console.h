@@ -29,6 +29,8 @@
 #define CONSOLE_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #define CONSOLE_LOG_MAX_SIZE    (500)
 #define CONSOLE_LOG_ENABLED     1
@@ -64,6 +66,10 @@ extern char console_log[CONSOLE_LOG_MAX_SIZE];
     } while (0)
 
 void console_init(void);
+void console_uart_init(void);
+void console_oled_init(void);
+bool console_oled_poll(uint32_t now_usec);
 void print_on_oled(const char *data);
+struct usart_module* console_get_usart(void);
 
 #endif // CONSOLE_H
@@ -0,0 +1,51 @@
+/**
+ * \file
+ * \brief  Table driven CRC-16 of CryptoAuth command and response packets
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#ifndef CRC16_H_
+#define CRC16_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+//Use a 16 entry table (32 bytes of flash, two lookups per byte) instead of the 256 entry table (512 bytes)
+#ifndef CRC16_NIBBLE_TABLE
+#define CRC16_NIBBLE_TABLE  0
+#endif
+
+//Register value before the first byte
+#define CRC16_INIT          0x0000
+
+//Size of the CRC at the end of a packet
+#define CRC16_SIZE          2
+
+uint16_t crc16_update(uint16_t crc, const uint8_t *data, size_t length);
+void crc16_final(uint16_t crc, uint8_t *crc_le);
+void crc16_calc(const uint8_t *data, size_t length, uint8_t *crc_le);
+
+#endif /* CRC16_H_ */
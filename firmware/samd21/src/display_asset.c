@@ -0,0 +1,170 @@
+/**
+ * \file
+ * \brief  Page-major image assets and their blitter
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <asf.h>
+#include <string.h>
+#include "display_asset.h"
+
+typedef struct
+{
+    const uint8_t *data;    //Next byte of the encoded stream
+    uint8_t remaining;      //Bytes left in the current literal or run
+    bool repeat;            //The current block is a run of one byte
+} da_decoder;
+
+static uint8_t g_page_buf[2][GFX_MONO_LCD_WIDTH];
+static uint8_t g_dest_buf[GFX_MONO_LCD_WIDTH];
+
+static void da_decode(da_decoder *decoder, uint8_t *out, gfx_coord_t length);
+
+
+//Function to decode the next length bytes of an RLE stream, see display_stream.c for the format
+static void da_decode(da_decoder *decoder, uint8_t *out, gfx_coord_t length)
+{
+    uint8_t count;
+    uint8_t control;
+
+    while (length > 0)
+    {
+        if (decoder->remaining == 0)
+        {
+            control = *decoder->data++;
+            decoder->repeat = (control >= 128);
+            decoder->remaining = decoder->repeat ? (control - 125) : (control + 1);
+        }
+
+        count = min(decoder->remaining, length);
+        if (decoder->repeat)
+        {
+            memset(out, *decoder->data, count);
+        }
+        else
+        {
+            memcpy(out, decoder->data, count);
+            decoder->data += count;
+        }
+        decoder->remaining -= count;
+        if (decoder->repeat && (decoder->remaining == 0))
+        {
+            decoder->data++;
+        }
+        out += count;
+        length -= count;
+    }
+}
+
+
+//Function to draw an asset with its top left corner at x, y. Pages are
+//decoded once and written with one page access per display page; pixels
+//outside the asset's page masks are left untouched
+void display_asset_blit(const display_asset *asset, gfx_coord_t x, gfx_coord_t y)
+{
+    da_decoder decoder;
+    const uint8_t *cur;
+    const uint8_t *prev = NULL;
+    uint8_t pages = (asset->height + 7) / 8;
+    uint8_t shift = y % 8;
+    uint8_t first_page = y / 8;
+    uint8_t page;
+    uint8_t index;
+    uint8_t mask;
+    uint8_t value;
+    gfx_coord_t columns;
+    gfx_coord_t column;
+
+    Assert(asset->width <= GFX_MONO_LCD_WIDTH);
+
+    if ((x >= GFX_MONO_LCD_WIDTH) || (y >= GFX_MONO_LCD_HEIGHT))
+    {
+        return;
+    }
+    columns = min(asset->width, GFX_MONO_LCD_WIDTH - x);
+
+    decoder.data = asset->data;
+    decoder.remaining = 0;
+    decoder.repeat = false;
+
+    //With a vertical shift the last source page spills into one more display page
+    for (index = 0; index < pages + (shift ? 1 : 0); index++)
+    {
+        page = first_page + index;
+        if (page >= GFX_MONO_LCD_PAGES)
+        {
+            break;
+        }
+
+        cur = NULL;
+        mask = 0;
+        if (index < pages)
+        {
+            if (asset->flags & DISPLAY_ASSET_RLE)
+            {
+                da_decode(&decoder, g_page_buf[index & 1], asset->width);
+            }
+            else
+            {
+                memcpy(g_page_buf[index & 1], &asset->data[index * asset->width], asset->width);
+            }
+            cur = g_page_buf[index & 1];
+            mask = asset->page_masks[index] << shift;
+        }
+        if (prev && shift)
+        {
+            mask |= asset->page_masks[index - 1] >> (8 - shift);
+        }
+        else
+        {
+            prev = NULL;
+        }
+
+        if ((mask == 0xFF) && !prev)
+        {
+            //Opaque aligned page, no need to read the display contents
+            gfx_mono_put_page((gfx_mono_color_t *)cur, page, x, columns);
+        }
+        else if (mask != 0)
+        {
+            gfx_mono_get_page(g_dest_buf, page, x, columns);
+            for (column = 0; column < columns; column++)
+            {
+                value = 0;
+                if (cur)
+                {
+                    value = cur[column] << shift;
+                }
+                if (prev)
+                {
+                    value |= prev[column] >> (8 - shift);
+                }
+                g_dest_buf[column] = (g_dest_buf[column] & ~mask) | (value & mask);
+            }
+            gfx_mono_put_page(g_dest_buf, page, x, columns);
+        }
+
+        prev = cur;
+    }
+}
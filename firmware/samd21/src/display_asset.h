@@ -0,0 +1,50 @@
+/**
+ * \file
+ * \brief  Page-major image assets and their blitter
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#ifndef DISPLAY_ASSET_H_
+#define DISPLAY_ASSET_H_
+
+#include <stdint.h>
+#include "gfx_mono.h"
+
+//Pixel data is RLE compressed with the display_stream.c scheme
+#define DISPLAY_ASSET_RLE   0x01
+
+//Image generated by gfx_mono/tools/asset_compiler.py
+typedef struct
+{
+    gfx_coord_t width;          //Width in pixels, at most GFX_MONO_LCD_WIDTH
+    gfx_coord_t height;         //Height in pixels
+    uint8_t flags;              //DISPLAY_ASSET_* flags
+    const uint8_t *page_masks;  //Rows of each page belonging to the image, one byte per page
+    const uint8_t *data;        //Page-major pixels, width bytes per page in display byte order
+} display_asset;
+
+void display_asset_blit(const display_asset *asset, gfx_coord_t x, gfx_coord_t y);
+
+#endif /* DISPLAY_ASSET_H_ */
@@ -0,0 +1,42 @@
+/**
+ * \file
+ * \brief  Display assets generated by asset_compiler.py from
+ *         button_legend.pbm
+ *
+ * Do not edit, run asset_compiler.py again instead.
+ */
+
+#include "display_assets.h"
+
+//button_legend.pbm, 128x32 pixels, 160 bytes
+static const uint8_t button_legend_asset_masks[] =
+{
+    0xff, 0xff, 0xff, 0xff,
+};
+
+static const uint8_t button_legend_asset_data[] =
+{
+    0xff, 0x00, 0x83, 0x00, 0x00, 0x0e, 0x80, 0x11, 0x00, 0x0e, 0xa2, 0x00,
+    0x00, 0x0e, 0x80, 0x11, 0x00, 0x0e, 0xa2, 0x00, 0x00, 0x0e, 0x80, 0x11,
+    0x00, 0x0e, 0x9c, 0x00, 0x00, 0xf0, 0x82, 0x00, 0x00, 0xf0, 0x80, 0x90,
+    0x0c, 0x10, 0x00, 0xf0, 0x90, 0x90, 0x10, 0x10, 0x00, 0x10, 0x10, 0xf0,
+    0x10, 0x10, 0x90, 0x00, 0x00, 0xe0, 0x80, 0x10, 0x06, 0xe0, 0x00, 0xf0,
+    0x80, 0x40, 0x20, 0x10, 0x9c, 0x00, 0x00, 0xf0, 0x80, 0x90, 0x08, 0x60,
+    0x00, 0x00, 0x10, 0xf0, 0x10, 0x00, 0x00, 0xe0, 0x80, 0x10, 0x02, 0x20,
+    0x00, 0xf0, 0x80, 0x80, 0x06, 0xf0, 0x00, 0x10, 0x10, 0xf0, 0x10, 0x10,
+    0x8c, 0x00, 0x00, 0x07, 0x81, 0x04, 0x01, 0x00, 0x07, 0x81, 0x04, 0x01,
+    0x00, 0x07, 0x84, 0x00, 0x00, 0x07, 0x92, 0x00, 0x00, 0x03, 0x80, 0x04,
+    0x06, 0x03, 0x00, 0x07, 0x00, 0x01, 0x02, 0x04, 0x9c, 0x00, 0x12, 0x07,
+    0x00, 0x01, 0x02, 0x04, 0x00, 0x00, 0x04, 0x07, 0x04, 0x00, 0x00, 0x03,
+    0x04, 0x04, 0x05, 0x03, 0x00, 0x07, 0x80, 0x00, 0x00, 0x07, 0x80, 0x00,
+    0x00, 0x07, 0x8e, 0x00,
+};
+
+const display_asset button_legend_asset =
+{
+    .width = 128,
+    .height = 32,
+    .flags = DISPLAY_ASSET_RLE,
+    .page_masks = button_legend_asset_masks,
+    .data = button_legend_asset_data,
+};
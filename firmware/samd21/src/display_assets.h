@@ -0,0 +1,17 @@
+/**
+ * \file
+ * \brief  Display assets generated by asset_compiler.py from
+ *         button_legend.pbm
+ *
+ * Do not edit, run asset_compiler.py again instead.
+ */
+
+
+#ifndef DISPLAY_ASSETS_H_
+#define DISPLAY_ASSETS_H_
+
+#include "display_asset.h"
+
+extern const display_asset button_legend_asset;
+
+#endif /* DISPLAY_ASSETS_H_ */
@@ -0,0 +1,307 @@
+/**
+ * \file
+ * \brief  Overlay layers composited over the gfx_mono framebuffer
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <asf.h>
+#include <string.h>
+#include "display_layer.h"
+
+#define OVERLAY_COUNT   (DISPLAY_LAYER_COUNT - 1)
+
+typedef struct
+{
+    uint8_t pixels[GFX_MONO_LCD_FRAMEBUFFER_SIZE];  //Pixel values, page-major like the framebuffer
+    uint8_t opaque[GFX_MONO_LCD_FRAMEBUFFER_SIZE];  //Set for pixels covering the layers below
+    uint8_t dirty_start[GFX_MONO_LCD_PAGES];        //Columns [start, end) of each page changed
+    uint8_t dirty_end[GFX_MONO_LCD_PAGES];          //since the last display_layer_commit()
+    bool visible;
+    bool visibility_changed;                        //Shown or hidden since the last commit
+} display_layer_plane;
+
+static display_layer_plane g_overlays[OVERLAY_COUNT];
+
+static display_layer_plane* dly_get(uint8_t layer);
+static void dly_mark(display_layer_plane *plane, uint8_t page, gfx_coord_t start, gfx_coord_t end);
+static void dly_mark_extent(display_layer_plane *plane);
+static void dly_set_pixel(display_layer_plane *plane, gfx_coord_t x, gfx_coord_t y, bool value);
+static void dly_compose(uint8_t *data, gfx_coord_t page, gfx_coord_t column, gfx_coord_t width);
+
+
+static display_layer_plane* dly_get(uint8_t layer)
+{
+    Assert((layer > DISPLAY_LAYER_BASE) && (layer < DISPLAY_LAYER_COUNT));
+
+    return &g_overlays[layer - 1];
+}
+
+//Function to record changed columns [start, end) of a page
+static void dly_mark(display_layer_plane *plane, uint8_t page, gfx_coord_t start, gfx_coord_t end)
+{
+    if (plane->dirty_start[page] >= plane->dirty_end[page])
+    {
+        plane->dirty_start[page] = start;
+        plane->dirty_end[page] = end;
+    }
+    else
+    {
+        plane->dirty_start[page] = min(plane->dirty_start[page], start);
+        plane->dirty_end[page] = max(plane->dirty_end[page], end);
+    }
+}
+
+//Function to mark every column covered by the layer, used when it is shown or hidden
+static void dly_mark_extent(display_layer_plane *plane)
+{
+    const uint8_t *opaque;
+    gfx_coord_t start;
+    gfx_coord_t end;
+    uint8_t page;
+
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        opaque = &plane->opaque[page * GFX_MONO_LCD_WIDTH];
+        for (start = 0; (start < GFX_MONO_LCD_WIDTH) && !opaque[start]; start++)
+        {
+        }
+        for (end = GFX_MONO_LCD_WIDTH; (end > start) && !opaque[end - 1]; end--)
+        {
+        }
+        if (start < end)
+        {
+            dly_mark(plane, page, start, end);
+        }
+    }
+}
+
+static void dly_set_pixel(display_layer_plane *plane, gfx_coord_t x, gfx_coord_t y, bool value)
+{
+    uint16_t offset = (y / 8) * GFX_MONO_LCD_WIDTH + x;
+    uint8_t mask = 1 << (y % 8);
+
+    if ((x >= GFX_MONO_LCD_WIDTH) || (y >= GFX_MONO_LCD_HEIGHT))
+    {
+        return;
+    }
+
+    plane->opaque[offset] |= mask;
+    if (value)
+    {
+        plane->pixels[offset] |= mask;
+    }
+    else
+    {
+        plane->pixels[offset] &= ~mask;
+    }
+    dly_mark(plane, y / 8, x, x + 1);
+}
+
+//Compose callback of the display driver, draws the visible overlays over an
+//area of the frame about to be sent
+static void dly_compose(uint8_t *data, gfx_coord_t page, gfx_coord_t column, gfx_coord_t width)
+{
+    const display_layer_plane *plane;
+    const uint8_t *pixels;
+    const uint8_t *opaque;
+    gfx_coord_t i;
+    uint8_t layer;
+
+    for (layer = 0; layer < OVERLAY_COUNT; layer++)
+    {
+        plane = &g_overlays[layer];
+        if (!plane->visible)
+        {
+            continue;
+        }
+
+        pixels = &plane->pixels[page * GFX_MONO_LCD_WIDTH + column];
+        opaque = &plane->opaque[page * GFX_MONO_LCD_WIDTH + column];
+        for (i = 0; i < width; i++)
+        {
+            data[i] = (data[i] & ~opaque[i]) | (pixels[i] & opaque[i]);
+        }
+    }
+}
+
+
+//Function to attach the layers to the display driver, overlays start empty and hidden
+void display_layer_init(void)
+{
+    memset(g_overlays, 0, sizeof(g_overlays));
+    gfx_mono_set_compose_callback(dly_compose);
+}
+
+//Function to make a layer fully transparent
+void display_layer_clear(uint8_t layer)
+{
+    display_layer_plane *plane = dly_get(layer);
+
+    dly_mark_extent(plane);
+    memset(plane->pixels, 0, sizeof(plane->pixels));
+    memset(plane->opaque, 0, sizeof(plane->opaque));
+}
+
+//Function to fill a rectangle of a layer, covering the layers below it
+void display_layer_fill_rect(uint8_t layer, gfx_coord_t x, gfx_coord_t y, gfx_coord_t width,
+                             gfx_coord_t height, enum gfx_mono_color color)
+{
+    display_layer_plane *plane = dly_get(layer);
+    gfx_coord_t x2;
+    gfx_coord_t y2;
+    gfx_coord_t column;
+    uint8_t page;
+    uint8_t mask;
+    uint8_t *pixels;
+
+    if ((x >= GFX_MONO_LCD_WIDTH) || (y >= GFX_MONO_LCD_HEIGHT) || (width == 0) || (height == 0))
+    {
+        return;
+    }
+    x2 = min(x + width, GFX_MONO_LCD_WIDTH);
+    y2 = min(y + height, GFX_MONO_LCD_HEIGHT);
+
+    for (page = y / 8; page <= (y2 - 1) / 8; page++)
+    {
+        //Rows of the rectangle within this page
+        mask = 0xFF;
+        if (page == y / 8)
+        {
+            mask &= 0xFF << (y % 8);
+        }
+        if (page == (y2 - 1) / 8)
+        {
+            mask &= 0xFF >> (7 - ((y2 - 1) % 8));
+        }
+
+        pixels = &plane->pixels[page * GFX_MONO_LCD_WIDTH];
+        for (column = x; column < x2; column++)
+        {
+            plane->opaque[page * GFX_MONO_LCD_WIDTH + column] |= mask;
+            switch (color)
+            {
+            case GFX_PIXEL_SET:
+                pixels[column] |= mask;
+                break;
+            case GFX_PIXEL_CLR:
+                pixels[column] &= ~mask;
+                break;
+            default:
+                pixels[column] ^= mask;
+                break;
+            }
+        }
+        dly_mark(plane, page, x, x2);
+    }
+}
+
+//Function to draw a string into a layer, each character cell covers the
+//layers below it like gfx_mono_draw_char() clears it on the display
+void display_layer_draw_string(uint8_t layer, const char *str, gfx_coord_t x, gfx_coord_t y,
+                               const struct font *font)
+{
+    display_layer_plane *plane = dly_get(layer);
+    gfx_coord_t start_x = x;
+    uint8_t char_row_size = (font->width + 7) / 8;
+    uint8_t PROGMEM_PTR_T glyph_data;
+    uint8_t glyph_byte = 0;
+    uint8_t row;
+    uint8_t i;
+
+    for (; *str != '\0'; str++)
+    {
+        if (*str == '\n')
+        {
+            x = start_x;
+            y += font->height + 1;
+            continue;
+        }
+        if (*str == '\r')
+        {
+            continue;
+        }
+
+        glyph_data = font->data.progmem + char_row_size * font->height * ((uint8_t)*str - font->first_char);
+        for (row = 0; row < font->height; row++)
+        {
+            for (i = 0; i < font->width; i++)
+            {
+                if (i % 8 == 0)
+                {
+                    glyph_byte = PROGMEM_READ_BYTE(glyph_data);
+                    glyph_data++;
+                }
+                dly_set_pixel(plane, x + i, y + row, glyph_byte & 0x80);
+                glyph_byte <<= 1;
+            }
+        }
+
+        x += font->width;
+    }
+}
+
+//Function to show or hide a layer without changing its contents
+void display_layer_set_visible(uint8_t layer, bool visible)
+{
+    display_layer_plane *plane = dly_get(layer);
+
+    if (plane->visible != visible)
+    {
+        plane->visible = visible;
+        plane->visibility_changed = true;
+        dly_mark_extent(plane);
+    }
+}
+
+bool display_layer_is_visible(uint8_t layer)
+{
+    return dly_get(layer)->visible;
+}
+
+//Function to report the layer changes to the display driver, so the next
+//gfx_mono_present() composites and sends only the changed areas
+void display_layer_commit(void)
+{
+    display_layer_plane *plane;
+    uint8_t layer;
+    uint8_t page;
+
+    for (layer = 0; layer < OVERLAY_COUNT; layer++)
+    {
+        plane = &g_overlays[layer];
+        for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+        {
+            //Changes to hidden layers do not show; showing or hiding marks their extent
+            if ((plane->visible || plane->visibility_changed) &&
+                (plane->dirty_start[page] < plane->dirty_end[page]))
+            {
+                gfx_mono_invalidate(page, plane->dirty_start[page],
+                                    plane->dirty_end[page] - plane->dirty_start[page]);
+            }
+            plane->dirty_start[page] = 0;
+            plane->dirty_end[page] = 0;
+        }
+        plane->visibility_changed = false;
+    }
+}
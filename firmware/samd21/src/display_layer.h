@@ -0,0 +1,56 @@
+/**
+ * \file
+ * \brief  Overlay layers composited over the gfx_mono framebuffer
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#ifndef DISPLAY_LAYER_H_
+#define DISPLAY_LAYER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gfx_mono.h"
+#include "gfx_mono_text.h"
+
+//The base layer is the gfx_mono framebuffer the game draws into
+#define DISPLAY_LAYER_BASE      0
+
+//Status messages shown over the game
+#define DISPLAY_LAYER_STATUS    1
+
+//Number of layers including the base layer, higher layers are drawn on top
+#define DISPLAY_LAYER_COUNT     2
+
+void display_layer_init(void);
+void display_layer_clear(uint8_t layer);
+void display_layer_fill_rect(uint8_t layer, gfx_coord_t x, gfx_coord_t y, gfx_coord_t width,
+                             gfx_coord_t height, enum gfx_mono_color color);
+void display_layer_draw_string(uint8_t layer, const char *str, gfx_coord_t x, gfx_coord_t y,
+                               const struct font *font);
+void display_layer_set_visible(uint8_t layer, bool visible);
+bool display_layer_is_visible(uint8_t layer);
+void display_layer_commit(void);
+
+#endif /* DISPLAY_LAYER_H_ */
@@ -0,0 +1,756 @@
+/**
+ * \file
+ * \brief  Deferred display list for the gfx_mono drawing primitives
+ *
+ * Drawing commands are recorded instead of being executed immediately. When
+ * the list is executed, commands fully overwritten by a later opaque command
+ * are dropped, adjacent fills of the same color are merged, and every display
+ * page is built once in a local scratch buffer before a single page write.
+ *
+ * The rasterization below mirrors gfx_mono_generic.c and gfx_mono_text.c so
+ * the result is pixel identical to drawing the same commands immediately.
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <asf.h>
+#include <string.h>
+#include "display_list.h"
+
+#define DL_MAX_X    (GFX_MONO_LCD_WIDTH - 1)
+#define DL_MAX_Y    (GFX_MONO_LCD_HEIGHT - 1)
+
+static display_list_cmd g_cmds[DISPLAY_LIST_MAX_COMMANDS];
+static uint8_t g_cmd_count;
+static display_list_stats g_stats;
+
+static display_list_cmd* dl_alloc(uint8_t op, uint8_t color);
+static bool dl_set_bounds(display_list_cmd *cmd, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+static bool dl_is_opaque(const display_list_cmd *cmd);
+static bool dl_covers(const display_list_cmd *outer, const display_list_cmd *inner);
+static bool dl_overlaps(const display_list_cmd *a, const display_list_cmd *b);
+static bool dl_can_merge(const display_list_cmd *a, const display_list_cmd *b);
+static void dl_remove(uint8_t index);
+static void dl_optimize(void);
+static void dl_mask(uint8_t *page_buf, gfx_coord_t column, uint8_t mask, uint8_t color);
+static void dl_plot(uint8_t *page_buf, uint8_t page, gfx_coord_t x, gfx_coord_t y, uint8_t color);
+static void dl_render_fill(uint8_t *page_buf, uint8_t page, gfx_coord_t x1, gfx_coord_t y1,
+                           gfx_coord_t x2, gfx_coord_t y2, uint8_t color);
+static void dl_render_line(uint8_t *page_buf, uint8_t page, const display_list_cmd *cmd);
+static void dl_render_circle(uint8_t *page_buf, uint8_t page, const display_list_cmd *cmd);
+static void dl_render_string(uint8_t *page_buf, uint8_t page, const display_list_cmd *cmd);
+static void dl_render_bitmap(uint8_t *page_buf, uint8_t page, const display_list_cmd *cmd);
+
+
+//Function to get a free command slot, executing the pending list first if it is full
+static display_list_cmd* dl_alloc(uint8_t op, uint8_t color)
+{
+    display_list_cmd *cmd;
+
+    if (g_cmd_count >= DISPLAY_LIST_MAX_COMMANDS)
+    {
+        display_list_execute();
+    }
+
+    cmd = &g_cmds[g_cmd_count];
+    cmd->op = op;
+    cmd->color = color;
+
+    return cmd;
+}
+
+//Function to store the screen area touched by a command, returns false if it is entirely off screen
+static bool dl_set_bounds(display_list_cmd *cmd, int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+    if ((x1 > DL_MAX_X) || (y1 > DL_MAX_Y) || (x2 < 0) || (y2 < 0) || (x1 > x2) || (y1 > y2))
+    {
+        return false;
+    }
+
+    cmd->x1 = (x1 < 0) ? 0 : x1;
+    cmd->y1 = (y1 < 0) ? 0 : y1;
+    cmd->x2 = (x2 > DL_MAX_X) ? DL_MAX_X : x2;
+    cmd->y2 = (y2 > DL_MAX_Y) ? DL_MAX_Y : y2;
+
+    return true;
+}
+
+//A command is opaque when every pixel of its area is overwritten regardless of the previous content
+static bool dl_is_opaque(const display_list_cmd *cmd)
+{
+    switch (cmd->op)
+    {
+    case DISPLAY_LIST_FILL:
+        return cmd->color != GFX_PIXEL_XOR;
+    case DISPLAY_LIST_BITMAP:
+        return true;
+    case DISPLAY_LIST_STRING:
+        //Every character cell is cleared before its glyph is drawn
+        return strchr(cmd->arg.string.text, '\n') == NULL;
+    default:
+        return false;
+    }
+}
+
+static bool dl_covers(const display_list_cmd *outer, const display_list_cmd *inner)
+{
+    return (outer->x1 <= inner->x1) && (outer->x2 >= inner->x2) &&
+           (outer->y1 <= inner->y1) && (outer->y2 >= inner->y2);
+}
+
+static bool dl_overlaps(const display_list_cmd *a, const display_list_cmd *b)
+{
+    return (a->x1 <= b->x2) && (b->x1 <= a->x2) && (a->y1 <= b->y2) && (b->y1 <= a->y2);
+}
+
+//Two opaque fills of the same color can be merged when their union is a rectangle
+static bool dl_can_merge(const display_list_cmd *a, const display_list_cmd *b)
+{
+    if ((a->op != DISPLAY_LIST_FILL) || (b->op != DISPLAY_LIST_FILL) ||
+        (a->color != b->color) || (a->color == GFX_PIXEL_XOR))
+    {
+        return false;
+    }
+
+    if ((a->y1 == b->y1) && (a->y2 == b->y2))
+    {
+        return (a->x1 <= b->x2 + 1) && (b->x1 <= a->x2 + 1);
+    }
+    if ((a->x1 == b->x1) && (a->x2 == b->x2))
+    {
+        return (a->y1 <= b->y2 + 1) && (b->y1 <= a->y2 + 1);
+    }
+
+    return false;
+}
+
+static void dl_remove(uint8_t index)
+{
+    memmove(&g_cmds[index], &g_cmds[index + 1], (g_cmd_count - index - 1) * sizeof(g_cmds[0]));
+    g_cmd_count--;
+}
+
+//Function to merge adjacent fills and drop commands hidden by later opaque commands
+static void dl_optimize(void)
+{
+    uint8_t i, j, k;
+
+    for (j = 1; j < g_cmd_count; j++)
+    {
+        i = j;
+        while (i-- > 0)
+        {
+            if (!dl_can_merge(&g_cmds[i], &g_cmds[j]))
+            {
+                continue;
+            }
+
+            //The earlier fill moves to position j, so nothing in between may touch it
+            for (k = i + 1; (k < j) && !dl_overlaps(&g_cmds[k], &g_cmds[i]); k++)
+            {
+                ;
+            }
+            if (k != j)
+            {
+                continue;
+            }
+
+            g_cmds[j].x1 = min(g_cmds[i].x1, g_cmds[j].x1);
+            g_cmds[j].y1 = min(g_cmds[i].y1, g_cmds[j].y1);
+            g_cmds[j].x2 = max(g_cmds[i].x2, g_cmds[j].x2);
+            g_cmds[j].y2 = max(g_cmds[i].y2, g_cmds[j].y2);
+            dl_remove(i);
+            g_stats.merged++;
+            j--;
+            i = j;
+        }
+    }
+
+    i = 0;
+    while (i < g_cmd_count)
+    {
+        for (j = i + 1; j < g_cmd_count; j++)
+        {
+            if (dl_is_opaque(&g_cmds[j]) && dl_covers(&g_cmds[j], &g_cmds[i]))
+            {
+                break;
+            }
+        }
+
+        if (j < g_cmd_count)
+        {
+            dl_remove(i);
+            g_stats.dropped++;
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+static void dl_mask(uint8_t *page_buf, gfx_coord_t column, uint8_t mask, uint8_t color)
+{
+    switch (color)
+    {
+    case GFX_PIXEL_SET:
+        page_buf[column] |= mask;
+        break;
+    case GFX_PIXEL_CLR:
+        page_buf[column] &= ~mask;
+        break;
+    case GFX_PIXEL_XOR:
+        page_buf[column] ^= mask;
+        break;
+    default:
+        break;
+    }
+}
+
+//Same clipping as gfx_mono_draw_pixel(), limited to the page being built
+static void dl_plot(uint8_t *page_buf, uint8_t page, gfx_coord_t x, gfx_coord_t y, uint8_t color)
+{
+    if ((x > DL_MAX_X) || (y > DL_MAX_Y) || ((y / GFX_MONO_LCD_PIXELS_PER_BYTE) != page))
+    {
+        return;
+    }
+
+    dl_mask(page_buf, x, 1 << (y % GFX_MONO_LCD_PIXELS_PER_BYTE), color);
+}
+
+static void dl_render_fill(uint8_t *page_buf, uint8_t page, gfx_coord_t x1, gfx_coord_t y1,
+                           gfx_coord_t x2, gfx_coord_t y2, uint8_t color)
+{
+    uint8_t first_row = page * GFX_MONO_LCD_PIXELS_PER_BYTE;
+    uint8_t last_row = first_row + GFX_MONO_LCD_PIXELS_PER_BYTE - 1;
+    uint8_t mask;
+
+    if ((y2 < first_row) || (y1 > last_row))
+    {
+        return;
+    }
+
+    mask = 0xFF;
+    if (y1 > first_row)
+    {
+        mask &= 0xFF << (y1 - first_row);
+    }
+    if (y2 < last_row)
+    {
+        mask &= 0xFF >> (last_row - y2);
+    }
+
+    for (; x1 <= x2; x1++)
+    {
+        dl_mask(page_buf, x1, mask, color);
+    }
+}
+
+//Bresenham line, identical to gfx_mono_generic_draw_line()
+static void dl_render_line(uint8_t *page_buf, uint8_t page, const display_list_cmd *cmd)
+{
+    gfx_coord_t x1 = cmd->arg.line.x1;
+    gfx_coord_t y1 = cmd->arg.line.y1;
+    gfx_coord_t x2 = cmd->arg.line.x2;
+    gfx_coord_t y2 = cmd->arg.line.y2;
+    uint8_t i;
+    uint8_t x;
+    uint8_t y;
+    int8_t xinc;
+    int8_t yinc;
+    int8_t dx;
+    int8_t dy;
+    int8_t e;
+
+    if (x1 > x2)
+    {
+        dx = x1;
+        x1 = x2;
+        x2 = dx;
+        dy = y1;
+        y1 = y2;
+        y2 = dy;
+    }
+
+    dx = x2 - x1;
+    dy = y2 - y1;
+
+    x = x1;
+    y = y1;
+
+    if (dx < 0)
+    {
+        xinc = -1;
+        dx = -dx;
+    }
+    else
+    {
+        xinc = 1;
+    }
+
+    if (dy < 0)
+    {
+        yinc = -1;
+        dy = -dy;
+    }
+    else
+    {
+        yinc = 1;
+    }
+
+    if (dx > dy)
+    {
+        e = dy - dx;
+        for (i = 0; i <= dx; i++)
+        {
+            dl_plot(page_buf, page, x, y, cmd->color);
+            if (e >= 0)
+            {
+                e -= dx;
+                y += yinc;
+            }
+            e += dy;
+            x += xinc;
+        }
+    }
+    else
+    {
+        e = dx - dy;
+        for (i = 0; i <= dy; i++)
+        {
+            dl_plot(page_buf, page, x, y, cmd->color);
+            if (e >= 0)
+            {
+                e -= dy;
+                x += xinc;
+            }
+            e += dx;
+            y += yinc;
+        }
+    }
+}
+
+//Midpoint circle, identical to gfx_mono_generic_draw_circle()
+static void dl_render_circle(uint8_t *page_buf, uint8_t page, const display_list_cmd *cmd)
+{
+    gfx_coord_t x = cmd->arg.circle.x;
+    gfx_coord_t y = cmd->arg.circle.y;
+    uint8_t octant_mask = cmd->arg.circle.octant_mask;
+    uint8_t color = cmd->color;
+    gfx_coord_t offset_x;
+    gfx_coord_t offset_y;
+    int16_t error;
+
+    if (cmd->arg.circle.radius == 0)
+    {
+        dl_plot(page_buf, page, x, y, color);
+        return;
+    }
+
+    offset_x = 0;
+    offset_y = cmd->arg.circle.radius;
+    error = 3 - 2 * cmd->arg.circle.radius;
+
+    while (offset_x <= offset_y)
+    {
+        if (octant_mask & GFX_OCTANT0)
+        {
+            dl_plot(page_buf, page, x + offset_y, y - offset_x, color);
+        }
+        if (octant_mask & GFX_OCTANT1)
+        {
+            dl_plot(page_buf, page, x + offset_x, y - offset_y, color);
+        }
+        if (octant_mask & GFX_OCTANT2)
+        {
+            dl_plot(page_buf, page, x - offset_x, y - offset_y, color);
+        }
+        if (octant_mask & GFX_OCTANT3)
+        {
+            dl_plot(page_buf, page, x - offset_y, y - offset_x, color);
+        }
+        if (octant_mask & GFX_OCTANT4)
+        {
+            dl_plot(page_buf, page, x - offset_y, y + offset_x, color);
+        }
+        if (octant_mask & GFX_OCTANT5)
+        {
+            dl_plot(page_buf, page, x - offset_x, y + offset_y, color);
+        }
+        if (octant_mask & GFX_OCTANT6)
+        {
+            dl_plot(page_buf, page, x + offset_x, y + offset_y, color);
+        }
+        if (octant_mask & GFX_OCTANT7)
+        {
+            dl_plot(page_buf, page, x + offset_y, y + offset_x, color);
+        }
+
+        if (error < 0)
+        {
+            error += ((offset_x << 2) + 6);
+        }
+        else
+        {
+            error += (((offset_x - offset_y) << 2) + 10);
+            --offset_y;
+        }
+        ++offset_x;
+    }
+}
+
+//Text in a progmem font, identical to gfx_mono_draw_string()
+static void dl_render_string(uint8_t *page_buf, uint8_t page, const display_list_cmd *cmd)
+{
+    const struct font *font = cmd->arg.string.font;
+    const char *str = cmd->arg.string.text;
+    gfx_coord_t x = cmd->arg.string.x;
+    gfx_coord_t y = cmd->arg.string.y;
+    uint8_t char_row_size;
+    uint8_t rows_left;
+    uint8_t glyph_byte;
+    uint8_t PROGMEM_PTR_T glyph_data;
+    gfx_coord_t inc_x;
+    gfx_coord_t inc_y;
+    uint8_t i;
+
+    char_row_size = (font->width + 7) / 8;
+
+    for (; *str != '\0'; str++)
+    {
+        if (*str == '\n')
+        {
+            x = cmd->arg.string.x;
+            y += font->height + 1;
+            continue;
+        }
+        if (*str == '\r')
+        {
+            continue;
+        }
+
+        //The character cell is cleared first, as done by gfx_mono_draw_char()
+        if ((x <= DL_MAX_X) && (y <= DL_MAX_Y))
+        {
+            dl_render_fill(page_buf, page, x, y, min(x + font->width - 1, DL_MAX_X),
+                           min(y + font->height - 1, DL_MAX_Y), GFX_PIXEL_CLR);
+        }
+
+        glyph_data = font->data.progmem + char_row_size * font->height * ((uint8_t)*str - font->first_char);
+        inc_y = y;
+        rows_left = font->height;
+        do
+        {
+            glyph_byte = 0;
+            inc_x = x;
+            for (i = 0; i < font->width; i++)
+            {
+                if (i % 8 == 0)
+                {
+                    glyph_byte = PROGMEM_READ_BYTE(glyph_data);
+                    glyph_data++;
+                }
+                if (glyph_byte & 0x80)
+                {
+                    dl_plot(page_buf, page, inc_x, inc_y, GFX_PIXEL_SET);
+                }
+                inc_x += 1;
+                glyph_byte <<= 1;
+            }
+            inc_y += 1;
+        }
+        while (--rows_left > 0);
+
+        x += font->width;
+    }
+}
+
+//Bitmap copy, identical to gfx_mono_generic_put_bitmap()
+static void dl_render_bitmap(uint8_t *page_buf, uint8_t page, const display_list_cmd *cmd)
+{
+    const struct gfx_mono_bitmap *bitmap = cmd->arg.bitmap.bitmap;
+    uint8_t bitmap_page = page - (cmd->arg.bitmap.y / GFX_MONO_LCD_PIXELS_PER_BYTE);
+    uint16_t offset = bitmap_page * bitmap->width;
+    gfx_coord_t column;
+
+    for (column = cmd->x1; column <= cmd->x2; column++)
+    {
+        if (bitmap->type == GFX_MONO_BITMAP_PROGMEM)
+        {
+            page_buf[column] = PROGMEM_READ_BYTE(bitmap->data.progmem + offset + column - cmd->x1);
+        }
+        else
+        {
+            page_buf[column] = bitmap->data.pixmap[offset + column - cmd->x1];
+        }
+    }
+}
+
+/**
+ * \brief Starts a new display list, discarding pending commands and statistics.
+ */
+void display_list_begin(void)
+{
+    g_cmd_count = 0;
+    memset(&g_stats, 0, sizeof(g_stats));
+}
+
+void display_list_fill_rect(gfx_coord_t x, gfx_coord_t y, gfx_coord_t width, gfx_coord_t height,
+                            enum gfx_mono_color color)
+{
+    display_list_cmd *cmd = dl_alloc(DISPLAY_LIST_FILL, color);
+
+    if ((width == 0) || (height == 0))
+    {
+        return;
+    }
+
+    if (dl_set_bounds(cmd, x, y, x + width - 1, y + height - 1))
+    {
+        g_cmd_count++;
+        g_stats.recorded++;
+    }
+}
+
+//Outline rectangle, recorded as the two horizontal and two vertical lines of gfx_mono_draw_rect()
+void display_list_rect(gfx_coord_t x, gfx_coord_t y, gfx_coord_t width, gfx_coord_t height,
+                       enum gfx_mono_color color)
+{
+    display_list_fill_rect(x, y, width, 1, color);
+    display_list_fill_rect(x, y + height - 1, width, 1, color);
+    display_list_fill_rect(x, y, 1, height, color);
+    display_list_fill_rect(x + width - 1, y, 1, height, color);
+}
+
+void display_list_line(gfx_coord_t x1, gfx_coord_t y1, gfx_coord_t x2, gfx_coord_t y2,
+                       enum gfx_mono_color color)
+{
+    display_list_cmd *cmd = dl_alloc(DISPLAY_LIST_LINE, color);
+
+    cmd->arg.line.x1 = x1;
+    cmd->arg.line.y1 = y1;
+    cmd->arg.line.x2 = x2;
+    cmd->arg.line.y2 = y2;
+    if (dl_set_bounds(cmd, min(x1, x2), min(y1, y2), max(x1, x2), max(y1, y2)))
+    {
+        g_cmd_count++;
+        g_stats.recorded++;
+    }
+}
+
+void display_list_circle(gfx_coord_t x, gfx_coord_t y, gfx_coord_t radius,
+                         enum gfx_mono_color color, uint8_t octant_mask)
+{
+    display_list_cmd *cmd = dl_alloc(DISPLAY_LIST_CIRCLE, color);
+    bool visible;
+
+    cmd->arg.circle.x = x;
+    cmd->arg.circle.y = y;
+    cmd->arg.circle.radius = radius;
+    cmd->arg.circle.octant_mask = octant_mask;
+
+    //Coordinates wrap at 8 bits, so a circle crossing 255 may reappear anywhere
+    if ((x + radius > UINT8_MAX) || (y + radius > UINT8_MAX))
+    {
+        visible = dl_set_bounds(cmd, 0, 0, DL_MAX_X, DL_MAX_Y);
+    }
+    else
+    {
+        visible = dl_set_bounds(cmd, x - radius, y - radius, x + radius, y + radius);
+    }
+
+    if (visible)
+    {
+        g_cmd_count++;
+        g_stats.recorded++;
+    }
+}
+
+void display_list_string(const char *str, gfx_coord_t x, gfx_coord_t y, const struct font *font)
+{
+    display_list_cmd *cmd;
+    int16_t cur_x = x;
+    int16_t cur_y = y;
+    int16_t max_x = x;
+    const char *c;
+
+    if (*str == '\0')
+    {
+        return;
+    }
+
+    //Strings that cannot be stored are drawn right away, after the pending commands
+    if ((strlen(str) >= DISPLAY_LIST_TEXT_MAX_SIZE) || (font->type != FONT_LOC_PROGMEM))
+    {
+        display_list_execute();
+        gfx_mono_draw_string(str, x, y, font);
+        return;
+    }
+
+    for (c = str; *c != '\0'; c++)
+    {
+        if (*c == '\n')
+        {
+            cur_x = x;
+            cur_y += font->height + 1;
+        }
+        else if (*c != '\r')
+        {
+            cur_x += font->width;
+            max_x = max(max_x, cur_x);
+        }
+    }
+
+    cmd = dl_alloc(DISPLAY_LIST_STRING, GFX_PIXEL_SET);
+    cmd->arg.string.x = x;
+    cmd->arg.string.y = y;
+    cmd->arg.string.font = font;
+    strcpy(cmd->arg.string.text, str);
+
+    if ((max_x > UINT8_MAX) || (cur_y + font->height > UINT8_MAX))
+    {
+        //Coordinates wrap at 8 bits, so the text may reappear anywhere
+        dl_set_bounds(cmd, 0, 0, DL_MAX_X, DL_MAX_Y);
+        g_cmd_count++;
+        g_stats.recorded++;
+    }
+    else if (dl_set_bounds(cmd, x, y, max_x - 1, cur_y + font->height - 1))
+    {
+        g_cmd_count++;
+        g_stats.recorded++;
+    }
+}
+
+void display_list_bitmap(const struct gfx_mono_bitmap *bitmap, gfx_coord_t x, gfx_coord_t y)
+{
+    display_list_cmd *cmd = dl_alloc(DISPLAY_LIST_BITMAP, GFX_PIXEL_SET);
+    int16_t first_row = (y / GFX_MONO_LCD_PIXELS_PER_BYTE) * GFX_MONO_LCD_PIXELS_PER_BYTE;
+    int16_t rows = (bitmap->height / GFX_MONO_LCD_PIXELS_PER_BYTE) * GFX_MONO_LCD_PIXELS_PER_BYTE;
+
+    cmd->arg.bitmap.x = x;
+    cmd->arg.bitmap.y = y;
+    cmd->arg.bitmap.bitmap = bitmap;
+    if ((rows > 0) && (bitmap->width > 0) &&
+        dl_set_bounds(cmd, x, first_row, x + bitmap->width - 1, first_row + rows - 1))
+    {
+        g_cmd_count++;
+        g_stats.recorded++;
+    }
+}
+
+/**
+ * \brief Optimizes and draws the pending commands, one display page at a time.
+ *
+ * Each page is read once from the framebuffer, all commands touching it are
+ * rendered into a scratch buffer and only the changed span is written back.
+ */
+void display_list_execute(void)
+{
+    uint8_t page_buf[GFX_MONO_LCD_WIDTH];
+    uint8_t page;
+    uint8_t first_row;
+    uint8_t first;
+    uint8_t last;
+    uint8_t i;
+    bool touched;
+
+    dl_optimize();
+
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        first_row = page * GFX_MONO_LCD_PIXELS_PER_BYTE;
+        touched = false;
+
+        for (i = 0; i < g_cmd_count; i++)
+        {
+            const display_list_cmd *cmd = &g_cmds[i];
+
+            if ((cmd->y2 < first_row) || (cmd->y1 >= first_row + GFX_MONO_LCD_PIXELS_PER_BYTE))
+            {
+                continue;
+            }
+
+            if (!touched)
+            {
+                gfx_mono_get_page(page_buf, page, 0, GFX_MONO_LCD_WIDTH);
+                touched = true;
+            }
+
+            switch (cmd->op)
+            {
+            case DISPLAY_LIST_FILL:
+                dl_render_fill(page_buf, page, cmd->x1, cmd->y1, cmd->x2, cmd->y2, cmd->color);
+                break;
+            case DISPLAY_LIST_LINE:
+                dl_render_line(page_buf, page, cmd);
+                break;
+            case DISPLAY_LIST_CIRCLE:
+                dl_render_circle(page_buf, page, cmd);
+                break;
+            case DISPLAY_LIST_STRING:
+                dl_render_string(page_buf, page, cmd);
+                break;
+            case DISPLAY_LIST_BITMAP:
+                dl_render_bitmap(page_buf, page, cmd);
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (!touched)
+        {
+            continue;
+        }
+
+        //Only the span that actually changed is sent to the display
+        for (first = 0; first < GFX_MONO_LCD_WIDTH; first++)
+        {
+            if (page_buf[first] != gfx_mono_get_byte(page, first))
+            {
+                break;
+            }
+        }
+        if (first == GFX_MONO_LCD_WIDTH)
+        {
+            continue;
+        }
+        for (last = GFX_MONO_LCD_WIDTH - 1; last > first; last--)
+        {
+            if (page_buf[last] != gfx_mono_get_byte(page, last))
+            {
+                break;
+            }
+        }
+
+        gfx_mono_put_page(&page_buf[first], page, first, last - first + 1);
+        g_stats.bytes_written += last - first + 1;
+    }
+
+    g_cmd_count = 0;
+}
+
+const display_list_stats* display_list_get_stats(void)
+{
+    return &g_stats;
+}
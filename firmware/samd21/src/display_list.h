@@ -0,0 +1,104 @@
+/**
+ * \file
+ * \brief  Deferred display list for the gfx_mono drawing primitives
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#ifndef DISPLAY_LIST_H_
+#define DISPLAY_LIST_H_
+
+#include <stdint.h>
+#include "gfx_mono.h"
+#include "gfx_mono_text.h"
+
+//Number of drawing commands held before the list is executed automatically
+#define DISPLAY_LIST_MAX_COMMANDS   24
+
+//Longest string (including the terminator) a text command can hold
+#define DISPLAY_LIST_TEXT_MAX_SIZE  22
+
+typedef enum
+{
+    DISPLAY_LIST_FILL,
+    DISPLAY_LIST_LINE,
+    DISPLAY_LIST_CIRCLE,
+    DISPLAY_LIST_STRING,
+    DISPLAY_LIST_BITMAP,
+} display_list_op;
+
+typedef struct
+{
+    uint8_t     op;             //One of display_list_op
+    uint8_t     color;          //enum gfx_mono_color of the operation
+    gfx_coord_t x1, y1;         //Top left corner of the area touched, clipped to the screen
+    gfx_coord_t x2, y2;         //Bottom right corner of the area touched, clipped to the screen
+    union
+    {
+        struct
+        {
+            gfx_coord_t x1, y1, x2, y2;
+        } line;
+        struct
+        {
+            gfx_coord_t x, y, radius;
+            uint8_t octant_mask;
+        } circle;
+        struct
+        {
+            gfx_coord_t x, y;
+            const struct font *font;
+            char text[DISPLAY_LIST_TEXT_MAX_SIZE];
+        } string;
+        struct
+        {
+            gfx_coord_t x, y;
+            const struct gfx_mono_bitmap *bitmap;
+        } bitmap;
+    } arg;
+} display_list_cmd;
+
+typedef struct
+{
+    uint16_t recorded;      //Commands recorded since the last reset
+    uint16_t dropped;       //Commands removed because a later opaque command covered them
+    uint16_t merged;        //Fills merged into an adjacent fill of the same color
+    uint16_t bytes_written; //Display bytes sent by display_list_execute()
+} display_list_stats;
+
+void display_list_begin(void);
+void display_list_fill_rect(gfx_coord_t x, gfx_coord_t y, gfx_coord_t width, gfx_coord_t height,
+                            enum gfx_mono_color color);
+void display_list_rect(gfx_coord_t x, gfx_coord_t y, gfx_coord_t width, gfx_coord_t height,
+                       enum gfx_mono_color color);
+void display_list_line(gfx_coord_t x1, gfx_coord_t y1, gfx_coord_t x2, gfx_coord_t y2,
+                       enum gfx_mono_color color);
+void display_list_circle(gfx_coord_t x, gfx_coord_t y, gfx_coord_t radius,
+                         enum gfx_mono_color color, uint8_t octant_mask);
+void display_list_string(const char *str, gfx_coord_t x, gfx_coord_t y, const struct font *font);
+void display_list_bitmap(const struct gfx_mono_bitmap *bitmap, gfx_coord_t x, gfx_coord_t y);
+void display_list_execute(void);
+const display_list_stats* display_list_get_stats(void);
+
+#endif /* DISPLAY_LIST_H_ */
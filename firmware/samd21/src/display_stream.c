@@ -0,0 +1,221 @@
+/**
+ * \file
+ * \brief  Framebuffer streaming over the EDBG console
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <asf.h>
+#include <string.h>
+#include "console.h"
+#include "display_stream.h"
+
+/*
+ * Frame layout, all multi byte fields little endian:
+ *
+ *   DISPLAY_STREAM_FRAME_START
+ *   sequence number (1 byte)
+ *   page mask (1 byte), bit n set when page n follows
+ *   for every page in the mask:
+ *       encoded length (2 bytes)
+ *       RLE encoded page
+ *   XOR of all bytes after DISPLAY_STREAM_FRAME_START (1 byte)
+ *
+ * RLE control byte c: c < 128 copies the next c + 1 bytes, c >= 128 repeats
+ * the next byte c - 125 times.
+ */
+
+#define RLE_MIN_RUN     3
+#define RLE_MAX_RUN     130
+#define RLE_MAX_LITERAL 128
+
+//Longest RLE encoding of one page, a literal control byte for every 128 bytes
+#define PAGE_MAX_ENCODED_SIZE   (GFX_MONO_LCD_WIDTH + (GFX_MONO_LCD_WIDTH + RLE_MAX_LITERAL - 1) / RLE_MAX_LITERAL)
+
+static uint8_t g_last_frame[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+static bool g_last_frame_valid;
+static uint8_t g_sequence;
+static display_stream_stats g_stats;
+
+static void ds_write(const uint8_t *data, uint16_t length, uint8_t *checksum);
+static void ds_get_page(uint8_t *data, uint8_t page);
+
+
+//Function to encode a buffer with the stream RLE, returns the encoded length
+uint16_t display_stream_rle_encode(const uint8_t *data, uint16_t length, uint8_t *out)
+{
+    uint16_t in_pos = 0;
+    uint16_t out_pos = 0;
+    uint16_t literal_start = 0;
+    uint16_t literal_length;
+    uint16_t run;
+
+    while (in_pos < length)
+    {
+        run = 1;
+        while ((in_pos + run < length) && (run < RLE_MAX_RUN) && (data[in_pos + run] == data[in_pos]))
+        {
+            run++;
+        }
+
+        if ((run < RLE_MIN_RUN) && (in_pos + run < length))
+        {
+            in_pos += run;
+            continue;
+        }
+        if (run < RLE_MIN_RUN)
+        {
+            //Trailing bytes too short for a run go out as literals
+            in_pos += run;
+            run = 0;
+        }
+
+        //Flush the literals collected before this run
+        while (literal_start < in_pos)
+        {
+            literal_length = min(in_pos - literal_start, RLE_MAX_LITERAL);
+            out[out_pos++] = (uint8_t)(literal_length - 1);
+            memcpy(&out[out_pos], &data[literal_start], literal_length);
+            out_pos += literal_length;
+            literal_start += literal_length;
+        }
+
+        if (run != 0)
+        {
+            out[out_pos++] = (uint8_t)(run + 125);
+            out[out_pos++] = data[in_pos];
+            in_pos += run;
+            literal_start = in_pos;
+        }
+    }
+
+    return out_pos;
+}
+
+
+//Function to write frame bytes to the console and update the checksum
+static void ds_write(const uint8_t *data, uint16_t length, uint8_t *checksum)
+{
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        *checksum ^= data[i];
+    }
+    usart_write_buffer_wait(console_get_usart(), data, length);
+    g_stats.sent_bytes += length;
+}
+
+
+//Function to read a page as the display shows it, with the layers composed
+//over the back buffer the graphic primitives draw into
+static void ds_get_page(uint8_t *data, uint8_t page)
+{
+    gfx_mono_get_page(data, page, 0, GFX_MONO_LCD_WIDTH);
+    gfx_mono_compose(data, page, 0, GFX_MONO_LCD_WIDTH);
+}
+
+
+//Function to send the display contents to the host, either complete or only
+//the pages changed since the last frame sent
+void display_stream_send(bool key_frame)
+{
+    uint8_t page_data[GFX_MONO_LCD_WIDTH];
+    uint8_t encoded[PAGE_MAX_ENCODED_SIZE];
+    uint8_t header[2];
+    uint8_t page_mask = 0;
+    uint8_t checksum = 0;
+    uint16_t length;
+    uint8_t page;
+    uint8_t start = DISPLAY_STREAM_FRAME_START;
+
+    if (!g_last_frame_valid)
+    {
+        key_frame = true;
+    }
+
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        ds_get_page(page_data, page);
+        if (key_frame || memcmp(page_data, &g_last_frame[page * GFX_MONO_LCD_WIDTH], GFX_MONO_LCD_WIDTH))
+        {
+            page_mask |= (1 << page);
+        }
+    }
+
+    usart_write_buffer_wait(console_get_usart(), &start, 1);
+    g_stats.sent_bytes++;
+    header[0] = g_sequence++;
+    header[1] = page_mask;
+    ds_write(header, sizeof(header), &checksum);
+
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        if (!(page_mask & (1 << page)))
+        {
+            continue;
+        }
+
+        ds_get_page(page_data, page);
+        memcpy(&g_last_frame[page * GFX_MONO_LCD_WIDTH], page_data, GFX_MONO_LCD_WIDTH);
+
+        length = display_stream_rle_encode(page_data, GFX_MONO_LCD_WIDTH, encoded);
+        header[0] = (uint8_t)(length & 0xFF);
+        header[1] = (uint8_t)(length >> 8);
+        ds_write(header, sizeof(header), &checksum);
+        ds_write(encoded, length, &checksum);
+    }
+
+    usart_write_buffer_wait(console_get_usart(), &checksum, 1);
+    g_stats.sent_bytes++;
+    g_stats.raw_bytes += GFX_MONO_LCD_FRAMEBUFFER_SIZE;
+    g_stats.frames++;
+    g_last_frame_valid = true;
+}
+
+
+//Function to be called from the main loop, sends a frame when the host asks for one
+void display_stream_poll(void)
+{
+    uint16_t request;
+
+    if (usart_read_wait(console_get_usart(), &request) != STATUS_OK)
+    {
+        return;
+    }
+
+    if (request == DISPLAY_STREAM_REQ_DELTA)
+    {
+        display_stream_send(false);
+    }
+    else if (request == DISPLAY_STREAM_REQ_KEY)
+    {
+        display_stream_send(true);
+    }
+}
+
+
+const display_stream_stats* display_stream_get_stats(void)
+{
+    return &g_stats;
+}
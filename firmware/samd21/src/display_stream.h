@@ -0,0 +1,56 @@
+/**
+ * \file
+ * \brief  Framebuffer streaming over the EDBG console
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#ifndef DISPLAY_STREAM_H_
+#define DISPLAY_STREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Request byte sent by the host for the pages changed since the last frame
+#define DISPLAY_STREAM_REQ_DELTA    'S'
+
+//Request byte sent by the host for a complete frame
+#define DISPLAY_STREAM_REQ_KEY      'K'
+
+//First byte of every frame sent to the host
+#define DISPLAY_STREAM_FRAME_START  0xA5
+
+typedef struct
+{
+    uint16_t frames;        //Frames sent to the host
+    uint32_t raw_bytes;     //Bytes the frames would have taken as raw complete frames
+    uint32_t sent_bytes;    //Bytes actually sent, including the frame headers
+} display_stream_stats;
+
+void display_stream_poll(void);
+void display_stream_send(bool key_frame);
+uint16_t display_stream_rle_encode(const uint8_t *data, uint16_t length, uint8_t *out);
+const display_stream_stats* display_stream_get_stats(void);
+
+#endif /* DISPLAY_STREAM_H_ */
@@ -0,0 +1,456 @@
+/**
+ * \file
+ * \brief  Factory provisioning driven by a host station over the console UART
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#include "configuration.h"
+
+#ifdef IP_PROTECTION_LOAD_CONFIG
+
+#include <asf.h>
+#include <string.h>
+#include "console.h"
+#include "factory_mode.h"
+#include "provision_device.h"
+#include "boot_sequence.h"
+#include "hal_i2c_dma.h"
+#include "challenge_table.h"
+#include "crc16.h"
+
+/*
+ * Frames, all multi byte fields little endian:
+ *
+ *   station: FACTORY_FRAME_START, command, length (2 bytes), payload,
+ *            XOR of all bytes after FACTORY_FRAME_START
+ *   board:   FACTORY_FRAME_START, command, status, length (2 bytes), payload,
+ *            XOR of all bytes after FACTORY_FRAME_START
+ *
+ * Job payload: configuration size (1 byte), configuration image, key slot
+ * (1 byte), diversified key (32 bytes), nonce input (20 bytes).
+ *
+ * Job answer: failed stage or FACTORY_STAGE_COUNT (1 byte), serial number
+ * (9 bytes), time of every stage in microseconds (4 bytes each), word, block
+ * and extra writes of the configuration (1 byte each), Nonce random output
+ * (32 bytes) and the MAC of TempKey with the key (32 bytes).
+ *
+ * Table payload (CHALLENGE_TABLE_MODE only): offset in the table region
+ * (2 bytes, a multiple of the row size) and up to one row. The row is erased
+ * and written, the answer is the CRC-16 register of the row read back
+ * (2 bytes). The station sends the rows before the job, the header row last,
+ * so a table cut short has no valid header.
+ *
+ * Stages already done on the device, like a locked configuration zone, are
+ * skipped. A board without a valid boot record listens for the station for
+ * FACTORY_LISTEN_USEC before its lock checks, so the station also finishes
+ * a job cut short by a reset before the data zone was locked. Once it is
+ * locked the board is provisioned for good: jobs and table rows are refused
+ * with ATCA_DATA_ZONE_LOCKED. The station derives the key from the serial
+ * number of the INFO answer and checks the MAC, so no button is pressed and
+ * the master key stays on the station.
+ */
+
+#if (CRYPTOAUTH_DEVICE == DEVICE_ATSHA204A)
+#define FACTORY_CONFIG_SIZE         ATCA_SHA_CONFIG_SIZE
+#else
+#define FACTORY_CONFIG_SIZE         ATCA_ECC_CONFIG_SIZE
+#endif
+
+#define FACTORY_JOB_FIXED_SIZE      (1 + 1 + ATCA_KEY_SIZE + NONCE_NUMIN_SIZE)
+#define FACTORY_ANSWER_MAX          (1 + ATCA_SERIAL_NUM_SIZE + 4 * FACTORY_STAGE_COUNT + 3 + 2 * ATCA_KEY_SIZE)
+
+typedef enum
+{
+    FACTORY_FRAME_OK,
+    FACTORY_FRAME_BAD,      //Timeout, too long or checksum mismatch, the station sends it again
+    FACTORY_FRAME_LEAVE,    //SW0 was pressed while waiting for a frame
+} factory_frame_result;
+
+static bool factory_read_byte(uint8_t *data, bool wait);
+static factory_frame_result factory_read_frame(uint8_t *command, uint8_t *payload, uint16_t *length);
+static void factory_write_frame(uint8_t command, uint8_t status, const uint8_t *payload, uint16_t length);
+static uint16_t factory_info(uint8_t *answer, ATCA_STATUS *status);
+static uint16_t factory_job(uint8_t slot, const uint8_t *payload, uint16_t length, uint8_t *answer,
+                            ATCA_STATUS *status);
+#if CHALLENGE_TABLE_MODE
+static uint16_t factory_table(const uint8_t *payload, uint16_t length, uint8_t *answer, ATCA_STATUS *status);
+#endif
+
+//Function to read a byte from the console, without wait gives up after FACTORY_BYTE_TIMEOUT_USEC
+static bool factory_read_byte(uint8_t *data, bool wait)
+{
+    uint32_t start = boot_time_usec();
+    uint16_t value;
+
+    while (usart_read_wait(console_get_usart(), &value) != STATUS_OK)
+    {
+        if (!wait && boot_time_usec() - start > FACTORY_BYTE_TIMEOUT_USEC)
+        {
+            return false;
+        }
+        //SW0 leaves factory mode while no frame is coming
+        if (wait && port_pin_get_input_level(BUTTON_0_PIN) != SW0_INACTIVE)
+        {
+            return false;
+        }
+    }
+
+    *data = (uint8_t)value;
+    return true;
+}
+
+//Function to read the next frame of the station, skipping bytes in front of it
+static factory_frame_result factory_read_frame(uint8_t *command, uint8_t *payload, uint16_t *length)
+{
+    uint8_t header[3];
+    uint8_t checksum = 0;
+    uint8_t data;
+    uint16_t i;
+
+    do
+    {
+        if (!factory_read_byte(&data, true))
+        {
+            return FACTORY_FRAME_LEAVE;
+        }
+    }
+    while (data != FACTORY_FRAME_START);
+
+    for (i = 0; i < sizeof(header); i++)
+    {
+        if (!factory_read_byte(&header[i], false))
+        {
+            return FACTORY_FRAME_BAD;
+        }
+        checksum ^= header[i];
+    }
+
+    *command = header[0];
+    *length = header[1] | (header[2] << 8);
+    if (*length > FACTORY_MAX_PAYLOAD)
+    {
+        return FACTORY_FRAME_BAD;
+    }
+
+    for (i = 0; i < *length; i++)
+    {
+        if (!factory_read_byte(&payload[i], false))
+        {
+            return FACTORY_FRAME_BAD;
+        }
+        checksum ^= payload[i];
+    }
+
+    if (!factory_read_byte(&data, false) || data != checksum)
+    {
+        return FACTORY_FRAME_BAD;
+    }
+    return FACTORY_FRAME_OK;
+}
+
+//Function to send an answer frame to the station
+static void factory_write_frame(uint8_t command, uint8_t status, const uint8_t *payload, uint16_t length)
+{
+    uint8_t header[5] = { FACTORY_FRAME_START, command, status, (uint8_t)(length & 0xFF), (uint8_t)(length >> 8) };
+    uint8_t checksum = 0;
+    uint16_t i;
+
+    for (i = 1; i < sizeof(header); i++)
+    {
+        checksum ^= header[i];
+    }
+    for (i = 0; i < length; i++)
+    {
+        checksum ^= payload[i];
+    }
+
+    usart_write_buffer_wait(console_get_usart(), header, sizeof(header));
+    if (length != 0)
+    {
+        usart_write_buffer_wait(console_get_usart(), payload, length);
+    }
+    usart_write_buffer_wait(console_get_usart(), &checksum, 1);
+}
+
+//Function to answer the serial number, the lock states and the device type
+static uint16_t factory_info(uint8_t *answer, ATCA_STATUS *status)
+{
+    bool is_locked;
+
+    if ((*status = atcab_read_serial_number(answer)) != ATCA_SUCCESS)
+    {
+        return 0;
+    }
+    if ((*status = atcab_is_locked(LOCK_ZONE_CONFIG, &is_locked)) != ATCA_SUCCESS)
+    {
+        return 0;
+    }
+    answer[ATCA_SERIAL_NUM_SIZE] = is_locked;
+    if ((*status = atcab_is_locked(LOCK_ZONE_DATA, &is_locked)) != ATCA_SUCCESS)
+    {
+        return 0;
+    }
+    answer[ATCA_SERIAL_NUM_SIZE + 1] = is_locked;
+    answer[ATCA_SERIAL_NUM_SIZE + 2] = CRYPTOAUTH_DEVICE;
+
+    return ATCA_SERIAL_NUM_SIZE + 3;
+}
+
+//Function to run the stages of a job back to back and answer their timing and the verification MAC
+static uint16_t factory_job(uint8_t slot, const uint8_t *payload, uint16_t length, uint8_t *answer,
+                            ATCA_STATUS *status)
+{
+    const uint8_t *config_data = &payload[1];
+    uint8_t config_size = payload[0];
+    const uint8_t *key;
+    const uint8_t *num_in;
+    uint8_t *stage_usec = &answer[1 + ATCA_SERIAL_NUM_SIZE];
+    uint8_t *writes = &stage_usec[4 * FACTORY_STAGE_COUNT];
+    uint8_t *rand_out = &writes[3];
+    uint8_t *mac = &rand_out[ATCA_KEY_SIZE];
+    config_writer_stats config_stats;
+    bool config_locked;
+    bool data_locked;
+    uint32_t start;
+    uint32_t elapsed;
+    uint8_t stage;
+
+    memset(answer, 0, FACTORY_ANSWER_MAX);
+    if (config_size != FACTORY_CONFIG_SIZE || length != FACTORY_JOB_FIXED_SIZE + config_size)
+    {
+        *status = ATCA_BAD_PARAM;
+        return 0;
+    }
+    if (payload[1 + config_size] != slot)
+    {
+        *status = ATCA_BAD_PARAM;
+        return 0;
+    }
+    key = &payload[2 + config_size];
+    num_in = &key[ATCA_KEY_SIZE];
+
+    if ((*status = atcab_read_serial_number(&answer[1])) != ATCA_SUCCESS ||
+        (*status = atcab_is_locked(LOCK_ZONE_CONFIG, &config_locked)) != ATCA_SUCCESS ||
+        (*status = atcab_is_locked(LOCK_ZONE_DATA, &data_locked)) != ATCA_SUCCESS)
+    {
+        return 0;
+    }
+    if (data_locked)
+    {
+        *status = ATCA_DATA_ZONE_LOCKED;
+        return 0;
+    }
+
+    for (stage = 0; stage < FACTORY_STAGE_COUNT; stage++)
+    {
+        start = boot_time_usec();
+        memset(&config_stats, 0, sizeof(config_stats));
+
+        switch (stage)
+        {
+        case FACTORY_STAGE_CONFIG_WRITE:
+            if (!config_locked)
+            {
+                *status = provision_write_config(config_data, config_size, &config_stats);
+                writes[0] = config_stats.word_writes;
+                writes[1] = config_stats.block_writes;
+                writes[2] = config_stats.extra_updates;
+            }
+            break;
+
+        case FACTORY_STAGE_CONFIG_LOCK:
+            if (!config_locked)
+            {
+                *status = atcab_lock_config_zone();
+            }
+            break;
+
+        case FACTORY_STAGE_KEY:
+            *status = provision_write_key(slot, key);
+            break;
+
+        default:
+            if ((*status = atcab_nonce_rand(num_in, rand_out)) == ATCA_SUCCESS)
+            {
+                *status = atcab_mac(MAC_MODE_BLOCK2_TEMPKEY, slot, NULL, mac);
+            }
+            break;
+        }
+
+        elapsed = boot_time_usec() - start;
+        stage_usec[4 * stage] = (uint8_t)elapsed;
+        stage_usec[4 * stage + 1] = (uint8_t)(elapsed >> 8);
+        stage_usec[4 * stage + 2] = (uint8_t)(elapsed >> 16);
+        stage_usec[4 * stage + 3] = (uint8_t)(elapsed >> 24);
+
+        if (*status != ATCA_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    answer[0] = stage;
+    return FACTORY_ANSWER_MAX;
+}
+
+#if CHALLENGE_TABLE_MODE
+//Function to write one row of the challenge table and answer the CRC of the flash read back
+static uint16_t factory_table(const uint8_t *payload, uint16_t length, uint8_t *answer, ATCA_STATUS *status)
+{
+    uint16_t offset;
+    uint16_t crc;
+    bool data_locked;
+
+    if (length <= 2)
+    {
+        *status = ATCA_BAD_PARAM;
+        return 0;
+    }
+    if ((*status = atcab_is_locked(LOCK_ZONE_DATA, &data_locked)) != ATCA_SUCCESS)
+    {
+        return 0;
+    }
+    if (data_locked)
+    {
+        *status = ATCA_DATA_ZONE_LOCKED;
+        return 0;
+    }
+    offset = payload[0] | (payload[1] << 8);
+    length -= 2;
+
+    if (!challenge_table_write_row(offset, &payload[2], length))
+    {
+        *status = (offset % FLASH_ROW_SIZE != 0 || offset + length > CHALLENGE_TABLE_REGION_SIZE) ?
+                  ATCA_BAD_PARAM : ATCA_GEN_FAIL;
+        return 0;
+    }
+
+    crc = crc16_update(CRC16_INIT, (const uint8_t*)(CHALLENGE_TABLE_ADDRESS + offset), length);
+    answer[0] = (uint8_t)crc;
+    answer[1] = (uint8_t)(crc >> 8);
+    *status = ATCA_SUCCESS;
+    return 2;
+}
+#endif
+
+//Function to check for the station while waiting for SW0
+bool factory_mode_detect(void)
+{
+    uint16_t value;
+
+    return usart_read_wait(console_get_usart(), &value) == STATUS_OK && value == FACTORY_REQ_HELLO;
+}
+
+//Function to wait up to timeout_usec for the hello of a station, whatever SW0 does
+bool factory_mode_listen(uint32_t timeout_usec)
+{
+    uint32_t start = boot_time_usec();
+
+    do
+    {
+        if (factory_mode_detect())
+        {
+            return true;
+        }
+    }
+    while (boot_time_usec() - start < timeout_usec);
+
+    return false;
+}
+
+//Function to serve the station until a job provisioned the device, SW0 or a QUIT frame leave factory mode.
+//A session of the caller is ended, every frame is served in a session of its own.
+//Only a completed job answers ATCA_SUCCESS, leaving without one answers ATCA_NOT_LOCKED.
+ATCA_STATUS factory_mode_run(uint8_t slot)
+{
+    uint8_t payload[FACTORY_MAX_PAYLOAD];
+    uint8_t answer[FACTORY_ANSWER_MAX];
+    ATCA_STATUS answer_status;
+    uint16_t length;
+    uint16_t answer_length;
+    uint8_t command;
+    factory_frame_result result;
+    bool job_done = false;
+    bool leave = false;
+
+    //The device idles while the UART waits for the station, which may take longer than its watchdog
+    hal_i2c_session_end(false);
+
+    //Answer the hello that started factory mode
+    answer[0] = FACTORY_PROTOCOL_VERSION;
+    factory_write_frame(FACTORY_CMD_HELLO, ATCA_SUCCESS, answer, 1);
+
+    while (!leave && (result = factory_read_frame(&command, payload, &length)) != FACTORY_FRAME_LEAVE)
+    {
+        if (result == FACTORY_FRAME_BAD)
+        {
+            continue;
+        }
+
+        answer_status = ATCA_SUCCESS;
+        answer_length = 0;
+        hal_i2c_session_begin();
+
+        switch (command)
+        {
+        case FACTORY_CMD_HELLO:
+            answer[0] = FACTORY_PROTOCOL_VERSION;
+            answer_length = 1;
+            break;
+
+        case FACTORY_CMD_INFO:
+            answer_length = factory_info(answer, &answer_status);
+            break;
+
+        case FACTORY_CMD_JOB:
+            answer_length = factory_job(slot, payload, length, answer, &answer_status);
+            job_done = (answer_status == ATCA_SUCCESS);
+            leave = job_done;
+            break;
+
+#if CHALLENGE_TABLE_MODE
+        case FACTORY_CMD_TABLE:
+            answer_length = factory_table(payload, length, answer, &answer_status);
+            break;
+#endif
+
+        case FACTORY_CMD_QUIT:
+            leave = true;
+            break;
+
+        default:
+            answer_status = ATCA_BAD_OPCODE;
+            break;
+        }
+
+        hal_i2c_session_end(false);
+        factory_write_frame(command, answer_status, answer, answer_length);
+    }
+
+    return job_done ? ATCA_SUCCESS : ATCA_NOT_LOCKED;
+}
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * \file
+ * \brief  Factory provisioning driven by a host station over the console UART
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#ifndef FACTORY_MODE_H_
+#define FACTORY_MODE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cryptoauthlib.h"
+
+//Byte the station sends until the board answers, while the board waits for SW0
+#define FACTORY_REQ_HELLO           'F'
+
+//First byte of every frame in both directions
+#define FACTORY_FRAME_START         0xA6
+
+//Commands of the station
+#define FACTORY_CMD_HELLO           'F'     //No payload, answers the protocol version
+#define FACTORY_CMD_INFO            'I'     //No payload, answers the serial number and lock states
+#define FACTORY_CMD_JOB             'P'     //Configuration image, key and nonce input, see factory_mode.c
+#define FACTORY_CMD_TABLE           'T'     //Table region offset and one row, see factory_mode.c
+#define FACTORY_CMD_QUIT            'Q'     //Leave factory mode
+
+#define FACTORY_PROTOCOL_VERSION    2
+
+//Largest payload of a frame, a table row with its offset
+#define FACTORY_MAX_PAYLOAD         (2 + 256)
+
+//Longest gap between the bytes of a frame before it is dropped
+#define FACTORY_BYTE_TIMEOUT_USEC   100000
+
+//Time device_provision() listens for a station before the lock checks, longer than the 50 ms between its hellos.
+//Only boards without a valid boot record listen, the others are only reached while waiting for SW0.
+#define FACTORY_LISTEN_USEC         60000
+
+//Job stages, timed separately
+enum
+{
+    FACTORY_STAGE_CONFIG_WRITE,
+    FACTORY_STAGE_CONFIG_LOCK,
+    FACTORY_STAGE_KEY,
+    FACTORY_STAGE_VERIFY,
+    FACTORY_STAGE_COUNT
+};
+
+bool factory_mode_detect(void);
+bool factory_mode_listen(uint32_t timeout_usec);
+ATCA_STATUS factory_mode_run(uint8_t slot);
+
+#endif /* FACTORY_MODE_H_ */
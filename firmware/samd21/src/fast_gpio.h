@@ -0,0 +1,93 @@
+/**
+ * \file
+ * \brief  Single-cycle GPIO access through the PORT IOBUS alias
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#ifndef FAST_GPIO_H_
+#define FAST_GPIO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <compiler.h>
+#include <board.h>
+#include "conf_board.h"
+
+//Port group of a PIN_Pxyy pin number, resolved at compile time for constant pins
+#define FAST_GPIO_GROUP(pin)        (&PORT_IOBUS->Group[(pin) / 32])
+
+//Bit of a pin within its port group
+#define FAST_GPIO_MASK(pin)         (1UL << ((pin) % 32))
+
+//Drive an output pin high or low with a single IOBUS store
+#define FAST_GPIO_SET(pin)          (FAST_GPIO_GROUP(pin)->OUTSET.reg = FAST_GPIO_MASK(pin))
+#define FAST_GPIO_CLR(pin)          (FAST_GPIO_GROUP(pin)->OUTCLR.reg = FAST_GPIO_MASK(pin))
+#define FAST_GPIO_WRITE(pin, level) \
+    ((level) ? FAST_GPIO_SET(pin) : FAST_GPIO_CLR(pin))
+
+//Read the input level of a pin with a single IOBUS load, the pin must have its CTRL.SAMPLING bit set
+#define FAST_GPIO_GET(pin)          ((FAST_GPIO_GROUP(pin)->IN.reg & FAST_GPIO_MASK(pin)) != 0)
+
+//The OLED1 buttons are all on port A of the EXT3 header, so one read samples them all
+#define FAST_GPIO_BUTTON_GROUP      (WING_BUTTON_1 / 32)
+#define FAST_GPIO_BUTTON_MASK       (FAST_GPIO_MASK(WING_BUTTON_1) | \
+                                     FAST_GPIO_MASK(WING_BUTTON_2) | \
+                                     FAST_GPIO_MASK(WING_BUTTON_3))
+
+#if ((WING_BUTTON_2 / 32) != FAST_GPIO_BUTTON_GROUP) || ((WING_BUTTON_3 / 32) != FAST_GPIO_BUTTON_GROUP)
+#  error "fast_gpio_read_buttons() needs all wing buttons in the same port group"
+#endif
+
+//Bits returned by fast_gpio_read_buttons()
+#define FAST_GPIO_BUTTON_1          (1u << 0)
+#define FAST_GPIO_BUTTON_2          (1u << 1)
+#define FAST_GPIO_BUTTON_3          (1u << 2)
+
+//Function to sample all wing buttons at once, a set bit means the button is pushed. init_buttons() sets
+//continuous sampling for them, on-demand sampling is not available over the IOBUS
+static inline uint8_t fast_gpio_read_buttons(void)
+{
+    //Buttons are active low
+    uint32_t pressed = ~PORT_IOBUS->Group[FAST_GPIO_BUTTON_GROUP].IN.reg & FAST_GPIO_BUTTON_MASK;
+    uint8_t buttons = 0;
+
+    if (pressed & FAST_GPIO_MASK(WING_BUTTON_1))
+    {
+        buttons |= FAST_GPIO_BUTTON_1;
+    }
+    if (pressed & FAST_GPIO_MASK(WING_BUTTON_2))
+    {
+        buttons |= FAST_GPIO_BUTTON_2;
+    }
+    if (pressed & FAST_GPIO_MASK(WING_BUTTON_3))
+    {
+        buttons |= FAST_GPIO_BUTTON_3;
+    }
+
+    return buttons;
+}
+
+#endif /* FAST_GPIO_H_ */
@@ -0,0 +1,101 @@
+/**
+ * \file
+ * \brief  Erase and write of application flash rows through the NVM controller
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#include <string.h>
+#include <asf.h>
+#include "flash_row.h"
+
+static bool flash_row_command(uint32_t command, uint32_t address);
+
+//Function to run one NVM controller command on the row or page at address
+static bool flash_row_command(uint32_t command, uint32_t address)
+{
+    while (!(NVMCTRL->INTFLAG.reg & NVMCTRL_INTFLAG_READY))
+    {
+        ;
+    }
+
+    //Clear the errors of an earlier command
+    NVMCTRL->STATUS.reg = NVMCTRL_STATUS_MASK;
+
+    //The address register holds 16 bit word addresses
+    NVMCTRL->ADDR.reg = address / 2;
+    NVMCTRL->CTRLA.reg = command | NVMCTRL_CTRLA_CMDEX_KEY;
+
+    while (!(NVMCTRL->INTFLAG.reg & NVMCTRL_INTFLAG_READY))
+    {
+        ;
+    }
+
+    return (NVMCTRL->INTFLAG.reg & NVMCTRL_INTFLAG_ERROR) == 0;
+}
+
+//Function to erase the row at a row aligned address
+bool flash_row_erase(uint32_t address)
+{
+    return flash_row_command(NVMCTRL_CTRLA_CMD_ER, address);
+}
+
+//Function to write the pages of an erased row from a page aligned address, the last page is padded with 0xFF
+bool flash_row_write(uint32_t address, const uint8_t *data, uint16_t length)
+{
+    uint32_t page[FLASH_PAGE_SIZE / sizeof(uint32_t)];
+    volatile uint32_t *flash;
+    uint16_t offset;
+    uint16_t size;
+    uint8_t i;
+
+    //Page writes are started by command only
+    NVMCTRL->CTRLB.reg |= NVMCTRL_CTRLB_MANW;
+
+    for (offset = 0; offset < length; offset += FLASH_PAGE_SIZE)
+    {
+        size = (length - offset < FLASH_PAGE_SIZE) ? (length - offset) : FLASH_PAGE_SIZE;
+        memset(page, 0xFF, sizeof(page));
+        memcpy(page, &data[offset], size);
+
+        if (!flash_row_command(NVMCTRL_CTRLA_CMD_PBC, address + offset))
+        {
+            return false;
+        }
+
+        //The page buffer only takes 16 or 32 bit writes
+        flash = (volatile uint32_t*)(address + offset);
+        for (i = 0; i < sizeof(page) / sizeof(page[0]); i++)
+        {
+            flash[i] = page[i];
+        }
+
+        if (!flash_row_command(NVMCTRL_CTRLA_CMD_WP, address + offset))
+        {
+            return false;
+        }
+    }
+
+    return memcmp((const void*)address, data, length) == 0;
+}
@@ -0,0 +1,943 @@
+/**
+ * \file
+ * \brief  CryptoAuth I2C HAL with DMA command and response transfers
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#include <asf.h>
+#include <string.h>
+#include "hal/atca_hal.h"
+#include "cmd_timing.h"
+#include "hal_i2c_dma.h"
+#include "boot_sequence.h"
+
+/*
+ * Replaces the polled hal_samd21_i2c_asf.c of cryptoauthlib. Command and
+ * response packets are moved between SRAM and the SERCOM DATA register by the
+ * DMAC. The SERCOM length counter (ADDR.LENEN) makes the hardware send the
+ * NACK and STOP conditions after the last byte, so the CPU only starts a
+ * transfer and takes one interrupt when it is done:
+ *
+ *   write: DMAC transfer complete, then SERCOM MB when the last byte is out
+ *   read:  DMAC transfer complete
+ *
+ * An address NACK or a bus error ends the job from the SERCOM MB or ERROR
+ * interrupt instead. Wake, idle and sleep are one byte or less and stay polled.
+ *
+ * The first receive after a command waits for the completion time learned in
+ * cmd_timing.c and then polls with a growing interval, so cryptoauthlib finds
+ * the response on its first read instead of polling every
+ * ATCA_POLLING_FREQUENCY_TIME_MSEC.
+ *
+ * Between hal_i2c_session_begin() and hal_i2c_session_end() the device is
+ * woken once and the idle and sleep requests of the single commands are
+ * dropped. The wake pulse is timed on the SysTick clock, so time spent away
+ * from the bus counts as well, and once HAL_I2C_SESSION_MAX_MSEC have passed
+ * the next wake goes through idle to restart the device watchdog. TempKey is
+ * kept in idle mode.
+ *
+ * Responses are read in two parts, the count byte and then only as many bytes
+ * as it announces, directly into the buffer of the caller. A count out of
+ * range reads the output buffer of the device again from the start. The CRC
+ * is left to the command layer of cryptoauthlib, which checks every response.
+ *
+ * hal_i2c_wake_start() and hal_i2c_wake_poll() split the wake into the pulse
+ * and the response, so the boot sequence can do other work during tWHI.
+ */
+
+//Word address values of the CryptoAuth I2C interface
+#define I2C_WORD_ADDRESS_RESET      0x00
+#define I2C_WORD_ADDRESS_SLEEP      0x01
+#define I2C_WORD_ADDRESS_IDLE       0x02
+#define I2C_WORD_ADDRESS_COMMAND    0x03
+
+//Shortest response, the count byte, a status byte and the CRC
+#define I2C_RESPONSE_MIN_COUNT      4
+
+//Default bus of the Xplained Pro extension headers
+#define I2C_XPRO_BUS                2
+
+//DMAC trigger sources of a SERCOM, instances are numbered RX then TX from SERCOM0
+#define I2C_DMAC_ID_RX(sercom)      (SERCOM0_DMAC_ID_RX + 2 * (sercom))
+#define I2C_DMAC_ID_TX(sercom)      (SERCOM0_DMAC_ID_TX + 2 * (sercom))
+
+#define I2C_BUSSTATE_IDLE           SERCOM_I2CM_STATUS_BUSSTATE(1)
+
+//Longest time of one byte on the bus, 9 bits at 100 kHz with room for clock stretching,
+//DMA transfers time out on the SysTick clock after this per byte and address byte
+#define I2C_DMA_BYTE_TIMEOUT_USEC   200
+
+//7-bit addresses probed by a full scan, the others are reserved by the I2C specification
+#define I2C_SCAN_FIRST              0x08
+#define I2C_SCAN_LAST               0x77
+
+//Polling times of cryptoauthlib, the first receive comes ATCA_POLLING_INIT_TIME_MSEC after the command
+#ifndef ATCA_POLLING_INIT_TIME_MSEC
+#define ATCA_POLLING_INIT_TIME_MSEC 1
+#endif
+#ifndef ATCA_POLLING_FREQUENCY_TIME_MSEC
+#define ATCA_POLLING_FREQUENCY_TIME_MSEC    2
+#endif
+#ifndef ATCA_POLLING_MAX_TIME_MSEC
+#define ATCA_POLLING_MAX_TIME_MSEC  2500
+#endif
+
+typedef struct
+{
+    struct i2c_master_module i2c_master_instance;
+    struct i2c_master_config config;
+    int ref_ct;
+    int bus_index;
+} hal_i2c_dma_bus;
+
+typedef struct
+{
+    struct i2c_master_module *module;
+    hal_i2c_dma_callback_t callback;
+    bool reading;
+    volatile bool busy;
+} hal_i2c_dma_job;
+
+typedef struct
+{
+    bool pending;
+    uint8_t devtype;
+    uint8_t opcode;
+} hal_i2c_dma_command;
+
+typedef struct
+{
+    bool active;            //Between hal_i2c_session_begin() and hal_i2c_session_end()
+    bool awake;             //Device was woken inside the session
+    uint32_t wake_usec;     //boot_time_usec() of the last wake pulse
+    uint32_t wake_pulses;   //Wake pulses sent, in and out of sessions
+} hal_i2c_session;
+
+static hal_i2c_dma_bus g_buses[MAX_I2C_BUSES];
+static hal_i2c_dma_job g_job;
+static hal_i2c_dma_command g_command;
+static hal_i2c_session g_session;
+static volatile enum status_code g_sync_status;
+static bool g_dma_initialized;
+
+COMPILER_ALIGNED(16)
+static DmacDescriptor g_dma_descriptors[HAL_I2C_DMA_CHANNEL + 1];
+
+COMPILER_ALIGNED(16)
+static DmacDescriptor g_dma_writeback[HAL_I2C_DMA_CHANNEL + 1];
+
+static void i2c_dma_init(void);
+static void i2c_dma_finish(enum status_code status);
+static void i2c_dma_sercom_handler(uint8_t instance);
+static enum status_code i2c_dma_start(struct i2c_master_module *module, uint8_t address, uint8_t *data,
+                                      uint8_t length, bool reading, hal_i2c_dma_callback_t callback);
+static enum status_code i2c_dma_transfer_wait(struct i2c_master_module *module, uint8_t address,
+                                              uint8_t *data, uint16_t length, bool reading);
+static enum status_code i2c_dma_bus_enable(hal_i2c_dma_bus *i2c_bus);
+static ATCA_STATUS i2c_write_word_address(ATCAIface iface, uint8_t word_address);
+static ATCA_STATUS i2c_poll_response(ATCAIface iface, uint8_t *rxdata, uint16_t rxlength);
+static enum status_code i2c_read_response(ATCAIface iface, uint8_t *rxdata, uint16_t rxlength);
+
+//Function to reset the DMAC and point it at the descriptor memory
+static void i2c_dma_init(void)
+{
+    system_ahb_clock_set_mask(PM_AHBMASK_DMAC);
+    system_apb_clock_set_mask(SYSTEM_CLOCK_APB_APBB, PM_APBBMASK_DMAC);
+
+    DMAC->CTRL.reg &= ~DMAC_CTRL_DMAENABLE;
+    DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+    while (DMAC->CTRL.reg & DMAC_CTRL_SWRST)
+    {
+    }
+
+    DMAC->BASEADDR.reg = (uint32_t)g_dma_descriptors;
+    DMAC->WRBADDR.reg = (uint32_t)g_dma_writeback;
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+
+    system_interrupt_enable(SYSTEM_INTERRUPT_MODULE_DMA);
+    g_dma_initialized = true;
+}
+
+//Function to stop the running job and report its status, called with the job interrupts masked
+static void i2c_dma_finish(enum status_code status)
+{
+    SercomI2cm *const i2c_hw = &(g_job.module->hw->I2CM);
+
+    DMAC->CHID.reg = DMAC_CHID_ID(HAL_I2C_DMA_CHANNEL);
+    DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    DMAC->CHINTENCLR.reg = DMAC_CHINTFLAG_MASK;
+
+    i2c_hw->INTENCLR.reg = SERCOM_I2CM_INTENCLR_MB | SERCOM_I2CM_INTENCLR_ERROR;
+
+    if (status != STATUS_OK)
+    {
+        //The length counter only ends complete transfers, release the bus here
+        i2c_hw->CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(3);
+        while (i2c_master_is_syncing(g_job.module))
+        {
+        }
+    }
+
+    g_job.busy = false;
+    if (g_job.callback != NULL)
+    {
+        g_job.callback(status);
+    }
+}
+
+void DMAC_Handler(void)
+{
+    uint8_t flags;
+
+    DMAC->CHID.reg = DMAC_CHID_ID(HAL_I2C_DMA_CHANNEL);
+    flags = DMAC->CHINTFLAG.reg;
+    DMAC->CHINTFLAG.reg = flags;
+
+    if (!g_job.busy)
+    {
+        return;
+    }
+
+    if (flags & DMAC_CHINTFLAG_TERR)
+    {
+        i2c_dma_finish(STATUS_ERR_IO);
+    }
+    else if (flags & DMAC_CHINTFLAG_TCMPL)
+    {
+        if (g_job.reading)
+        {
+            i2c_dma_finish(STATUS_OK);
+        }
+        else
+        {
+            //The last byte is still being shifted out, finish on the next MB
+            g_job.module->hw->I2CM.INTENSET.reg = SERCOM_I2CM_INTENSET_MB;
+        }
+    }
+}
+
+static void i2c_dma_sercom_handler(uint8_t instance)
+{
+    SercomI2cm *const i2c_hw = &(g_job.module->hw->I2CM);
+    uint16_t status = i2c_hw->STATUS.reg;
+
+    (void)instance;
+    i2c_hw->INTFLAG.reg = SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_ERROR;
+
+    if (!g_job.busy)
+    {
+        i2c_hw->INTENCLR.reg = SERCOM_I2CM_INTENCLR_MB | SERCOM_I2CM_INTENCLR_ERROR;
+    }
+    else if (status & (SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST))
+    {
+        i2c_dma_finish(STATUS_ERR_PACKET_COLLISION);
+    }
+    else if (status & (SERCOM_I2CM_STATUS_RXNACK | SERCOM_I2CM_STATUS_LENERR))
+    {
+        //Device is asleep or still executing a command
+        i2c_dma_finish(STATUS_ERR_BAD_ADDRESS);
+    }
+    else
+    {
+        i2c_dma_finish(STATUS_OK);
+    }
+}
+
+//Function to set up the DMAC channel and the SERCOM for one transfer and start it
+static enum status_code i2c_dma_start(struct i2c_master_module *module, uint8_t address, uint8_t *data,
+                                      uint8_t length, bool reading, hal_i2c_dma_callback_t callback)
+{
+    SercomI2cm *const i2c_hw = &(module->hw->I2CM);
+    DmacDescriptor *const descriptor = &g_dma_descriptors[HAL_I2C_DMA_CHANNEL];
+    uint8_t sercom_index = _sercom_get_sercom_inst_index(module->hw);
+
+    if (g_job.busy)
+    {
+        return STATUS_BUSY;
+    }
+    if (length == 0)
+    {
+        return STATUS_ERR_INVALID_ARG;
+    }
+    if (!g_dma_initialized)
+    {
+        i2c_dma_init();
+    }
+
+    g_job.module = module;
+    g_job.callback = callback;
+    g_job.reading = reading;
+    g_job.busy = true;
+
+    //Incrementing addresses in a descriptor point past the end of the block
+    descriptor->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_BLOCKACT_NOACT |
+                             (reading ? DMAC_BTCTRL_DSTINC : DMAC_BTCTRL_SRCINC);
+    descriptor->BTCNT.reg = length;
+    if (reading)
+    {
+        descriptor->SRCADDR.reg = (uint32_t)&i2c_hw->DATA.reg;
+        descriptor->DSTADDR.reg = (uint32_t)(data + length);
+    }
+    else
+    {
+        descriptor->SRCADDR.reg = (uint32_t)(data + length);
+        descriptor->DSTADDR.reg = (uint32_t)&i2c_hw->DATA.reg;
+    }
+    descriptor->DESCADDR.reg = 0;
+
+    system_interrupt_enter_critical_section();
+    DMAC->CHID.reg = DMAC_CHID_ID(HAL_I2C_DMA_CHANNEL);
+    DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+    while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST)
+    {
+    }
+    DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) | DMAC_CHCTRLB_TRIGACT_BEAT |
+                        DMAC_CHCTRLB_TRIGSRC(reading ? I2C_DMAC_ID_RX(sercom_index) : I2C_DMAC_ID_TX(sercom_index));
+    DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+    DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL | DMAC_CHINTENSET_TERR;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+    system_interrupt_leave_critical_section();
+
+    //MB is the DMAC trigger when writing, when reading it only shows up on an address NACK
+    _sercom_set_handler(sercom_index, i2c_dma_sercom_handler);
+    i2c_hw->INTFLAG.reg = SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB | SERCOM_I2CM_INTFLAG_ERROR;
+    i2c_hw->INTENSET.reg = SERCOM_I2CM_INTENSET_ERROR | (reading ? SERCOM_I2CM_INTENSET_MB : 0);
+    system_interrupt_enable(_sercom_get_interrupt_vector(module->hw));
+
+    //Writing the address starts the transfer, the length counter ends it
+    i2c_master_dma_set_transfer(module, address, length, reading ? I2C_TRANSFER_READ : I2C_TRANSFER_WRITE);
+
+    return STATUS_OK;
+}
+
+//Function to start writing a packet to a 7-bit address, callback is called when the STOP condition is sent
+enum status_code hal_i2c_dma_write_job(struct i2c_master_module *module, uint8_t address,
+                                       const uint8_t *data, uint8_t length, hal_i2c_dma_callback_t callback)
+{
+    return i2c_dma_start(module, address, (uint8_t*)data, length, false, callback);
+}
+
+//Function to start reading a packet from a 7-bit address, callback is called when the last byte is stored
+enum status_code hal_i2c_dma_read_job(struct i2c_master_module *module, uint8_t address,
+                                      uint8_t *data, uint8_t length, hal_i2c_dma_callback_t callback)
+{
+    return i2c_dma_start(module, address, data, length, true, callback);
+}
+
+bool hal_i2c_dma_is_busy(void)
+{
+    return g_job.busy;
+}
+
+//Function to stop the running job, its callback gets STATUS_ABORTED
+void hal_i2c_dma_abort(void)
+{
+    system_interrupt_enter_critical_section();
+    if (g_job.busy)
+    {
+        i2c_dma_finish(STATUS_ABORTED);
+    }
+    system_interrupt_leave_critical_section();
+}
+
+static void i2c_dma_sync_done(enum status_code status)
+{
+    g_sync_status = status;
+}
+
+//Function to run a DMA transfer and wait for it, used by the blocking cryptoauthlib HAL calls
+static enum status_code i2c_dma_transfer_wait(struct i2c_master_module *module, uint8_t address,
+                                              uint8_t *data, uint16_t length, bool reading)
+{
+    struct i2c_master_packet packet =
+    {
+        .address = address,
+        .data_length = length,
+        .data = data,
+        .ten_bit_address = false,
+        .high_speed = false,
+        .hs_master_code = 0x0,
+    };
+    uint32_t start = boot_time_usec();
+    uint32_t timeout_usec;
+    enum status_code status;
+
+    if (length > HAL_I2C_DMA_MAX_LENGTH)
+    {
+        return reading ? i2c_master_read_packet_wait(module, &packet) :
+               i2c_master_write_packet_wait(module, &packet);
+    }
+
+    //Let the STOP condition of the previous transfer finish
+    while ((module->hw->I2CM.STATUS.reg & SERCOM_I2CM_STATUS_BUSSTATE_Msk) != I2C_BUSSTATE_IDLE &&
+           boot_time_usec() - start < I2C_DMA_BYTE_TIMEOUT_USEC)
+    {
+    }
+
+    if (reading)
+    {
+        status = hal_i2c_dma_read_job(module, address, data, length, i2c_dma_sync_done);
+    }
+    else
+    {
+        status = hal_i2c_dma_write_job(module, address, data, length, i2c_dma_sync_done);
+    }
+    if (status != STATUS_OK)
+    {
+        return status;
+    }
+
+    //The job ends in the DMAC or SERCOM interrupt, the clock only bounds a bus that hangs
+    start = boot_time_usec();
+    timeout_usec = I2C_DMA_BYTE_TIMEOUT_USEC * (length + 1UL);
+    while (hal_i2c_dma_is_busy())
+    {
+        if (boot_time_usec() - start > timeout_usec)
+        {
+            hal_i2c_dma_abort();
+            return STATUS_ERR_TIMEOUT;
+        }
+    }
+
+    return g_sync_status;
+}
+
+static enum status_code i2c_dma_bus_enable(hal_i2c_dma_bus *i2c_bus)
+{
+    Sercom *const sercom_insts[SERCOM_INST_NUM] = SERCOM_INSTS;
+    enum status_code status;
+
+    status = i2c_master_init(&i2c_bus->i2c_master_instance, sercom_insts[i2c_bus->bus_index], &i2c_bus->config);
+    if (status == STATUS_OK)
+    {
+        i2c_master_enable(&i2c_bus->i2c_master_instance);
+    }
+    return status;
+}
+
+ATCA_STATUS hal_i2c_discover_buses(int i2c_buses[], int max_buses)
+{
+    //Only the SERCOM routed to the Xplained Pro extension headers is probed
+    if (max_buses > 0)
+    {
+        i2c_buses[0] = I2C_XPRO_BUS;
+    }
+    return ATCA_SUCCESS;
+}
+
+//Function to find the CryptoAuth devices on a bus with one scan of their known addresses. cfg needs
+//room for HAL_I2C_DISCOVER_MAX entries, each device found gets the default configuration of its type.
+//The ATECCx08A default address is reported as ATECC508A, an Info command tells it from an ATECC608A.
+ATCA_STATUS hal_i2c_discover_devices(int bus_num, ATCAIfaceCfg *cfg, int *found)
+{
+    const uint8_t candidates[HAL_I2C_DISCOVER_MAX] = { 0xC0, 0xC8, 0x6A };
+    const ATCADeviceType devtypes[HAL_I2C_DISCOVER_MAX] = { ATECC508A, ATSHA204A, ATECC608A };
+    ATCAIfaceCfg scan_cfg = cfg_ateccx08a_i2c_default;
+    uint8_t addresses[HAL_I2C_DISCOVER_MAX];
+    uint8_t count;
+    uint8_t i;
+    uint8_t j;
+
+    *found = 0;
+    if (bus_num < 0 || bus_num >= MAX_I2C_BUSES)
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    //The ATSHA204A takes longest to wake, wait for it before probing
+    scan_cfg.atcai2c.bus = (uint8_t)bus_num;
+    scan_cfg.wake_delay = cfg_atsha204a_i2c_default.wake_delay;
+    count = hal_i2c_scan(&scan_cfg, candidates, sizeof(candidates), addresses, sizeof(addresses));
+
+    for (i = 0; i < count; i++)
+    {
+        for (j = 0; candidates[j] != addresses[i]; j++)
+        {
+        }
+        cfg[i] = (devtypes[j] == ATSHA204A) ? cfg_atsha204a_i2c_default : cfg_ateccx08a_i2c_default;
+        cfg[i].devtype = devtypes[j];
+        cfg[i].atcai2c.slave_address = addresses[i];
+        cfg[i].atcai2c.bus = (uint8_t)bus_num;
+    }
+    *found = count;
+
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_i2c_init(void *hal, ATCAIfaceCfg *cfg)
+{
+    int bus = cfg->atcai2c.bus;
+    ATCAHAL_t *phal = (ATCAHAL_t*)hal;
+    hal_i2c_dma_bus *i2c_bus;
+
+    if (bus < 0 || bus >= MAX_I2C_BUSES)
+    {
+        return ATCA_COMM_FAIL;
+    }
+
+    i2c_bus = &g_buses[bus];
+    if (i2c_bus->ref_ct == 0)
+    {
+        i2c_master_get_config_defaults(&i2c_bus->config);
+        if (bus == I2C_XPRO_BUS)
+        {
+            i2c_bus->config.pinmux_pad0 = EXT1_I2C_SERCOM_PINMUX_PAD0;
+            i2c_bus->config.pinmux_pad1 = EXT1_I2C_SERCOM_PINMUX_PAD1;
+        }
+        i2c_bus->config.buffer_timeout = 10000;
+        i2c_bus->config.baud_rate = cfg->atcai2c.baud / 1000;
+        i2c_bus->bus_index = bus;
+
+        if (i2c_dma_bus_enable(i2c_bus) != STATUS_OK)
+        {
+            return ATCA_COMM_FAIL;
+        }
+    }
+
+    i2c_bus->ref_ct++;
+    phal->hal_data = i2c_bus;
+
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_i2c_post_init(ATCAIface iface)
+{
+    (void)iface;
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_i2c_send(ATCAIface iface, uint8_t *txdata, int txlength)
+{
+    ATCAIfaceCfg *cfg = atgetifacecfg(iface);
+    hal_i2c_dma_bus *i2c_bus = (hal_i2c_dma_bus*)atgetifacehaldat(iface);
+
+    //txdata is an ATCAPacket, its _reserved first byte takes the word address like in the ASF HAL of
+    //cryptoauthlib, so the DMA sends the packet where it was built
+    txdata[0] = I2C_WORD_ADDRESS_COMMAND;
+    txlength++;
+
+    if (i2c_dma_transfer_wait(&i2c_bus->i2c_master_instance, cfg->atcai2c.slave_address >> 1,
+                              txdata, txlength, false) != STATUS_OK)
+    {
+        return ATCA_COMM_FAIL;
+    }
+
+    //txdata[1] is the count, txdata[2] the opcode of the command now executing
+    g_command.pending = true;
+    g_command.devtype = (uint8_t)cfg->devtype;
+    g_command.opcode = txdata[2];
+
+    return ATCA_SUCCESS;
+}
+
+//Function to read a response into the caller buffer, reading the output buffer again while its count is out of range
+static enum status_code i2c_read_response(ATCAIface iface, uint8_t *rxdata, uint16_t rxlength)
+{
+    ATCAIfaceCfg *cfg = atgetifacecfg(iface);
+    hal_i2c_dma_bus *i2c_bus = (hal_i2c_dma_bus*)atgetifacehaldat(iface);
+    uint8_t address = cfg->atcai2c.slave_address >> 1;
+    int retries = cfg->rx_retries;
+    enum status_code status;
+    uint8_t count;
+
+    do
+    {
+        //The count byte comes first, a busy device NACKs this one byte read
+        status = i2c_dma_transfer_wait(&i2c_bus->i2c_master_instance, address, rxdata, 1, true);
+        if (status != STATUS_OK)
+        {
+            return status;
+        }
+
+        //Only the response itself is read, straight behind the count byte
+        count = rxdata[0];
+        if (count >= I2C_RESPONSE_MIN_COUNT && count <= rxlength)
+        {
+            return i2c_dma_transfer_wait(&i2c_bus->i2c_master_instance, address, &rxdata[1], count - 1, true);
+        }
+
+        //Start the next read at the count byte again
+        i2c_write_word_address(iface, I2C_WORD_ADDRESS_RESET);
+    }
+    while (retries-- > 0);
+
+    return STATUS_ERR_BAD_DATA;
+}
+
+//Function to wait for the fastest completion seen of the last command and poll for its response
+static ATCA_STATUS i2c_poll_response(ATCAIface iface, uint8_t *rxdata, uint16_t rxlength)
+{
+    ATCAIfaceCfg *cfg = atgetifacecfg(iface);
+    uint32_t elapsed = ATCA_POLLING_INIT_TIME_MSEC * 1000UL;
+    uint32_t expected = cmd_timing_expected_usec(g_command.devtype, g_command.opcode);
+    uint32_t step = CMD_TIMING_MIN_STEP_USEC;
+    //Address byte and NACK of a read the device refuses
+    uint32_t nack_usec = 9 * 1000000UL / cfg->atcai2c.baud + 1;
+    uint16_t polls = 0;
+    enum status_code status;
+
+    expected -= expected >> CMD_TIMING_EARLY_SHIFT;
+    if (expected > elapsed)
+    {
+        atca_delay_us(expected - elapsed);
+        elapsed = expected;
+    }
+
+    while (true)
+    {
+        status = i2c_read_response(iface, rxdata, rxlength);
+        if (status == STATUS_OK)
+        {
+            cmd_timing_record(g_command.devtype, g_command.opcode, elapsed, polls);
+            return ATCA_SUCCESS;
+        }
+
+        //Leave anything else than a busy device to the polling of cryptoauthlib
+        if (status != STATUS_ERR_BAD_ADDRESS || elapsed >= ATCA_POLLING_MAX_TIME_MSEC * 1000UL)
+        {
+            return ATCA_COMM_FAIL;
+        }
+
+        polls++;
+        atca_delay_us(step);
+        elapsed += step + nack_usec;
+        step = (step * 2 < CMD_TIMING_MAX_STEP_USEC) ? step * 2 : CMD_TIMING_MAX_STEP_USEC;
+    }
+}
+
+ATCA_STATUS hal_i2c_receive(ATCAIface iface, uint8_t *rxdata, uint16_t *rxlength)
+{
+    if (g_command.pending)
+    {
+        g_command.pending = false;
+        return i2c_poll_response(iface, rxdata, *rxlength);
+    }
+
+    //i2c_read_response() already reads the output buffer again up to rx_retries times
+    if (i2c_read_response(iface, rxdata, *rxlength) != STATUS_OK)
+    {
+        return ATCA_COMM_FAIL;
+    }
+
+    return ATCA_SUCCESS;
+}
+
+//Function to start a sequence of commands sharing one wake pulse, a session already
+//woken by hal_i2c_wake_poll() is continued
+void hal_i2c_session_begin(void)
+{
+    if (!g_session.active)
+    {
+        g_session.awake = false;
+    }
+    g_session.active = true;
+}
+
+//Function to end a session and put the device in idle or sleep mode once
+ATCA_STATUS hal_i2c_session_end(bool sleep)
+{
+    bool awake = g_session.active && g_session.awake;
+
+    g_session.active = false;
+    g_session.awake = false;
+    if (!awake)
+    {
+        return ATCA_SUCCESS;
+    }
+
+    return sleep ? atcab_sleep() : atcab_idle();
+}
+
+uint32_t hal_i2c_get_wake_pulses(void)
+{
+    return g_session.wake_pulses;
+}
+
+static void i2c_dma_bus_set_speed(hal_i2c_dma_bus *i2c_bus, uint32_t speed)
+{
+    i2c_master_disable(&i2c_bus->i2c_master_instance);
+    i2c_bus->config.baud_rate = speed / 1000;
+    i2c_dma_bus_enable(i2c_bus);
+}
+
+void change_i2c_speed(ATCAIface iface, uint32_t speed)
+{
+    i2c_dma_bus_set_speed((hal_i2c_dma_bus*)atgetifacehaldat(iface), speed);
+}
+
+//Function to find the devices acknowledging on the bus of cfg. candidates holds 8-bit addresses
+//like atcai2c.slave_address, NULL probes the whole 7-bit range. Returns the number of 8-bit
+//addresses stored in found.
+uint8_t hal_i2c_scan(ATCAIfaceCfg *cfg, const uint8_t *candidates, uint8_t candidate_count,
+                     uint8_t *found, uint8_t found_max)
+{
+    ATCAHAL_t hal;
+    hal_i2c_dma_bus *i2c_bus;
+    uint8_t word_address = I2C_WORD_ADDRESS_SLEEP;
+    struct i2c_master_packet packet =
+    {
+        .address = 0x00,
+        .data_length = 0,
+        .data = &word_address,
+        .ten_bit_address = false,
+        .high_speed = false,
+        .hs_master_code = 0x0,
+    };
+    uint16_t total = (candidates != NULL) ? candidate_count : (I2C_SCAN_LAST - I2C_SCAN_FIRST + 1);
+    uint16_t index;
+    uint8_t count = 0;
+
+    if (hal_i2c_init(&hal, cfg) != ATCA_SUCCESS)
+    {
+        return 0;
+    }
+    i2c_bus = (hal_i2c_dma_bus*)hal.hal_data;
+
+    //Only awake CryptoAuth devices acknowledge their address, one wake pulse reaches all of them
+    if (cfg->atcai2c.baud != 100000)
+    {
+        i2c_dma_bus_set_speed(i2c_bus, 100000);
+    }
+    i2c_master_write_packet_wait(&i2c_bus->i2c_master_instance, &packet);
+    if (cfg->atcai2c.baud != 100000)
+    {
+        i2c_dma_bus_set_speed(i2c_bus, cfg->atcai2c.baud);
+    }
+    atca_delay_us(cfg->wake_delay);
+    g_session.wake_pulses++;
+
+    //Address only transfers, a missing device costs one NACKed address byte
+    for (index = 0; index < total && count < found_max; index++)
+    {
+        packet.address = (candidates != NULL) ? (candidates[index] >> 1) : (I2C_SCAN_FIRST + index);
+        packet.data_length = 0;
+        if (i2c_master_write_packet_wait(&i2c_bus->i2c_master_instance, &packet) == STATUS_OK)
+        {
+            found[count++] = packet.address << 1;
+
+            //Put it back to sleep, a session it was awake for has to wake it again
+            packet.data_length = 1;
+            i2c_master_write_packet_wait(&i2c_bus->i2c_master_instance, &packet);
+            g_session.awake = false;
+        }
+    }
+
+    hal_i2c_release(i2c_bus);
+    return count;
+}
+
+//Function to send the wake pulse on the bus of an initialized interface without waiting for the device
+ATCA_STATUS hal_i2c_wake_start(ATCAIfaceCfg *cfg)
+{
+    hal_i2c_dma_bus *i2c_bus;
+    uint8_t data = 0;
+    struct i2c_master_packet packet =
+    {
+        .address = 0x00,
+        .data_length = 0,
+        .data = &data,
+        .ten_bit_address = false,
+        .high_speed = false,
+        .hs_master_code = 0x0,
+    };
+
+    if (cfg->atcai2c.bus >= MAX_I2C_BUSES || g_buses[cfg->atcai2c.bus].ref_ct <= 0)
+    {
+        return ATCA_BAD_PARAM;
+    }
+    i2c_bus = &g_buses[cfg->atcai2c.bus];
+
+    //Nothing is executing after a wake
+    g_command.pending = false;
+
+    if (cfg->atcai2c.baud != 100000)
+    {
+        i2c_dma_bus_set_speed(i2c_bus, 100000);
+    }
+    i2c_master_write_packet_wait(&i2c_bus->i2c_master_instance, &packet);
+    if (cfg->atcai2c.baud != 100000)
+    {
+        i2c_dma_bus_set_speed(i2c_bus, cfg->atcai2c.baud);
+    }
+    g_session.wake_pulses++;
+    g_session.wake_usec = boot_time_usec();
+
+    return ATCA_SUCCESS;
+}
+
+//Function to try once to read the wake response after hal_i2c_wake_start(), the device NACKs
+//until tWHI has passed. A successful wake inside a session is kept for its commands.
+ATCA_STATUS hal_i2c_wake_poll(ATCAIfaceCfg *cfg)
+{
+    hal_i2c_dma_bus *i2c_bus;
+    uint8_t data[4];
+    const uint8_t expected[4] = { 0x04, 0x11, 0x33, 0x43 };
+    struct i2c_master_packet packet =
+    {
+        .address = cfg->atcai2c.slave_address >> 1,
+        .data_length = sizeof(data),
+        .data = data,
+        .ten_bit_address = false,
+        .high_speed = false,
+        .hs_master_code = 0x0,
+    };
+
+    if (cfg->atcai2c.bus >= MAX_I2C_BUSES || g_buses[cfg->atcai2c.bus].ref_ct <= 0)
+    {
+        return ATCA_BAD_PARAM;
+    }
+    i2c_bus = &g_buses[cfg->atcai2c.bus];
+
+    if (i2c_master_read_packet_wait(&i2c_bus->i2c_master_instance, &packet) != STATUS_OK)
+    {
+        return ATCA_RX_NO_RESPONSE;
+    }
+    if (memcmp(data, expected, sizeof(expected)) != 0)
+    {
+        return ATCA_COMM_FAIL;
+    }
+
+    g_session.awake = g_session.active;
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_i2c_wake(ATCAIface iface)
+{
+    ATCAIfaceCfg *cfg = atgetifacecfg(iface);
+    hal_i2c_dma_bus *i2c_bus = (hal_i2c_dma_bus*)atgetifacehaldat(iface);
+    int retries = cfg->rx_retries;
+    uint32_t bdrt = cfg->atcai2c.baud;
+    enum status_code status = STATUS_ERR_TIMEOUT;
+    uint8_t data[4];
+    const uint8_t expected[4] = { 0x04, 0x11, 0x33, 0x43 };
+    struct i2c_master_packet packet =
+    {
+        .address = 0x00,
+        .data_length = 0,
+        .data = data,
+        .ten_bit_address = false,
+        .high_speed = false,
+        .hs_master_code = 0x0,
+    };
+
+    //Nothing is executing after a wake
+    g_command.pending = false;
+
+    if (g_session.active && g_session.awake)
+    {
+        if (boot_time_usec() - g_session.wake_usec < HAL_I2C_SESSION_MAX_MSEC * 1000UL)
+        {
+            return ATCA_SUCCESS;
+        }
+        //The watchdog only restarts on a wake from idle or sleep
+        i2c_write_word_address(iface, I2C_WORD_ADDRESS_IDLE);
+        g_session.awake = false;
+    }
+
+    //Holding SDA low for tWLO at 100 kHz wakes the device
+    if (bdrt != 100000)
+    {
+        change_i2c_speed(iface, 100000);
+    }
+    i2c_master_write_packet_wait(&i2c_bus->i2c_master_instance, &packet);
+    g_session.wake_usec = boot_time_usec();
+    atca_delay_us(cfg->wake_delay);
+
+    packet.address = cfg->atcai2c.slave_address >> 1;
+    packet.data_length = sizeof(data);
+    while (retries-- > 0 && status != STATUS_OK)
+    {
+        status = i2c_master_read_packet_wait(&i2c_bus->i2c_master_instance, &packet);
+    }
+
+    if (bdrt != 100000)
+    {
+        change_i2c_speed(iface, bdrt);
+    }
+
+    g_session.wake_pulses++;
+    if (status != STATUS_OK || memcmp(data, expected, sizeof(expected)) != 0)
+    {
+        return ATCA_COMM_FAIL;
+    }
+
+    g_session.awake = g_session.active;
+    return ATCA_SUCCESS;
+}
+
+static ATCA_STATUS i2c_write_word_address(ATCAIface iface, uint8_t word_address)
+{
+    ATCAIfaceCfg *cfg = atgetifacecfg(iface);
+    hal_i2c_dma_bus *i2c_bus = (hal_i2c_dma_bus*)atgetifacehaldat(iface);
+    struct i2c_master_packet packet =
+    {
+        .address = cfg->atcai2c.slave_address >> 1,
+        .data_length = 1,
+        .data = &word_address,
+        .ten_bit_address = false,
+        .high_speed = false,
+        .hs_master_code = 0x0,
+    };
+
+    if (i2c_master_write_packet_wait(&i2c_bus->i2c_master_instance, &packet) != STATUS_OK)
+    {
+        return ATCA_COMM_FAIL;
+    }
+
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS hal_i2c_idle(ATCAIface iface)
+{
+    //Deferred to hal_i2c_session_end()
+    if (g_session.active && g_session.awake)
+    {
+        return ATCA_SUCCESS;
+    }
+    return i2c_write_word_address(iface, I2C_WORD_ADDRESS_IDLE);
+}
+
+ATCA_STATUS hal_i2c_sleep(ATCAIface iface)
+{
+    if (g_session.active && g_session.awake)
+    {
+        return ATCA_SUCCESS;
+    }
+    return i2c_write_word_address(iface, I2C_WORD_ADDRESS_SLEEP);
+}
+
+ATCA_STATUS hal_i2c_release(void *hal_data)
+{
+    hal_i2c_dma_bus *i2c_bus = (hal_i2c_dma_bus*)hal_data;
+
+    if (i2c_bus != NULL && i2c_bus->ref_ct > 0 && --i2c_bus->ref_ct == 0)
+    {
+        hal_i2c_dma_abort();
+        i2c_master_reset(&i2c_bus->i2c_master_instance);
+    }
+
+    return ATCA_SUCCESS;
+}
@@ -0,0 +1,72 @@
+/**
+ * \file
+ * \brief  CryptoAuth I2C HAL with DMA command and response transfers
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+
+#ifndef HAL_I2C_DMA_H_
+#define HAL_I2C_DMA_H_
+
+#include <asf.h>
+#include "cryptoauthlib.h"
+
+//Largest transfer the SERCOM length counter can handle, longer packets are sent polled
+#define HAL_I2C_DMA_MAX_LENGTH  255
+
+//DMAC channel used for I2C transfers
+#define HAL_I2C_DMA_CHANNEL     0
+
+//Number of SERCOM instances usable as CryptoAuth buses
+#define MAX_I2C_BUSES           6
+
+//Devices hal_i2c_discover_devices() can find on a bus, one per address it probes
+#define HAL_I2C_DISCOVER_MAX    3
+
+//Longest time a session keeps the device awake before an idle and wake cycle
+//restarts its watchdog, half the shortest tWATCHDOG of the ATSHA204A
+#define HAL_I2C_SESSION_MAX_MSEC    350
+
+//Called from interrupt context when a DMA job has finished
+typedef void (*hal_i2c_dma_callback_t)(enum status_code status);
+
+enum status_code hal_i2c_dma_write_job(struct i2c_master_module *module, uint8_t address,
+                                       const uint8_t *data, uint8_t length, hal_i2c_dma_callback_t callback);
+enum status_code hal_i2c_dma_read_job(struct i2c_master_module *module, uint8_t address,
+                                      uint8_t *data, uint8_t length, hal_i2c_dma_callback_t callback);
+bool hal_i2c_dma_is_busy(void);
+void hal_i2c_dma_abort(void);
+
+void hal_i2c_session_begin(void);
+ATCA_STATUS hal_i2c_session_end(bool sleep);
+uint32_t hal_i2c_get_wake_pulses(void);
+ATCA_STATUS hal_i2c_wake_start(ATCAIfaceCfg *cfg);
+ATCA_STATUS hal_i2c_wake_poll(ATCAIfaceCfg *cfg);
+uint8_t hal_i2c_scan(ATCAIfaceCfg *cfg, const uint8_t *candidates, uint8_t candidate_count,
+                     uint8_t *found, uint8_t found_max);
+
+void change_i2c_speed(ATCAIface iface, uint32_t speed);
+
+#endif /* HAL_I2C_DMA_H_ */
@@ -34,24 +34,27 @@
 
 struct adc_module g_adc_instance;
 struct adc_config g_config_adc;
-static uint16_t calculate_adc(enum adc_positive_input adc_input);
 static void configure_adc(void);
+static void start_adc(enum adc_positive_input adc_input);
 
-//Function to calculate the ADC value
-uint16_t calculate_adc(enum adc_positive_input adc_input)
+//Analog sources mixed into the seed, one byte each
+static const enum adc_positive_input seed_inputs[] =
+{
+    ADC_POSITIVE_INPUT_TEMP,
+    ADC_POSITIVE_INPUT_SCALEDCOREVCC,
+    ADC_POSITIVE_INPUT_SCALEDIOVCC,
+    ADC_POSITIVE_INPUT_BANDGAP,
+};
+
+static uint8_t g_seed_conversions;   //Conversions started, 0 before the ADC is configured
+static uint32_t g_rand_seed;
+static bool g_seeded;
+
+//Function to start a conversion of the ADC
+static void start_adc(enum adc_positive_input adc_input)
 {
-    uint16_t result;
-
     adc_set_positive_input(&g_adc_instance, adc_input);
     adc_start_conversion(&g_adc_instance);
-    do
-    {
-        /* Wait for conversion to be done and read out result */
-    }
-    while (adc_read(&g_adc_instance, &result) == STATUS_BUSY);
-    adc_flush(&g_adc_instance);
-
-    return result;
 }
 
 //Function to initialize and enable the ADC
@@ -66,27 +69,49 @@ void configure_adc(void)
     adc_enable(&g_adc_instance);
 }
 
-//Function that calculates the ADC value from different analog sources and updates that value as Seed for the random number
-void random_seed_init(void)
+//Function to advance the seed calculation without waiting for the ADC, returns true once
+//the ADC values from the different analog sources are the seed for the random number
+bool random_seed_poll(void)
 {
     uint16_t result;
-    uint32_t rand_seed = 0;
 
-    configure_adc();
+    if (g_seeded)
+    {
+        return true;
+    }
 
-    result = calculate_adc(ADC_POSITIVE_INPUT_TEMP);
-    rand_seed |= (uint32_t)(result & 0x00FF) << 0;
+    if (g_seed_conversions == 0)
+    {
+        configure_adc();
+        start_adc(seed_inputs[g_seed_conversions++]);
+        return false;
+    }
 
-    result = calculate_adc(ADC_POSITIVE_INPUT_SCALEDCOREVCC);
-    rand_seed |= (uint32_t)(result & 0x00FF) << 8;
+    if (adc_read(&g_adc_instance, &result) == STATUS_BUSY)
+    {
+        return false;
+    }
+    adc_flush(&g_adc_instance);
+    g_rand_seed |= (uint32_t)(result & 0x00FF) << (8 * (g_seed_conversions - 1));
 
-    result = calculate_adc(ADC_POSITIVE_INPUT_SCALEDIOVCC);
-    rand_seed |= (uint32_t)(result & 0x00FF) << 16;
+    if (g_seed_conversions < sizeof(seed_inputs) / sizeof(seed_inputs[0]))
+    {
+        start_adc(seed_inputs[g_seed_conversions++]);
+        return false;
+    }
 
-    result = calculate_adc(ADC_POSITIVE_INPUT_BANDGAP);
-    rand_seed |= (uint32_t)(result & 0x00FF) << 24;
+    srand(g_rand_seed);
+    g_seeded = true;
+    return true;
+}
 
-    srand(rand_seed);
+//Function that calculates the ADC value from different analog sources and updates that value as Seed for the random number
+void random_seed_init(void)
+{
+    while (!random_seed_poll())
+    {
+        ;
+    }
 }
 
 //Function to calculate 20 byte random number from host
@@ -29,8 +29,10 @@
 #define HOST_RANDOM_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 void random_seed_init(void);
+bool random_seed_poll(void);
 void host_generate_random_number(uint8_t *rand_num);
 
 #endif /* HOST_RANDOM_H_ */
\ No newline at end of file
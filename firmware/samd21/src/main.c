@@ -36,14 +36,55 @@
 #include "application.h"
 #include "led_patterns.h"
 #include "main.h"
+#include "cmd_timing.h"
+#include "hal_i2c_dma.h"
+#include "boot_sequence.h"
+#include "challenge_table.h"
 
+//Longest wait for the wake response of the early wake pulse, the commands wake the device again after it
+#define BOOT_WAKE_TIMEOUT_USEC  5000
+
+//Boot stages, a stage only runs once the stages in its dependency mask are done
+enum
+{
+    BOOT_CRYPTOAUTH,
+    BOOT_CONSOLE,
+    BOOT_OLED,
+    BOOT_SEED,
+    BOOT_PROVISION,
+    BOOT_AUTHENTICATE,
+    BOOT_APPLICATION,
+    BOOT_STAGE_COUNT
+};
 
 static ATCA_STATUS cryptoauthlib_init(void);
+static ATCAIfaceCfg* cryptoauthlib_cfg(void);
+static bool boot_cryptoauth_step(void);
+static bool boot_console_step(void);
+static bool boot_oled_step(void);
+static bool boot_provision_step(void);
+static bool boot_authenticate_step(void);
+static bool boot_application_step(void);
 
 volatile uint32_t g_ticks_msec = 0;          //!< Tracks elapsed time in milliseconds
-volatile uint32_t g_auth_interval_msec = 1;  //!< Interval until next authentication check in milliseconds
+volatile uint32_t g_auth_interval_msec = 0;  //!< Interval until next authentication check in milliseconds
 volatile static bool g_do_auth = false;      //!< Indicates the authentication sequence should be performed
 
+static boot_stage g_boot_stages[BOOT_STAGE_COUNT] =
+{
+    [BOOT_CRYPTOAUTH]   = { .name = "cryptoauth",   .step = boot_cryptoauth_step },
+    [BOOT_CONSOLE]      = { .name = "console",      .step = boot_console_step },
+    [BOOT_OLED]         = { .name = "oled",         .step = boot_oled_step },
+    [BOOT_SEED]         = { .name = "seed",         .step = random_seed_poll },
+    [BOOT_PROVISION]    = { .name = "provision",    .step = boot_provision_step,
+                            .depends = BOOT_STAGE_BIT(BOOT_CRYPTOAUTH) | BOOT_STAGE_BIT(BOOT_CONSOLE) |
+                                       BOOT_STAGE_BIT(BOOT_OLED) },
+    [BOOT_AUTHENTICATE] = { .name = "authenticate", .step = boot_authenticate_step,
+                            .depends = BOOT_STAGE_BIT(BOOT_PROVISION) | BOOT_STAGE_BIT(BOOT_SEED) },
+    [BOOT_APPLICATION]  = { .name = "application",  .step = boot_application_step,
+                            .depends = BOOT_STAGE_BIT(BOOT_AUTHENTICATE) },
+};
+
 
 //Function to get the master secret key .
 void get_master_key(uint8_t *master_key)
@@ -66,8 +107,10 @@ void get_master_key(uint8_t *master_key)
 //also performs the led blinking operation
 void SysTick_Handler(void)
 {
+    boot_sequence_tick();
     g_ticks_msec++;
-    if (g_ticks_msec % g_auth_interval_msec == 0)
+    //SysTick starts before the BOOT_SEED stage, the authenticate stage draws the first interval after it
+    if (g_auth_interval_msec != 0 && g_ticks_msec % g_auth_interval_msec == 0)
     {
         g_do_auth = true;
         g_ticks_msec = 0;
@@ -95,23 +138,136 @@ static ATCA_STATUS cryptoauthlib_init(void)
     return status;
 }
 
+//Function to get the interface configuration of the selected device
+static ATCAIfaceCfg* cryptoauthlib_cfg(void)
+{
+    #if (CRYPTOAUTH_DEVICE == DEVICE_ATSHA204A)
+    return &cfg_atsha204a_i2c_default;
+    #else
+    return &cfg_ateccx08a_i2c_default;
+    #endif
+}
+
+//Boot stage initializing CryptoAuthLib and waking the device, which starts up while the other stages run
+static bool boot_cryptoauth_step(void)
+{
+    static uint32_t wake_usec;
+    ATCA_STATUS status;
+
+    if (g_boot_stages[BOOT_CRYPTOAUTH].steps == 1)
+    {
+        if (cryptoauthlib_init() != ATCA_SUCCESS)
+        {
+            return true;
+        }
+
+        //The provisioning or the first authentication continues this session
+        hal_i2c_session_begin();
+        if (hal_i2c_wake_start(cryptoauthlib_cfg()) != ATCA_SUCCESS)
+        {
+            return true;
+        }
+        wake_usec = boot_time_usec();
+        return false;
+    }
+
+    status = hal_i2c_wake_poll(cryptoauthlib_cfg());
+    return status != ATCA_RX_NO_RESPONSE || boot_time_usec() - wake_usec > BOOT_WAKE_TIMEOUT_USEC;
+}
+
+//Boot stage initializing the EDBG Port for the output log
+static bool boot_console_step(void)
+{
+    console_uart_init();
+    return true;
+}
+
+//Boot stage initializing the OLED for the output log, the other stages run during its reset and first frame
+static bool boot_oled_step(void)
+{
+    return console_oled_poll(boot_time_usec());
+}
+
+//Boot stage provisioning the device with the configuration and shared secret data
+static bool boot_provision_step(void)
+{
+#if IP_PROTECTION_LOAD_CONFIG
+    if (device_provision(CRYPTOAUTH_DEVICE_AUTH_KEY_SLOT) != ATCA_SUCCESS)
+    {
+        debug_print("%s", "Provision failed...");
+        debug_print("%s\r\n", "Check device and press RESET");
+    }
+#endif
+    return true;
+}
+
+//Boot stage repeating the authentication until it passes
+static bool boot_authenticate_step(void)
+{
+    if (g_boot_stages[BOOT_AUTHENTICATE].steps == 1)
+    {
+        //Initialize the time for the authentication to perform
+        g_auth_interval_msec = (rand() % AUTHENTICATION_RANGE_MSEC) + AUTHENTICATION_MIN_MSEC;
+
+        //Forcing to do Authentication at the start
+        g_do_auth = true;
+    }
+
+    return authenticate_application() == AUTHENTICATED;
+}
+
+//Boot stage starting the application once the authentication passed
+static bool boot_application_step(void)
+{
+    printf("%s\r\n", "Authentication succeeded");
+#if TIMING_DEBUG
+    cmd_timing_print_stats();
+#endif
 
+    //Initialize the Application
+    init_display();
+    return true;
+}
 
 //Function to be called by application at random interval to perform authentication
 state authenticate_application(void)
 {
     static state auth_status = NOT_AUTHENTICATED;
+#if CHALLENGE_TABLE_MODE
+    static bool table_usable = true;
+#endif
     uint8_t master_key[ATCA_KEY_SIZE];
     uint8_t host_nonce[NONCE_NUMIN_SIZE];
+    ATCA_STATUS status = ATCA_GEN_FAIL;
 
     if (!g_do_auth)
     {
         return auth_status;
     }
 
-    get_master_key(master_key);
-    host_generate_random_number(host_nonce);
-    if (symmetric_authenticate(CRYPTOAUTH_DEVICE_AUTH_KEY_SLOT, master_key, host_nonce) == ATCA_SUCCESS)
+    //Nonce, serial number read and MAC share one wake pulse
+    hal_i2c_session_begin();
+#if CHALLENGE_TABLE_MODE
+    if (table_usable)
+    {
+        status = challenge_table_authenticate(CRYPTOAUTH_DEVICE_AUTH_KEY_SLOT);
+        if (status == ATCA_INVALID_ID)
+        {
+            //A missing, empty, foreign or forged table never passes, the MAC is calculated on the host instead
+            debug_print("%s\r\n", "No challenge table for this device, calculating the MAC");
+            table_usable = false;
+        }
+    }
+    if (!table_usable)
+#endif
+    {
+        get_master_key(master_key);
+        host_generate_random_number(host_nonce);
+        status = symmetric_authenticate(CRYPTOAUTH_DEVICE_AUTH_KEY_SLOT, master_key, host_nonce);
+    }
+    hal_i2c_session_end(false);
+
+    if (status == ATCA_SUCCESS)
     {
         auth_status = AUTHENTICATED;
         update_led_pattern(success_pattern);
@@ -137,41 +293,15 @@ int main(void)
     // Enable interrupts
     cpu_irq_enable();
 
-    // Update the seed value for use with rand()
-    random_seed_init();
-
-    //Initialize the EDBG Port for the output log
-    console_init();
-
-    //Initialize CryptoAuthlib library
-    cryptoauthlib_init();
-
-    //Initialize the Systick module
+    //Initialize the Systick module, it also times the boot stages
     SysTick_Config(system_gclk_gen_get_hz(GCLK_GENERATOR_0) / 1000);
 
-    //Provision the device with the configuration and shared secret data
-#if IP_PROTECTION_LOAD_CONFIG
-    if (device_provision(CRYPTOAUTH_DEVICE_AUTH_KEY_SLOT) != ATCA_SUCCESS)
-    {
-        debug_print("%s", "Provision failed...");
-        debug_print("%s\r\n", "Check device and press RESET");
-    }
+    //The OLED reset and first frame, the seeding conversions and the device wake overlap up to the first authentication
+    boot_sequence_run(g_boot_stages, BOOT_STAGE_COUNT);
+#if TIMING_DEBUG
+    boot_sequence_print_timing(g_boot_stages, BOOT_STAGE_COUNT);
 #endif
 
-    //Initialize the time for the authentication to perform
-    g_auth_interval_msec = (rand() % AUTHENTICATION_RANGE_MSEC) + AUTHENTICATION_MIN_MSEC;
-
-    //Forcing to do Authentication at the start
-    g_do_auth = true;
-    while (authenticate_application() == NOT_AUTHENTICATED)
-    {
-        ;
-    }
-    printf("%s\r\n", "Authentication succeeded");
-
-    //Initialize the Application
-    init_display();
-
     while (true)
     {
         run_application();
@@ -39,6 +39,11 @@
 #include "provision_device.h"
 #include "symmetric_authentication.h"
 #include "console.h"
+#include "hal_i2c_dma.h"
+#include "boot_cache.h"
+#include "crc16.h"
+#include "config_writer.h"
+#include "factory_mode.h"
 #ifndef CRYPTOAUTH_DEVICE
 #error "Device not selected, select it in the configuration.h file."
 #endif
@@ -104,8 +109,111 @@ const uint8_t ecc608_configdata[ATCA_ECC_CONFIG_SIZE] = {
     0x53,            0x00, 0x53, 0x00, 0x73, 0x00, 0x73, 0x00, 0x73,  0x00, 0x38, 0x00, 0x7C, 0x00, 0x1C, 0x00,
     0x3C,            0x00, 0x1A, 0x00, 0x1C, 0x00, 0x10, 0x00, 0x1C,  0x00, 0x30, 0x00, 0x12, 0x00, 0x30, 0x00
 };
+
+//I2C address found by detect_crypto_device(), 0 until the bus has been scanned
+static uint8_t g_device_address;
 #endif
 
+static const uint8_t* provision_configdata(size_t *config_size);
+static uint16_t provision_config_crc(void);
+static bool boot_cache_check_device(uint8_t slot, uint8_t *sn, bool *sn_read);
+static void boot_cache_update(uint8_t slot, const uint8_t *sn);
+
+//Function to get the configuration data this firmware writes to the selected device
+static const uint8_t* provision_configdata(size_t *config_size)
+{
+    #if (CRYPTOAUTH_DEVICE == DEVICE_ATSHA204A)
+    *config_size = sizeof(sha204_configdata);
+    return sha204_configdata;
+    #elif (CRYPTOAUTH_DEVICE == DEVICE_ATECC508A)
+    *config_size = sizeof(ecc508_configdata);
+    return ecc508_configdata;
+    #elif (CRYPTOAUTH_DEVICE == DEVICE_ATECC608A)
+    *config_size = sizeof(ecc608_configdata);
+    return ecc608_configdata;
+    #endif
+}
+
+//Function to get the CRC of the configuration data this firmware writes, a changed table invalidates the boot record
+static uint16_t provision_config_crc(void)
+{
+    size_t config_size;
+    const uint8_t *config_data = provision_configdata(&config_size);
+
+    return crc16_update(CRC16_INIT, config_data, config_size);
+}
+
+//Function to check the boot record against the serial number of the device, one read replaces the lock queries and the bus scan
+static bool boot_cache_check_device(uint8_t slot, uint8_t *sn, bool *sn_read)
+{
+    boot_cache_record record;
+    ATCA_STATUS status;
+
+    //Without a valid record there is nothing to check, the full checks run without an extra read
+    if (!boot_cache_load(&record, provision_config_crc()) ||
+        record.device != CRYPTOAUTH_DEVICE || record.slot != slot ||
+        record.lock_state != (BOOT_CACHE_CONFIG_LOCKED | BOOT_CACHE_DATA_LOCKED))
+    {
+        return false;
+    }
+
+    #if (CRYPTOAUTH_DEVICE == DEVICE_ATECC608A)
+    cfg_ateccx08a_i2c_default.atcai2c.slave_address = record.i2c_address;
+    if (atcab_init(&cfg_ateccx08a_i2c_default) != ATCA_SUCCESS)
+    {
+        return false;
+    }
+    #endif
+
+    hal_i2c_session_begin();
+    status = atcab_read_serial_number(sn);
+    hal_i2c_session_end(false);
+
+    //No device at the cached address, the record is of no use to the next boot either
+    if (status != ATCA_SUCCESS)
+    {
+        boot_cache_invalidate();
+        return false;
+    }
+
+    //Locks cannot be undone, so the same serial number means the same provisioned device
+    if (memcmp(sn, record.serial_number, ATCA_SERIAL_NUM_SIZE) != 0)
+    {
+        //The record is rewritten with this serial number once the full checks pass
+        *sn_read = true;
+        return false;
+    }
+
+    #if (CRYPTOAUTH_DEVICE == DEVICE_ATECC608A)
+    g_device_address = record.i2c_address;
+    #endif
+    return true;
+}
+
+//Function to record the provisioned device with the serial number read on the way, the next boot skips the queries
+static void boot_cache_update(uint8_t slot, const uint8_t *sn)
+{
+    boot_cache_record record;
+
+    memset(&record, 0, sizeof(record));
+    memcpy(record.serial_number, sn, sizeof(record.serial_number));
+
+    record.device = CRYPTOAUTH_DEVICE;
+    #if (CRYPTOAUTH_DEVICE == DEVICE_ATSHA204A)
+    record.i2c_address = cfg_atsha204a_i2c_default.atcai2c.slave_address;
+    #else
+    record.i2c_address = cfg_ateccx08a_i2c_default.atcai2c.slave_address;
+    #endif
+    record.lock_state = BOOT_CACHE_CONFIG_LOCKED | BOOT_CACHE_DATA_LOCKED;
+    record.slot = slot;
+    record.config_crc = provision_config_crc();
+
+    if (!boot_cache_store(&record))
+    {
+        debug_print("%s\r\n", "Boot record could not be written");
+    }
+}
+
 //Function to configure the device configuration zone and the symmetric diversified key in the slot
 ATCA_STATUS device_provision(uint8_t slot)
 {
@@ -116,6 +224,17 @@ ATCA_STATUS device_provision(uint8_t slot)
     uint8_t master_key[ATCA_KEY_SIZE];
     atca_temp_key_t temp_key_derive;
     struct atca_derive_key_in_out derivekey_params;
+    config_writer_stats config_stats;
+    const uint8_t *config_data;
+    size_t config_size;
+    bool factory;
+    bool sn_read = false;
+
+    //A provisioned device found in the boot record skips the lock queries
+    if (boot_cache_check_device(slot, sn, &sn_read))
+    {
+        return ATCA_SUCCESS;
+    }
 
     do
     {
@@ -125,6 +244,16 @@ ATCA_STATUS device_provision(uint8_t slot)
             break;
         }
          #endif
+        //A station sending hellos at reset serves the board whatever its lock states, like after a job cut short
+        if (factory_mode_listen(FACTORY_LISTEN_USEC))
+        {
+            //A station leaving without a job, like for a board provisioned already, leaves it to the lock checks
+            factory_mode_run(slot);
+        }
+
+        //The lock checks, writes and locks share one wake pulse, except across button presses
+        hal_i2c_session_begin();
+
         //Check current status of configuration lock status
         if ((status = atcab_is_locked(LOCK_ZONE_CONFIG, &is_locked)) != ATCA_SUCCESS)
         {
@@ -138,46 +267,46 @@ ATCA_STATUS device_provision(uint8_t slot)
             debug_print("%s", "Device is not provisioned...");
             debug_print("%s\r\n", "Press SW0 button to provision");
 
+            hal_i2c_session_end(false);
+
             //Update the led pattern with provision led pattern
             update_led_pattern(provision_pattern);
 
-            //Wait for the SW0 button to be pressed
-            while (port_pin_get_input_level(BUTTON_0_PIN) == SW0_INACTIVE)
+            //Wait for the SW0 button to be pressed, or for a factory station on the console
+            factory = false;
+            while (!factory && port_pin_get_input_level(BUTTON_0_PIN) == SW0_INACTIVE)
             {
-                ;
+                factory = factory_mode_detect();
             }
 
-            //Trigger Configuration write
-            #if (CRYPTOAUTH_DEVICE == DEVICE_ATSHA204A)
-            if ((status = atcab_write_config_zone(sha204_configdata)) != ATCA_SUCCESS)
+            if (factory)
             {
-                break;
+                //The station sends the configuration image and the key, and checks the result
+                if ((status = factory_mode_run(slot)) != ATCA_SUCCESS)
+                {
+                    break;
+                }
+                hal_i2c_session_begin();
             }
-
-            #elif (CRYPTOAUTH_DEVICE == DEVICE_ATECC508A)
-            if ((status = atcab_write_config_zone(ecc508_configdata)) != ATCA_SUCCESS)
+            else
             {
-                break;
-            }
-            #elif (CRYPTOAUTH_DEVICE == DEVICE_ATECC608A)
-            if ((status = atcab_write_config_zone(ecc608_configdata)) != ATCA_SUCCESS)
-            {
-                break;
-            }
-            if (cfg_ateccx08a_i2c_default.atcai2c.slave_address != ecc608_configdata[16])
-            {
-                atcab_wakeup();
-                atcab_sleep();
-                cfg_ateccx08a_i2c_default.atcai2c.slave_address = ecc608_configdata[16];
-                atcab_init(&cfg_ateccx08a_i2c_default);
-            }
-            #endif
-
-
-            //Lock Configuration Zone on completing configuration
-            if ((status = atcab_lock_config_zone()) != ATCA_SUCCESS)
-            {
-                break;
+                hal_i2c_session_begin();
+
+                //Trigger Configuration write
+                config_data = provision_configdata(&config_size);
+                if ((status = provision_write_config(config_data, config_size, &config_stats)) != ATCA_SUCCESS)
+                {
+                    break;
+                }
+
+                debug_print_uart("Configuration written with %u word, %u block and %u extra writes\r\n",
+                                 config_stats.word_writes, config_stats.block_writes, config_stats.extra_updates);
+
+                //Lock Configuration Zone on completing configuration
+                if ((status = atcab_lock_config_zone()) != ATCA_SUCCESS)
+                {
+                    break;
+                }
             }
         }
 
@@ -197,6 +326,7 @@ ATCA_STATUS device_provision(uint8_t slot)
             {
                 break;
             }
+            sn_read = true;
 
             get_master_key(master_key);
 
@@ -218,25 +348,13 @@ ATCA_STATUS device_provision(uint8_t slot)
                 break;
             }
 
-            //Store the symmetric diversified key in device
-            if ((status = atcab_write_zone(ATCA_ZONE_DATA, slot, 0, 0, symmetric_key, ATCA_KEY_SIZE)) != ATCA_SUCCESS)
-            {
-                break;
-            }
-
-            //Lock the data zone of the device
-            if ((status = atcab_lock_data_zone()) != ATCA_SUCCESS)
+            //Store the symmetric diversified key in device and lock it
+            if ((status = provision_write_key(slot, symmetric_key)) != ATCA_SUCCESS)
             {
                 break;
             }
 
-            #if (CRYPTOAUTH_DEVICE == DEVICE_ATECC508A) || (CRYPTOAUTH_DEVICE == DEVICE_ATECC608A)
-            if ((status = atcab_lock_data_slot(slot)) != ATCA_SUCCESS)
-            {
-                break;
-            }
-            #endif
-
+            hal_i2c_session_end(false);
             update_led_pattern(NULL);
 
             debug_print("%s", "Device provisioned succesfully...");
@@ -247,32 +365,89 @@ ATCA_STATUS device_provision(uint8_t slot)
             {
                 ;
             }
+            hal_i2c_session_begin();
         }
 
+        //Both zones are locked now, the record is only written when the serial number was read on the way
+        if (sn_read)
+        {
+            boot_cache_update(slot, sn);
+        }
     }
     while (0);
 
+    //Ends the session of a failed step or of an already provisioned device
+    hal_i2c_session_end(false);
+
     return status;
 }
 
-#if (CRYPTOAUTH_DEVICE == DEVICE_ATECC608A)
-ATCA_STATUS detect_crypto_device(void)
+//Function to write a configuration image to the configuration zone, the ECC608A is moved to the address in the image
+ATCA_STATUS provision_write_config(const uint8_t *config_data, size_t config_size, config_writer_stats *stats)
+{
+    ATCA_STATUS status;
+
+    if ((status = config_writer_write(config_data, config_size, stats)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+
+    #if (CRYPTOAUTH_DEVICE == DEVICE_ATECC608A)
+    if (cfg_ateccx08a_i2c_default.atcai2c.slave_address != config_data[16])
+    {
+        //The new address is used after a real sleep
+        hal_i2c_session_end(false);
+        atcab_wakeup();
+        atcab_sleep();
+        cfg_ateccx08a_i2c_default.atcai2c.slave_address = config_data[16];
+        g_device_address = config_data[16];
+        atcab_init(&cfg_ateccx08a_i2c_default);
+        hal_i2c_session_begin();
+    }
+    #endif
+
+    return ATCA_SUCCESS;
+}
+
+//Function to store the symmetric diversified key in the slot, then lock the data zone and the slot
+ATCA_STATUS provision_write_key(uint8_t slot, const uint8_t *key)
 {
     ATCA_STATUS status;
 
-    uint8_t addr_list[] = { ECC608A_DEFAULT_ADDRESS, ECC608A_ADDRESS };
+    if ((status = atcab_write_zone(ATCA_ZONE_DATA, slot, 0, 0, key, ATCA_KEY_SIZE)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
 
-    for (uint8_t addr_index = 0; addr_index < (sizeof(addr_list) / sizeof(addr_list[0])); addr_index++)
+    //Lock the data zone of the device
+    if ((status = atcab_lock_data_zone()) != ATCA_SUCCESS)
     {
-        cfg_ateccx08a_i2c_default.atcai2c.slave_address = addr_list[addr_index];
-        if ((status = atcab_init(&cfg_ateccx08a_i2c_default)) == ATCA_SUCCESS)
+        return status;
+    }
+
+    #if (CRYPTOAUTH_DEVICE == DEVICE_ATECC508A) || (CRYPTOAUTH_DEVICE == DEVICE_ATECC608A)
+    status = atcab_lock_data_slot(slot);
+    #endif
+
+    return status;
+}
+
+#if (CRYPTOAUTH_DEVICE == DEVICE_ATECC608A)
+//Function to find the ECC608A at its configured or default address with one bus scan, the address is cached
+ATCA_STATUS detect_crypto_device(void)
+{
+    const uint8_t addr_list[] = { ECC608A_DEFAULT_ADDRESS, ECC608A_ADDRESS };
+
+    if (g_device_address == 0)
+    {
+        if (hal_i2c_scan(&cfg_ateccx08a_i2c_default, addr_list, sizeof(addr_list), &g_device_address, 1) == 0)
         {
-            /*ECC608A with addr_list[addr_index] address is found */
-            break;
+            return ATCA_NO_DEVICES;
         }
     }
 
-    return status;
+    cfg_ateccx08a_i2c_default.atcai2c.slave_address = g_device_address;
+    return atcab_init(&cfg_ateccx08a_i2c_default);
 }
 #endif
 
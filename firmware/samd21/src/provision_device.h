@@ -30,6 +30,8 @@
 #define PROVISION_DEVICE_H_
 
 #include <stdint.h>
+#include <stddef.h>
+#include "config_writer.h"
 
 #define ECC608A_DEFAULT_ADDRESS 0xC0 // Default I2C address for unconfigured ECC608A crypto devices
 #define ECC608A_ADDRESS 0x6A         //  I2C address for configured ECC608A crypto devices.
@@ -38,5 +40,9 @@ ATCA_STATUS device_provision(uint8_t slot);
 
 ATCA_STATUS detect_crypto_device(void);
 
+ATCA_STATUS provision_write_config(const uint8_t *config_data, size_t config_size, config_writer_stats *stats);
+
+ATCA_STATUS provision_write_key(uint8_t slot, const uint8_t *key);
+
 
 #endif /* PROVISION_DEVICE_H_ */
\ No newline at end of file
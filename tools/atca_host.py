@@ -0,0 +1,81 @@
+##
+# \file
+#
+# \brief Host side CryptoAuth calculations shared by the station and fleet tools
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# The calculations of cryptoauthlib's atca_host.c that the tools need, on
+# hashlib. The key of every board is the DeriveKey result of the master key
+# and its serial number, as calculated in device_provision().
+import hashlib
+
+SERIAL_NUMBER_SIZE = 9
+KEY_SIZE = 32
+NUM_IN_SIZE = 20
+AUTH_KEY_SLOT = 6
+
+OPCODE_DERIVE_KEY = 0x1C
+OPCODE_NONCE = 0x16
+OPCODE_MAC = 0x08
+MAC_MODE_CHALLENGE = 0x00
+MAC_MODE_BLOCK2_TEMPKEY = 0x01
+
+# Demo master key of get_master_key() in main.c
+MASTER_KEY = bytes((
+	0x37, 0x80, 0xe6, 0x3d, 0x49, 0x68, 0xad, 0xe5,
+	0xd8, 0x22, 0xc0, 0x13, 0xfc, 0xc3, 0x23, 0x84,
+	0x5d, 0x1b, 0x56, 0x9f, 0xe7, 0x05, 0xb6, 0x00,
+	0x06, 0xfe, 0xec, 0x14, 0x5a, 0x0d, 0xb1, 0xe3))
+
+def sha256(data):
+	return hashlib.sha256(data).digest()
+
+def derive_key(parent_key, serial_number, slot = AUTH_KEY_SLOT, mode = 0):
+	# TempKey is SN[0:8] padded with zeros, like device_provision()
+	temp_key = serial_number + bytes(KEY_SIZE - SERIAL_NUMBER_SIZE)
+	return sha256(parent_key + bytes((OPCODE_DERIVE_KEY, mode, slot & 0xFF, slot >> 8))
+			+ serial_number[8:9] + serial_number[0:2] + bytes(25) + temp_key)
+
+def nonce_temp_key(rand_out, num_in, mode = 0):
+	return sha256(rand_out + num_in + bytes((OPCODE_NONCE, mode, 0x00)))
+
+def mac_message(key, block2, mode, serial_number, slot):
+	# Modes 0x00 and 0x01 leave the OTP bits and SN[2:7] out of the message
+	return sha256(key + block2 + bytes((OPCODE_MAC, mode, slot & 0xFF, slot >> 8))
+			+ bytes(11) + serial_number[8:9] + bytes(4) + serial_number[0:2] + bytes(2))
+
+def mac_temp_key(key, temp_key, serial_number, slot = AUTH_KEY_SLOT):
+	return mac_message(key, temp_key, MAC_MODE_BLOCK2_TEMPKEY, serial_number, slot)
+
+def mac_challenge(key, challenge, serial_number, slot = AUTH_KEY_SLOT):
+	return mac_message(key, challenge, MAC_MODE_CHALLENGE, serial_number, slot)
+
+def crc16_update(crc, data):
+	# Register of crc16_update() in crc16.c, bit reflected polynomial 0xA001
+	for byte in data:
+		crc ^= byte
+		for _ in range(8):
+			crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+	return crc
@@ -0,0 +1,214 @@
+##
+# \file
+#
+# \brief Simulate boots with and without the boot record of boot_cache.c
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# Models the secure element, the I2C bus and the last flash row of the
+# SAMD21 on the host, and runs the boot sequence of provision_device.c up to
+# the first authentication. Every bus transaction is counted and charged with
+# the typical timing of the device datasheets, so the boot with the record in
+# flash can be compared with the full provisioning checks.
+import sys
+import argparse
+
+# Bus and device timing in microseconds
+I2C_BYTE_USEC = {100000: 90.0, 400000: 22.5, 1000000: 9.0}
+WAKE_USEC = 60 + 1500           # wake pulse and tWHI
+PROBE_BYTES = 1                 # address only write of the bus scan
+
+# Typical execution times, opcode: (usec, response bytes)
+COMMANDS = {
+	"read4": (1000, 4 + 3),
+	"read32": (1000, 32 + 3),
+	"write": (7000, 1 + 3),
+	"lock": (8000, 1 + 3),
+	"nonce": (7000, 32 + 3),
+	"mac": (5000, 32 + 3),
+}
+COMMAND_BYTES = 8               # word address, count, opcode, params, CRC
+
+# SAMD21 flash row erase and page write
+FLASH_ERASE_USEC = 6000
+FLASH_WRITE_USEC = 2500
+
+ECC608A_DEFAULT_ADDRESS = 0xC0
+ECC608A_ADDRESS = 0x6A
+
+class Bus(object):
+	def __init__(self, speed):
+		self.byte_usec = I2C_BYTE_USEC[speed]
+		self.transactions = 0
+		self.usec = 0.0
+
+	def wake(self):
+		self.transactions += 1
+		self.usec += WAKE_USEC
+
+	def probe(self):
+		self.transactions += 1
+		self.usec += PROBE_BYTES * self.byte_usec
+
+	def sleep(self):
+		self.transactions += 1
+		self.usec += 2 * self.byte_usec
+
+	def command(self, opcode):
+		execution_usec, response_bytes = COMMANDS[opcode]
+		# Command write, then the response read
+		self.transactions += 2
+		self.usec += (COMMAND_BYTES + response_bytes) * self.byte_usec + execution_usec
+
+class Device(object):
+	def __init__(self, serial, address = ECC608A_ADDRESS, provisioned = True):
+		self.serial = serial
+		self.address = address if provisioned else ECC608A_DEFAULT_ADDRESS
+		self.config_locked = provisioned
+		self.data_locked = provisioned
+
+class Flash(object):
+	def __init__(self):
+		self.record = None
+		self.usec = 0.0
+		self.erases = 0
+
+	def store(self, record):
+		if self.record == record:
+			return
+		self.record = record
+		self.erases += 1
+		self.usec += FLASH_ERASE_USEC + FLASH_WRITE_USEC
+
+	def invalidate(self):
+		if self.record is not None:
+			self.record = None
+			self.erases += 1
+			self.usec += FLASH_ERASE_USEC
+
+def full_provisioning(bus, device, flash, use_cache, serial_read):
+	# detect_crypto_device(): one wake pulse, address only probes, sleep
+	bus.wake()
+	for _ in (ECC608A_DEFAULT_ADDRESS, ECC608A_ADDRESS):
+		bus.probe()
+	bus.sleep()
+
+	# The session of device_provision()
+	bus.wake()
+	bus.command("read4")
+	if not device.config_locked:
+		bus.command("write")
+		bus.command("lock")
+		device.config_locked = True
+		device.address = ECC608A_ADDRESS
+		bus.sleep()
+		bus.wake()
+	bus.command("read4")
+	if not device.data_locked:
+		bus.command("read32")
+		bus.command("write")
+		bus.command("lock")
+		bus.command("lock")
+		device.data_locked = True
+		serial_read = True
+	# The record is only written with a serial number read on the way
+	if use_cache and serial_read:
+		flash.store((device.serial, device.address))
+	bus.sleep()
+
+def boot(bus, device, flash, use_cache):
+	serial_read = False
+	if use_cache and flash.record is not None:
+		# boot_cache_check_device(): one serial number read
+		bus.wake()
+		serial_read = flash.record[1] == device.address
+		if serial_read:
+			bus.command("read32")
+		bus.sleep()
+		if flash.record == (device.serial, device.address):
+			return
+		# A device with another serial number gets the record rewritten
+		if not serial_read:
+			flash.invalidate()
+	full_provisioning(bus, device, flash, use_cache, serial_read)
+
+def authenticate(bus):
+	bus.wake()
+	bus.command("nonce")
+	bus.command("read32")
+	bus.command("mac")
+	bus.sleep()
+
+def run(device, flash, use_cache, speed):
+	bus = Bus(speed)
+	flash_usec = flash.usec
+	boot(bus, device, flash, use_cache)
+	authenticate(bus)
+	return bus.transactions, bus.usec + flash.usec - flash_usec
+
+def simulate(boots, speed):
+	scenarios = []
+	for use_cache in (False, True):
+		# Board with a device provisioned before, no serial number is read for the record
+		flash = Flash()
+		device = Device(serial = 1)
+		provisioned = run(device, flash, use_cache, speed)
+		erases = flash.erases
+		# Board provisioned by the firmware, then booted again
+		flash = Flash()
+		device = Device(serial = 2, provisioned = False)
+		results = [run(device, flash, use_cache, speed) for _ in range(boots)]
+		# Board reworked with another provisioned device
+		swapped = run(Device(serial = 3), flash, use_cache, speed)
+		scenarios.append((use_cache, provisioned, results, swapped, erases + flash.erases))
+	return scenarios
+
+def main():
+	parser = argparse.ArgumentParser(description="This script simulates "
+			"the boot of a board with a provisioned ATECC608A, with and "
+			"without the boot record in flash, and reports the bus "
+			"transactions and the time to the first authentication.")
+	parser.add_argument("-n", "--boots", dest="boots", type=int,
+			help="boots of the same device, default is 10", default=10)
+	parser.add_argument("-s", "--speed", dest="speed", type=int,
+			choices=sorted(I2C_BYTE_USEC), help="I2C speed in Hz, default "
+			"is 1000000", default=1000000)
+
+	arguments = parser.parse_args()
+	if arguments.boots < 2:
+		print("error: at least two boots are needed")
+		sys.exit(1)
+
+	for use_cache, provisioned, results, swapped, erases in simulate(arguments.boots, arguments.speed):
+		first, later = results[0], results[1:]
+		print("%s boot record:" % ("with" if use_cache else "without"))
+		print("  first boot      %3u transactions, %7.2f ms" % (provisioned[0], provisioned[1] / 1000))
+		print("  provisioning    %3u transactions, %7.2f ms" % (first[0], first[1] / 1000))
+		print("  later boots     %3u transactions, %7.2f ms" % (later[0][0],
+				sum(result[1] for result in later) / len(later) / 1000))
+		print("  swapped device  %3u transactions, %7.2f ms" % (swapped[0], swapped[1] / 1000))
+		print("  flash erases    %3u" % erases)
+
+if __name__ == "__main__":
+	main()
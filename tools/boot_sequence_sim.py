@@ -0,0 +1,155 @@
+##
+# \file
+#
+# \brief Simulate the boot stages of boot_sequence.c, in sequence and overlapped
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# Every stage is a list of segments: CPU time, during which the step does not
+# return, and hardware waits, during which the step returns at once and the
+# other stages run. The sequential boot runs the stages one after the other
+# and waits out every hardware delay, like main() used to. The overlapped boot
+# calls the steps of all ready stages in turn, like boot_sequence_run().
+# Times are typical estimates in microseconds for the SAMD21 at 48 MHz.
+#
+# The OLED stage resets the controller and sends the cleared frame with the
+# console drawn into it. main() used to wait out the reset and the cleared
+# frame, then start the console frame without waiting for it.
+import argparse
+
+POLL_USEC = 2       # a step that finds its hardware still busy
+
+# SPI transfer of a whole OLED frame at SSD1306_CLOCK_SPEED, 8 us per byte
+OLED_FRAME_USEC = 512 * 8
+
+# name: (dependencies, [(kind, usec), ...])
+STAGES = [
+	("cryptoauth", (), [("cpu", 150), ("cpu", 90), ("wait", 1500), ("cpu", 60)]),
+	("console", (), [("cpu", 250)]),
+	("oled", (), [("cpu", 60), ("wait", 10), ("cpu", 2), ("wait", 10), ("cpu", 420),
+			("wait", OLED_FRAME_USEC)]),
+	("seed", (), [("cpu", 120)] + [("wait", 260), ("cpu", 10)] * 4),
+	("provision", ("cryptoauth", "console", "oled"), [("cpu", 1300)]),
+	("authenticate", ("provision", "seed"), [("cpu", 14200)]),
+	("application", ("authenticate",), [("cpu", 2100)]),
+]
+
+# Without the early wake the first command of provisioning waits out tWHI
+WAKE_USEC = 1560
+
+# Stages main() ran differently before boot_sequence_run()
+SEQUENTIAL_SEGMENTS = {
+	"oled": [("cpu", 60), ("cpu", 20), ("cpu", 400), ("cpu", OLED_FRAME_USEC), ("cpu", 20)],
+}
+
+class Stage(object):
+	def __init__(self, name, depends, segments):
+		self.name = name
+		self.depends = depends
+		self.segments = list(segments)
+		self.start = None
+		self.end = None
+
+def sequential():
+	stages = [Stage(name, depends, SEQUENTIAL_SEGMENTS.get(name, segments))
+			for name, depends, segments in STAGES]
+	now = 0
+	for stage in stages:
+		stage.start = now
+		for kind, usec in stage.segments:
+			now += usec
+		if stage.name == "cryptoauth":
+			# Only initialization, the device is woken by the first command
+			now = stage.start + sum(usec for kind, usec in stage.segments[:1])
+		if stage.name == "provision":
+			now += WAKE_USEC
+		stage.end = now
+	return stages
+
+def overlapped():
+	stages = [Stage(*stage) for stage in STAGES]
+	by_name = dict((stage.name, stage) for stage in stages)
+	now = 0
+	waiting = {}
+	while any(stage.end is None for stage in stages):
+		progress = False
+		for stage in stages:
+			if stage.end is not None or any(by_name[dep].end is None or by_name[dep].end > now
+					for dep in stage.depends):
+				continue
+			if stage.start is None:
+				stage.start = now
+			# Run segments until the step has to return
+			while stage.segments:
+				kind, usec = stage.segments[0]
+				if kind == "cpu":
+					now += usec
+					stage.segments.pop(0)
+					progress = True
+					continue
+				if stage.name not in waiting:
+					waiting[stage.name] = now + usec
+					break
+				if waiting[stage.name] <= now:
+					del waiting[stage.name]
+					stage.segments.pop(0)
+					continue
+				now += POLL_USEC
+				break
+			if not stage.segments:
+				stage.end = now
+				progress = True
+		if not progress and waiting:
+			now = max(now, min(waiting.values()))
+	return stages
+
+def critical_path(stages):
+	by_name = dict((stage.name, stage) for stage in stages)
+	stage = max(stages, key = lambda stage: stage.end)
+	path = [stage.name]
+	while stage.depends:
+		stage = max((by_name[dep] for dep in stage.depends), key = lambda stage: stage.end)
+		path.append(stage.name)
+	return " <- ".join(path)
+
+def report(title, stages, path):
+	print("%s: %.2f ms" % (title, max(stage.end for stage in stages) / 1000.0))
+	for stage in stages:
+		print("  %-12s start %7u us, end %7u us" % (stage.name, stage.start, stage.end))
+	print("  critical path: %s" % path)
+
+def main():
+	parser = argparse.ArgumentParser(description="This script simulates "
+			"the boot stages of the firmware up to the application, run "
+			"in sequence and overlapped by boot_sequence_run(), and "
+			"reports the total boot time and the critical path.")
+	parser.parse_args()
+
+	stages = sequential()
+	report("sequential", stages, " <- ".join(stage.name for stage in reversed(stages)))
+	stages = overlapped()
+	report("overlapped", stages, critical_path(stages))
+
+if __name__ == "__main__":
+	main()
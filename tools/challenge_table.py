@@ -0,0 +1,165 @@
+##
+# \file
+#
+# \brief Challenge/MAC table the factory station writes to the flash of a board
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# Image of the table region of challenge_table.h, all multi byte fields
+# little endian:
+#
+#   header: magic "RCT1", version (1 byte), key slot (1 byte), entry count
+#   (2 bytes), serial number (9 bytes), MAC size (1 byte), 12 reserved bytes,
+#   table MAC (32 bytes), CRC-16 register of the fields before it (2 bytes)
+#   entries: challenge (32 bytes), leading bytes of the MAC in mode 0x00
+#
+# The table MAC is the MAC in mode 0x00 with the board's key over the SHA-256
+# of the header fields in front of it and of the entries, so only the holder
+# of the master key can make a table challenge_table_load() accepts.
+#
+# The image is padded with erased flash to whole rows. The station writes the
+# rows last to first, so the header only becomes valid with the whole table.
+import os
+import sys
+import struct
+import argparse
+import atca_host
+
+MAGIC = 0x31544352
+VERSION = 2
+HEADER = struct.Struct("<IBBH9sB12x32sH")
+CHALLENGE_SIZE = 32
+MAC_SIZE = 16
+ENTRY_SIZE = CHALLENGE_SIZE + MAC_SIZE
+
+# Flash layout of the SAMD21J18A, see challenge_table.h and the linker script
+ROW_SIZE = 256
+REGION_SIZE = 32 * ROW_SIZE
+FLASH_SIZE = 0x40000
+ADDRESS = FLASH_SIZE - ROW_SIZE - REGION_SIZE
+MAX_ENTRIES = (REGION_SIZE - HEADER.size) // ENTRY_SIZE
+
+class ChallengeTableError(Exception):
+	pass
+
+TABLE_MAC_OFFSET = HEADER.size - 2 - atca_host.KEY_SIZE
+
+def header_crc(header):
+	return atca_host.crc16_update(0, header[:HEADER.size - 2])
+
+def table_mac(key, header, entries, serial_number, slot):
+	# Same message as challenge_table_check_mac()
+	digest = atca_host.sha256(bytes(header[:TABLE_MAC_OFFSET]) + bytes(entries))
+	return atca_host.mac_challenge(key, digest, serial_number, slot)
+
+def build_image(serial_number, key, slot, count, random=os.urandom):
+	if not 0 < count <= MAX_ENTRIES:
+		raise ChallengeTableError("a table holds 1 to %u entries" % MAX_ENTRIES)
+	if len(serial_number) != atca_host.SERIAL_NUMBER_SIZE:
+		raise ChallengeTableError("the serial number has %u bytes" % atca_host.SERIAL_NUMBER_SIZE)
+	entries = bytearray()
+	for _ in range(count):
+		challenge = random(CHALLENGE_SIZE)
+		entries += challenge + atca_host.mac_challenge(key, challenge, serial_number, slot)[:MAC_SIZE]
+	header = HEADER.pack(MAGIC, VERSION, slot, count, serial_number, MAC_SIZE, bytes(atca_host.KEY_SIZE), 0)
+	mac = table_mac(key, header, entries, serial_number, slot)
+	header = HEADER.pack(MAGIC, VERSION, slot, count, serial_number, MAC_SIZE, mac, 0)
+	image = bytearray(HEADER.pack(MAGIC, VERSION, slot, count, serial_number, MAC_SIZE, mac, header_crc(header)))
+	image += entries
+	image += b"\xFF" * (-len(image) % ROW_SIZE)
+	return bytes(image)
+
+def parse_image(image, slot=None, key=None):
+	# Same checks as challenge_table_valid(), and challenge_table_check_mac() with a key
+	if len(image) < HEADER.size:
+		raise ChallengeTableError("truncated header")
+	magic, version, table_slot, count, serial_number, mac_size, mac, crc = HEADER.unpack_from(image)
+	if magic != MAGIC or version != VERSION:
+		raise ChallengeTableError("not a version %u challenge table" % VERSION)
+	if crc != header_crc(image):
+		raise ChallengeTableError("header CRC mismatch")
+	if slot is not None and table_slot != slot:
+		raise ChallengeTableError("table is for slot %u" % table_slot)
+	if count == 0 or count > MAX_ENTRIES or mac_size != MAC_SIZE:
+		raise ChallengeTableError("bad entry count or MAC size")
+	if len(image) < HEADER.size + count * ENTRY_SIZE:
+		raise ChallengeTableError("truncated entries")
+	if key is not None and mac != table_mac(key, image, image[HEADER.size:HEADER.size + count * ENTRY_SIZE],
+			serial_number, table_slot):
+		raise ChallengeTableError("table MAC mismatch")
+	entries = [(image[offset:offset + CHALLENGE_SIZE], image[offset + CHALLENGE_SIZE:offset + ENTRY_SIZE])
+			for offset in range(HEADER.size, HEADER.size + count * ENTRY_SIZE, ENTRY_SIZE)]
+	return table_slot, serial_number, entries
+
+def rows(image):
+	# (offset, row) in the order the station writes them, the header row last
+	return [(offset, image[offset:offset + ROW_SIZE]) for offset in reversed(range(0, len(image), ROW_SIZE))]
+
+def main():
+	parser = argparse.ArgumentParser(description="This script builds the "
+			"challenge/MAC table of one board from its serial number and "
+			"the master key, or shows the header of a table image.")
+	parser.add_argument("serial_number", nargs="?", metavar="SERIAL",
+			help="serial number of the board as 18 hex digits")
+	parser.add_argument("-o", "--output", dest="output", default="challenge_table.bin",
+			help="table image to write, default is challenge_table.bin")
+	parser.add_argument("-n", "--entries", dest="entries", type=int, default=MAX_ENTRIES,
+			help="number of entries, default is %u" % MAX_ENTRIES)
+	parser.add_argument("-s", "--slot", dest="slot", type=int, default=atca_host.AUTH_KEY_SLOT,
+			help="key slot, default is %u" % atca_host.AUTH_KEY_SLOT)
+	parser.add_argument("-k", "--master-key", dest="master_key",
+			help="master key as 64 hex digits, default is the demo key of main.c")
+	parser.add_argument("-i", "--info", dest="info", metavar="IMAGE",
+			help="check a table image with the master key and show its header")
+
+	arguments = parser.parse_args()
+
+	try:
+		if arguments.info:
+			with open(arguments.info, "rb") as input_file:
+				image = input_file.read()
+			slot, serial_number, entries = parse_image(image)
+			master_key = bytes.fromhex(arguments.master_key) if arguments.master_key else atca_host.MASTER_KEY
+			parse_image(image, slot, atca_host.derive_key(master_key, serial_number, slot))
+			print("serial number %s, slot %u, %u entries" % (serial_number.hex(), slot, len(entries)))
+			return
+		if not arguments.serial_number:
+			parser.print_usage()
+			sys.exit()
+
+		master_key = bytes.fromhex(arguments.master_key) if arguments.master_key else atca_host.MASTER_KEY
+		serial_number = bytes.fromhex(arguments.serial_number)
+		key = atca_host.derive_key(master_key, serial_number, arguments.slot)
+		image = build_image(serial_number, key, arguments.slot, arguments.entries)
+		with open(arguments.output, "wb") as output_file:
+			output_file.write(image)
+	except (IOError, ValueError, ChallengeTableError) as e:
+		print("error: %s" % (str(e)))
+		sys.exit(1)
+
+	print("%u entries, %u rows written to %s for flash address 0x%05X" % (arguments.entries,
+			len(image) // ROW_SIZE, arguments.output, ADDRESS))
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,333 @@
+##
+# \file
+#
+# \brief Simulation of the challenge/MAC table authentication against a modelled secure element
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# Runs challenge_table_authenticate() of challenge_table.c on a table image
+# built by challenge_table.py, against a secure element modelled with
+# atca_host.py, and checks that the right device passes while a swapped
+# device, a tampered entry, damaged headers and a table a clone made with its
+# own key are refused. A missing, empty, foreign or forged table has to fall
+# back to symmetric_authenticate() like authenticate_application() of main.c,
+# without drawing an entry. Then the bus transactions and host SHA-256 blocks
+# of one authentication are charged with the timing of boot_cache_sim.py, for
+# symmetric_authenticate() and for the table, and the one-off
+# challenge_table_load() of a boot on its own.
+import os
+import sys
+import struct
+import argparse
+
+import atca_host
+import challenge_table
+import boot_cache_sim
+
+ATCA_SUCCESS = 0x00
+ATCA_CHECKMAC_VERIFY_FAILED = 0xD1
+ATCA_INVALID_ID = 0xE3
+
+# SHA-256 blocks symmetric_authenticate() runs on the SAMD21: DeriveKey (2),
+# Nonce TempKey (1) and the MAC (2)
+COMPUTED_SHA_BLOCKS = 5
+
+def sha_blocks(size):
+	# SHA-256 blocks of a message with its padding and 64 bit length
+	return (size + 9 + 63) // 64
+
+def load_sha_blocks(entries):
+	# challenge_table_check_mac(): DeriveKey (2), the table digest and the MAC (2)
+	return 2 + sha_blocks(challenge_table.TABLE_MAC_OFFSET + entries * challenge_table.ENTRY_SIZE) + 2
+
+class Device(object):
+	# ATSHA204A/ATECC608A answering MAC commands with the key in one slot
+	def __init__(self, serial_number, key, slot, reported_serial_number=None):
+		self.serial_number = serial_number
+		self.key = key
+		self.slot = slot
+		self.temp_key = None
+		# A clone can report any serial number, its MACs still use its own key
+		self.reported_serial_number = reported_serial_number or serial_number
+		self.commands = []
+
+	def read_serial_number(self):
+		self.commands.append("read")
+		return self.reported_serial_number
+
+	def nonce(self, num_in):
+		self.commands.append("nonce")
+		rand_out = os.urandom(atca_host.KEY_SIZE)
+		self.temp_key = atca_host.nonce_temp_key(rand_out, num_in)
+		return rand_out
+
+	def mac(self, mode, slot, challenge):
+		self.commands.append("mac")
+		if slot != self.slot:
+			raise ValueError("no key in slot %u" % slot)
+		if mode == atca_host.MAC_MODE_CHALLENGE:
+			return atca_host.mac_challenge(self.key, challenge, self.serial_number, slot)
+		temp_key, self.temp_key = self.temp_key, None
+		if mode != atca_host.MAC_MODE_BLOCK2_TEMPKEY or temp_key is None:
+			raise ValueError("no TempKey for MAC mode 0x%02X" % mode)
+		return atca_host.mac_temp_key(self.key, temp_key, self.serial_number, slot)
+
+class NewlibRand(object):
+	# rand() of newlib, seeded like main.c with srand()
+	def __init__(self, seed):
+		self.next = seed
+
+	def __call__(self):
+		self.next = (self.next * 6364136223846793005 + 1) & 0xFFFFFFFFFFFFFFFF
+		return (self.next >> 32) & 0x7FFFFFFF
+
+def load(flash, device, slot):
+	# challenge_table_load(), flash is the memory mapped table region
+	header = challenge_table.HEADER.unpack_from(flash)
+	magic, version, table_slot, count, serial_number, mac_size, mac, crc = header
+	if (magic != challenge_table.MAGIC or version != challenge_table.VERSION or table_slot != slot or
+			count == 0 or count > challenge_table.MAX_ENTRIES or mac_size != challenge_table.MAC_SIZE or
+			crc != challenge_table.header_crc(flash)):
+		return ATCA_INVALID_ID
+	if device.read_serial_number() != serial_number:
+		return ATCA_INVALID_ID
+	key = atca_host.derive_key(atca_host.MASTER_KEY, serial_number, slot)
+	entries = flash[challenge_table.HEADER.size:challenge_table.HEADER.size + count * challenge_table.ENTRY_SIZE]
+	if challenge_table.table_mac(key, flash, entries, serial_number, slot) != mac:
+		return ATCA_INVALID_ID
+	return ATCA_SUCCESS
+
+def authenticate(flash, device, slot, rand):
+	# challenge_table_authenticate() on a fresh boot, the table is loaded first
+	status = load(flash, device, slot)
+	if status != ATCA_SUCCESS:
+		return status, None
+	count = challenge_table.HEADER.unpack_from(flash)[3]
+	index = rand() % count
+	entry = flash[challenge_table.HEADER.size + index * challenge_table.ENTRY_SIZE:]
+	response = device.mac(atca_host.MAC_MODE_CHALLENGE, slot, entry[:challenge_table.CHALLENGE_SIZE])
+	difference = 0
+	for a, b in zip(response, entry[challenge_table.CHALLENGE_SIZE:challenge_table.ENTRY_SIZE]):
+		difference |= a ^ b
+	return (ATCA_SUCCESS if difference == 0 else ATCA_CHECKMAC_VERIFY_FAILED), index
+
+def symmetric_authenticate(device, slot):
+	# symmetric_authenticate() of symmetric_authentication.c
+	num_in = os.urandom(atca_host.NUM_IN_SIZE)
+	rand_out = device.nonce(num_in)
+	serial_number = device.read_serial_number()
+	key = atca_host.derive_key(atca_host.MASTER_KEY, serial_number, slot)
+	expected = atca_host.mac_temp_key(key, atca_host.nonce_temp_key(rand_out, num_in), serial_number, slot)
+	response = device.mac(atca_host.MAC_MODE_BLOCK2_TEMPKEY, slot, None)
+	return ATCA_SUCCESS if response == expected else ATCA_CHECKMAC_VERIFY_FAILED
+
+class Application(object):
+	# authenticate_application() of main.c with CHALLENGE_TABLE_MODE set
+	def __init__(self, flash, device, slot, rand):
+		self.flash = flash
+		self.device = device
+		self.slot = slot
+		self.rand = rand
+		self.table_usable = True
+		self.fallbacks = 0
+
+	def authenticate(self):
+		if self.table_usable:
+			status, index = authenticate(self.flash, self.device, self.slot, self.rand)
+			if status != ATCA_INVALID_ID:
+				return status
+			self.table_usable = False
+			self.fallbacks += 1
+		return symmetric_authenticate(self.device, self.slot)
+
+def region(image):
+	# The image in the erased table region of the flash
+	return memoryview(image + b"\xFF" * (challenge_table.REGION_SIZE - len(image)))
+
+def patch_header(image, **fields):
+	values = dict(zip(("magic", "version", "slot", "count", "serial_number", "mac_size", "table_mac", "header_crc"),
+			challenge_table.HEADER.unpack_from(image)))
+	fix_crc = fields.pop("fix_crc", True)
+	values.update(fields)
+	header = bytearray(challenge_table.HEADER.pack(*values.values()))
+	if fix_crc:
+		struct.pack_into("<H", header, challenge_table.HEADER.size - 2, challenge_table.header_crc(header))
+	return bytes(header) + image[challenge_table.HEADER.size:]
+
+def consumption_checks(entries, boots, seed):
+	slot = atca_host.AUTH_KEY_SLOT
+	serial_number = bytes((0x01, 0x23)) + os.urandom(6) + bytes((0xEE,))
+	other_serial_number = bytes((0x01, 0x23)) + os.urandom(6) + bytes((0xEE,))
+	key = atca_host.derive_key(atca_host.MASTER_KEY, serial_number, slot)
+	image = challenge_table.build_image(serial_number, key, slot, entries)
+	device = Device(serial_number, key, slot)
+	other_key = atca_host.derive_key(atca_host.MASTER_KEY, other_serial_number, slot)
+	swapped = Device(other_serial_number, other_key, slot)
+	clone = Device(other_serial_number, other_key, slot, serial_number)
+	# A clone with a key of its own, writing a table for the serial number it reports
+	forger_key = os.urandom(atca_host.KEY_SIZE)
+	forger = Device(other_serial_number, forger_key, slot, serial_number)
+	forged_image = challenge_table.build_image(serial_number, forger_key, slot, entries)
+
+	def run(flash, device, slot = slot):
+		rand = NewlibRand(seed)
+		return [authenticate(flash, device, slot, rand) for _ in range(boots)]
+
+	checks = []
+	# symmetric_authenticate() with the same device, the table replaces it
+	num_in = os.urandom(atca_host.NUM_IN_SIZE)
+	temp_key = atca_host.nonce_temp_key(device.nonce(num_in), num_in)
+	checks.append(("computed MAC of the device matches the host",
+			device.mac(atca_host.MAC_MODE_BLOCK2_TEMPKEY, slot, None)
+			== atca_host.mac_temp_key(atca_host.derive_key(atca_host.MASTER_KEY, serial_number, slot),
+			temp_key, serial_number, slot)))
+
+	results = run(region(image), device)
+	picked = len(set(index for _, index in results))
+	checks.append(("right device passes %u boots, %u of %u entries used" % (boots, picked, entries),
+			all(status == ATCA_SUCCESS for status, _ in results)))
+	checks.append(("swapped device is refused by its serial number",
+			all(status == ATCA_INVALID_ID for status, _ in run(region(image), swapped))))
+	checks.append(("swapped device draws no entry and sends no MAC", "mac" not in swapped.commands))
+	checks.append(("clone reporting the serial number is refused by the MAC",
+			all(status == ATCA_CHECKMAC_VERIFY_FAILED for status, _ in run(region(image), clone))))
+
+	tampered = bytearray(image)
+	tampered_index = results[0][1]
+	tampered[challenge_table.HEADER.size + tampered_index * challenge_table.ENTRY_SIZE + challenge_table.ENTRY_SIZE - 1] ^= 0x01
+	checks.append(("tampered entry is refused by the table MAC",
+			all(status == ATCA_INVALID_ID for status, _ in run(region(bytes(tampered)), device))))
+	checks.append(("table a clone made with its own key is refused by the table MAC",
+			all(status == ATCA_INVALID_ID for status, _ in run(region(forged_image), forger))))
+	checks.append(("forged table draws no entry and sends no MAC", "mac" not in forger.commands))
+
+	headers = (
+		("bad magic", patch_header(image, magic=0)),
+		("other slot", patch_header(image, slot=slot + 1)),
+		("header CRC mismatch", patch_header(image, count=entries // 2, fix_crc=False)),
+		("no entries", patch_header(image, count=0)),
+		("too many entries", patch_header(image, count=challenge_table.MAX_ENTRIES + 1)),
+		("MAC size", patch_header(image, mac_size=challenge_table.MAC_SIZE * 2)),
+		("erased region", b""),
+	)
+	for name, bad_image in headers:
+		checks.append(("%s is refused" % name, all(status == ATCA_INVALID_ID for status, _ in run(region(bad_image), device))))
+	checks.append(("table for another slot is refused",
+			all(status == ATCA_INVALID_ID for status, _ in run(region(image), device, slot + 1))))
+
+	# Station stopped after some rows: the header row comes last, so it is still erased
+	flash = bytearray(b"\xFF" * challenge_table.REGION_SIZE)
+	for offset, row in challenge_table.rows(image)[:-1]:
+		flash[offset:offset + len(row)] = row
+	checks.append(("table cut short before the header row is refused",
+			all(status == ATCA_INVALID_ID for status, _ in run(memoryview(bytes(flash)), device))))
+
+	# authenticate_application() gives up on a table that can never pass after the first try
+	fallbacks = (
+		("empty table", region(patch_header(image, count=0)), device, ATCA_SUCCESS),
+		("erased region", region(b""), device, ATCA_SUCCESS),
+		("table of another device", region(image), swapped, ATCA_SUCCESS),
+		("empty table with a clone", region(patch_header(image, count=0)), clone, ATCA_CHECKMAC_VERIFY_FAILED),
+		("forged table with its clone", region(forged_image), forger, ATCA_CHECKMAC_VERIFY_FAILED),
+	)
+	for name, flash, fallback_device, expected in fallbacks:
+		rand = NewlibRand(seed)
+		application = Application(flash, fallback_device, slot, rand)
+		statuses = [application.authenticate() for _ in range(boots)]
+		checks.append(("%s falls back to the computed MAC once, %s" % (name,
+				"passes" if expected == ATCA_SUCCESS else "refused"),
+				application.fallbacks == 1 and all(status == expected for status in statuses) and
+				rand() == NewlibRand(seed)()))
+
+	return checks
+
+def latency(speed, sha_block_usec, entries):
+	bus = boot_cache_sim.Bus(speed)
+	# symmetric_authenticate(): one wake pulse for Nonce, the serial number and the MAC
+	bus.wake()
+	bus.command("nonce")
+	bus.command("read32")
+	bus.command("mac")
+	bus.sleep()
+	computed = (bus.transactions, bus.usec + COMPUTED_SHA_BLOCKS * sha_block_usec)
+
+	bus = boot_cache_sim.Bus(speed)
+	# challenge_table_authenticate() of a loaded table: the MAC command carrying the 32 byte challenge
+	bus.wake()
+	bus.command("mac")
+	bus.usec += challenge_table.CHALLENGE_SIZE * bus.byte_usec
+	bus.sleep()
+	table = (bus.transactions, bus.usec)
+
+	bus = boot_cache_sim.Bus(speed)
+	# challenge_table_load() once per boot: the serial number and the table MAC in software
+	bus.wake()
+	bus.command("read32")
+	bus.sleep()
+	loading = (bus.transactions, bus.usec + load_sha_blocks(entries) * sha_block_usec)
+	return computed, table, loading
+
+def main():
+	parser = argparse.ArgumentParser(description="This script checks the "
+			"challenge/MAC table authentication against a simulated secure "
+			"element and compares its latency with the MAC calculated on "
+			"the host.")
+	parser.add_argument("-n", "--entries", dest="entries", type=int, default=challenge_table.MAX_ENTRIES,
+			help="entries of the table, default is %u" % challenge_table.MAX_ENTRIES)
+	parser.add_argument("-b", "--boots", dest="boots", type=int, default=1000,
+			help="authentications per check, default is 1000")
+	parser.add_argument("--seed", dest="seed", type=int, default=1,
+			help="srand() seed of the simulated board, default is 1")
+	parser.add_argument("-s", "--speed", dest="speed", type=int,
+			choices=sorted(boot_cache_sim.I2C_BYTE_USEC), help="I2C speed in Hz, default "
+			"is 1000000", default=1000000)
+	parser.add_argument("--sha-block-usec", dest="sha_block_usec", type=float, default=300.0,
+			help="software SHA-256 block on the SAMD21 in microseconds, default is 300")
+
+	arguments = parser.parse_args()
+
+	try:
+		checks = consumption_checks(arguments.entries, arguments.boots, arguments.seed)
+	except (ValueError, challenge_table.ChallengeTableError) as e:
+		print("error: %s" % (str(e)))
+		sys.exit(1)
+
+	for name, passed in checks:
+		print("%s  %s" % ("pass" if passed else "FAIL", name))
+
+	computed, table, loading = latency(arguments.speed, arguments.sha_block_usec, arguments.entries)
+	print("authentication at %u Hz:" % arguments.speed)
+	print("  computed MAC    %3u transactions, %u SHA blocks, %7.2f ms" % (computed[0],
+			COMPUTED_SHA_BLOCKS, computed[1] / 1000))
+	print("  table           %3u transactions, %u SHA blocks, %7.2f ms" % (table[0], 0, table[1] / 1000))
+	print("  saved           %7.2f ms, %.0f%%" % ((computed[1] - table[1]) / 1000,
+			100.0 * (computed[1] - table[1]) / computed[1]))
+	print("  load, once      %3u transactions, %u SHA blocks, %7.2f ms" % (loading[0],
+			load_sha_blocks(arguments.entries), loading[1] / 1000))
+
+	if not all(passed for _, passed in checks):
+		sys.exit(1)
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,341 @@
+/**
+ * \file
+ * \brief  Measures the response latency of the learned command timing on a simulated device
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux x86-64 with
+ *
+ *   S=../firmware/samd21/src D=$S/ASF/sam0/drivers
+ *   cc -O2 -no-pie -Wno-pointer-to-int-cast -D__SAMD21J18A__ -DBOARD=SAMD21_XPLAINED_PRO \
+ *      -DI2C_MASTER_CALLBACK_MODE=false \
+ *      -Ihost/sam -Ihost/cryptoauthlib -I$S -I$S/config -I$S/ASF/common/boards -I$S/ASF/sam0/boards \
+ *      -I$S/ASF/sam0/boards/samd21_xplained_pro -I$S/ASF/sam0/utils -I$S/ASF/sam0/utils/header_files \
+ *      -I$S/ASF/sam0/utils/preprocessor -I$S/ASF/sam0/utils/cmsis/samd21/include \
+ *      -I$S/ASF/sam0/utils/cmsis/samd21/source -I$S/ASF/thirdparty/CMSIS/Include \
+ *      -I$D/sercom -I$D/sercom/i2c -I$D/port -I$D/system -I$D/system/pinmux -I$D/system/clock \
+ *      -I$D/system/clock/clock_samd21_r21_da -I$D/system/interrupt \
+ *      -I$D/system/interrupt/system_interrupt_samd21 -I$D/system/power/power_sam_d_r \
+ *      -I$D/system/reset/reset_sam_d_r -I$S/ASF/common/utils \
+ *      -o cmd_timing_check cmd_timing_check.c host/i2c_sim.c host/reg_trap.c \
+ *      host/cryptoauthlib/cryptoauthlib_sim.c $S/hal_i2c_dma.c $S/cmd_timing.c \
+ *      $D/sercom/i2c/i2c_sam0/i2c_master.c $D/sercom/sercom.c $D/sercom/sercom_interrupt.c
+ *
+ * hal_i2c_dma.c and cmd_timing.c run unchanged on the bus model of
+ * host/i2c_sim.c, with host/cryptoauthlib standing in for the library,
+ * which is not part of this tree. An ATECC608A and an ATSHA204A execute
+ * MAC, Nonce, Random and Read with a time drawn for every command between
+ * 1 - j and 1 + j times the typical time of the datasheet, capped at the
+ * maximum. The device model records how long after a command the read that
+ * got its response started.
+ *
+ * That wait is compared with two ways of waiting the HAL replaced, worked
+ * out for the same drawn times: the polling of cryptoauthlib on the stock
+ * HAL, which reads after ATCA_POLLING_INIT_TIME_MSEC and then every
+ * ATCA_POLLING_FREQUENCY_TIME_MSEC, each receive trying rx_retries NACKed
+ * reads in a row, and waiting the maximum execution time (ATCA_NO_POLL).
+ * The learned wait has to beat the maximum time for every command and the
+ * polling over all of them. A command whose times straddle the polling
+ * init time, like Random on the ATECC608A, can lose a little to the reads
+ * cryptoauthlib retries back to back there.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include "host/reg_trap.h"
+#include "host/i2c_sim.h"
+
+//glibc defines these as well, the ASF definitions win for the firmware code
+#undef __always_inline
+#undef LITTLE_ENDIAN
+#include "hal_i2c_dma.h"
+#include "cmd_timing.h"
+
+#define CHECK_OPCODES           4
+
+typedef struct
+{
+    const char *name;
+    ATCADeviceType devtype;
+    uint8_t address;
+    uint32_t typical_usec[CHECK_OPCODES];   //Datasheet execution times in the order of g_opcodes
+    uint32_t max_usec[CHECK_OPCODES];
+} check_device;
+
+typedef struct
+{
+    uint64_t exec_usec;
+    uint64_t learned_usec;
+    uint64_t polling_usec;
+    uint64_t max_usec;
+    uint32_t runs;
+} check_totals;
+
+typedef struct
+{
+    uint32_t runs;
+    uint32_t jitter;            //Percent of the typical time
+    uint32_t random;
+    const check_device *device;
+    uint32_t exec_usec;         //Drawn for the last command
+    uint32_t failures;
+} check_context;
+
+static const uint8_t g_opcodes[CHECK_OPCODES] = { ATCA_MAC, ATCA_NONCE, ATCA_RANDOM, ATCA_READ };
+static const char *const g_opcode_names[CHECK_OPCODES] = { "MAC", "Nonce", "Random", "Read" };
+
+static const check_device g_devices[] =
+{
+    { "ATECC608A", ATECC608A, 0xC0, { 5000, 100, 1000, 100 }, { 14000, 7000, 23000, 1000 } },
+    { "ATSHA204A", ATSHA204A, 0xC8, { 12000, 22000, 11000, 400 }, { 35000, 60000, 50000, 4000 } },
+};
+
+static void print_usage(const char *name)
+{
+    printf("Usage: %s [-n runs] [-j jitter] [-s seed]\n", name);
+    printf("  -n  commands of each opcode per device (default 200)\n");
+    printf("  -j  spread of the execution times in percent of the typical time, 0 to 90 (default 50)\n");
+    printf("  -s  seed of the execution times (default 1)\n");
+}
+
+static uint8_t check_opcode_index(uint8_t opcode)
+{
+    uint8_t i;
+
+    for (i = 0; i < CHECK_OPCODES - 1 && g_opcodes[i] != opcode; i++)
+    {
+    }
+    return i;
+}
+
+static uint32_t check_exec_time(void *context_pointer, uint8_t device, uint8_t opcode)
+{
+    check_context *context = context_pointer;
+    uint8_t index = check_opcode_index(opcode);
+    uint32_t typical = context->device->typical_usec[index];
+    uint32_t spread = typical / 100 * context->jitter;
+    uint32_t exec;
+
+    (void)device;
+    context->random = context->random * 1103515245UL + 12345UL;
+    exec = typical - spread + (uint32_t)((uint64_t)((context->random >> 8) & 0xFFFF) * 2 * spread / 0x10000);
+    if (exec > context->device->max_usec[index])
+    {
+        exec = context->device->max_usec[index];
+    }
+    context->exec_usec = exec;
+    return exec;
+}
+
+//Returns when the polling of cryptoauthlib on the stock HAL starts the read that gets the response
+static uint32_t check_polling_wait(uint32_t exec_usec, uint32_t nack_usec, int retries)
+{
+    uint32_t wait = ATCA_POLLING_INIT_TIME_MSEC * 1000UL;
+    int i;
+
+    while (true)
+    {
+        for (i = 0; i < retries; i++)
+        {
+            if (wait >= exec_usec)
+            {
+                return wait;
+            }
+            wait += nack_usec;
+        }
+        wait += ATCA_POLLING_FREQUENCY_TIME_MSEC * 1000UL;
+    }
+}
+
+static ATCA_STATUS check_run(uint8_t opcode)
+{
+    uint8_t num_in[NONCE_NUMIN_SIZE] = { 0 };
+    uint8_t challenge[ATCA_KEY_SIZE] = { 0 };
+    uint8_t response[ATCA_BLOCK_SIZE];
+
+    switch (opcode)
+    {
+    case ATCA_MAC:
+        return atcab_mac(MAC_MODE_CHALLENGE, 0, challenge, response);
+    case ATCA_NONCE:
+        return atcab_nonce_rand(num_in, response);
+    case ATCA_RANDOM:
+        return atcab_random(response);
+    default:
+        return atcab_read_zone(ATCA_ZONE_CONFIG, 0, 0, 0, response, ATCA_WORD_SIZE);
+    }
+}
+
+static void check_device_timing(check_context *context, check_totals *all)
+{
+    const check_device *device = context->device;
+    ATCAIfaceCfg cfg = (device->devtype == ATSHA204A) ? cfg_atsha204a_i2c_default : cfg_ateccx08a_i2c_default;
+    i2c_sim_device_config config;
+    i2c_sim_device *state;
+    check_totals totals;
+    uint32_t nack_usec;
+    uint32_t polls;
+    uint32_t run;
+    uint8_t i;
+    uint8_t count;
+    const cmd_timing_stats *stats;
+
+    i2c_sim_init();
+    i2c_sim_default_config(&config, device->address, device->devtype);
+    config.exec_time = check_exec_time;
+    config.exec_context = context;
+    i2c_sim_add_device(&config);
+    state = i2c_sim_get_device(0);
+
+    cfg.devtype = device->devtype;
+    cfg.atcai2c.slave_address = device->address;
+    if (atcab_init(&cfg) != ATCA_SUCCESS)
+    {
+        printf("%s: init failed\n", device->name);
+        context->failures++;
+        return;
+    }
+    //A read NACKed by a busy device: START, address byte and STOP
+    nack_usec = (11 * 1000000UL + i2c_sim_scl_hz() - 1) / i2c_sim_scl_hz();
+
+    for (i = 0; i < CHECK_OPCODES; i++)
+    {
+        memset(&totals, 0, sizeof(totals));
+        for (run = 0; run < context->runs; run++)
+        {
+            if (check_run(g_opcodes[i]) != ATCA_SUCCESS)
+            {
+                context->failures++;
+                continue;
+            }
+            totals.runs++;
+            totals.exec_usec += context->exec_usec;
+            totals.learned_usec += state->response_wait_usec;
+            totals.polling_usec += check_polling_wait(context->exec_usec, nack_usec, cfg.rx_retries);
+            totals.max_usec += device->max_usec[i];
+        }
+        if (totals.runs == 0)
+        {
+            printf("%-10s %-7s all commands failed\n", device->name, g_opcode_names[i]);
+            continue;
+        }
+
+        stats = cmd_timing_get_stats(&count);
+        for (polls = 0; count > 0; count--, stats++)
+        {
+            if (stats->devtype == device->devtype && stats->opcode == g_opcodes[i])
+            {
+                polls = stats->polls;
+            }
+        }
+
+        printf("%-10s %-7s %5u %8lu | %8lu %8lu %8lu | %6.2f%s\n", device->name, g_opcode_names[i], totals.runs,
+               (unsigned long)(totals.exec_usec / totals.runs), (unsigned long)(totals.learned_usec / totals.runs),
+               (unsigned long)(totals.polling_usec / totals.runs), (unsigned long)(totals.max_usec / totals.runs),
+               (double)polls / totals.runs,
+               (totals.learned_usec > totals.max_usec) ? "  FAIL" : "");
+        if (totals.learned_usec > totals.max_usec)
+        {
+            context->failures++;
+        }
+
+        all->runs += totals.runs;
+        all->exec_usec += totals.exec_usec;
+        all->learned_usec += totals.learned_usec;
+        all->polling_usec += totals.polling_usec;
+        all->max_usec += totals.max_usec;
+    }
+
+    if (state->bad_packets != 0)
+    {
+        context->failures++;
+    }
+    atcab_release();
+}
+
+static void check_all(void *argument)
+{
+    check_context *context = argument;
+    check_totals all;
+    uint8_t i;
+
+    memset(&all, 0, sizeof(all));
+    cmd_timing_reset();
+    for (i = 0; i < sizeof(g_devices) / sizeof(g_devices[0]); i++)
+    {
+        context->device = &g_devices[i];
+        check_device_timing(context, &all);
+    }
+
+    if (all.runs != 0)
+    {
+        printf("%-18s %5u %8lu | %8lu %8lu %8lu |\n", "all", all.runs, (unsigned long)(all.exec_usec / all.runs),
+               (unsigned long)(all.learned_usec / all.runs), (unsigned long)(all.polling_usec / all.runs),
+               (unsigned long)(all.max_usec / all.runs));
+        printf("\nlearned timing waits %.1f%% of the polling wait and %.1f%% of the maximum time wait\n",
+               100.0 * all.learned_usec / all.polling_usec, 100.0 * all.learned_usec / all.max_usec);
+        if (all.learned_usec > all.polling_usec)
+        {
+            context->failures++;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    check_context context = { .runs = 200, .jitter = 50, .random = 1, .failures = 0 };
+    int option;
+
+    while ((option = getopt(argc, argv, "n:j:s:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'n': context.runs = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'j': context.jitter = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 's': context.random = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+    if (context.runs == 0 || context.jitter > 90)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("%u commands of each opcode, execution times within %u%% of the typical time\n\n", context.runs,
+           context.jitter);
+    printf("%-18s %5s %8s | %-26s | %6s\n", "", "", "", "wait for the response, us", "");
+    printf("%-10s %-7s %5s %8s | %8s %8s %8s | %6s\n", "device", "command", "runs", "exec us", "learned", "polling",
+           "max time", "polls");
+    i2c_sim_call(check_all, &context);
+
+    context.failures += i2c_sim_get_stats()->errors;
+    printf("\n%lu register accesses trapped, %u failed\n", (unsigned long)reg_trap_accesses(), context.failures);
+    return (context.failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+##
+# \file
+#
+# \brief Compare the full and the differential configuration zone writes on a simulated device
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# The configuration arrays are taken from provision_device.c. The full write
+# sends every writable word like atcab_write_config_zone(), with 32 byte
+# writes for the blocks that are writable as a whole, and both UpdateExtra
+# commands. The differential write
+# of config_writer.c reads the first block; a part where most of its words
+# differ is written in full without further reads, otherwise the rest of the
+# zone is read, what differs is written and the zone is read again.
+import os
+import re
+import sys
+import argparse
+
+FIRMWARE_SOURCE = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+		"..", "firmware", "samd21", "src", "provision_device.c")
+DEFINES = {"ECC608A_ADDRESS": "0x6A"}
+
+WORD_SIZE = 4
+BLOCK_SIZE = 32
+FIRST_WORD = 4
+EXTRA_OFFSET = 84
+BLOCK_THRESHOLD = 2
+
+# Typical execution times in microseconds
+EXECUTION_USEC = {
+	"sha204": {"read": 400, "write": 4000, "updateextra": 8000},
+	"ecc508": {"read": 1000, "write": 7000, "updateextra": 8000},
+	"ecc608": {"read": 800, "write": 7000, "updateextra": 8000},
+}
+
+# Word address, count, opcode, param1, param2 (2), CRC (2)
+COMMAND_BYTES = 8
+RESPONSE_BYTES = 3
+
+class Device(object):
+	def __init__(self, name, zone, speed):
+		self.name = name
+		self.zone = bytearray(zone)
+		self.byte_usec = 9 * 1000000.0 / speed
+		self.commands = 0
+		self.bus_bytes = 0
+		self.usec = 0.0
+
+	def command(self, opcode, data_bytes, response_data_bytes):
+		length = COMMAND_BYTES + data_bytes + RESPONSE_BYTES + response_data_bytes
+		self.commands += 1
+		self.bus_bytes += length
+		self.usec += length * self.byte_usec + EXECUTION_USEC[self.name][opcode]
+
+	def read_zone(self, offset = 0, size = None):
+		# atcab_read_bytes_zone(), 32 byte reads of whole blocks, 4 byte reads for the rest
+		size = len(self.zone) - offset if size is None else size
+		for _ in range(size // BLOCK_SIZE):
+			self.command("read", 0, BLOCK_SIZE)
+		for _ in range((size % BLOCK_SIZE) // WORD_SIZE):
+			self.command("read", 0, WORD_SIZE)
+		return bytes(self.zone[offset:offset + size])
+
+	def write(self, offset, data):
+		self.command("write", len(data), 1)
+		self.zone[offset:offset + len(data)] = data
+
+	def update_extra(self, offset, value):
+		self.command("updateextra", 0, 1)
+		if self.zone[offset] == 0:
+			self.zone[offset] = value
+
+def word_writable(word, size):
+	return word >= FIRST_WORD and word != EXTRA_OFFSET // WORD_SIZE and (word + 1) * WORD_SIZE <= size
+
+def block_writable(block, size):
+	words = BLOCK_SIZE // WORD_SIZE
+	return all(word_writable(word, size) for word in range(block * words, (block + 1) * words))
+
+def blocks(size):
+	return range((size + BLOCK_SIZE - 1) // BLOCK_SIZE)
+
+def block_words(block):
+	words = BLOCK_SIZE // WORD_SIZE
+	return range(block * words, (block + 1) * words)
+
+def full_write(device, config):
+	size = len(config)
+	for block in blocks(size):
+		if block_writable(block, size):
+			device.write(block * BLOCK_SIZE, config[block * BLOCK_SIZE:(block + 1) * BLOCK_SIZE])
+			continue
+		for word in block_words(block):
+			if word_writable(word, size):
+				device.write(word * WORD_SIZE, config[word * WORD_SIZE:(word + 1) * WORD_SIZE])
+	# atcab_write_config_zone() sends UserExtra and Selector whatever their values
+	for offset in (EXTRA_OFFSET, EXTRA_OFFSET + 1):
+		device.update_extra(offset, config[offset])
+
+def differs(current, config, word):
+	return current[word * WORD_SIZE:(word + 1) * WORD_SIZE] != config[word * WORD_SIZE:(word + 1) * WORD_SIZE]
+
+def diff_write(device, config):
+	size = len(config)
+	current = bytearray(device.read_zone(0, BLOCK_SIZE))
+	writable = [word for word in block_words(0) if word_writable(word, size)]
+	fresh = 2 * sum(1 for word in writable if differs(current, config, word)) > len(writable)
+	if fresh:
+		# Every later word counts as differing, UserExtra and Selector are zero
+		current += bytes(~byte & 0xFF for byte in config[BLOCK_SIZE:])
+		current[EXTRA_OFFSET:EXTRA_OFFSET + 2] = b"\x00\x00"
+	else:
+		current += device.read_zone(BLOCK_SIZE)
+	written = False
+	for block in blocks(size):
+		changed = [word for word in block_words(block) if word_writable(word, size) and differs(current, config, word)]
+		if len(changed) >= BLOCK_THRESHOLD and block_writable(block, size):
+			device.write(block * BLOCK_SIZE, config[block * BLOCK_SIZE:(block + 1) * BLOCK_SIZE])
+			written = True
+			continue
+		for word in changed:
+			device.write(word * WORD_SIZE, config[word * WORD_SIZE:(word + 1) * WORD_SIZE])
+			written = True
+	for offset in (EXTRA_OFFSET, EXTRA_OFFSET + 1):
+		if current[offset] != config[offset]:
+			device.update_extra(offset, config[offset])
+			written = True
+	if fresh:
+		# Not read back by config_writer.c, checked here on the model only
+		current = device.zone
+	elif written:
+		current = device.read_zone()
+	for word in range(size // WORD_SIZE):
+		if word_writable(word, size) and differs(current, config, word):
+			raise ValueError("%s: word %u does not match after the write" % (device.name, word))
+
+def read_configurations(file_name):
+	with open(file_name) as source_file:
+		source = source_file.read()
+	configurations = {}
+	for name, body in re.findall(r"const uint8_t (\w+)_configdata\[\w+\] = \{(.*?)\};", source, re.S):
+		body = re.sub(r"//[^\n]*", "", body)
+		values = [DEFINES.get(value.strip(), value.strip()) for value in body.split(",") if value.strip()]
+		configurations[name] = bytes(int(value, 16) for value in values)
+	return configurations
+
+def scenarios(config):
+	size = len(config)
+	# Writable words all differ from the shipped state, UserExtra and Selector are 0
+	factory = bytearray(config)
+	for word in range(size // WORD_SIZE):
+		if word_writable(word, size):
+			for offset in range(word * WORD_SIZE, (word + 1) * WORD_SIZE):
+				factory[offset] ^= 0xA5
+	factory[EXTRA_OFFSET:EXTRA_OFFSET + 2] = b"\x00\x00"
+	one_word = bytearray(config)
+	one_word[5 * WORD_SIZE] ^= 0x01
+	return [("factory", bytes(factory)), ("one word changed", bytes(one_word)),
+			("already written", bytes(config))]
+
+def main():
+	parser = argparse.ArgumentParser(description="This script compares "
+			"writing the whole configuration zone with the differential "
+			"writer of config_writer.c on a simulated device, using the "
+			"configuration arrays of provision_device.c.")
+	parser.add_argument("-s", "--speed", dest="speed", type=int,
+			help="I2C speed in Hz, default is 400000", default=400000)
+	parser.add_argument("-f", "--file", dest="file_name",
+			help="provision_device.c to read the configurations from",
+			default=FIRMWARE_SOURCE)
+
+	arguments = parser.parse_args()
+
+	try:
+		configurations = read_configurations(arguments.file_name)
+	except IOError as e:
+		print("error: %s" % (str(e)))
+		sys.exit(1)
+
+	for name in sorted(configurations):
+		config = configurations[name]
+		print("%s (%u bytes):" % (name, len(config)))
+		for title, zone in scenarios(config):
+			results = []
+			for writer in (full_write, diff_write):
+				device = Device(name, zone, arguments.speed)
+				writer(device, config)
+				results.append(device)
+			print("  %-16s full %2u commands %4u bytes %6.1f ms, diff %2u commands %4u bytes %6.1f ms" % (
+					title, results[0].commands, results[0].bus_bytes, results[0].usec / 1000,
+					results[1].commands, results[1].bus_bytes, results[1].usec / 1000))
+
+if __name__ == "__main__":
+	main()
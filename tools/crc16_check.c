@@ -0,0 +1,305 @@
+/**
+ * \file
+ * \brief  Checks both table variants of crc16.c against the bitwise CRC of cryptoauthlib
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux with
+ *
+ *   cc -O2 -I../firmware/samd21/src -o crc16_check crc16_check.c
+ *
+ * crc16.c is included twice, with the 256 entry table and with the 16 entry
+ * table of CRC16_NIBBLE_TABLE, its functions renamed for each. Both are
+ * compared with the bit by bit atCRC() of cryptoauthlib, on packets the
+ * devices send and on random data of every length up to 256 bytes, fed
+ * whole and in two parts.
+ *
+ * The throughput is then measured for the packet lengths on the bus,
+ * from the 7 byte command to the 155 byte response. It is a host figure,
+ * it only compares the variants with each other.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <time.h>
+
+#define crc16_table         crc16_byte_table
+#define crc16_reverse_bits  crc16_byte_reverse_bits
+#define crc16_update        crc16_byte_update
+#define crc16_final         crc16_byte_final
+#define crc16_calc          crc16_byte_calc
+#define CRC16_NIBBLE_TABLE  0
+#include "crc16.c"
+#undef crc16_table
+#undef crc16_reverse_bits
+#undef crc16_update
+#undef crc16_final
+#undef crc16_calc
+#undef CRC16_NIBBLE_TABLE
+#undef CRC16_H_
+
+#define crc16_table         crc16_nibble_table
+#define crc16_reverse_bits  crc16_nibble_reverse_bits
+#define crc16_update        crc16_nibble_update
+#define crc16_final         crc16_nibble_final
+#define crc16_calc          crc16_nibble_calc
+#define CRC16_NIBBLE_TABLE  1
+#include "crc16.c"
+#undef crc16_table
+#undef crc16_reverse_bits
+#undef crc16_update
+#undef crc16_final
+#undef crc16_calc
+
+#define CHECK_MAX_LENGTH    256
+
+typedef struct
+{
+    const char *name;
+    uint16_t (*update)(uint16_t crc, const uint8_t *data, size_t length);
+    void (*final)(uint16_t crc, uint8_t *crc_le);
+    void (*calc)(const uint8_t *data, size_t length, uint8_t *crc_le);
+    size_t table_size;
+} check_variant;
+
+typedef struct
+{
+    uint32_t iterations;
+    uint32_t failures;
+} check_context;
+
+//Packets with their CRC as the devices send them, polynomial 0x8005
+static const struct
+{
+    const char *name;
+    uint8_t length;
+    uint8_t packet[7];
+} g_vectors[] =
+{
+    { "wake response",     4, { 0x04, 0x11, 0x33, 0x43 } },
+    { "success status",    4, { 0x04, 0x00, 0x03, 0x40 } },
+    { "execution error",   4, { 0x04, 0x0F, 0x23, 0x42 } },
+    { "Info command",      7, { 0x07, 0x30, 0x00, 0x00, 0x00, 0x03, 0x5D } },
+    { "Random command",    7, { 0x07, 0x1B, 0x00, 0x00, 0x00, 0x24, 0xCD } },
+};
+
+static const uint8_t g_lengths[] = { 7, 10, 35, 39, 67, 84, 155 };
+
+static uint32_t g_random = 1;
+
+static void print_usage(const char *name)
+{
+    printf("Usage: %s [-n iterations]\n", name);
+    printf("  -n  CRCs per length in the throughput measurement (default 200000)\n");
+}
+
+static uint8_t check_random_byte(void)
+{
+    g_random = g_random * 1103515245UL + 12345UL;
+    return (uint8_t)(g_random >> 16);
+}
+
+//Function to calculate the CRC bit by bit like atCRC() of cryptoauthlib
+static void check_reference(size_t length, const uint8_t *data, uint8_t *crc_le)
+{
+    const uint16_t polynom = 0x8005;
+    uint16_t crc_register = 0;
+    uint8_t shift_register;
+    uint8_t data_bit, crc_bit;
+    size_t counter;
+
+    for (counter = 0; counter < length; counter++)
+    {
+        for (shift_register = 0x01; shift_register > 0x00; shift_register <<= 1)
+        {
+            data_bit = (data[counter] & shift_register) ? 1 : 0;
+            crc_bit = crc_register >> 15;
+            crc_register <<= 1;
+            if (data_bit != crc_bit)
+            {
+                crc_register ^= polynom;
+            }
+        }
+    }
+    crc_le[0] = (uint8_t)(crc_register & 0x00FF);
+    crc_le[1] = (uint8_t)(crc_register >> 8);
+}
+
+static bool check_fail(check_context *context, const check_variant *variant, const char *name, const char *reason)
+{
+    printf("%-12s %-28s FAIL %s\n", variant->name, name, reason);
+    context->failures++;
+    return false;
+}
+
+static bool check_vectors(check_context *context, const check_variant *variant)
+{
+    uint8_t crc_le[CRC16_SIZE];
+    size_t i;
+
+    for (i = 0; i < sizeof(g_vectors) / sizeof(g_vectors[0]); i++)
+    {
+        variant->calc(g_vectors[i].packet, g_vectors[i].length - CRC16_SIZE, crc_le);
+        if (memcmp(crc_le, &g_vectors[i].packet[g_vectors[i].length - CRC16_SIZE], CRC16_SIZE) != 0)
+        {
+            return check_fail(context, variant, g_vectors[i].name, "wrong CRC");
+        }
+    }
+    return true;
+}
+
+static bool check_random(check_context *context, const check_variant *variant)
+{
+    uint8_t data[CHECK_MAX_LENGTH];
+    uint8_t expected[CRC16_SIZE];
+    uint8_t crc_le[CRC16_SIZE];
+    char name[40];
+    size_t length;
+    size_t split;
+    size_t i;
+    uint16_t crc;
+
+    for (length = 0; length <= CHECK_MAX_LENGTH; length++)
+    {
+        snprintf(name, sizeof(name), "%u random bytes", (unsigned)length);
+        for (i = 0; i < length; i++)
+        {
+            data[i] = check_random_byte();
+        }
+        check_reference(length, data, expected);
+
+        variant->calc(data, length, crc_le);
+        if (memcmp(crc_le, expected, CRC16_SIZE) != 0)
+        {
+            return check_fail(context, variant, name, "differs from the bitwise CRC");
+        }
+
+        //Consecutive parts give the CRC of the whole
+        split = (length != 0) ? (check_random_byte() % length) : 0;
+        crc = variant->update(CRC16_INIT, data, split);
+        crc = variant->update(crc, &data[split], length - split);
+        variant->final(crc, crc_le);
+        if (memcmp(crc_le, expected, CRC16_SIZE) != 0)
+        {
+            return check_fail(context, variant, name, "differs when fed in two parts");
+        }
+    }
+    return true;
+}
+
+static double check_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+//Function to time the CRC of one packet length, returns nanoseconds per byte
+static double check_throughput(check_context *context, const check_variant *variant, size_t length,
+                               volatile uint16_t *sink)
+{
+    uint8_t data[CHECK_MAX_LENGTH];
+    uint8_t crc_le[CRC16_SIZE];
+    double start;
+    uint32_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        data[i] = check_random_byte();
+    }
+
+    start = check_now();
+    for (i = 0; i < context->iterations; i++)
+    {
+        data[0] = (uint8_t)i;
+        if (variant != NULL)
+        {
+            variant->calc(data, length, crc_le);
+        }
+        else
+        {
+            check_reference(length, data, crc_le);
+        }
+        *sink += crc_le[0];
+    }
+    return (check_now() - start) * 1e9 / ((double)context->iterations * length);
+}
+
+int main(int argc, char **argv)
+{
+    const check_variant variants[] =
+    {
+        { "256 entries", crc16_byte_update, crc16_byte_final, crc16_byte_calc, sizeof(crc16_byte_table) },
+        { "16 entries", crc16_nibble_update, crc16_nibble_final, crc16_nibble_calc, sizeof(crc16_nibble_table) },
+    };
+    check_context context = { .iterations = 200000, .failures = 0 };
+    volatile uint16_t sink = 0;
+    int option;
+    size_t v;
+    size_t l;
+
+    while ((option = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'n': context.iterations = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+    if (context.iterations == 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    for (v = 0; v < sizeof(variants) / sizeof(variants[0]); v++)
+    {
+        if (check_vectors(&context, &variants[v]) && check_random(&context, &variants[v]))
+        {
+            printf("%-12s %u packets and 0 to %u random bytes match the bitwise CRC, %u table bytes\n",
+                   variants[v].name, (unsigned)(sizeof(g_vectors) / sizeof(g_vectors[0])), CHECK_MAX_LENGTH,
+                   (unsigned)variants[v].table_size);
+        }
+    }
+
+    printf("\nns per byte   %8s %12s %12s\n", "bitwise", variants[0].name, variants[1].name);
+    for (l = 0; l < sizeof(g_lengths); l++)
+    {
+        printf("%3u bytes     %8.2f", g_lengths[l], check_throughput(&context, NULL, g_lengths[l], &sink));
+        for (v = 0; v < sizeof(variants) / sizeof(variants[0]); v++)
+        {
+            printf(" %12.2f", check_throughput(&context, &variants[v], g_lengths[l], &sink));
+        }
+        printf("\n");
+    }
+
+    printf("\n%u failed\n", context.failures);
+    return (context.failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,308 @@
+/**
+ * \file
+ * \brief  Checks display_asset_blit() against drawing the asset pixel by pixel
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux with
+ *
+ *   S=../firmware/samd21/src G=$S/ASF/common2/services/gfx_mono
+ *   cc -O2 -Ihost -I$S -I$S/config -I$S/ASF/sam0/utils -I$G -o display_asset_check \
+ *      display_asset_check.c host/usart_sim.c $S/display_asset.c $S/display_stream.c \
+ *      $G/gfx_mono_null.c $G/gfx_mono_framebuffer.c
+ *
+ * Random assets are blitted onto a random display with the null gfx_mono
+ * driver, raw and RLE compressed with display_stream_rle_encode() like
+ * asset_compiler.py does, at every vertical shift and clipped at the right
+ * and bottom edges. The display must then equal the background with every
+ * asset pixel whose row is set in the page masks copied over it, and no
+ * other pixel changed.
+ *
+ * Half of the assets have the page masks of asset_compiler.py, the other
+ * half random rows of them cleared to cover transparent rows anywhere in a
+ * page. Every
+ * blit may write each display page it covers at most once, and must not
+ * read the display for pages it covers completely.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <asf.h>
+#include "display_asset.h"
+#include "display_stream.h"
+
+#define CHECK_MAX_HEIGHT    40
+#define CHECK_MAX_PAGES     ((CHECK_MAX_HEIGHT + 7) / 8)
+#define CHECK_MAX_DATA      (GFX_MONO_LCD_WIDTH * CHECK_MAX_PAGES)
+
+typedef struct
+{
+    uint32_t blits;
+    uint32_t failures;
+    uint32_t rle_blits;
+    uint64_t page_writes;
+    uint64_t read_bytes;
+    uint64_t raw_size;
+    uint64_t stored_size;
+} check_totals;
+
+static uint64_t g_random_state = 1;
+
+static uint32_t check_random(uint32_t range)
+{
+    g_random_state ^= g_random_state >> 12;
+    g_random_state ^= g_random_state << 25;
+    g_random_state ^= g_random_state >> 27;
+    return (uint32_t)((g_random_state * 2685821657736338717ULL) >> 33) % range;
+}
+
+static bool check_asset_pixel(const display_asset *asset, const uint8_t *pixels, gfx_coord_t column, gfx_coord_t row)
+{
+    return (pixels[(row / 8) * asset->width + column] >> (row % 8)) & 1;
+}
+
+//Function to make a random asset, pixels holds the uncompressed page data
+static void check_make_asset(display_asset *asset, uint8_t *pixels, uint8_t *masks, uint8_t *encoded, bool rle)
+{
+    uint8_t pages;
+    uint16_t size;
+    uint16_t i;
+    uint16_t length;
+    uint8_t value;
+
+    asset->width = 1 + check_random(GFX_MONO_LCD_WIDTH);
+    asset->height = 1 + check_random(CHECK_MAX_HEIGHT);
+    pages = (asset->height + 7) / 8;
+    size = asset->width * pages;
+
+    for (i = 0; i < pages; i++)
+    {
+        //Rows past the height never belong to the image
+        masks[i] = (uint8_t)((1 << min(8, asset->height - i * 8)) - 1);
+        if (check_random(2))
+        {
+            masks[i] &= (uint8_t)check_random(256);
+        }
+    }
+
+    //Runs of one byte like drawn images have, so RLE gets both literals and runs
+    for (i = 0; i < size; i += length)
+    {
+        length = 1 + check_random(check_random(2) ? 4 : 40);
+        length = min(length, size - i);
+        value = check_random(3) ? (uint8_t)check_random(256) : 0x00;
+        memset(&pixels[i], value, length);
+        if (check_random(2))
+        {
+            pixels[i] = (uint8_t)check_random(256);
+        }
+    }
+
+    asset->flags = 0;
+    asset->page_masks = masks;
+    asset->data = pixels;
+    if (rle)
+    {
+        asset->flags = DISPLAY_ASSET_RLE;
+        asset->data = encoded;
+        display_stream_rle_encode(pixels, size, encoded);
+    }
+}
+
+static void check_background(uint8_t *frame)
+{
+    uint8_t page_data[GFX_MONO_LCD_WIDTH];
+    uint8_t page;
+    uint8_t i;
+
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        for (i = 0; i < GFX_MONO_LCD_WIDTH; i++)
+        {
+            page_data[i] = (uint8_t)check_random(256);
+        }
+        gfx_mono_put_page(page_data, page, 0, GFX_MONO_LCD_WIDTH);
+        memcpy(&frame[page * GFX_MONO_LCD_WIDTH], page_data, GFX_MONO_LCD_WIDTH);
+    }
+    gfx_mono_null_reset_stats();
+}
+
+//Function to draw an asset into a copy of the display the way the blit should
+static void check_reference(uint8_t *frame, const display_asset *asset, const uint8_t *pixels, gfx_coord_t x,
+                            gfx_coord_t y)
+{
+    uint16_t column, row;
+    uint16_t screen_x, screen_y;
+    uint8_t bit;
+
+    for (row = 0; row < asset->height; row++)
+    {
+        if (!((asset->page_masks[row / 8] >> (row % 8)) & 1))
+        {
+            continue;
+        }
+        for (column = 0; column < asset->width; column++)
+        {
+            screen_x = x + column;
+            screen_y = y + row;
+            if ((screen_x >= GFX_MONO_LCD_WIDTH) || (screen_y >= GFX_MONO_LCD_HEIGHT))
+            {
+                continue;
+            }
+            bit = 1 << (screen_y % 8);
+            if (check_asset_pixel(asset, pixels, column, row))
+            {
+                frame[(screen_y / 8) * GFX_MONO_LCD_WIDTH + screen_x] |= bit;
+            }
+            else
+            {
+                frame[(screen_y / 8) * GFX_MONO_LCD_WIDTH + screen_x] &= ~bit;
+            }
+        }
+    }
+}
+
+//Function to blit one random asset and compare the display with the reference
+static bool check_blit(uint32_t number, bool rle, check_totals *totals)
+{
+    static uint8_t pixels[CHECK_MAX_DATA];
+    static uint8_t encoded[CHECK_MAX_DATA + CHECK_MAX_DATA / 128 + 1];
+    static uint8_t expected[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+    uint8_t masks[CHECK_MAX_PAGES];
+    uint8_t page_data[GFX_MONO_LCD_WIDTH];
+    const struct gfx_mono_null_stats *stats = gfx_mono_null_get_stats();
+    display_asset asset;
+    gfx_coord_t x, y;
+    uint8_t page, first_page, last_page;
+    uint8_t full_pages = 0;
+    uint16_t column;
+    bool ok = true;
+
+    check_make_asset(&asset, pixels, masks, encoded, rle);
+    //Mostly on the screen, sometimes past the right or bottom edge
+    x = check_random(4) ? check_random(GFX_MONO_LCD_WIDTH - asset.width + 1) : check_random(GFX_MONO_LCD_WIDTH + 8);
+    y = check_random(4) ? check_random(GFX_MONO_LCD_HEIGHT) : check_random(GFX_MONO_LCD_HEIGHT + 8);
+
+    check_background(expected);
+    check_reference(expected, &asset, pixels, x, y);
+    display_asset_blit(&asset, x, y);
+
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        gfx_mono_framebuffer_get_page(page_data, page, 0, GFX_MONO_LCD_WIDTH);
+        for (column = 0; column < GFX_MONO_LCD_WIDTH; column++)
+        {
+            if (ok && (page_data[column] != expected[page * GFX_MONO_LCD_WIDTH + column]))
+            {
+                printf("blit %u: %ux%u %s asset at %u,%u differs at page %u column %u: 0x%02X, expected 0x%02X\n",
+                       number, asset.width, asset.height, rle ? "RLE" : "raw", x, y, page, column,
+                       page_data[column], expected[page * GFX_MONO_LCD_WIDTH + column]);
+                ok = false;
+            }
+        }
+    }
+
+    //Display pages the asset covers, and those it covers completely
+    first_page = y / 8;
+    last_page = (y + asset.height - 1) / 8;
+    if ((x >= GFX_MONO_LCD_WIDTH) || (y >= GFX_MONO_LCD_HEIGHT))
+    {
+        last_page = first_page - 1;
+    }
+    for (page = first_page; (page <= last_page) && (page < GFX_MONO_LCD_PAGES); page++)
+    {
+        if (((y % 8) == 0) && (asset.page_masks[page - first_page] == 0xFF))
+        {
+            full_pages++;
+        }
+    }
+    if (stats->transactions > (uint32_t)(last_page - first_page + 1))
+    {
+        printf("blit %u: %u page writes for %d pages\n", number, stats->transactions, last_page - first_page + 1);
+        ok = false;
+    }
+    if (stats->read_bytes > (uint32_t)(last_page - first_page + 1 - full_pages) * GFX_MONO_LCD_WIDTH)
+    {
+        printf("blit %u: %u bytes read with %u of the pages covered completely\n", number, stats->read_bytes,
+               full_pages);
+        ok = false;
+    }
+
+    totals->blits++;
+    totals->rle_blits += rle;
+    totals->page_writes += stats->transactions;
+    totals->read_bytes += stats->read_bytes;
+    totals->raw_size += asset.width * ((asset.height + 7) / 8);
+    totals->stored_size += rle ? display_stream_rle_encode(pixels, asset.width * ((asset.height + 7) / 8), encoded)
+                               : asset.width * ((asset.height + 7) / 8);
+
+    return ok;
+}
+
+static void print_usage(const char *name)
+{
+    printf("usage: %s [-n blits] [-s seed]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    check_totals totals;
+    uint32_t blits = 20000;
+    uint32_t i;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:s:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'n': blits = (uint32_t)atoi(optarg); break;
+        case 's': g_random_state = strtoull(optarg, NULL, 0) + 1; break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+
+    memset(&totals, 0, sizeof(totals));
+    gfx_mono_init();
+
+    for (i = 0; i < blits; i++)
+    {
+        if (!check_blit(i, (i % 2) != 0, &totals))
+        {
+            totals.failures++;
+        }
+    }
+
+    printf("%u blits (%u RLE), %u failed\n", totals.blits, totals.rle_blits, totals.failures);
+    printf("per blit: %.2f page writes, %.1f bytes read back; RLE assets %.1f%% of their raw size\n",
+           (double)totals.page_writes / totals.blits, (double)totals.read_bytes / totals.blits,
+           100.0 * totals.stored_size / totals.raw_size);
+
+    return (totals.failures == 0) ? 0 : 1;
+}
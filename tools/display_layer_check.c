@@ -0,0 +1,467 @@
+/**
+ * \file
+ * \brief  Checks the display layers on the display and in the display stream
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux with
+ *
+ *   S=../firmware/samd21/src G=$S/ASF/common2/services/gfx_mono
+ *   cc -O2 -DGFX_MONO_UG_2832HSWEG04 -Ihost -I$S -I$S/config -I$S/ASF/sam0/utils -I$G \
+ *      -o display_layer_check display_layer_check.c host/ssd1306_sim.c host/usart_sim.c \
+ *      $S/display_layer.c $S/display_stream.c $G/gfx_mono_ug_2832hsweg04.c \
+ *      $G/gfx_mono_generic.c $G/gfx_mono_text.c $G/gfx_mono_framebuffer.c $G/sysfont.c
+ *
+ * The layers of display_layer.c run on the double-buffered driver of
+ * gfx_mono_ug_2832hsweg04.c and the simulated controller of
+ * host/ssd1306_sim.c. Random steps draw into the base layer and the status
+ * layer, show and hide it, then commit and present with a random flush
+ * budget. A model keeps the pixels and opaque mask of the status layer
+ * independently of display_layer.c: every pixel of the display must be the
+ * status layer's where it is visible and opaque, and the base layer's
+ * everywhere else, so cleared but opaque overlay pixels hide lit base pixels
+ * and transparent ones show them.
+ *
+ * After each step a delta frame of display_stream.c is decoded as well and
+ * must show the same composed display, not the base layer alone.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <asf.h>
+#include "display_layer.h"
+#include "display_stream.h"
+
+#define CHECK_FRAME_MAX_SIZE    2048
+
+typedef struct
+{
+    uint8_t pixels[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+    uint8_t opaque[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+    bool visible;
+} check_layer;
+
+typedef struct
+{
+    uint32_t steps;
+    uint32_t failures;
+    uint32_t visible_steps;
+    uint64_t sent_bytes;
+    uint64_t stream_bytes;
+} check_totals;
+
+static uint64_t g_random_state = 1;
+static check_layer g_status;
+static uint8_t g_host_frame[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+
+static uint32_t check_random(uint32_t range)
+{
+    g_random_state ^= g_random_state >> 12;
+    g_random_state ^= g_random_state << 25;
+    g_random_state ^= g_random_state >> 27;
+    return (uint32_t)((g_random_state * 2685821657736338717ULL) >> 33) % range;
+}
+
+static void model_set_pixel(check_layer *layer, uint16_t x, uint16_t y, uint8_t color)
+{
+    uint16_t offset = (y / 8) * GFX_MONO_LCD_WIDTH + x;
+    uint8_t bit = 1 << (y % 8);
+
+    if ((x >= GFX_MONO_LCD_WIDTH) || (y >= GFX_MONO_LCD_HEIGHT))
+    {
+        return;
+    }
+    layer->opaque[offset] |= bit;
+    if (color == GFX_PIXEL_SET)
+    {
+        layer->pixels[offset] |= bit;
+    }
+    else if (color == GFX_PIXEL_CLR)
+    {
+        layer->pixels[offset] &= ~bit;
+    }
+    else
+    {
+        layer->pixels[offset] ^= bit;
+    }
+}
+
+//Function to draw a string the way gfx_mono_draw_char() draws it, every pixel of a cell set or cleared
+static void model_draw_string(check_layer *layer, const char *str, uint16_t x, uint16_t y, const struct font *font)
+{
+    uint8_t row_size = (font->width + 7) / 8;
+    const uint8_t *glyph;
+    uint8_t row, column;
+
+    for (; *str != '\0'; str++, x += font->width)
+    {
+        glyph = font->data.progmem + row_size * font->height * ((uint8_t)*str - font->first_char);
+        for (row = 0; row < font->height; row++)
+        {
+            for (column = 0; column < font->width; column++)
+            {
+                model_set_pixel(layer, x + column, y + row,
+                                ((glyph[row * row_size + column / 8] << (column % 8)) & 0x80) ? GFX_PIXEL_SET
+                                                                                             : GFX_PIXEL_CLR);
+            }
+        }
+    }
+}
+
+//Function to compose the display from the base layer in the back buffer and the model of the status layer
+static void model_compose(uint8_t *frame)
+{
+    uint16_t i;
+
+    for (i = 0; i < GFX_MONO_LCD_PAGES; i++)
+    {
+        gfx_mono_framebuffer_get_page(&frame[i * GFX_MONO_LCD_WIDTH], i, 0, GFX_MONO_LCD_WIDTH);
+    }
+    if (g_status.visible)
+    {
+        for (i = 0; i < GFX_MONO_LCD_FRAMEBUFFER_SIZE; i++)
+        {
+            frame[i] = (frame[i] & ~g_status.opaque[i]) | (g_status.pixels[i] & g_status.opaque[i]);
+        }
+    }
+}
+
+static void check_random_string(char *str, uint16_t x, const struct font *font)
+{
+    uint8_t length = 1 + check_random(8);
+    uint8_t i;
+
+    //Short enough that the column never passes 255, cells past the right edge are clipped
+    length = min(length, (uint8_t)((250 - x) / font->width));
+    for (i = 0; i < length; i++)
+    {
+        str[i] = (char)(font->first_char + check_random(font->last_char - font->first_char + 1));
+    }
+    str[i] = '\0';
+}
+
+//Function to make one random change to the base or status layer
+static void check_change(void)
+{
+    uint8_t page_data[GFX_MONO_LCD_WIDTH];
+    char str[16];
+    gfx_coord_t x = check_random(GFX_MONO_LCD_WIDTH);
+    gfx_coord_t y = check_random(GFX_MONO_LCD_HEIGHT);
+    gfx_coord_t width, height;
+    uint8_t color;
+    uint8_t i;
+
+    switch (check_random(8))
+    {
+    case 0:
+        for (i = 0; i < GFX_MONO_LCD_WIDTH; i++)
+        {
+            page_data[i] = (uint8_t)check_random(256);
+        }
+        gfx_mono_put_page(page_data, y / 8, 0, GFX_MONO_LCD_WIDTH);
+        break;
+    case 1:
+        gfx_mono_draw_filled_rect(x, y, 1 + check_random(GFX_MONO_LCD_WIDTH - x),
+                                  1 + check_random(GFX_MONO_LCD_HEIGHT - y), check_random(3));
+        break;
+    case 2:
+    case 3:
+        //Past the right and bottom edges as well
+        width = 1 + check_random(GFX_MONO_LCD_WIDTH);
+        height = 1 + check_random(GFX_MONO_LCD_HEIGHT);
+        color = check_random(3);
+        display_layer_fill_rect(DISPLAY_LAYER_STATUS, x, y, width, height, color);
+        for (i = 0; i < height; i++)
+        {
+            uint16_t column;
+
+            for (column = x; column < x + width; column++)
+            {
+                model_set_pixel(&g_status, column, y + i, color);
+            }
+        }
+        break;
+    case 4:
+        check_random_string(str, x, &sysfont);
+        display_layer_draw_string(DISPLAY_LAYER_STATUS, str, x, y, &sysfont);
+        model_draw_string(&g_status, str, x, y, &sysfont);
+        break;
+    case 5:
+        if (check_random(4) == 0)
+        {
+            display_layer_clear(DISPLAY_LAYER_STATUS);
+            memset(g_status.pixels, 0, sizeof(g_status.pixels));
+            memset(g_status.opaque, 0, sizeof(g_status.opaque));
+        }
+        break;
+    default:
+        g_status.visible = !g_status.visible;
+        display_layer_set_visible(DISPLAY_LAYER_STATUS, g_status.visible);
+        break;
+    }
+}
+
+//Function to run the SPI jobs and flush steps until the driver has sent everything presented
+static void check_drain(void)
+{
+    do
+    {
+        ssd1306_sim_complete_job();
+    }
+    while (gfx_mono_flush() || ssd1306_sim_job_running());
+}
+
+//Function to decode the RLE of a stream page, see display_stream.c for the format
+static bool check_rle_decode(const uint8_t *data, uint16_t length, uint8_t *out)
+{
+    uint16_t in_pos = 0;
+    uint16_t out_pos = 0;
+    uint8_t control;
+    uint8_t count;
+
+    while (in_pos < length)
+    {
+        control = data[in_pos++];
+        count = (control < 128) ? control + 1 : control - 125;
+        if ((out_pos + count > GFX_MONO_LCD_WIDTH) || (in_pos + ((control < 128) ? count : 1) > length))
+        {
+            return false;
+        }
+        if (control < 128)
+        {
+            memcpy(&out[out_pos], &data[in_pos], count);
+            in_pos += count;
+        }
+        else
+        {
+            memset(&out[out_pos], data[in_pos++], count);
+        }
+        out_pos += count;
+    }
+    return out_pos == GFX_MONO_LCD_WIDTH;
+}
+
+//Function to request a delta frame of the display stream and apply it to the host's copy of the display
+static bool check_stream(uint32_t *stream_bytes)
+{
+    static uint8_t frame[CHECK_FRAME_MAX_SIZE];
+    uint16_t length;
+    uint16_t position = 3;
+    uint16_t page_length;
+    uint8_t checksum = 0;
+    uint8_t page;
+    uint16_t i;
+
+    usart_sim_queue(DISPLAY_STREAM_REQ_DELTA);
+    display_stream_poll();
+    length = usart_sim_take(frame, sizeof(frame));
+    *stream_bytes = length;
+    if ((length < 4) || (frame[0] != DISPLAY_STREAM_FRAME_START))
+    {
+        return false;
+    }
+    for (i = 1; i < length; i++)
+    {
+        checksum ^= frame[i];
+    }
+    if (checksum != 0)
+    {
+        return false;
+    }
+
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        if (!(frame[2] & (1 << page)))
+        {
+            continue;
+        }
+        page_length = frame[position] | (frame[position + 1] << 8);
+        position += 2;
+        if ((position + page_length >= length) ||
+            !check_rle_decode(&frame[position], page_length, &g_host_frame[page * GFX_MONO_LCD_WIDTH]))
+        {
+            return false;
+        }
+        position += page_length;
+    }
+    return position == length - 1;
+}
+
+static bool check_step(uint32_t step, check_totals *totals)
+{
+    static uint8_t expected[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+    const ssd1306_sim_stats *stats = ssd1306_sim_get_stats();
+    uint32_t stream_bytes = 0;
+    uint8_t changes = 1 + check_random(4);
+    uint16_t budget = check_random(3) ? 0 : 1 + check_random(GFX_MONO_LCD_WIDTH);
+    bool ok = true;
+    uint16_t i;
+
+    while (changes-- > 0)
+    {
+        check_change();
+    }
+
+    ssd1306_sim_reset_stats();
+    gfx_mono_set_flush_budget(budget);
+    display_layer_commit();
+    gfx_mono_present();
+    check_drain();
+    model_compose(expected);
+
+    if (memcmp(ssd1306_sim_get_ram(), expected, sizeof(expected)) != 0)
+    {
+        for (i = 0; ssd1306_sim_get_ram()[i] == expected[i]; i++)
+        {
+        }
+        printf("step %u: display differs at page %u column %u: 0x%02X, expected 0x%02X (status layer %s)\n", step,
+               i / GFX_MONO_LCD_WIDTH, i % GFX_MONO_LCD_WIDTH, ssd1306_sim_get_ram()[i], expected[i],
+               g_status.visible ? "shown" : "hidden");
+        ok = false;
+    }
+    if (stats->errors != 0)
+    {
+        printf("step %u: %u controller errors\n", step, stats->errors);
+        ok = false;
+    }
+    if (!check_stream(&stream_bytes))
+    {
+        printf("step %u: malformed stream frame\n", step);
+        ok = false;
+    }
+    else if (memcmp(g_host_frame, expected, sizeof(expected)) != 0)
+    {
+        printf("step %u: streamed display differs from the display (status layer %s)\n", step,
+               g_status.visible ? "shown" : "hidden");
+        ok = false;
+    }
+
+    totals->steps++;
+    totals->visible_steps += g_status.visible;
+    totals->sent_bytes += stats->data_bytes;
+    totals->stream_bytes += stream_bytes;
+    return ok;
+}
+
+//Function to check the opaque mask on a fixed picture before the random steps
+static bool check_fixed(void)
+{
+    uint8_t page_data[GFX_MONO_LCD_WIDTH];
+    const uint8_t *ram = ssd1306_sim_get_ram();
+
+    //Base lit over page 0, a cleared opaque rectangle over columns 10-19, rows 0-3
+    memset(page_data, 0xFF, sizeof(page_data));
+    gfx_mono_put_page(page_data, 0, 0, GFX_MONO_LCD_WIDTH);
+    display_layer_fill_rect(DISPLAY_LAYER_STATUS, 10, 0, 10, 4, GFX_PIXEL_CLR);
+    memset(&g_status, 0, sizeof(g_status));
+    memset(g_status.opaque + 10, 0x0F, 10);
+    display_layer_commit();
+    gfx_mono_present();
+    check_drain();
+    if ((ram[9] != 0xFF) || (ram[10] != 0xFF))
+    {
+        printf("fixed: a hidden layer shows on the display\n");
+        return false;
+    }
+
+    display_layer_set_visible(DISPLAY_LAYER_STATUS, true);
+    g_status.visible = true;
+    display_layer_commit();
+    gfx_mono_present();
+    check_drain();
+    if ((ram[9] != 0xFF) || (ram[10] != 0xF0) || (ram[19] != 0xF0) || (ram[20] != 0xFF))
+    {
+        printf("fixed: cleared opaque pixels do not hide the base layer\n");
+        return false;
+    }
+
+    display_layer_set_visible(DISPLAY_LAYER_STATUS, false);
+    g_status.visible = false;
+    display_layer_commit();
+    gfx_mono_present();
+    check_drain();
+    if (ram[10] != 0xFF)
+    {
+        printf("fixed: hiding the layer does not restore the base layer\n");
+        return false;
+    }
+    return true;
+}
+
+static void print_usage(const char *name)
+{
+    printf("usage: %s [-n steps] [-s seed]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    check_totals totals;
+    uint32_t steps = 20000;
+    uint32_t stream_bytes;
+    uint32_t i;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:s:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'n': steps = (uint32_t)atoi(optarg); break;
+        case 's': g_random_state = strtoull(optarg, NULL, 0) + 1; break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+
+    memset(&totals, 0, sizeof(totals));
+    gfx_mono_init();
+    display_layer_init();
+    usart_sim_queue(DISPLAY_STREAM_REQ_KEY);
+    display_stream_poll();
+    usart_sim_take(g_host_frame, sizeof(g_host_frame));
+    memset(g_host_frame, 0, sizeof(g_host_frame));
+
+    if (!check_fixed() || !check_stream(&stream_bytes))
+    {
+        totals.failures++;
+    }
+
+    for (i = 0; i < steps; i++)
+    {
+        if (!check_step(i, &totals))
+        {
+            totals.failures++;
+        }
+    }
+
+    printf("%u steps (status layer shown in %u), %u failed\n", totals.steps, totals.visible_steps, totals.failures);
+    printf("per step: %.1f display bytes sent, %.1f stream bytes\n", (double)totals.sent_bytes / totals.steps,
+           (double)totals.stream_bytes / totals.steps);
+
+    return (totals.failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,493 @@
+/**
+ * \file
+ * \brief  Checks the display list renderer against immediate gfx_mono drawing
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux with
+ *
+ *   S=../firmware/samd21/src G=$S/ASF/common2/services/gfx_mono
+ *   cc -O2 -Ihost -I$S -I$S/config -I$S/ASF/sam0/utils -I$G -o display_list_check display_list_check.c \
+ *      $S/display_list.c $G/gfx_mono_generic.c $G/gfx_mono_text.c $G/gfx_mono_framebuffer.c \
+ *      $G/sysfont.c $G/gfx_mono_null.c
+ *
+ * Every scene is drawn twice on the null driver of gfx_mono_null.c, once
+ * with the gfx_mono primitives of ASF and once through display_list.c, over
+ * the same random background. The two frames must match pixel for pixel.
+ * The null driver counts the bytes an SSD1306 would have received for each,
+ * which gives the writes the display list saves.
+ *
+ * Scenes are random lines, circles or strings, mixes of all commands like
+ * setup_board() and highlight_square() draw, and the board itself. Lines and
+ * circles go through gfx_mono_draw_pixel(), which drops pixels off the
+ * screen, so they are also drawn partly off it. The ASF rectangle and text
+ * primitives only clip a length running over the right edge; one starting
+ * past an edge writes outside the framebuffer, so rectangles and strings are
+ * kept on the screen like the game draws them.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <asf.h>
+#include "display_list.h"
+
+#define CHECK_MAX_OPS       40
+#define CHECK_TEXT_SIZE     DISPLAY_LIST_TEXT_MAX_SIZE
+
+typedef enum
+{
+    SCENE_LINES,
+    SCENE_CIRCLES,
+    SCENE_TEXT,
+    SCENE_MIXED,
+    SCENE_BOARD,
+    SCENE_KINDS,
+} check_scene_kind;
+
+typedef struct
+{
+    display_list_op op;
+    uint8_t color;
+    bool outline;       //DISPLAY_LIST_FILL drawn as a rectangle outline
+    gfx_coord_t a, b, c, d;
+    uint8_t octant_mask;
+    char text[CHECK_TEXT_SIZE];
+} check_op;
+
+typedef struct
+{
+    uint32_t scenes;
+    uint32_t failures;
+    uint64_t immediate_bytes;   //Command and data bytes of immediate drawing
+    uint64_t list_bytes;        //Command and data bytes of the display list
+    uint64_t immediate_transactions;
+    uint64_t list_transactions;
+} check_totals;
+
+static const char *const scene_names[SCENE_KINDS] = { "lines", "circles", "text", "mixed", "board" };
+
+static uint64_t g_random_state = 1;
+static const char *g_pbm_prefix;
+
+static uint32_t check_random(uint32_t range)
+{
+    //xorshift64*, the scenes only have to be repeatable for a seed
+    g_random_state ^= g_random_state >> 12;
+    g_random_state ^= g_random_state << 25;
+    g_random_state ^= g_random_state >> 27;
+    return (uint32_t)((g_random_state * 2685821657736338717ULL) >> 33) % range;
+}
+
+//Function to pick a coordinate, mostly on the screen and sometimes just past its edge
+static gfx_coord_t check_coord(gfx_coord_t size)
+{
+    return (gfx_coord_t)check_random(size + size / 4);
+}
+
+//Function to make a string that fits on the screen at x, y. gfx_mono_draw_string()
+//draws the first character even of an empty string, so there always is one
+static void check_random_text(char *text, gfx_coord_t x, gfx_coord_t y)
+{
+    static const char charset[] = " !#%()+-./0123456789:<=>?ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz|";
+    uint8_t columns = (GFX_MONO_LCD_WIDTH - x) / sysfont.width;
+    uint8_t lines = (GFX_MONO_LCD_HEIGHT - y + 1) / (sysfont.height + 1);
+    uint8_t length = 1 + check_random(CHECK_TEXT_SIZE - 1);
+    uint8_t column = 0;
+    uint8_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        if ((i > 0) && ((column == columns) || (check_random(12) == 0)))
+        {
+            if (--lines == 0)
+            {
+                break;
+            }
+            text[i] = '\n';
+            column = 0;
+            continue;
+        }
+        text[i] = charset[check_random(sizeof(charset) - 1)];
+        column++;
+    }
+    text[i] = '\0';
+}
+
+static void check_random_op(check_op *op, check_scene_kind kind)
+{
+    memset(op, 0, sizeof(*op));
+    op->color = check_random(3);
+
+    switch (kind)
+    {
+    case SCENE_LINES:
+        op->op = DISPLAY_LIST_LINE;
+        break;
+    case SCENE_CIRCLES:
+        op->op = DISPLAY_LIST_CIRCLE;
+        break;
+    case SCENE_TEXT:
+        op->op = DISPLAY_LIST_STRING;
+        break;
+    default:
+        op->op = check_random(DISPLAY_LIST_BITMAP);
+        break;
+    }
+
+    switch (op->op)
+    {
+    case DISPLAY_LIST_FILL:
+        //Only the width of a filled rectangle is clipped by ASF
+        op->outline = check_random(2);
+        op->a = check_random(GFX_MONO_LCD_WIDTH);
+        op->b = check_random(GFX_MONO_LCD_HEIGHT);
+        op->c = 1 + check_random(op->outline ? GFX_MONO_LCD_WIDTH - op->a : GFX_MONO_LCD_WIDTH / 2);
+        op->d = 1 + check_random(GFX_MONO_LCD_HEIGHT - op->b);
+        break;
+    case DISPLAY_LIST_LINE:
+        op->a = check_coord(GFX_MONO_LCD_WIDTH);
+        op->b = check_coord(GFX_MONO_LCD_HEIGHT);
+        op->c = check_coord(GFX_MONO_LCD_WIDTH);
+        op->d = check_coord(GFX_MONO_LCD_HEIGHT);
+        break;
+    case DISPLAY_LIST_CIRCLE:
+        op->a = check_coord(GFX_MONO_LCD_WIDTH);
+        op->b = check_coord(GFX_MONO_LCD_HEIGHT);
+        op->c = check_random(GFX_MONO_LCD_HEIGHT);
+        op->octant_mask = check_random(2) ? GFX_WHOLE : check_random(256);
+        break;
+    default:
+        op->a = check_random(GFX_MONO_LCD_WIDTH - sysfont.width + 1);
+        op->b = check_random(GFX_MONO_LCD_HEIGHT - sysfont.height + 1);
+        check_random_text(op->text, op->a, op->b);
+        break;
+    }
+}
+
+//Function to build the tic-tac-toe board of setup_board() and a highlighted square
+static uint8_t check_board_ops(check_op *ops)
+{
+    const gfx_coord_t square = GFX_MONO_LCD_HEIGHT / 3;
+    uint8_t count = 0;
+    uint8_t i;
+
+    memset(ops, 0, sizeof(*ops) * 8);
+    ops[count].op = DISPLAY_LIST_FILL;
+    ops[count].color = GFX_PIXEL_CLR;
+    ops[count].c = GFX_MONO_LCD_WIDTH;
+    ops[count++].d = GFX_MONO_LCD_HEIGHT;
+    for (i = 1; i <= 2; i++)
+    {
+        ops[count].op = DISPLAY_LIST_LINE;
+        ops[count].color = GFX_PIXEL_SET;
+        ops[count].a = square * i;
+        ops[count].c = square * i;
+        ops[count++].d = square * 3;
+        ops[count].op = DISPLAY_LIST_LINE;
+        ops[count].color = GFX_PIXEL_SET;
+        ops[count].b = square * i;
+        ops[count].c = square * 3;
+        ops[count++].d = square * i;
+    }
+    ops[count].op = DISPLAY_LIST_STRING;
+    ops[count].a = square * 3 + 8;
+    snprintf(ops[count++].text, CHECK_TEXT_SIZE, "Games: %u", check_random(1000));
+    ops[count].op = DISPLAY_LIST_STRING;
+    ops[count].a = square * 3 + 8;
+    ops[count].b = square;
+    snprintf(ops[count++].text, CHECK_TEXT_SIZE, "Wins: %u", check_random(1000));
+    ops[count].op = DISPLAY_LIST_FILL;
+    ops[count].outline = true;
+    ops[count].color = GFX_PIXEL_SET;
+    ops[count].a = square * check_random(3) + 1;
+    ops[count].b = square * check_random(3) + 1;
+    ops[count].c = square - 2;
+    ops[count++].d = square - 2;
+
+    return count;
+}
+
+static void check_draw_immediate(const check_op *ops, uint8_t count)
+{
+    uint8_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        const check_op *op = &ops[i];
+
+        switch (op->op)
+        {
+        case DISPLAY_LIST_FILL:
+            if (op->outline)
+            {
+                gfx_mono_draw_rect(op->a, op->b, op->c, op->d, op->color);
+            }
+            else
+            {
+                gfx_mono_draw_filled_rect(op->a, op->b, op->c, op->d, op->color);
+            }
+            break;
+        case DISPLAY_LIST_LINE:
+            gfx_mono_draw_line(op->a, op->b, op->c, op->d, op->color);
+            break;
+        case DISPLAY_LIST_CIRCLE:
+            gfx_mono_draw_circle(op->a, op->b, op->c, op->color, op->octant_mask);
+            break;
+        default:
+            gfx_mono_draw_string(op->text, op->a, op->b, &sysfont);
+            break;
+        }
+    }
+}
+
+static void check_draw_list(const check_op *ops, uint8_t count)
+{
+    uint8_t i;
+
+    display_list_begin();
+    for (i = 0; i < count; i++)
+    {
+        const check_op *op = &ops[i];
+
+        switch (op->op)
+        {
+        case DISPLAY_LIST_FILL:
+            if (op->outline)
+            {
+                display_list_rect(op->a, op->b, op->c, op->d, op->color);
+            }
+            else
+            {
+                display_list_fill_rect(op->a, op->b, op->c, op->d, op->color);
+            }
+            break;
+        case DISPLAY_LIST_LINE:
+            display_list_line(op->a, op->b, op->c, op->d, op->color);
+            break;
+        case DISPLAY_LIST_CIRCLE:
+            display_list_circle(op->a, op->b, op->c, op->color, op->octant_mask);
+            break;
+        default:
+            display_list_string(op->text, op->a, op->b, &sysfont);
+            break;
+        }
+    }
+    display_list_execute();
+}
+
+//Function to fill the display with a random pattern through the driver, without counting it
+static void check_background(uint64_t seed)
+{
+    uint8_t page_data[GFX_MONO_LCD_WIDTH];
+    uint64_t state = seed;
+    uint8_t page;
+    uint8_t i;
+
+    gfx_mono_init();
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        for (i = 0; i < GFX_MONO_LCD_WIDTH; i++)
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            page_data[i] = (state >> 56) & (state >> 48);
+        }
+        gfx_mono_put_page(page_data, page, 0, GFX_MONO_LCD_WIDTH);
+    }
+    gfx_mono_null_reset_stats();
+}
+
+static void check_snapshot(uint8_t *frame)
+{
+    uint8_t page;
+
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        gfx_mono_framebuffer_get_page(&frame[page * GFX_MONO_LCD_WIDTH], page, 0, GFX_MONO_LCD_WIDTH);
+    }
+}
+
+static void check_write_pbm(uint32_t scene, const char *name)
+{
+    uint8_t image[GFX_MONO_NULL_PBM_SIZE];
+    char path[256];
+    FILE *file;
+
+    snprintf(path, sizeof(path), "%s%u_%s.pbm", g_pbm_prefix, scene, name);
+    file = fopen(path, "wb");
+    if (file != NULL)
+    {
+        fwrite(image, 1, gfx_mono_null_export_pbm(image, sizeof(image)), file);
+        fclose(file);
+    }
+}
+
+static void check_print_op(const check_op *op)
+{
+    static const char *const ops[] = { "fill", "line", "circle", "string", "bitmap" };
+
+    if (op->op == DISPLAY_LIST_STRING)
+    {
+        printf("    string (%u, %u) \"", op->a, op->b);
+        for (const char *c = op->text; *c != '\0'; c++)
+        {
+            printf((*c == '\n') ? "\\n" : "%c", *c);
+        }
+        printf("\"\n");
+    }
+    else
+    {
+        printf("    %s%s (%u, %u, %u, %u) color %u octants 0x%02X\n", ops[op->op],
+               op->outline ? " outline" : "", op->a, op->b, op->c, op->d, op->color, op->octant_mask);
+    }
+}
+
+static bool check_scene(uint32_t scene, check_scene_kind kind, check_totals *totals)
+{
+    static uint8_t immediate_frame[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+    static uint8_t list_frame[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+    check_op ops[CHECK_MAX_OPS];
+    const struct gfx_mono_null_stats *stats = gfx_mono_null_get_stats();
+    uint64_t background = ((uint64_t)check_random(UINT32_MAX) << 32) | check_random(UINT32_MAX);
+    uint8_t count;
+    uint16_t i;
+
+    if (kind == SCENE_BOARD)
+    {
+        count = check_board_ops(ops);
+    }
+    else
+    {
+        count = 1 + check_random((kind == SCENE_MIXED) ? CHECK_MAX_OPS : 8);
+        for (i = 0; i < count; i++)
+        {
+            check_random_op(&ops[i], kind);
+        }
+    }
+
+    check_background(background);
+    check_draw_immediate(ops, count);
+    check_snapshot(immediate_frame);
+    totals->immediate_bytes += stats->command_bytes + stats->data_bytes;
+    totals->immediate_transactions += stats->transactions;
+    if (g_pbm_prefix != NULL)
+    {
+        check_write_pbm(scene, "gfx_mono");
+    }
+
+    check_background(background);
+    check_draw_list(ops, count);
+    check_snapshot(list_frame);
+    totals->list_bytes += stats->command_bytes + stats->data_bytes;
+    totals->list_transactions += stats->transactions;
+    if (g_pbm_prefix != NULL)
+    {
+        check_write_pbm(scene, "display_list");
+    }
+
+    totals->scenes++;
+    if (memcmp(immediate_frame, list_frame, sizeof(list_frame)) == 0)
+    {
+        return true;
+    }
+
+    totals->failures++;
+    for (i = 0; i < sizeof(list_frame); i++)
+    {
+        if (immediate_frame[i] != list_frame[i])
+        {
+            break;
+        }
+    }
+    printf("scene %u (%s): pixels differ first at x %u page %u, gfx_mono 0x%02X display list 0x%02X\n",
+           scene, scene_names[kind], i % GFX_MONO_LCD_WIDTH, i / GFX_MONO_LCD_WIDTH,
+           immediate_frame[i], list_frame[i]);
+    for (i = 0; i < count; i++)
+    {
+        check_print_op(&ops[i]);
+    }
+    return false;
+}
+
+static void print_usage(const char *name)
+{
+    printf("usage: %s [-n scenes per kind] [-s seed] [-p pbm prefix]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    check_totals totals[SCENE_KINDS];
+    check_totals sum;
+    uint32_t scenes = 2000;
+    uint32_t scene = 0;
+    uint32_t i;
+    int kind;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:s:p:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'n': scenes = (uint32_t)atoi(optarg); break;
+        case 's': g_random_state = strtoull(optarg, NULL, 0) + 1; break;
+        case 'p': g_pbm_prefix = optarg; break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+
+    memset(totals, 0, sizeof(totals));
+    memset(&sum, 0, sizeof(sum));
+    for (kind = 0; kind < SCENE_KINDS; kind++)
+    {
+        for (i = 0; i < scenes; i++)
+        {
+            check_scene(scene++, kind, &totals[kind]);
+        }
+    }
+
+    printf("%-8s %7s %8s %12s %12s %7s\n", "scenes", "count", "failed", "gfx_mono B", "list B", "saved");
+    for (kind = 0; kind < SCENE_KINDS; kind++)
+    {
+        printf("%-8s %7u %8u %12llu %12llu %6.1f%%\n", scene_names[kind], totals[kind].scenes,
+               totals[kind].failures, (unsigned long long)totals[kind].immediate_bytes,
+               (unsigned long long)totals[kind].list_bytes,
+               100.0 * (1.0 - (double)totals[kind].list_bytes / (double)totals[kind].immediate_bytes));
+        sum.scenes += totals[kind].scenes;
+        sum.failures += totals[kind].failures;
+        sum.immediate_bytes += totals[kind].immediate_bytes;
+        sum.list_bytes += totals[kind].list_bytes;
+        sum.immediate_transactions += totals[kind].immediate_transactions;
+        sum.list_transactions += totals[kind].list_transactions;
+    }
+    printf("%u scenes, %u failed; SSD1306 bytes %llu -> %llu, address setups %llu -> %llu\n",
+           sum.scenes, sum.failures, (unsigned long long)sum.immediate_bytes, (unsigned long long)sum.list_bytes,
+           (unsigned long long)sum.immediate_transactions, (unsigned long long)sum.list_transactions);
+
+    return (sum.failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,374 @@
+/**
+ * \file
+ * \brief  Checks the areas the double-buffered SSD1306 driver sends per frame
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux with
+ *
+ *   S=../firmware/samd21/src G=$S/ASF/common2/services/gfx_mono
+ *   cc -O2 -DGFX_MONO_UG_2832HSWEG04 -Ihost -I$S -I$S/config -I$S/ASF/sam0/utils -I$G \
+ *      -o display_present_check display_present_check.c host/ssd1306_sim.c $S/display_list.c \
+ *      $G/gfx_mono_ug_2832hsweg04.c $G/gfx_mono_generic.c $G/gfx_mono_text.c \
+ *      $G/gfx_mono_framebuffer.c $G/sysfont.c
+ *
+ * The driver of gfx_mono_ug_2832hsweg04.c runs with CONFIG_SSD1306_DOUBLE_BUFFER
+ * on the simulated controller of host/ssd1306_sim.c. Every frame draws random
+ * primitives and display list commands into the back buffer, then presents
+ * it and calls gfx_mono_flush() until the driver is idle. Without a flush
+ * budget the driver sends whole frames, so by default a budget of one page
+ * is set to have it send only the dirty ranges it tracked. After that:
+ *
+ * - the display RAM must equal the back buffer, as if the whole frame had
+ *   been sent like gfx_mono_null_put_framebuffer() accounts it,
+ * - every byte differing from the previous frame must have been sent, and
+ * - the span sent per page is compared with the span of the differences.
+ *   It is wider only where a byte was changed and restored within a frame,
+ *   or a display list page write rewrote unchanged bytes between changes.
+ *
+ * -b sets the flush budget, 0 for whole frames. No SPI job may be larger than
+ * the budget, and without -m a frame must be sent in exactly one flush call
+ * per budget sized part of each page span, plus the call reporting idle.
+ *
+ * With -m the SPI jobs are held until the check completes them, and up to
+ * three frames are presented while the first part of the previous one is
+ * still being sent. They must merge into the
+ * last one, and the driver must not touch a buffer the SPI job still reads.
+ *
+ * With -p the display is initialized in the steps console_oled_poll() uses.
+ * gfx_mono_init_finish() must not send anything, the cleared frame must go
+ * out as one SPI job once presented, and the flush steps must then clear the
+ * display.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <asf.h>
+#include "display_list.h"
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t failures;
+    uint32_t exact_pages;       //Changed pages sent exactly over the span of their differences
+    uint32_t wider_pages;       //Changed pages sent over a wider span
+    uint64_t diff_bytes;        //Bytes inside the difference spans
+    uint64_t sent_bytes;        //Display data bytes sent
+    uint64_t jobs;
+    uint64_t flush_calls;
+    uint32_t most_flush_calls;  //Flush calls of the frame needing the most
+} check_totals;
+
+static uint64_t g_random_state = 1;
+
+static uint32_t check_random(uint32_t range)
+{
+    g_random_state ^= g_random_state >> 12;
+    g_random_state ^= g_random_state << 25;
+    g_random_state ^= g_random_state >> 27;
+    return (uint32_t)((g_random_state * 2685821657736338717ULL) >> 33) % range;
+}
+
+//Function to draw a few random primitives into the back buffer, on the screen like the game does
+static void check_draw(void)
+{
+    uint8_t count = check_random(6);
+    uint8_t page_data[GFX_MONO_LCD_WIDTH];
+    gfx_coord_t x, y;
+    uint8_t i;
+    uint8_t j;
+
+    for (i = 0; i < count; i++)
+    {
+        x = check_random(GFX_MONO_LCD_WIDTH - 8);
+        y = check_random(GFX_MONO_LCD_HEIGHT - 8);
+        switch (check_random(7))
+        {
+        case 0:
+            gfx_mono_draw_pixel(x, y, check_random(3));
+            break;
+        case 1:
+            gfx_mono_draw_line(x, y, check_random(GFX_MONO_LCD_WIDTH), check_random(GFX_MONO_LCD_HEIGHT),
+                               check_random(3));
+            break;
+        case 2:
+            gfx_mono_draw_filled_rect(x, y, 1 + check_random(GFX_MONO_LCD_WIDTH - x),
+                                      1 + check_random(GFX_MONO_LCD_HEIGHT - y), check_random(3));
+            break;
+        case 3:
+            gfx_mono_draw_circle(x, y, check_random(12), check_random(3), GFX_WHOLE);
+            break;
+        case 4:
+            gfx_mono_draw_string("42", x, y, &sysfont);
+            break;
+        case 5:
+            //A page write rewrites every byte it covers, changed or not
+            for (j = 0; j < sizeof(page_data); j++)
+            {
+                page_data[j] = check_random(4) ? 0x00 : (uint8_t)check_random(256);
+            }
+            j = check_random(GFX_MONO_LCD_WIDTH / 2);
+            gfx_mono_put_page(page_data, y / 8, x, min(j + 1, GFX_MONO_LCD_WIDTH - x));
+            break;
+        default:
+            display_list_begin();
+            display_list_rect(x, y, 8, 8, check_random(2));
+            display_list_string("ok", check_random(GFX_MONO_LCD_WIDTH - 12), check_random(GFX_MONO_LCD_HEIGHT - 7),
+                                &sysfont);
+            display_list_execute();
+            break;
+        }
+    }
+}
+
+static void check_back_buffer(uint8_t *frame)
+{
+    uint8_t page;
+
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        gfx_mono_framebuffer_get_page(&frame[page * GFX_MONO_LCD_WIDTH], page, 0, GFX_MONO_LCD_WIDTH);
+    }
+}
+
+//Function to run the SPI jobs and flush steps until the driver has sent everything presented
+static uint32_t check_drain(void)
+{
+    uint32_t calls = 0;
+    bool pending;
+
+    do
+    {
+        ssd1306_sim_complete_job();
+        calls++;
+        pending = gfx_mono_flush();
+    }
+    while (pending || ssd1306_sim_job_running());
+
+    return calls;
+}
+
+//Function to check the display against a frame and the bytes sent against its differences to before
+static bool check_frame(uint32_t frame_number, const uint8_t *before, const uint8_t *frame, uint16_t budget,
+                        uint32_t *parts, check_totals *totals)
+{
+    const uint8_t *ram = ssd1306_sim_get_ram();
+    const uint8_t *written = ssd1306_sim_get_written();
+    int16_t diff_first, diff_last, sent_first, sent_last;
+    bool ok = true;
+    uint8_t page;
+    int16_t i;
+
+    *parts = 0;
+
+    if (memcmp(ram, frame, GFX_MONO_LCD_FRAMEBUFFER_SIZE) != 0)
+    {
+        for (i = 0; ram[i] == frame[i]; i++)
+        {
+        }
+        printf("frame %u: display differs from the presented frame at page %u column %u\n",
+               frame_number, i / GFX_MONO_LCD_WIDTH, i % GFX_MONO_LCD_WIDTH);
+        ok = false;
+    }
+
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        diff_first = sent_first = GFX_MONO_LCD_WIDTH;
+        diff_last = sent_last = -1;
+        for (i = 0; i < GFX_MONO_LCD_WIDTH; i++)
+        {
+            uint16_t offset = page * GFX_MONO_LCD_WIDTH + i;
+
+            if (before[offset] != frame[offset])
+            {
+                diff_first = min(diff_first, i);
+                diff_last = i;
+                if (!written[offset])
+                {
+                    printf("frame %u: page %u column %u changed but was not sent\n", frame_number, page, i);
+                    ok = false;
+                }
+            }
+            if (written[offset])
+            {
+                sent_first = min(sent_first, i);
+                sent_last = i;
+            }
+        }
+
+        if (sent_last >= 0)
+        {
+            *parts += (budget == 0) ? 1 : (sent_last - sent_first + budget) / budget;
+        }
+        if (diff_last >= 0)
+        {
+            totals->diff_bytes += diff_last - diff_first + 1;
+            if (sent_first == diff_first && sent_last == diff_last)
+            {
+                totals->exact_pages++;
+            }
+            else
+            {
+                totals->wider_pages++;
+            }
+        }
+    }
+
+    return ok;
+}
+
+static void print_usage(const char *name)
+{
+    printf("usage: %s [-n frames] [-s seed] [-b budget] [-m] [-p]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t before[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+    static uint8_t frame[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+    const ssd1306_sim_stats *stats = ssd1306_sim_get_stats();
+    check_totals totals;
+    uint32_t frames = 20000;
+    uint16_t budget = GFX_MONO_LCD_WIDTH;
+    uint32_t calls;
+    uint32_t parts;
+    bool merge = false;
+    bool polled = false;
+    bool ok;
+    uint8_t presents;
+    uint32_t i;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:s:b:mph")) != -1)
+    {
+        switch (option)
+        {
+        case 'n': frames = (uint32_t)atoi(optarg); break;
+        case 's': g_random_state = strtoull(optarg, NULL, 0) + 1; break;
+        case 'b': budget = (uint16_t)atoi(optarg); break;
+        case 'm': merge = true; break;
+        case 'p': polled = true; break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+
+    memset(&totals, 0, sizeof(totals));
+    if (polled)
+    {
+        //The cleared frame is held until the drain completes it
+        gfx_mono_init_start();
+        ssd1306_sim_defer_jobs(true);
+        gfx_mono_init_release();
+        gfx_mono_init_finish();
+        if (stats->jobs != 0 || stats->data_bytes != 0)
+        {
+            printf("gfx_mono_init_finish() sent display data\n");
+            return 1;
+        }
+        gfx_mono_present();
+        if (!ssd1306_sim_job_running() || stats->jobs != 1)
+        {
+            printf("gfx_mono_present() did not start the cleared frame as one SPI job\n");
+            return 1;
+        }
+        check_drain();
+    }
+    else
+    {
+        gfx_mono_init();
+    }
+    gfx_mono_set_flush_budget(budget);
+    ssd1306_sim_defer_jobs(merge);
+    memcpy(before, ssd1306_sim_get_ram(), sizeof(before));
+    if (stats->errors != 0 || memcmp(before, (uint8_t[GFX_MONO_LCD_FRAMEBUFFER_SIZE]){ 0 }, sizeof(before)) != 0)
+    {
+        printf("gfx_mono_init() did not clear the display\n");
+        return 1;
+    }
+
+    for (i = 0; i < frames; i++)
+    {
+        ssd1306_sim_clear_written();
+        ssd1306_sim_reset_stats();
+
+        //Frames presented while a job runs are merged, only the last one has to show
+        presents = merge ? 1 + check_random(3) : 1;
+        while (presents-- > 0)
+        {
+            check_draw();
+            gfx_mono_present();
+            if (merge)
+            {
+                gfx_mono_flush();
+            }
+        }
+        check_back_buffer(frame);
+        calls = check_drain();
+
+        totals.frames++;
+        totals.sent_bytes += stats->data_bytes;
+        totals.jobs += stats->jobs;
+        totals.flush_calls += calls;
+        totals.most_flush_calls = max(totals.most_flush_calls, calls);
+        ok = check_frame(i, before, frame, budget, &parts, &totals);
+        if (stats->errors != 0)
+        {
+            printf("frame %u: %u controller errors\n", i, stats->errors);
+            ok = false;
+        }
+        if (budget != 0 && stats->largest_job > budget)
+        {
+            printf("frame %u: SPI job of %u bytes exceeds the budget of %u\n", i, stats->largest_job, budget);
+            ok = false;
+        }
+        //Sending a whole frame starts in gfx_mono_present(), the drain only sees it finish
+        if (!merge && calls != ((budget == 0) ? 1 : parts + 1))
+        {
+            printf("frame %u: %u flush calls for %u parts\n", i, calls, parts);
+            ok = false;
+        }
+        if (!ok)
+        {
+            totals.failures++;
+        }
+        memcpy(before, frame, sizeof(before));
+    }
+
+    printf("%u frames, %u failed\n", totals.frames, totals.failures);
+    printf("changed pages sent over their difference span: %u exactly, %u wider\n",
+           totals.exact_pages, totals.wider_pages);
+    printf("bytes per frame: %.1f sent, %.1f in difference spans, %u for a full frame; %.2f SPI jobs\n",
+           (double)totals.sent_bytes / totals.frames, (double)totals.diff_bytes / totals.frames,
+           GFX_MONO_LCD_FRAMEBUFFER_SIZE, (double)totals.jobs / totals.frames);
+    printf("flush calls per frame with a budget of %u bytes: %.2f average, %u most\n",
+           budget, (double)totals.flush_calls / totals.frames, totals.most_flush_calls);
+
+    return (totals.failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+##
+# \file
+#
+# \brief Host check of the display stream encoder against its decoder
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# display_stream.c sends the display to stream_display_over_serial.py as RLE
+# encoded delta frames. This module builds display_stream.c with the host
+# compiler, on the null gfx_mono driver and the console stand-in of
+# host/usart_sim.c, wraps it with ctypes and feeds what it sends to the
+# decoder of stream_display_over_serial.py.
+#
+# --selftest checks the RLE encoding against the Python encoder and decodes
+# it back for runs and literals around every length limit, then streams
+# random frame sequences and compares the rebuilt display, the page masks
+# and the error checks of the decoder.
+import os
+import sys
+import ctypes
+import random
+import hashlib
+import argparse
+import tempfile
+import subprocess
+
+TOOLS = os.path.dirname(os.path.abspath(__file__))
+FIRMWARE = os.path.join(TOOLS, "..", "firmware", "samd21", "src")
+GFX_MONO = os.path.join(FIRMWARE, "ASF", "common2", "services", "gfx_mono")
+
+sys.path.insert(0, os.path.join(GFX_MONO, "tools"))
+import stream_display_over_serial as stream
+
+SOURCES = [os.path.join(FIRMWARE, "display_stream.c"), os.path.join(TOOLS, "host", "usart_sim.c"),
+		os.path.join(GFX_MONO, "gfx_mono_null.c"), os.path.join(GFX_MONO, "gfx_mono_framebuffer.c")]
+HEADERS = [os.path.join(FIRMWARE, "display_stream.h"), os.path.join(TOOLS, "host", "usart.h"),
+		os.path.join(TOOLS, "host", "asf.h"), os.path.join(GFX_MONO, "gfx_mono_null.h")]
+INCLUDES = [os.path.join(TOOLS, "host"), FIRMWARE, os.path.join(FIRMWARE, "config"),
+		os.path.join(FIRMWARE, "ASF", "sam0", "utils"), GFX_MONO]
+
+PAGE_SIZE = stream.WIDTH
+FRAME_SIZE = stream.WIDTH * stream.PAGES
+
+class StreamCheckError(Exception):
+	pass
+
+class StreamStats(ctypes.Structure):
+	_fields_ = [("frames", ctypes.c_uint16), ("raw_bytes", ctypes.c_uint32), ("sent_bytes", ctypes.c_uint32)]
+
+def build(compiler="cc"):
+	# One build per version of the sources, shared by all users of the machine's temp directory
+	sources = hashlib.sha256()
+	for file_name in SOURCES + HEADERS:
+		with open(file_name, "rb") as source_file:
+			sources.update(source_file.read())
+	digest = sources.hexdigest()[:16]
+	library = os.path.join(tempfile.gettempdir(), "display_stream_%s.so" % digest)
+	if not os.path.exists(library):
+		partial = "%s.%u" % (library, os.getpid())
+		try:
+			subprocess.check_call([compiler, "-O2", "-shared", "-fPIC", "-o", partial]
+					+ ["-I" + include for include in INCLUDES] + SOURCES)
+		except (OSError, subprocess.CalledProcessError) as e:
+			raise StreamCheckError("cannot build display_stream.c: %s" % e)
+		os.replace(partial, library)
+	return library
+
+class Target(object):
+	# The firmware side, read and written like the serial port of the board
+	def __init__(self, library=None):
+		self.library = ctypes.CDLL(library or build())
+		self.library.display_stream_rle_encode.argtypes = (ctypes.c_char_p, ctypes.c_uint16, ctypes.c_char_p)
+		self.library.display_stream_rle_encode.restype = ctypes.c_uint16
+		self.library.display_stream_get_stats.restype = ctypes.POINTER(StreamStats)
+		self.library.gfx_mono_null_put_page.argtypes = (ctypes.c_char_p, ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint8)
+		self.library.usart_sim_take.argtypes = (ctypes.c_char_p, ctypes.c_uint16)
+		self.library.usart_sim_take.restype = ctypes.c_uint16
+		self.library.usart_sim_queue.argtypes = (ctypes.c_uint8,)
+		self.library.usart_sim_overflows.restype = ctypes.c_uint32
+		self.library.gfx_mono_null_init()
+		self.received = b""
+
+	def encode(self, data):
+		# A literal control byte for every 128 bytes at most
+		bound = len(data) + (len(data) + 127) // 128
+		out = ctypes.create_string_buffer(bound + 16)
+		length = self.library.display_stream_rle_encode(bytes(data), len(data), out)
+		if length > bound:
+			raise StreamCheckError("%u bytes encode to %u bytes, more than %u" % (len(data), length, bound))
+		return out.raw[:length]
+
+	def show(self, framebuffer):
+		for page in range(stream.PAGES):
+			self.library.gfx_mono_null_put_page(bytes(framebuffer[page * PAGE_SIZE:(page + 1) * PAGE_SIZE]),
+					page, 0, PAGE_SIZE)
+
+	def stats(self):
+		return self.library.display_stream_get_stats().contents
+
+	def write(self, request):
+		for byte in request:
+			self.library.usart_sim_queue(byte)
+			self.library.display_stream_poll()
+		buffer = ctypes.create_string_buffer(8192)
+		length = self.library.usart_sim_take(buffer, len(buffer))
+		self.received += buffer.raw[:length]
+		if self.library.usart_sim_overflows():
+			raise StreamCheckError("console buffer overflow")
+
+	def read(self, length):
+		data, self.received = self.received[:length], self.received[length:]
+		return data
+
+	def close(self):
+		pass
+
+def rle_cases(rng):
+	cases = [b"", b"\x00", bytes(PAGE_SIZE), bytes(range(256)), bytes(rng.randrange(256) for _ in range(PAGE_SIZE))]
+	# Runs around the minimum and maximum run, between and at the ends of literals
+	for run in list(range(1, 8)) + list(range(125, 136)) + [259, 260, 261, 300]:
+		cases.append(b"\x55" * run)
+		cases.append(b"\x01\x02" + b"\x55" * run + b"\x03")
+		cases.append(b"\x01\x02" + b"\x55" * run)
+		cases.append(b"\x55" * run + b"\x01\x02")
+	# Literals around the longest literal
+	for literal in list(range(1, 5)) + list(range(126, 131)) + [255, 256, 257]:
+		data = bytes((index * 7 + 1) & 0xFF for index in range(literal))
+		cases.append(data)
+		cases.append(data + b"\x00" * 3)
+		cases.append(b"\x00" * 3 + data)
+	# Pages like the game draws: mostly blank with short details
+	for _ in range(200):
+		page = bytearray(PAGE_SIZE)
+		for _ in range(rng.randrange(8)):
+			start = rng.randrange(PAGE_SIZE)
+			for column in range(start, min(start + rng.randrange(1, 20), PAGE_SIZE)):
+				page[column] = rng.choice((0xFF, 0x81, rng.randrange(256)))
+		cases.append(bytes(page))
+	return cases
+
+def random_frame(rng, framebuffer, pages):
+	for page in pages:
+		start = page * PAGE_SIZE
+		kind = rng.randrange(3)
+		for column in range(PAGE_SIZE):
+			if kind == 0:
+				framebuffer[start + column] = rng.randrange(256)
+			elif kind == 1:
+				framebuffer[start + column] = 0xFF if (column // rng.randrange(1, 9)) % 2 else 0x00
+			elif rng.randrange(16) == 0:
+				framebuffer[start + column] ^= 1 << rng.randrange(8)
+
+def selftest(target, seed, frames):
+	rng = random.Random(seed)
+
+	cases = rle_cases(rng)
+	for data in cases:
+		encoded = target.encode(data)
+		if encoded != stream.rle_encode(data):
+			raise StreamCheckError("%u bytes encode differently than in stream_display_over_serial.py" % len(data))
+		if stream.rle_decode(encoded, len(data)) != data:
+			raise StreamCheckError("%u bytes do not decode back" % len(data))
+	print("rle: %u buffers ok" % len(cases))
+
+	display = stream.Display()
+	framebuffer = bytearray(FRAME_SIZE)
+	random_frame(rng, framebuffer, range(stream.PAGES))
+	target.show(framebuffer)
+	request = stream.REQ_KEY
+	for frame in range(frames):
+		page_mask = display.receive(target, request)
+		expected_mask = (1 << stream.PAGES) - 1 if request == stream.REQ_KEY else changed_mask
+		if page_mask != expected_mask:
+			raise StreamCheckError("frame %u: page mask 0x%X, expected 0x%X" % (frame, page_mask, expected_mask))
+		if display.framebuffer != framebuffer:
+			raise StreamCheckError("frame %u: decoded display differs" % frame)
+
+		# Changed pages, sometimes changed back to what the host already has
+		changed = [page for page in range(stream.PAGES) if rng.randrange(3) == 0]
+		before = bytes(framebuffer)
+		random_frame(rng, framebuffer, changed)
+		if rng.randrange(10) == 0:
+			framebuffer[:] = before
+		target.show(framebuffer)
+		changed_mask = sum(1 << page for page in range(stream.PAGES)
+				if framebuffer[page * PAGE_SIZE:(page + 1) * PAGE_SIZE] != before[page * PAGE_SIZE:(page + 1) * PAGE_SIZE])
+		request = stream.REQ_KEY if rng.randrange(20) == 0 else stream.REQ_DELTA
+
+	stats = target.stats()
+	if stats.frames != frames or stats.sent_bytes != display.received_bytes:
+		raise StreamCheckError("stats count %u frames and %u bytes, the host %u and %u" % (stats.frames,
+				stats.sent_bytes, display.frames, display.received_bytes))
+	print("frames: %u ok, %u bytes sent for %u raw bytes, ratio %.2f" % (frames, stats.sent_bytes,
+			stats.raw_bytes, stats.raw_bytes / float(stats.sent_bytes)))
+
+	# The decoder must notice a corrupted frame and a lost one
+	target.write(stream.REQ_KEY)
+	frame = bytearray(target.read(len(target.received)))
+	frame[-1] ^= 0x01
+	target.received = bytes(frame)
+	try:
+		display.receive(target, b"")
+		raise StreamCheckError("corrupted checksum not detected")
+	except stream.StreamError:
+		pass
+	target.write(stream.REQ_DELTA)
+	target.read(len(target.received))
+	try:
+		display.receive(target, stream.REQ_DELTA)
+		raise StreamCheckError("lost frame not detected")
+	except stream.StreamError:
+		pass
+	print("errors: ok")
+
+def main():
+	parser = argparse.ArgumentParser(description="This script checks the "
+			"RLE delta frames display_stream.c sends against the decoder of "
+			"stream_display_over_serial.py, with display_stream.c built for "
+			"the host.")
+	parser.add_argument("--selftest", dest="selftest", action="store_true",
+			help="round trip buffers and frame sequences through the decoder")
+	parser.add_argument("--frames", dest="frames", type=int, default=500,
+			help="frames to stream for --selftest, default is 500")
+	parser.add_argument("--seed", dest="seed", type=int, default=1,
+			help="seed of the random frames, default is 1")
+
+	arguments = parser.parse_args()
+
+	if not arguments.selftest:
+		parser.print_usage()
+		sys.exit()
+
+	try:
+		selftest(Target(), arguments.seed, arguments.frames)
+	except (StreamCheckError, stream.StreamError) as e:
+		print("error: %s" % (str(e)))
+		sys.exit(1)
+
+if __name__ == "__main__":
+	main()
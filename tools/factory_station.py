@@ -0,0 +1,403 @@
+##
+# \file
+#
+# \brief Factory station provisioning boards through the factory mode of factory_mode.c
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# For every board the station waits for it to answer the hello, reads its
+# serial number, derives the diversified key with the master key and sends
+# one job with the configuration image, the key and a nonce input. The board
+# writes and locks everything without a button press and answers the timing
+# of every stage and a MAC over the nonce, which the station checks. A board
+# with a locked data zone is provisioned already and refuses jobs. Several
+# serial ports are served in parallel, one board fixture each.
+#
+# With --table the station builds the challenge/MAC table of every board
+# with challenge_table.py and writes it row by row before the job, for
+# firmware built with CHALLENGE_TABLE_MODE.
+#
+# With --simulate the boards are simulated on the host with the typical
+# command timings of config_writer_sim.py, to measure units per hour.
+import os
+import sys
+import time
+import struct
+import argparse
+import threading
+
+import atca_host
+import challenge_table
+import config_writer_sim
+
+FRAME_START = 0xA6
+REQ_HELLO = b"F"
+CMD_HELLO = ord("F")
+CMD_INFO = ord("I")
+CMD_JOB = ord("P")
+CMD_TABLE = ord("T")
+CMD_QUIT = ord("Q")
+
+STAGES = ("config write", "config lock", "key", "verify")
+ATCA_SUCCESS = 0x00
+ATCA_DATA_ZONE_LOCKED = 0x02
+ATCA_BAD_PARAM = 0xE2
+PROTOCOL_VERSION = 2
+
+class StationError(Exception):
+	pass
+
+def checksum(data):
+	value = 0
+	for byte in data:
+		value ^= byte
+	return value
+
+def encode_request(command, payload = b""):
+	body = struct.pack("<BH", command, len(payload)) + payload
+	return bytes((FRAME_START,)) + body + bytes((checksum(body),))
+
+def encode_answer(command, status, payload = b""):
+	body = struct.pack("<BBH", command, status, len(payload)) + payload
+	return bytes((FRAME_START,)) + body + bytes((checksum(body),))
+
+def read_exact(port, length):
+	data = port.read(length)
+	if len(data) != length:
+		raise StationError("timeout waiting for the board")
+	return data
+
+def read_answer(port):
+	# Skip console text printed before the frame
+	while True:
+		data = port.read(1)
+		if not data:
+			return None
+		if data[0] == FRAME_START:
+			break
+	header = read_exact(port, 4)
+	command, status, length = struct.unpack("<BBH", header)
+	payload = read_exact(port, length)
+	if read_exact(port, 1)[0] != checksum(header + payload):
+		raise StationError("checksum mismatch in answer to %c" % command)
+	return command, status, payload
+
+def request(port, command, payload = b""):
+	port.write(encode_request(command, payload))
+	answer = read_answer(port)
+	if answer is None:
+		raise StationError("no answer to %c" % command)
+	if answer[0] != command:
+		raise StationError("answer to %c instead of %c" % (answer[0], command))
+	return answer[1], answer[2]
+
+class Station(object):
+	def __init__(self, config, master_key, slot, table_entries = 0):
+		self.config = config
+		self.master_key = master_key
+		self.slot = slot
+		self.table_entries = table_entries
+		self.lock = threading.Lock()
+		self.claimed = 0
+		self.units = 0
+		self.failures = 0
+		self.stage_usec = [0] * len(STAGES)
+		self.table_seconds = 0.0
+
+	def wait_for_board(self, port, stop):
+		# The 'F' of a HELLO frame also starts factory mode on a board waiting for SW0
+		while not stop.is_set():
+			port.write(encode_request(CMD_HELLO))
+			answer = read_answer(port)
+			if answer is not None and answer[0] == CMD_HELLO:
+				return True
+		return False
+
+	def provision(self, port):
+		status, info = request(port, CMD_INFO)
+		if status != ATCA_SUCCESS:
+			raise StationError("INFO failed with 0x%02X" % status)
+		serial_number = info[:atca_host.SERIAL_NUMBER_SIZE]
+		if info[atca_host.SERIAL_NUMBER_SIZE + 1]:
+			# The board refuses table rows and jobs with ATCA_DATA_ZONE_LOCKED
+			raise StationError("%s is already provisioned" % serial_number.hex())
+		key = atca_host.derive_key(self.master_key, serial_number, self.slot)
+		num_in = os.urandom(atca_host.NUM_IN_SIZE)
+		table_seconds = self.write_table(port, serial_number, key) if self.table_entries else 0.0
+
+		payload = (bytes((len(self.config),)) + self.config + bytes((self.slot,)) + key + num_in)
+		status, answer = request(port, CMD_JOB, payload)
+		if status != ATCA_SUCCESS:
+			stage = STAGES[answer[0]] if answer and answer[0] < len(STAGES) else "job"
+			raise StationError("%s failed with 0x%02X" % (stage, status))
+
+		stage_usec = struct.unpack_from("<%uI" % len(STAGES), answer, 1 + atca_host.SERIAL_NUMBER_SIZE)
+		offset = 1 + atca_host.SERIAL_NUMBER_SIZE + 4 * len(STAGES) + 3
+		rand_out = answer[offset:offset + atca_host.KEY_SIZE]
+		mac = answer[offset + atca_host.KEY_SIZE:offset + 2 * atca_host.KEY_SIZE]
+		temp_key = atca_host.nonce_temp_key(rand_out, num_in)
+		if mac != atca_host.mac_temp_key(key, temp_key, serial_number, self.slot):
+			raise StationError("MAC of %s does not match" % serial_number.hex())
+		return serial_number, stage_usec, table_seconds
+
+	def write_table(self, port, serial_number, key):
+		# The job returns from factory mode, so the table goes first
+		started = time.time()
+		image = challenge_table.build_image(serial_number, key, self.slot, self.table_entries)
+		for offset, row in challenge_table.rows(image):
+			status, answer = request(port, CMD_TABLE, struct.pack("<H", offset) + row)
+			if status != ATCA_SUCCESS:
+				raise StationError("table row 0x%04X failed with 0x%02X" % (offset, status))
+			if answer != struct.pack("<H", atca_host.crc16_update(0, row)):
+				raise StationError("table row 0x%04X does not read back" % offset)
+		return time.time() - started
+
+	def serve(self, port, units, stop):
+		while not stop.is_set():
+			with self.lock:
+				if units and self.claimed >= units:
+					return
+				self.claimed += 1
+			if not self.wait_for_board(port, stop):
+				return
+			try:
+				serial_number, stage_usec, table_seconds = self.provision(port)
+			except StationError as e:
+				print("%s: %s" % (port.name, str(e)))
+				with self.lock:
+					self.failures += 1
+				continue
+			with self.lock:
+				self.units += 1
+				self.table_seconds += table_seconds
+				for stage in range(len(STAGES)):
+					self.stage_usec[stage] += stage_usec[stage]
+			if hasattr(port, "next_board"):
+				port.next_board()
+
+class SimulatedBoard(object):
+	# Typical execution times in microseconds
+	LOCK_USEC = 15000
+	WRITE_USEC = 7000
+	NONCE_USEC = 7000
+	MAC_USEC = 5000
+	READ_USEC = 1000
+	ROW_USEC = 6000 + 4 * 2500      # SAMD21 row erase and four page writes
+
+	def __init__(self, name, device, config, time_scale, baud, handling_seconds):
+		self.name = name
+		self.device = device
+		self.config = config
+		self.time_scale = time_scale
+		self.byte_seconds = 10.0 / baud
+		self.handling_seconds = handling_seconds
+		self.pending = bytearray()
+		self.output = bytearray()
+		self.new_board()
+
+	def new_board(self):
+		self.serial_number = bytes((0x01, 0x23)) + os.urandom(6) + bytes((0xEE,))
+		self.zone = bytearray(config_writer_sim.scenarios(self.config)[0][1])
+		self.config_locked = False
+		self.data_locked = False
+		self.key = None
+		self.listening = False
+		self.table = {}
+
+	def next_board(self):
+		# The operator swaps the board, the new one boots up to its SW0 wait
+		self.sleep(self.handling_seconds)
+		self.new_board()
+
+	def sleep(self, seconds):
+		time.sleep(seconds * self.time_scale)
+
+	def write(self, data):
+		self.sleep(len(data) * self.byte_seconds)
+		for byte in data:
+			if not self.listening:
+				if byte == REQ_HELLO[0]:
+					self.listening = True
+					self.output += encode_answer(CMD_HELLO, ATCA_SUCCESS, bytes((PROTOCOL_VERSION,)))
+				continue
+			self.pending.append(byte)
+			self.parse()
+
+	def read(self, length):
+		if len(self.output) < length:
+			self.sleep(0.05)
+			length = len(self.output)
+		data = bytes(self.output[:length])
+		del self.output[:length]
+		self.sleep(len(data) * self.byte_seconds)
+		return data
+
+	def parse(self):
+		while self.pending and self.pending[0] != FRAME_START:
+			del self.pending[0]
+		if len(self.pending) < 5:
+			return
+		command, length = struct.unpack_from("<BH", self.pending, 1)
+		if len(self.pending) < 5 + length:
+			return
+		payload = bytes(self.pending[4:4 + length])
+		del self.pending[:5 + length]
+		self.output += self.handle(command, payload)
+
+	def handle(self, command, payload):
+		if command == CMD_INFO:
+			self.sleep(3 * self.READ_USEC / 1e6)
+			return encode_answer(command, ATCA_SUCCESS, self.serial_number
+					+ bytes((self.config_locked, self.data_locked, 0)))
+		if command in (CMD_TABLE, CMD_JOB) and self.data_locked:
+			return encode_answer(command, ATCA_DATA_ZONE_LOCKED)
+		if command == CMD_TABLE:
+			offset = struct.unpack_from("<H", payload)[0]
+			row = payload[2:]
+			if offset % challenge_table.ROW_SIZE or offset + len(row) > challenge_table.REGION_SIZE:
+				return encode_answer(command, ATCA_BAD_PARAM)
+			self.sleep(self.ROW_USEC / 1e6)
+			self.table[offset] = row
+			return encode_answer(command, ATCA_SUCCESS, struct.pack("<H", atca_host.crc16_update(0, row)))
+		if command != CMD_JOB:
+			return encode_answer(command, ATCA_SUCCESS)
+
+		config_size = payload[0]
+		config = payload[1:1 + config_size]
+		slot = payload[1 + config_size]
+		key = payload[2 + config_size:2 + config_size + atca_host.KEY_SIZE]
+		num_in = payload[2 + config_size + atca_host.KEY_SIZE:]
+
+		stage_usec = [0] * len(STAGES)
+		device = config_writer_sim.Device(self.device, self.zone, 400000)
+		if not self.config_locked:
+			config_writer_sim.diff_write(device, config)
+			stage_usec[0] = int(device.usec)
+			stage_usec[1] = self.LOCK_USEC
+			self.config_locked = True
+		self.key = key
+		stage_usec[2] = self.WRITE_USEC + 2 * self.LOCK_USEC
+		self.data_locked = True
+		rand_out = os.urandom(atca_host.KEY_SIZE)
+		temp_key = atca_host.nonce_temp_key(rand_out, num_in)
+		mac = atca_host.mac_temp_key(self.key, temp_key, self.serial_number, slot)
+		stage_usec[3] = self.NONCE_USEC + self.MAC_USEC
+		self.sleep(sum(stage_usec) / 1e6)
+
+		answer = (bytes((len(STAGES),)) + self.serial_number + struct.pack("<%uI" % len(STAGES), *stage_usec)
+				+ bytes((0, 0, 0)) + rand_out + mac)
+		return encode_answer(command, ATCA_SUCCESS, answer)
+
+def open_port(serial_port, baud_rate):
+	import serial
+	port = serial.Serial(port = serial_port, baudrate = baud_rate, timeout = 0.05)
+	port.name = serial_port
+	return port
+
+def main():
+	parser = argparse.ArgumentParser(description="This script provisions "
+			"boards waiting in factory mode. It derives the key of every "
+			"board from its serial number, sends the configuration image "
+			"and the key in one job and checks the MAC the board answers. "
+			"Every serial port is served in parallel. With --simulate the "
+			"boards are simulated to measure units per hour.")
+	parser.add_argument("-p", "--port", dest="serial_ports", action="append",
+			default=[], help="serial port of a board fixture, repeat for more")
+	parser.add_argument("-b", "--baud", dest="baudrate", type=int,
+			help="baud rate of the console, default is 115200", default=115200)
+	parser.add_argument("-d", "--device", dest="device", default="ecc608",
+			choices=("sha204", "ecc508", "ecc608"), help="configuration "
+			"image of provision_device.c to write, default is ecc608")
+	parser.add_argument("-k", "--master-key", dest="master_key",
+			help="master key as 64 hex digits, default is the demo key of main.c")
+	parser.add_argument("-n", "--units", dest="units", type=int, default=0,
+			help="stop after this many boards, 0 to run until interrupted")
+	parser.add_argument("-t", "--table", dest="table_entries", type=int, default=0,
+			metavar="ENTRIES", help="write a challenge/MAC table of this many "
+			"entries before the job, for CHALLENGE_TABLE_MODE firmware")
+	parser.add_argument("--simulate", dest="simulate", type=int, default=0,
+			metavar="FIXTURES", help="simulate this many board fixtures")
+	parser.add_argument("--time-scale", dest="time_scale", type=float, default=1.0,
+			help="run simulated delays this much faster or slower, results "
+			"are scaled back to real time")
+	parser.add_argument("--handling", dest="handling_seconds", type=float, default=0.0,
+			help="seconds to swap a simulated board")
+
+	arguments = parser.parse_args()
+
+	try:
+		config = config_writer_sim.read_configurations(config_writer_sim.FIRMWARE_SOURCE)[arguments.device]
+		master_key = bytes.fromhex(arguments.master_key) if arguments.master_key else atca_host.MASTER_KEY
+	except (IOError, ValueError, KeyError) as e:
+		print("error: %s" % (str(e)))
+		sys.exit(1)
+
+	if arguments.simulate:
+		if not arguments.units:
+			arguments.units = 10 * arguments.simulate
+		ports = [SimulatedBoard("sim%u" % index, arguments.device, config, arguments.time_scale,
+				arguments.baudrate, arguments.handling_seconds) for index in range(arguments.simulate)]
+		time_scale = arguments.time_scale
+	elif arguments.serial_ports:
+		try:
+			ports = [open_port(serial_port, arguments.baudrate) for serial_port in arguments.serial_ports]
+		except Exception as e:
+			print("error: could not open serial port. %s" % (str(e)))
+			sys.exit(1)
+		time_scale = 1.0
+	else:
+		parser.print_usage()
+		sys.exit()
+
+	if not 0 <= arguments.table_entries <= challenge_table.MAX_ENTRIES:
+		print("error: a table holds 1 to %u entries" % challenge_table.MAX_ENTRIES)
+		sys.exit(1)
+
+	station = Station(config, master_key, atca_host.AUTH_KEY_SLOT, arguments.table_entries)
+	stop = threading.Event()
+	threads = [threading.Thread(target = station.serve, args = (port, arguments.units, stop))
+			for port in ports]
+	started = time.time()
+	for thread in threads:
+		thread.start()
+	try:
+		for thread in threads:
+			while thread.is_alive():
+				thread.join(0.5)
+	except KeyboardInterrupt:
+		stop.set()
+		for thread in threads:
+			thread.join()
+	elapsed = (time.time() - started) / time_scale
+
+	print("%u boards provisioned, %u failed in %.1f s" % (station.units, station.failures, elapsed))
+	if station.units:
+		print("%.0f units per hour with %u fixtures" % (station.units * 3600 / elapsed, len(ports)))
+		for stage, usec in zip(STAGES, station.stage_usec):
+			print("  %-12s %8.1f ms average" % (stage, usec / 1000.0 / station.units))
+		if arguments.table_entries:
+			print("  %-12s %8.1f ms average" % ("table", station.table_seconds * 1000.0 / time_scale / station.units))
+
+if __name__ == "__main__":
+	main()
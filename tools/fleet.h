@@ -0,0 +1,160 @@
+/**
+ * \file
+ * \brief  Records exchanged between simulated boards and the fleet verifier
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#ifndef FLEET_H_
+#define FLEET_H_
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * A board's authentication is the serial number, the NumIn the host sent
+ * with the Nonce command, the RandOut the device returned and the MAC
+ * response, see symmetric_authenticate(). Boards send them to the verifier
+ * in UDP datagrams of up to FLEET_DATAGRAM_RECORDS records, the verifier
+ * answers every record with its id and a status.
+ */
+#define FLEET_PORT                  4360
+#define FLEET_DATAGRAM_RECORDS      14
+
+#define FLEET_STATUS_OK             0   //The response is the MAC of the board's key
+#define FLEET_STATUS_MISMATCH       1   //Wrong response
+#define FLEET_STATUS_UNKNOWN        2   //The serial number is not in the key store
+#define FLEET_STATUS_BUSY           3   //The verifier queue was full, the record was dropped
+#define FLEET_STATUSES              4
+
+typedef struct
+{
+    uint8_t id[4];                  //Little endian, chosen by the sender
+    uint8_t serial_number[9];
+    uint8_t num_in[20];
+    uint8_t rand_out[32];
+    uint8_t response[32];
+} fleet_record;
+
+typedef struct
+{
+    uint8_t id[4];
+    uint8_t status;
+} fleet_reply;
+
+/*
+ * Traffic files, written by fleet_traffic.py and replayed by fleet_replay.c:
+ * a header and count records in the order they are sent.
+ */
+#define FLEET_TRAFFIC_MAGIC         "FTRF"
+#define FLEET_TRAFFIC_VERSION       1
+
+typedef struct
+{
+    uint8_t magic[4];
+    uint8_t version;
+    uint8_t reserved[3];
+    uint8_t count[4];               //Little endian
+} fleet_traffic_header;
+
+typedef struct
+{
+    uint8_t serial_number[9];
+    uint8_t num_in[20];
+    uint8_t rand_out[32];
+    uint8_t response[32];
+    uint8_t expected;               //FLEET_STATUS_OK, _MISMATCH or _UNKNOWN
+} fleet_traffic_record;
+
+/*
+ * Latency histogram with 4 buckets per power of two nanoseconds, so a
+ * percentile is known within 25%.
+ */
+#define FLEET_HISTOGRAM_BUCKETS     256
+
+static inline uint32_t fleet_get_le32(const uint8_t *data)
+{
+    return data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static inline void fleet_put_le32(uint8_t *data, uint32_t value)
+{
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+    data[2] = (uint8_t)(value >> 16);
+    data[3] = (uint8_t)(value >> 24);
+}
+
+static inline uint64_t fleet_time_nsec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static inline unsigned int fleet_histogram_bucket(uint64_t nsec)
+{
+    unsigned int power;
+
+    if (nsec < 4)
+    {
+        return (unsigned int)nsec;
+    }
+    power = 63 - (unsigned int)__builtin_clzll(nsec);
+    return 4 * (power - 1) + (unsigned int)((nsec >> (power - 2)) & 3);
+}
+
+//Lowest latency of a bucket
+static inline uint64_t fleet_histogram_value(unsigned int bucket)
+{
+    if (bucket < 4)
+    {
+        return bucket;
+    }
+    return (uint64_t)(4 + (bucket & 3)) << (bucket / 4 - 1);
+}
+
+//Function to find the latency at or below which a fraction of the samples are, 0 without samples
+static inline uint64_t fleet_histogram_percentile(const uint64_t *histogram, double fraction)
+{
+    uint64_t total = 0, seen = 0;
+    unsigned int bucket;
+
+    for (bucket = 0; bucket < FLEET_HISTOGRAM_BUCKETS; bucket++)
+    {
+        total += histogram[bucket];
+    }
+    for (bucket = 0; bucket < FLEET_HISTOGRAM_BUCKETS && total; bucket++)
+    {
+        seen += histogram[bucket];
+        if (seen >= fraction * total)
+        {
+            return fleet_histogram_value(bucket);
+        }
+    }
+    return 0;
+}
+
+#endif /* FLEET_H_ */
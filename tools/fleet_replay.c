@@ -0,0 +1,384 @@
+/**
+ * \file
+ * \brief  Replay a traffic file of board authentications against the fleet verifier
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux with
+ *
+ *   cc -O2 -pthread -o fleet_replay fleet_replay.c
+ *
+ * Every thread sends its share of the records of a fleet_traffic.py file
+ * from its own socket, FLEET_DATAGRAM_RECORDS or fewer per datagram, at a
+ * fixed rate or as fast as its window of unanswered records allows. The
+ * replies are matched by id with the record, the expected status and the
+ * send time. Records without a reply after a second are counted as lost.
+ */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "fleet.h"
+
+#define REPLAY_MAX_THREADS          64
+#define REPLAY_LOST_NSEC            1000000000ULL
+#define REPLAY_ID_BITS              24
+
+typedef struct
+{
+    uint64_t sent_nsec;
+    uint32_t id;
+    uint32_t record;
+    bool pending;
+} replay_slot;
+
+typedef struct
+{
+    pthread_t thread;
+    unsigned int number;
+    int socket;
+    replay_slot *window;
+    uint64_t sent;
+    uint64_t lost;
+    uint64_t statuses[FLEET_STATUSES + 1][FLEET_STATUSES];
+    uint64_t latency[FLEET_HISTOGRAM_BUCKETS];
+} replay_thread;
+
+static struct
+{
+    const char *address;
+    uint16_t port;
+    unsigned int threads;
+    unsigned int per_datagram;
+    size_t window;
+    double rate;
+    unsigned int loops;
+} options =
+{
+    .address = "127.0.0.1",
+    .port = FLEET_PORT,
+    .threads = 2,
+    .per_datagram = FLEET_DATAGRAM_RECORDS,
+    .window = 1024,
+    .rate = 0,
+    .loops = 1,
+};
+
+static const fleet_traffic_record *traffic;
+static uint32_t traffic_count;
+
+static bool load_traffic(const char *file_name);
+static void *replay_main(void *argument);
+static void receive_replies(replay_thread *thread, int timeout_msec);
+
+//Function to map a traffic file
+static bool load_traffic(const char *file_name)
+{
+    struct stat status;
+    const fleet_traffic_header *header;
+    const uint8_t *map;
+    int fd = open(file_name, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(fleet_traffic_header))
+    {
+        fprintf(stderr, "error: cannot read %s\n", file_name);
+        return false;
+    }
+    map = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        fprintf(stderr, "error: cannot map %s\n", file_name);
+        return false;
+    }
+
+    header = (const fleet_traffic_header*)map;
+    traffic_count = fleet_get_le32(header->count);
+    if (memcmp(header->magic, FLEET_TRAFFIC_MAGIC, 4) != 0 || header->version != FLEET_TRAFFIC_VERSION
+            || (size_t)status.st_size < sizeof(*header) + (size_t)traffic_count * sizeof(fleet_traffic_record))
+    {
+        fprintf(stderr, "error: %s is not a version %u traffic file\n", file_name, FLEET_TRAFFIC_VERSION);
+        return false;
+    }
+    traffic = (const fleet_traffic_record*)(map + sizeof(*header));
+    return true;
+}
+
+//Function to match the replies that arrived within the timeout with their records
+static void receive_replies(replay_thread *thread, int timeout_msec)
+{
+    fleet_reply replies[FLEET_DATAGRAM_RECORDS * 2];
+    struct pollfd descriptor = { thread->socket, POLLIN, 0 };
+
+    while (poll(&descriptor, 1, timeout_msec) > 0)
+    {
+        ssize_t size = recv(thread->socket, replies, sizeof(replies), MSG_DONTWAIT);
+        uint64_t now = fleet_time_nsec();
+        size_t i;
+
+        if (size <= 0)
+        {
+            break;
+        }
+        for (i = 0; i < (size_t)size / sizeof(fleet_reply); i++)
+        {
+            uint32_t id = fleet_get_le32(replies[i].id);
+            replay_slot *slot = &thread->window[id & (options.window - 1)];
+
+            //Replies to records given up on find their slot reused
+            if (!slot->pending || slot->id != id || replies[i].status >= FLEET_STATUSES)
+            {
+                continue;
+            }
+            slot->pending = false;
+            thread->statuses[traffic[slot->record].expected][replies[i].status]++;
+            thread->latency[fleet_histogram_bucket(now - slot->sent_nsec)]++;
+        }
+        timeout_msec = 0;
+    }
+}
+
+static void *replay_main(void *argument)
+{
+    replay_thread *thread = argument;
+    fleet_record datagram[FLEET_DATAGRAM_RECORDS];
+    uint64_t total = (uint64_t)options.loops * traffic_count;
+    uint64_t sequence = 0, oldest = 0, record;
+    double interval = options.rate > 0 ? options.threads * 1e9 / options.rate : 0;
+    uint64_t started = fleet_time_nsec();
+
+    //Records thread, thread + threads, ... of every loop
+    record = thread->number;
+    while (record < total || oldest < sequence)
+    {
+        uint64_t now = fleet_time_nsec();
+        size_t count = 0;
+
+        //Skip answered records, give up on the oldest after a second when the window is full or all are sent
+        while (oldest < sequence)
+        {
+            replay_slot *slot = &thread->window[oldest & (options.window - 1)];
+
+            if (slot->pending)
+            {
+                if ((sequence - oldest < options.window && record < total) || now - slot->sent_nsec < REPLAY_LOST_NSEC)
+                {
+                    break;
+                }
+                slot->pending = false;
+                thread->lost++;
+            }
+            oldest++;
+        }
+
+        while (count < options.per_datagram && record < total && sequence - oldest < options.window
+                && (interval == 0 || now >= started + (uint64_t)(sequence * interval)))
+        {
+            const fleet_traffic_record *source = &traffic[record % traffic_count];
+            replay_slot *slot = &thread->window[sequence & (options.window - 1)];
+            fleet_record *target = &datagram[count++];
+
+            slot->id = (thread->number << REPLAY_ID_BITS) | (uint32_t)(sequence & ((1u << REPLAY_ID_BITS) - 1));
+            fleet_put_le32(target->id, slot->id);
+            memcpy(target->serial_number, source->serial_number, sizeof(target->serial_number));
+            memcpy(target->num_in, source->num_in, sizeof(target->num_in));
+            memcpy(target->rand_out, source->rand_out, sizeof(target->rand_out));
+            memcpy(target->response, source->response, sizeof(target->response));
+            slot->record = (uint32_t)(record % traffic_count);
+            slot->sent_nsec = now;
+            slot->pending = true;
+            sequence++;
+            record += options.threads;
+        }
+        if (count)
+        {
+            if (send(thread->socket, datagram, count * sizeof(fleet_record), 0) < 0)
+            {
+                //Receive buffer of the verifier full, the replies will be lost
+                ;
+            }
+            thread->sent += count;
+        }
+
+        //Wait when the window is full, sending is paced or everything is sent
+        receive_replies(thread, count ? 0 : 1);
+    }
+    return NULL;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [-a address] [-p port] [-t threads] [-n records per datagram]\n"
+            "       [-w window] [-r records/s] [-l loops] traffic file\n"
+            "  -w  unanswered records per thread, a power of two, default is 1024\n"
+            "  -r  total send rate, default is as fast as the windows allow\n", program);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const names[FLEET_STATUSES] = { "ok", "mismatch", "unknown", "busy" };
+    replay_thread *threads;
+    struct sockaddr_in address;
+    uint64_t statuses[FLEET_STATUSES + 1][FLEET_STATUSES] = { { 0 } }, latency[FLEET_HISTOGRAM_BUCKETS] = { 0 };
+    uint64_t sent = 0, lost = 0, replies = 0, wrong;
+    uint64_t started;
+    double seconds;
+    unsigned int i, j, k;
+    int option;
+
+    while ((option = getopt(argc, argv, "a:p:t:n:w:r:l:")) != -1)
+    {
+        switch (option)
+        {
+        case 'a': options.address = optarg; break;
+        case 'p': options.port = (uint16_t)atoi(optarg); break;
+        case 't': options.threads = (unsigned int)atoi(optarg); break;
+        case 'n': options.per_datagram = (unsigned int)atoi(optarg); break;
+        case 'w': options.window = (size_t)atol(optarg); break;
+        case 'r': options.rate = atof(optarg); break;
+        case 'l': options.loops = (unsigned int)atoi(optarg); break;
+        default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1 || options.threads < 1 || options.threads > REPLAY_MAX_THREADS || options.per_datagram < 1
+            || options.per_datagram > FLEET_DATAGRAM_RECORDS || options.window < 1 || options.window > (1u << REPLAY_ID_BITS)
+            || (options.window & (options.window - 1))
+            || options.loops < 1)
+    {
+        usage(argv[0]);
+    }
+    if (!load_traffic(argv[optind]))
+    {
+        return 1;
+    }
+    if (traffic_count == 0)
+    {
+        fprintf(stderr, "error: no records in %s\n", argv[optind]);
+        return 1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(options.port);
+    if (inet_pton(AF_INET, options.address, &address.sin_addr) != 1)
+    {
+        usage(argv[0]);
+    }
+
+    threads = calloc(options.threads, sizeof(replay_thread));
+    if (threads == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < options.threads; i++)
+    {
+        int buffer = 4 << 20;
+
+        threads[i].number = i;
+        threads[i].window = calloc(options.window, sizeof(replay_slot));
+        threads[i].socket = socket(AF_INET, SOCK_DGRAM, 0);
+        if (threads[i].window == NULL || threads[i].socket < 0
+                || connect(threads[i].socket, (struct sockaddr*)&address, sizeof(address)) != 0)
+        {
+            fprintf(stderr, "error: cannot open a socket to %s:%u: %s\n", options.address, options.port, strerror(errno));
+            return 1;
+        }
+        setsockopt(threads[i].socket, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+    }
+
+    started = fleet_time_nsec();
+    for (i = 0; i < options.threads; i++)
+    {
+        pthread_create(&threads[i].thread, NULL, replay_main, &threads[i]);
+    }
+    for (i = 0; i < options.threads; i++)
+    {
+        pthread_join(threads[i].thread, NULL);
+        sent += threads[i].sent;
+        lost += threads[i].lost;
+        for (j = 0; j < FLEET_STATUSES; j++)
+        {
+            for (k = 0; k < FLEET_STATUSES; k++)
+            {
+                statuses[j][k] += threads[i].statuses[j][k];
+                replies += threads[i].statuses[j][k];
+            }
+        }
+        for (j = 0; j < FLEET_HISTOGRAM_BUCKETS; j++)
+        {
+            latency[j] += threads[i].latency[j];
+        }
+    }
+    seconds = (fleet_time_nsec() - started) / 1e9;
+
+    printf("%llu records sent in %.2f s, %.0f records/s, %llu replies, %llu lost\n",
+           (unsigned long long)sent, seconds, sent / seconds, (unsigned long long)replies, (unsigned long long)lost);
+    printf("round trip p50 %.1f p99 %.1f max %.1f us\n", fleet_histogram_percentile(latency, 0.5) / 1e3,
+           fleet_histogram_percentile(latency, 0.99) / 1e3, fleet_histogram_percentile(latency, 1.0) / 1e3);
+    printf("%-10s", "expected");
+    for (k = 0; k < FLEET_STATUSES; k++)
+    {
+        printf("%12s", names[k]);
+    }
+    printf("\n");
+    for (j = 0; j < FLEET_STATUS_BUSY; j++)
+    {
+        printf("%-10s", names[j]);
+        for (k = 0; k < FLEET_STATUSES; k++)
+        {
+            printf("%12llu", (unsigned long long)statuses[j][k]);
+        }
+        printf("\n");
+    }
+
+    //A verifier deriving keys from the master key answers mismatch for unknown boards
+    wrong = statuses[FLEET_STATUS_OK][FLEET_STATUS_MISMATCH] + statuses[FLEET_STATUS_OK][FLEET_STATUS_UNKNOWN]
+            + statuses[FLEET_STATUS_MISMATCH][FLEET_STATUS_OK] + statuses[FLEET_STATUS_MISMATCH][FLEET_STATUS_UNKNOWN]
+            + statuses[FLEET_STATUS_UNKNOWN][FLEET_STATUS_OK];
+    if (wrong)
+    {
+        printf("%llu records answered with a wrong status\n", (unsigned long long)wrong);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,799 @@
+/**
+ * \file
+ * \brief  Simulated fleet of boards authenticating on a virtual clock
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux with
+ *
+ *   cc -O2 -pthread -I../firmware/samd21/src -o fleet_sim fleet_sim.c sha256_mb.c
+ *
+ * Every board has a serial number, the key device_provision() derives for
+ * it and the rand() state its ADC seed gave it. Like SysTick_Handler() and
+ * authenticate_application() it draws the next authentication interval from
+ * AUTHENTICATION_MIN_MSEC and AUTHENTICATION_RANGE_MSEC of configuration.h,
+ * then the NumIn of host_generate_random_number(), and sends the MAC of the
+ * Nonce TempKey. rand() is newlib's, so a board seeded like the firmware
+ * draws the same intervals and NumIns (the game's rand() calls aside).
+ *
+ * The boards are split over worker threads that advance together in slices
+ * of virtual time; the main thread paces the slices against the wall clock
+ * or lets them run as fast as they go. Records go to fleet_verifier.c over
+ * UDP, to a traffic file for fleet_replay.c, or nowhere to measure the
+ * generation alone.
+ */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "configuration.h"
+#include "fleet.h"
+#include "sha256_mb.h"
+
+#define SIM_MAX_THREADS             64
+#define SIM_BATCH                   64
+#define SIM_REPLY_WAIT_NSEC         1000000000ULL
+
+#define NEWLIB_RAND_MAX             0x7FFFFFFF
+
+typedef struct
+{
+    uint8_t serial_number[MAC_SERIAL_NUMBER_SIZE];
+    uint8_t key[MAC_KEY_SIZE];
+    uint64_t rand_next;             //State of newlib's rand()
+    uint64_t device_random;         //State of the secure element's RandOut
+    uint64_t next_msec;             //Virtual time of the next authentication
+    uint64_t power_on_msec;
+    bool booted;
+    bool counterfeit;
+} sim_board;
+
+typedef struct
+{
+    pthread_t thread;
+    unsigned int number;
+    uint32_t *heap;                 //Boards of the thread by next_msec
+    size_t heap_size;
+    uint32_t due[SIM_BATCH];
+    uint8_t serial_numbers[SIM_BATCH * MAC_SERIAL_NUMBER_SIZE];
+    uint8_t keys[SIM_BATCH * MAC_KEY_SIZE];
+    uint8_t num_ins[SIM_BATCH * NONCE_NUM_IN_SIZE];
+    uint8_t rand_outs[SIM_BATCH * NONCE_RAND_OUT_SIZE];
+    uint8_t temp_keys[SIM_BATCH * SHA256_DIGEST_SIZE];
+    uint8_t macs[SIM_BATCH * SHA256_DIGEST_SIZE];
+    fleet_record datagram[FLEET_DATAGRAM_RECORDS];
+    size_t datagram_count;
+    int socket;
+    uint32_t sequence;
+    fleet_traffic_record *output;   //Records of the slice for the traffic file
+    size_t output_count;
+    size_t output_size;
+    uint64_t random;                //Failure injection
+    uint64_t generated;
+    uint64_t injected[FLEET_STATUSES];
+    uint64_t dropped;
+    uint64_t replies[FLEET_STATUSES];
+    uint64_t send_errors;
+} sim_thread;
+
+static struct
+{
+    unsigned int boards;
+    unsigned int threads;
+    double duration;
+    double speed;
+    double rate;
+    unsigned int slice_msec;
+    unsigned int boot_msec;
+    unsigned int spread_msec;
+    double corrupt;
+    double counterfeit;
+    double drop;
+    uint64_t seed;
+    uint16_t slot;
+    uint8_t master_key[MAC_KEY_SIZE];
+    const char *output_file;
+    const char *address;
+    uint16_t port;
+    int path;
+} options =
+{
+    .boards = 1000,
+    .threads = 4,
+    .duration = 60,
+    .slice_msec = 10,
+    .boot_msec = 100,
+    .spread_msec = AUTHENTICATION_MIN_MSEC + AUTHENTICATION_RANGE_MSEC,
+    .seed = 1,
+    .slot = CRYPTOAUTH_DEVICE_AUTH_KEY_SLOT,
+    .port = FLEET_PORT,
+    .path = SHA256_MB_AUTO,
+    //Demo master key of get_master_key() in main.c
+    .master_key =
+    {
+        0x37, 0x80, 0xe6, 0x3d, 0x49, 0x68, 0xad, 0xe5,
+        0xd8, 0x22, 0xc0, 0x13, 0xfc, 0xc3, 0x23, 0x84,
+        0x5d, 0x1b, 0x56, 0x9f, 0xe7, 0x05, 0xb6, 0x00,
+        0x06, 0xfe, 0xec, 0x14, 0x5a, 0x0d, 0xb1, 0xe3
+    },
+};
+
+static sim_board *boards;
+static sim_thread *threads;
+static pthread_barrier_t slice_start;
+static pthread_barrier_t slice_end;
+static uint64_t slice_end_msec;
+static bool finished;
+static struct sockaddr_in verifier_address;
+
+static uint64_t splitmix64(uint64_t *state);
+static double uniform(uint64_t *state);
+static int newlib_rand(sim_board *board);
+static void heap_push(sim_thread *thread, uint32_t board);
+static uint32_t heap_pop(sim_thread *thread);
+static void boards_init(void);
+static void board_authenticate(sim_board *board, uint64_t now_msec, uint8_t *num_in, uint8_t *rand_out);
+static void thread_flush(sim_thread *thread, size_t count);
+static void thread_send(sim_thread *thread);
+static void thread_receive(sim_thread *thread);
+static void *thread_main(void *argument);
+
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double uniform(uint64_t *state)
+{
+    return (splitmix64(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+//Function to run newlib's rand() on the board's state, srand() sets the state to the seed
+static int newlib_rand(sim_board *board)
+{
+    board->rand_next = board->rand_next * 6364136223846793005ULL + 1;
+    return (int)((board->rand_next >> 32) & NEWLIB_RAND_MAX);
+}
+
+static void heap_push(sim_thread *thread, uint32_t board)
+{
+    size_t child = thread->heap_size++;
+
+    while (child > 0)
+    {
+        size_t parent = (child - 1) / 2;
+
+        if (boards[thread->heap[parent]].next_msec <= boards[board].next_msec)
+        {
+            break;
+        }
+        thread->heap[child] = thread->heap[parent];
+        child = parent;
+    }
+    thread->heap[child] = board;
+}
+
+static uint32_t heap_pop(sim_thread *thread)
+{
+    uint32_t top = thread->heap[0];
+    uint32_t last = thread->heap[--thread->heap_size];
+    size_t parent = 0;
+
+    for (;;)
+    {
+        size_t child = 2 * parent + 1;
+
+        if (child >= thread->heap_size)
+        {
+            break;
+        }
+        if (child + 1 < thread->heap_size && boards[thread->heap[child + 1]].next_msec < boards[thread->heap[child]].next_msec)
+        {
+            child++;
+        }
+        if (boards[last].next_msec <= boards[thread->heap[child]].next_msec)
+        {
+            break;
+        }
+        thread->heap[parent] = thread->heap[child];
+        parent = child;
+    }
+    if (thread->heap_size)
+    {
+        thread->heap[parent] = last;
+    }
+    return top;
+}
+
+//Function to give every board its serial number, key, seeds and power on time
+static void boards_init(void)
+{
+    uint64_t random = options.seed;
+    uint8_t *serial_numbers = malloc((size_t)options.boards * MAC_SERIAL_NUMBER_SIZE);
+    uint8_t *keys = malloc((size_t)options.boards * MAC_KEY_SIZE);
+    uint8_t foreign_key[MAC_KEY_SIZE];
+    unsigned int i;
+
+    for (i = 0; i < options.boards; i++)
+    {
+        sim_board *board = &boards[i];
+        uint64_t unique = splitmix64(&random);
+
+        //SN[0:1] and SN[8] are fixed on CryptoAuth devices
+        board->serial_number[0] = 0x01;
+        board->serial_number[1] = 0x23;
+        memcpy(&board->serial_number[2], &unique, 6);
+        board->serial_number[8] = 0xEE;
+        memcpy(&serial_numbers[i * MAC_SERIAL_NUMBER_SIZE], board->serial_number, MAC_SERIAL_NUMBER_SIZE);
+
+        //The seed of random_seed_poll() is four ADC bytes
+        board->rand_next = (uint32_t)splitmix64(&random);
+        board->device_random = splitmix64(&random);
+        board->power_on_msec = options.spread_msec ? splitmix64(&random) % options.spread_msec : 0;
+        board->next_msec = board->power_on_msec + options.boot_msec;
+        board->counterfeit = uniform(&random) < options.counterfeit;
+    }
+
+    derive_key_batch(options.boards, options.master_key, serial_numbers, options.slot, keys);
+    for (i = 0; i < options.boards; i++)
+    {
+        if (boards[i].counterfeit)
+        {
+            //A clone programmed with keys of another master key
+            size_t j;
+
+            for (j = 0; j < sizeof(foreign_key); j += 8)
+            {
+                uint64_t value = splitmix64(&random);
+                memcpy(&foreign_key[j], &value, 8);
+            }
+            derive_key_batch(1, foreign_key, boards[i].serial_number, options.slot, boards[i].key);
+        }
+        else
+        {
+            memcpy(boards[i].key, &keys[i * MAC_KEY_SIZE], MAC_KEY_SIZE);
+        }
+    }
+    free(serial_numbers);
+    free(keys);
+}
+
+//Function to draw the board's next interval and NumIn, and the device's RandOut, of an authentication at now_msec
+static void board_authenticate(sim_board *board, uint64_t now_msec, uint8_t *num_in, uint8_t *rand_out)
+{
+    uint32_t interval = (uint32_t)(newlib_rand(board) % AUTHENTICATION_RANGE_MSEC) + AUTHENTICATION_MIN_MSEC;
+    size_t i;
+
+    //host_generate_random_number() copies whole ints of rand()
+    for (i = 0; i < NONCE_NUM_IN_SIZE; i += sizeof(int))
+    {
+        int value = newlib_rand(board);
+        memcpy(&num_in[i], &value, sizeof(value));
+    }
+    for (i = 0; i < NONCE_RAND_OUT_SIZE; i += 8)
+    {
+        uint64_t value = splitmix64(&board->device_random);
+        memcpy(&rand_out[i], &value, 8);
+    }
+
+    if (board->booted)
+    {
+        board->next_msec = now_msec + interval;
+    }
+    else
+    {
+        //The boot authentication leaves g_ticks_msec counting from SysTick_Config(), the first
+        //SysTick_Handler() check passes at the next multiple of the interval
+        uint64_t ticks = now_msec - board->power_on_msec;
+
+        board->next_msec = board->power_on_msec + (ticks / interval + 1) * interval;
+        board->booted = true;
+    }
+}
+
+//Function to hash the due authentications and emit their records
+static void thread_flush(sim_thread *thread, size_t count)
+{
+    size_t i;
+
+    nonce_batch(count, thread->rand_outs, thread->num_ins, thread->temp_keys);
+    mac_batch(count, thread->keys, thread->temp_keys, thread->serial_numbers, options.slot, thread->macs);
+
+    for (i = 0; i < count; i++)
+    {
+        const sim_board *board = &boards[thread->due[i]];
+        uint8_t *mac = &thread->macs[i * SHA256_DIGEST_SIZE];
+        uint8_t expected = board->counterfeit ? FLEET_STATUS_UNKNOWN : FLEET_STATUS_OK;
+
+        if (options.drop > 0 && uniform(&thread->random) < options.drop)
+        {
+            thread->dropped++;
+            continue;
+        }
+        if (!board->counterfeit && options.corrupt > 0 && uniform(&thread->random) < options.corrupt)
+        {
+            mac[splitmix64(&thread->random) % SHA256_DIGEST_SIZE] ^= 0x01;
+            expected = FLEET_STATUS_MISMATCH;
+        }
+        thread->injected[expected]++;
+        thread->generated++;
+
+        if (options.output_file)
+        {
+            fleet_traffic_record *record;
+
+            if (thread->output_count == thread->output_size)
+            {
+                thread->output_size = thread->output_size ? 2 * thread->output_size : 1024;
+                thread->output = realloc(thread->output, thread->output_size * sizeof(*thread->output));
+                if (thread->output == NULL)
+                {
+                    fprintf(stderr, "error: out of memory\n");
+                    exit(1);
+                }
+            }
+            record = &thread->output[thread->output_count++];
+            memcpy(record->serial_number, board->serial_number, sizeof(record->serial_number));
+            memcpy(record->num_in, &thread->num_ins[i * NONCE_NUM_IN_SIZE], sizeof(record->num_in));
+            memcpy(record->rand_out, &thread->rand_outs[i * NONCE_RAND_OUT_SIZE], sizeof(record->rand_out));
+            memcpy(record->response, mac, sizeof(record->response));
+            record->expected = expected;
+        }
+        if (options.address)
+        {
+            fleet_record *record = &thread->datagram[thread->datagram_count++];
+
+            fleet_put_le32(record->id, (thread->number << 24) | (thread->sequence++ & 0xFFFFFF));
+            memcpy(record->serial_number, board->serial_number, sizeof(record->serial_number));
+            memcpy(record->num_in, &thread->num_ins[i * NONCE_NUM_IN_SIZE], sizeof(record->num_in));
+            memcpy(record->rand_out, &thread->rand_outs[i * NONCE_RAND_OUT_SIZE], sizeof(record->rand_out));
+            memcpy(record->response, mac, sizeof(record->response));
+            if (thread->datagram_count == FLEET_DATAGRAM_RECORDS)
+            {
+                thread_send(thread);
+            }
+        }
+    }
+}
+
+static void thread_send(sim_thread *thread)
+{
+    if (thread->datagram_count && send(thread->socket, thread->datagram, thread->datagram_count * sizeof(fleet_record), 0) < 0)
+    {
+        thread->send_errors += thread->datagram_count;
+    }
+    thread->datagram_count = 0;
+}
+
+//Function to count the replies of the verifier that arrived
+static void thread_receive(sim_thread *thread)
+{
+    fleet_reply replies[FLEET_DATAGRAM_RECORDS * 2];
+    ssize_t size;
+
+    while ((size = recv(thread->socket, replies, sizeof(replies), MSG_DONTWAIT)) > 0)
+    {
+        size_t i;
+
+        for (i = 0; i < (size_t)size / sizeof(fleet_reply); i++)
+        {
+            if (replies[i].status < FLEET_STATUSES)
+            {
+                thread->replies[replies[i].status]++;
+            }
+        }
+    }
+}
+
+static void *thread_main(void *argument)
+{
+    sim_thread *thread = argument;
+
+    for (;;)
+    {
+        size_t count = 0;
+
+        pthread_barrier_wait(&slice_start);
+        if (finished)
+        {
+            break;
+        }
+
+        thread->output_count = 0;
+        while (thread->heap_size && boards[thread->heap[0]].next_msec < slice_end_msec)
+        {
+            uint32_t index = heap_pop(thread);
+            sim_board *board = &boards[index];
+
+            thread->due[count] = index;
+            memcpy(&thread->serial_numbers[count * MAC_SERIAL_NUMBER_SIZE], board->serial_number, MAC_SERIAL_NUMBER_SIZE);
+            memcpy(&thread->keys[count * MAC_KEY_SIZE], board->key, MAC_KEY_SIZE);
+            board_authenticate(board, board->next_msec, &thread->num_ins[count * NONCE_NUM_IN_SIZE],
+                               &thread->rand_outs[count * NONCE_RAND_OUT_SIZE]);
+            heap_push(thread, index);
+            if (++count == SIM_BATCH)
+            {
+                thread_flush(thread, count);
+                count = 0;
+            }
+        }
+        if (count)
+        {
+            thread_flush(thread, count);
+        }
+        if (options.address)
+        {
+            thread_send(thread);
+            thread_receive(thread);
+        }
+
+        pthread_barrier_wait(&slice_end);
+    }
+    return NULL;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [-n boards] [-t threads] [-d seconds] [-x speed | -r records/s] [-o traffic file]\n"
+            "       [-u address[:port]] [--corrupt share] [--counterfeit share] [--drop share]\n"
+            "       [--slice msec] [--boot msec] [--spread msec] [--seed n] [-m master key] [-s slot] [-P path]\n"
+            "  -d  virtual time to run, default is 60 s\n"
+            "  -x  virtual seconds per second, default is as fast as possible\n"
+            "  -r  records per second, sets the speed from the mean authentication interval\n"
+            "  -u  send the records to fleet_verifier and count its replies\n"
+            "  --corrupt      share of responses of genuine boards with a flipped bit\n"
+            "  --counterfeit  share of boards with keys of another master key\n"
+            "  --drop         share of authentications that are not sent\n"
+            "  --spread       boards power on at random in this time, default is the longest interval\n", program);
+    exit(1);
+}
+
+static bool parse_hex(const char *text, uint8_t *data, size_t size)
+{
+    size_t i;
+
+    if (strlen(text) != 2 * size)
+    {
+        return false;
+    }
+    for (i = 0; i < size; i++)
+    {
+        unsigned int byte;
+
+        if (sscanf(text + 2 * i, "%2x", &byte) != 1)
+        {
+            return false;
+        }
+        data[i] = (uint8_t)byte;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option long_options[] =
+    {
+        { "corrupt", required_argument, NULL, 'C' },
+        { "counterfeit", required_argument, NULL, 'F' },
+        { "drop", required_argument, NULL, 'D' },
+        { "slice", required_argument, NULL, 'S' },
+        { "boot", required_argument, NULL, 'B' },
+        { "spread", required_argument, NULL, 'W' },
+        { "seed", required_argument, NULL, 'E' },
+        { NULL, 0, NULL, 0 }
+    };
+    static const char *const names[FLEET_STATUSES] = { "ok", "mismatch", "unknown", "busy" };
+    uint64_t injected[FLEET_STATUSES] = { 0 }, replies[FLEET_STATUSES] = { 0 };
+    uint64_t generated = 0, dropped = 0, send_errors = 0, reply_count = 0, last_generated = 0;
+    uint64_t started, last_report, duration_msec, virtual_msec = 0;
+    double mean_interval = AUTHENTICATION_MIN_MSEC + (AUTHENTICATION_RANGE_MSEC - 1) / 2.0;
+    double seconds;
+    FILE *output = NULL;
+    fleet_traffic_header header;
+    unsigned int i, j;
+    int option, path;
+
+    while ((option = getopt_long(argc, argv, "n:t:d:x:r:o:u:m:s:P:", long_options, NULL)) != -1)
+    {
+        switch (option)
+        {
+        case 'n': options.boards = (unsigned int)atoi(optarg); break;
+        case 't': options.threads = (unsigned int)atoi(optarg); break;
+        case 'd': options.duration = atof(optarg); break;
+        case 'x': options.speed = atof(optarg); break;
+        case 'r': options.rate = atof(optarg); break;
+        case 'o': options.output_file = optarg; break;
+        case 's': options.slot = (uint16_t)atoi(optarg); break;
+        case 'C': options.corrupt = atof(optarg); break;
+        case 'F': options.counterfeit = atof(optarg); break;
+        case 'D': options.drop = atof(optarg); break;
+        case 'S': options.slice_msec = (unsigned int)atoi(optarg); break;
+        case 'B': options.boot_msec = (unsigned int)atoi(optarg); break;
+        case 'W': options.spread_msec = (unsigned int)atoi(optarg); break;
+        case 'E': options.seed = strtoull(optarg, NULL, 0); break;
+        case 'u':
+        {
+            char *port = strchr(optarg, ':');
+
+            if (port)
+            {
+                *port = '\0';
+                options.port = (uint16_t)atoi(port + 1);
+            }
+            options.address = optarg;
+            break;
+        }
+        case 'm':
+            if (!parse_hex(optarg, options.master_key, sizeof(options.master_key)))
+            {
+                usage(argv[0]);
+            }
+            break;
+        case 'P':
+            for (path = SHA256_MB_AUTO + 1; path < SHA256_MB_PATHS; path++)
+            {
+                if (sha256_mb_name(path) && strcmp(optarg, sha256_mb_name(path)) == 0)
+                {
+                    options.path = path;
+                }
+            }
+            if (options.path == SHA256_MB_AUTO)
+            {
+                usage(argv[0]);
+            }
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (optind != argc || options.boards < 1 || options.threads < 1 || options.threads > SIM_MAX_THREADS
+            || options.threads > options.boards || options.duration <= 0 || options.slice_msec < 1
+            || options.speed < 0 || options.rate < 0 || (options.speed > 0 && options.rate > 0))
+    {
+        usage(argv[0]);
+    }
+    if (options.rate > 0)
+    {
+        //A board authenticates every mean_interval milliseconds
+        options.speed = options.rate * mean_interval / (1000.0 * options.boards);
+    }
+
+    path = sha256_mb_select(options.path);
+    if (path < 0)
+    {
+        fprintf(stderr, "error: the CPU does not run the %s path\n", sha256_mb_name(options.path));
+        return 1;
+    }
+
+    if (options.address)
+    {
+        memset(&verifier_address, 0, sizeof(verifier_address));
+        verifier_address.sin_family = AF_INET;
+        verifier_address.sin_port = htons(options.port);
+        if (inet_pton(AF_INET, options.address, &verifier_address.sin_addr) != 1)
+        {
+            usage(argv[0]);
+        }
+    }
+    if (options.output_file)
+    {
+        output = fopen(options.output_file, "wb");
+        if (output == NULL)
+        {
+            fprintf(stderr, "error: cannot write %s\n", options.output_file);
+            return 1;
+        }
+        //The count is written at the end
+        memset(&header, 0, sizeof(header));
+        fwrite(&header, sizeof(header), 1, output);
+    }
+
+    boards = calloc(options.boards, sizeof(sim_board));
+    threads = calloc(options.threads, sizeof(sim_thread));
+    if (boards == NULL || threads == NULL)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        return 1;
+    }
+    started = fleet_time_nsec();
+    boards_init();
+    printf("%u boards derived in %.2f s, %s path, authentication every %u to %u ms\n", options.boards,
+           (fleet_time_nsec() - started) / 1e9, sha256_mb_name(path), AUTHENTICATION_MIN_MSEC,
+           AUTHENTICATION_MIN_MSEC + AUTHENTICATION_RANGE_MSEC - 1);
+
+    for (i = 0; i < options.threads; i++)
+    {
+        sim_thread *thread = &threads[i];
+
+        thread->number = i;
+        thread->random = options.seed ^ (0xA5A5A5A5ULL * (i + 1));
+        thread->heap = malloc(((options.boards + options.threads - 1) / options.threads) * sizeof(uint32_t));
+        if (thread->heap == NULL)
+        {
+            fprintf(stderr, "error: out of memory\n");
+            return 1;
+        }
+        for (j = i; j < options.boards; j += options.threads)
+        {
+            heap_push(thread, j);
+        }
+        if (options.address)
+        {
+            int buffer = 4 << 20;
+
+            thread->socket = socket(AF_INET, SOCK_DGRAM, 0);
+            if (thread->socket < 0 || connect(thread->socket, (struct sockaddr*)&verifier_address, sizeof(verifier_address)) != 0)
+            {
+                fprintf(stderr, "error: cannot open a socket to %s:%u: %s\n", options.address, options.port, strerror(errno));
+                return 1;
+            }
+            setsockopt(thread->socket, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+        }
+    }
+
+    pthread_barrier_init(&slice_start, NULL, options.threads + 1);
+    pthread_barrier_init(&slice_end, NULL, options.threads + 1);
+    for (i = 0; i < options.threads; i++)
+    {
+        pthread_create(&threads[i].thread, NULL, thread_main, &threads[i]);
+    }
+
+    duration_msec = (uint64_t)(options.duration * 1000);
+    started = last_report = fleet_time_nsec();
+    while (virtual_msec < duration_msec)
+    {
+        uint64_t now;
+
+        virtual_msec += options.slice_msec;
+        if (virtual_msec > duration_msec)
+        {
+            virtual_msec = duration_msec;
+        }
+        slice_end_msec = virtual_msec;
+
+        //Start the slice when the wall clock reaches its beginning
+        if (options.speed > 0)
+        {
+            uint64_t due = started + (uint64_t)((slice_end_msec - options.slice_msec) * 1e6 / options.speed);
+
+            now = fleet_time_nsec();
+            if (slice_end_msec > options.slice_msec && due > now)
+            {
+                struct timespec pause = { (time_t)((due - now) / 1000000000u), (long)((due - now) % 1000000000u) };
+                nanosleep(&pause, NULL);
+            }
+        }
+        pthread_barrier_wait(&slice_start);
+        pthread_barrier_wait(&slice_end);
+
+        generated = 0;
+        for (i = 0; i < options.threads; i++)
+        {
+            generated += threads[i].generated;
+            if (output && threads[i].output_count)
+            {
+                fwrite(threads[i].output, sizeof(fleet_traffic_record), threads[i].output_count, output);
+            }
+        }
+
+        now = fleet_time_nsec();
+        if (now - last_report >= 1000000000u)
+        {
+            printf("virtual %8.1f s  %10.0f records/s\n", virtual_msec / 1e3, (generated - last_generated) * 1e9 / (now - last_report));
+            fflush(stdout);
+            last_generated = generated;
+            last_report = now;
+        }
+    }
+    seconds = (fleet_time_nsec() - started) / 1e9;
+
+    finished = true;
+    pthread_barrier_wait(&slice_start);
+    for (i = 0; i < options.threads; i++)
+    {
+        pthread_join(threads[i].thread, NULL);
+    }
+
+    //Replies still on their way
+    if (options.address)
+    {
+        uint64_t deadline = fleet_time_nsec() + SIM_REPLY_WAIT_NSEC;
+
+        do
+        {
+            struct timespec pause = { 0, 10000000 };
+
+            nanosleep(&pause, NULL);
+            reply_count = 0;
+            for (i = 0; i < options.threads; i++)
+            {
+                thread_receive(&threads[i]);
+                for (j = 0; j < FLEET_STATUSES; j++)
+                {
+                    reply_count += threads[i].replies[j];
+                }
+            }
+        } while (reply_count < generated && fleet_time_nsec() < deadline);
+    }
+
+    for (i = 0; i < options.threads; i++)
+    {
+        for (j = 0; j < FLEET_STATUSES; j++)
+        {
+            injected[j] += threads[i].injected[j];
+            replies[j] += threads[i].replies[j];
+        }
+        dropped += threads[i].dropped;
+        send_errors += threads[i].send_errors;
+    }
+
+    if (output)
+    {
+        memcpy(header.magic, FLEET_TRAFFIC_MAGIC, sizeof(header.magic));
+        header.version = FLEET_TRAFFIC_VERSION;
+        fleet_put_le32(header.count, (uint32_t)generated);
+        fseek(output, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, output);
+        fclose(output);
+    }
+
+    printf("%llu records of %.1f virtual s in %.2f s: %.0f records/s, %.0f virtual records/s, speed %.1f\n",
+           (unsigned long long)generated, virtual_msec / 1e3, seconds, generated / seconds,
+           generated * 1e3 / virtual_msec, virtual_msec / 1e3 / seconds);
+    printf("injected: %llu ok, %llu corrupted, %llu of counterfeit boards, %llu dropped\n",
+           (unsigned long long)injected[FLEET_STATUS_OK], (unsigned long long)injected[FLEET_STATUS_MISMATCH],
+           (unsigned long long)injected[FLEET_STATUS_UNKNOWN], (unsigned long long)dropped);
+    if (options.address)
+    {
+        printf("replies:");
+        for (j = 0; j < FLEET_STATUSES; j++)
+        {
+            printf(" %llu %s", (unsigned long long)replies[j], names[j]);
+        }
+        printf(", %llu unanswered, %llu not sent\n", (unsigned long long)(generated - reply_count - send_errors),
+               (unsigned long long)send_errors);
+    }
+    if (output)
+    {
+        printf("traffic written to %s\n", options.output_file);
+    }
+    return 0;
+}
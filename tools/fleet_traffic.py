@@ -0,0 +1,126 @@
+##
+# \file
+#
+# \brief Generate board authentication traffic for the fleet verifier
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# Writes the records fleet_replay.c sends, in the layout of fleet.h: a
+# header of magic "FTRF", version (1 byte), 3 reserved bytes and the record
+# count (4 bytes little endian), then records of serial number, NumIn,
+# RandOut, MAC response and the status the verifier should answer.
+#
+# Boards are picked at random for every record. A share of the boards is
+# counterfeit, with keys that are not derived from the master key and are
+# not in the key table; a share of the responses is corrupted.
+import sys
+import random
+import struct
+import argparse
+
+import atca_host
+import key_table
+
+MAGIC = b"FTRF"
+VERSION = 1
+HEADER = struct.Struct("<4sB3xI")
+
+STATUS_OK = 0
+STATUS_MISMATCH = 1
+STATUS_UNKNOWN = 2
+
+def make_boards(count, counterfeit, master_key, slot, generator):
+	boards = []
+	for _ in range(count):
+		serial_number = bytes((0x01, 0x23)) + generator.getrandbits(48).to_bytes(6, "big") + bytes((0xEE,))
+		known = generator.random() >= counterfeit
+		parent_key = master_key if known else generator.getrandbits(256).to_bytes(32, "big")
+		boards.append((serial_number, atca_host.derive_key(parent_key, serial_number, slot), known))
+	return boards
+
+def make_records(boards, count, mismatch, slot, generator):
+	for _ in range(count):
+		serial_number, key, known = generator.choice(boards)
+		num_in = generator.getrandbits(8 * atca_host.NUM_IN_SIZE).to_bytes(atca_host.NUM_IN_SIZE, "big")
+		rand_out = generator.getrandbits(256).to_bytes(32, "big")
+		response = atca_host.mac_temp_key(key, atca_host.nonce_temp_key(rand_out, num_in), serial_number, slot)
+		expected = STATUS_OK if known else STATUS_UNKNOWN
+		if known and generator.random() < mismatch:
+			response = bytes((response[0] ^ 0x01,)) + response[1:]
+			expected = STATUS_MISMATCH
+		yield serial_number + num_in + rand_out + response + bytes((expected,))
+
+def write(file_name, records, count):
+	with open(file_name, "wb") as output_file:
+		output_file.write(HEADER.pack(MAGIC, VERSION, count))
+		for record in records:
+			output_file.write(record)
+
+def main():
+	parser = argparse.ArgumentParser(description="This script writes a "
+			"traffic file of board authentications for fleet_replay.c and "
+			"the key table of the boards for key_store.py.")
+	parser.add_argument("-o", "--output", dest="output", default="traffic.ftrf",
+			help="traffic file to write, default is traffic.ftrf")
+	parser.add_argument("-k", "--keys", dest="keys",
+			help="key table of the genuine boards to write")
+	parser.add_argument("-b", "--boards", dest="boards", type=int, default=10000,
+			help="number of boards, default is 10000")
+	parser.add_argument("-n", "--records", dest="records", type=int, default=100000,
+			help="number of records, default is 100000")
+	parser.add_argument("--counterfeit", dest="counterfeit", type=float, default=0.01,
+			help="share of boards with keys of another master key, default is 0.01")
+	parser.add_argument("--mismatch", dest="mismatch", type=float, default=0.01,
+			help="share of corrupted responses of genuine boards, default is 0.01")
+	parser.add_argument("-s", "--slot", dest="slot", type=int, default=atca_host.AUTH_KEY_SLOT,
+			help="key slot, default is %u" % atca_host.AUTH_KEY_SLOT)
+	parser.add_argument("-m", "--master-key", dest="master_key",
+			help="master key as 64 hex digits, default is the demo key of main.c")
+	parser.add_argument("--seed", dest="seed", type=int, default=1,
+			help="random seed, default is 1")
+
+	arguments = parser.parse_args()
+
+	try:
+		master_key = bytes.fromhex(arguments.master_key) if arguments.master_key else atca_host.MASTER_KEY
+		if len(master_key) != atca_host.KEY_SIZE:
+			raise ValueError("the master key has %u bytes" % atca_host.KEY_SIZE)
+		if arguments.boards < 1 or arguments.records < 0:
+			raise ValueError("at least one board is needed")
+
+		generator = random.Random(arguments.seed)
+		boards = make_boards(arguments.boards, arguments.counterfeit, master_key, arguments.slot, generator)
+		write(arguments.output, make_records(boards, arguments.records, arguments.mismatch, arguments.slot, generator),
+				arguments.records)
+		print("%u records of %u boards written to %s" % (arguments.records, len(boards), arguments.output))
+		if arguments.keys:
+			count = key_table.write(arguments.keys, arguments.slot,
+					[(serial_number, key) for serial_number, key, known in boards if known])
+			print("%u keys written to %s" % (count, arguments.keys))
+	except (IOError, ValueError) as e:
+		print("error: %s" % (str(e)))
+		sys.exit(1)
+
+if __name__ == "__main__":
+	main()
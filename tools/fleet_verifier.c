@@ -0,0 +1,785 @@
+/**
+ * \file
+ * \brief  Verifier service for the authentication records of a fleet of boards
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux with
+ *
+ *   cc -O2 -pthread -o fleet_verifier fleet_verifier.c sha256_mb.c
+ *
+ * Receiver threads read fleet_record datagrams from a SO_REUSEPORT socket
+ * each and push the records on a bounded lock-free queue, or answer
+ * FLEET_STATUS_BUSY when it is full. Worker threads pop what is queued, up
+ * to a batch, look up or derive the keys, calculate the TempKeys and MACs
+ * of the whole batch with sha256_mb.c and answer every sender. All buffers
+ * are allocated at start, nothing is allocated per record. Every interval
+ * the main thread prints the throughput and the latency from receiving a
+ * record to sending its reply.
+ *
+ * The keys come from a key store of key_store.py, or are derived from the
+ * master key like device_provision() does.
+ */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "fleet.h"
+#include "sha256_mb.h"
+
+#define VERIFIER_MAX_WORKERS        64
+#define VERIFIER_MAX_RECEIVERS      16
+#define VERIFIER_MAX_BATCH          256
+#define VERIFIER_IDLE_SPINS         64
+#define VERIFIER_IDLE_NSEC          20000
+#define VERIFIER_CACHE_LINE         64
+
+#define KEY_STORE_MAGIC             "KSTO"
+#define KEY_STORE_VERSION           1
+#define KEY_STORE_HEADER_SIZE       16
+#define KEY_STORE_HASH_MULTIPLIER   0x9E3779B97F4A7C15ULL
+
+typedef struct
+{
+    fleet_record record;
+    struct sockaddr_in source;
+    uint64_t received_nsec;
+    int socket;
+} verifier_job;
+
+//Bounded MPMC queue of D. Vyukov: every cell has a sequence number telling
+//producers and consumers whose turn it is, positions are claimed with a CAS
+typedef struct
+{
+    _Atomic size_t sequence;
+    verifier_job job;
+} queue_cell;
+
+typedef struct
+{
+    queue_cell *cells;
+    size_t mask;
+    _Alignas(VERIFIER_CACHE_LINE) _Atomic size_t enqueue_position;
+    _Alignas(VERIFIER_CACHE_LINE) _Atomic size_t dequeue_position;
+} job_queue;
+
+//Counters are written by their thread only and read by the main thread
+typedef struct
+{
+    _Atomic uint64_t statuses[FLEET_STATUSES];
+    _Atomic uint64_t batches;
+    _Atomic uint64_t latency[FLEET_HISTOGRAM_BUCKETS];
+} worker_metrics;
+
+typedef struct
+{
+    _Alignas(VERIFIER_CACHE_LINE) pthread_t thread;
+    verifier_job jobs[VERIFIER_MAX_BATCH];
+    uint8_t serial_numbers[VERIFIER_MAX_BATCH * MAC_SERIAL_NUMBER_SIZE];
+    uint8_t num_ins[VERIFIER_MAX_BATCH * NONCE_NUM_IN_SIZE];
+    uint8_t rand_outs[VERIFIER_MAX_BATCH * NONCE_RAND_OUT_SIZE];
+    uint8_t responses[VERIFIER_MAX_BATCH * SHA256_DIGEST_SIZE];
+    uint8_t keys[VERIFIER_MAX_BATCH * MAC_KEY_SIZE];
+    uint8_t temp_keys[VERIFIER_MAX_BATCH * SHA256_DIGEST_SIZE];
+    uint8_t results[VERIFIER_MAX_BATCH];
+    uint8_t statuses[VERIFIER_MAX_BATCH];
+    fleet_reply replies[FLEET_DATAGRAM_RECORDS];
+    worker_metrics metrics;
+} verifier_worker;
+
+typedef struct
+{
+    _Alignas(VERIFIER_CACHE_LINE) pthread_t thread;
+    int socket;
+    fleet_reply busy[FLEET_DATAGRAM_RECORDS];
+    _Atomic uint64_t received;
+    _Atomic uint64_t busy_count;
+    _Atomic uint64_t malformed;
+} verifier_receiver;
+
+typedef struct
+{
+    const uint8_t *map;
+    size_t size;
+    const uint8_t *records;
+    uint32_t count;
+    unsigned int bits;
+    uint8_t slot;
+} key_store;
+
+static struct
+{
+    uint16_t port;
+    unsigned int workers;
+    unsigned int receivers;
+    unsigned int batch;
+    size_t queue_size;
+    double interval;
+    uint16_t slot;
+    bool slot_set;
+    const char *store_file;
+    uint8_t master_key[MAC_KEY_SIZE];
+    int path;
+} options =
+{
+    .port = FLEET_PORT,
+    .workers = 4,
+    .receivers = 2,
+    .batch = 64,
+    .queue_size = 65536,
+    .interval = 1.0,
+    .slot = 6,
+    .path = SHA256_MB_AUTO,
+    //Demo master key of get_master_key() in main.c
+    .master_key =
+    {
+        0x37, 0x80, 0xe6, 0x3d, 0x49, 0x68, 0xad, 0xe5,
+        0xd8, 0x22, 0xc0, 0x13, 0xfc, 0xc3, 0x23, 0x84,
+        0x5d, 0x1b, 0x56, 0x9f, 0xe7, 0x05, 0xb6, 0x00,
+        0x06, 0xfe, 0xec, 0x14, 0x5a, 0x0d, 0xb1, 0xe3
+    },
+};
+
+static job_queue queue;
+static key_store store;
+static bool use_store;
+static verifier_worker *workers;
+static verifier_receiver *receivers;
+static atomic_bool receiving = true;
+static atomic_bool working = true;
+static volatile sig_atomic_t stop_requested;
+
+static bool queue_init(job_queue *q, size_t size);
+static bool queue_push(job_queue *q, const verifier_job *job);
+static bool queue_pop(job_queue *q, verifier_job *job);
+static bool key_store_open(key_store *s, const char *file_name);
+static const uint8_t *key_store_lookup(const key_store *s, const uint8_t *serial_number);
+static void *receiver_main(void *argument);
+static void *worker_main(void *argument);
+static void worker_verify(verifier_worker *worker, size_t count);
+static void worker_reply(verifier_worker *worker, size_t count);
+static void print_metrics(double seconds, bool total);
+
+static bool queue_init(job_queue *q, size_t size)
+{
+    size_t i;
+
+    q->cells = aligned_alloc(VERIFIER_CACHE_LINE, size * sizeof(queue_cell));
+    if (q->cells == NULL)
+    {
+        return false;
+    }
+    for (i = 0; i < size; i++)
+    {
+        atomic_init(&q->cells[i].sequence, i);
+    }
+    q->mask = size - 1;
+    atomic_init(&q->enqueue_position, 0);
+    atomic_init(&q->dequeue_position, 0);
+    return true;
+}
+
+//Function to add a job, false when the queue is full
+static bool queue_push(job_queue *q, const verifier_job *job)
+{
+    size_t position = atomic_load_explicit(&q->enqueue_position, memory_order_relaxed);
+    queue_cell *cell;
+
+    for (;;)
+    {
+        intptr_t difference;
+
+        cell = &q->cells[position & q->mask];
+        difference = (intptr_t)atomic_load_explicit(&cell->sequence, memory_order_acquire) - (intptr_t)position;
+        if (difference == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&q->enqueue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = atomic_load_explicit(&q->enqueue_position, memory_order_relaxed);
+        }
+    }
+
+    cell->job = *job;
+    atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+    return true;
+}
+
+//Function to take the oldest job, false when the queue is empty
+static bool queue_pop(job_queue *q, verifier_job *job)
+{
+    size_t position = atomic_load_explicit(&q->dequeue_position, memory_order_relaxed);
+    queue_cell *cell;
+
+    for (;;)
+    {
+        intptr_t difference;
+
+        cell = &q->cells[position & q->mask];
+        difference = (intptr_t)atomic_load_explicit(&cell->sequence, memory_order_acquire) - (intptr_t)(position + 1);
+        if (difference == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&q->dequeue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = atomic_load_explicit(&q->dequeue_position, memory_order_relaxed);
+        }
+    }
+
+    *job = cell->job;
+    atomic_store_explicit(&cell->sequence, position + q->mask + 1, memory_order_release);
+    return true;
+}
+
+//Function to map a key store of key_store.py, the records present when it is opened are used
+static bool key_store_open(key_store *s, const char *file_name)
+{
+    struct stat status;
+    const uint8_t *header;
+    int fd = open(file_name, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &status) != 0 || (size_t)status.st_size < KEY_STORE_HEADER_SIZE)
+    {
+        fprintf(stderr, "error: cannot read %s\n", file_name);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return false;
+    }
+    s->size = (size_t)status.st_size;
+    s->map = mmap(NULL, s->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (s->map == MAP_FAILED)
+    {
+        fprintf(stderr, "error: cannot map %s\n", file_name);
+        return false;
+    }
+
+    //Magic, version, slot, serial number size, key size, count, index bits
+    header = s->map;
+    if (memcmp(header, KEY_STORE_MAGIC, 4) != 0 || header[4] != KEY_STORE_VERSION
+            || header[6] != MAC_SERIAL_NUMBER_SIZE || header[7] != MAC_KEY_SIZE || header[12] > 31)
+    {
+        fprintf(stderr, "error: %s is not a key store of 9 byte serial numbers and 32 byte keys\n", file_name);
+        return false;
+    }
+    s->slot = header[5];
+    s->count = fleet_get_le32(header + 8);
+    s->bits = header[12];
+    s->records = s->map + KEY_STORE_HEADER_SIZE + ((size_t)4 << s->bits);
+    if ((size_t)(s->records - s->map) + (size_t)s->count * (MAC_SERIAL_NUMBER_SIZE + MAC_KEY_SIZE) > s->size)
+    {
+        fprintf(stderr, "error: %s is truncated\n", file_name);
+        return false;
+    }
+    return true;
+}
+
+//Function to find the key of a serial number, with the hash and probing of key_store.py
+static const uint8_t *key_store_lookup(const key_store *s, const uint8_t *serial_number)
+{
+    const uint8_t *index = s->map + KEY_STORE_HEADER_SIZE;
+    size_t mask = ((size_t)1 << s->bits) - 1;
+    uint64_t value = 0;
+    size_t bucket;
+    int i;
+
+    for (i = 7; i >= 0; i--)
+    {
+        value = (value << 8) | serial_number[i];
+    }
+    value ^= serial_number[8];
+    bucket = (size_t)((value * KEY_STORE_HASH_MULTIPLIER) >> (64 - s->bits));
+
+    for (;;)
+    {
+        uint32_t entry = fleet_get_le32(index + 4 * bucket);
+        const uint8_t *record;
+
+        if (entry == 0 || entry > s->count)
+        {
+            return NULL;
+        }
+        record = s->records + (size_t)(entry - 1) * (MAC_SERIAL_NUMBER_SIZE + MAC_KEY_SIZE);
+        if (memcmp(record, serial_number, MAC_SERIAL_NUMBER_SIZE) == 0)
+        {
+            return record + MAC_SERIAL_NUMBER_SIZE;
+        }
+        bucket = (bucket + 1) & mask;
+    }
+}
+
+static void *receiver_main(void *argument)
+{
+    verifier_receiver *receiver = argument;
+    fleet_record records[FLEET_DATAGRAM_RECORDS + 1];
+    verifier_job job;
+
+    job.socket = receiver->socket;
+    while (atomic_load_explicit(&receiving, memory_order_relaxed))
+    {
+        socklen_t source_size = sizeof(job.source);
+        ssize_t size = recvfrom(receiver->socket, records, sizeof(records), 0, (struct sockaddr*)&job.source, &source_size);
+        size_t count, busy = 0, i;
+
+        if (size < 0)
+        {
+            //Timeout to check for shutdown
+            continue;
+        }
+        if (size == 0 || size % sizeof(fleet_record) != 0 || size > (ssize_t)(FLEET_DATAGRAM_RECORDS * sizeof(fleet_record)))
+        {
+            atomic_store_explicit(&receiver->malformed, receiver->malformed + 1, memory_order_relaxed);
+            continue;
+        }
+
+        count = (size_t)size / sizeof(fleet_record);
+        job.received_nsec = fleet_time_nsec();
+        for (i = 0; i < count; i++)
+        {
+            job.record = records[i];
+            if (!queue_push(&queue, &job))
+            {
+                memcpy(receiver->busy[busy].id, records[i].id, sizeof(records[i].id));
+                receiver->busy[busy++].status = FLEET_STATUS_BUSY;
+            }
+        }
+        if (busy)
+        {
+            sendto(receiver->socket, receiver->busy, busy * sizeof(fleet_reply), 0, (struct sockaddr*)&job.source, sizeof(job.source));
+        }
+        atomic_store_explicit(&receiver->received, receiver->received + count, memory_order_relaxed);
+        atomic_store_explicit(&receiver->busy_count, receiver->busy_count + busy, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+static void *worker_main(void *argument)
+{
+    verifier_worker *worker = argument;
+    unsigned int idle = 0;
+
+    for (;;)
+    {
+        size_t count = 0;
+
+        //Take what is queued, batches grow with the load
+        while (count < options.batch && queue_pop(&queue, &worker->jobs[count]))
+        {
+            count++;
+        }
+        if (count)
+        {
+            idle = 0;
+            worker_verify(worker, count);
+            worker_reply(worker, count);
+            continue;
+        }
+
+        if (!atomic_load_explicit(&working, memory_order_relaxed))
+        {
+            break;
+        }
+        if (++idle < VERIFIER_IDLE_SPINS)
+        {
+            sched_yield();
+        }
+        else
+        {
+            struct timespec pause = { 0, VERIFIER_IDLE_NSEC };
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+//Function to verify the jobs of a batch into worker->statuses
+static void worker_verify(verifier_worker *worker, size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        const fleet_record *record = &worker->jobs[i].record;
+
+        memcpy(&worker->serial_numbers[i * MAC_SERIAL_NUMBER_SIZE], record->serial_number, MAC_SERIAL_NUMBER_SIZE);
+        memcpy(&worker->num_ins[i * NONCE_NUM_IN_SIZE], record->num_in, NONCE_NUM_IN_SIZE);
+        memcpy(&worker->rand_outs[i * NONCE_RAND_OUT_SIZE], record->rand_out, NONCE_RAND_OUT_SIZE);
+        memcpy(&worker->responses[i * SHA256_DIGEST_SIZE], record->response, SHA256_DIGEST_SIZE);
+        worker->statuses[i] = FLEET_STATUS_OK;
+        if (use_store)
+        {
+            const uint8_t *key = key_store_lookup(&store, record->serial_number);
+
+            if (key != NULL)
+            {
+                memcpy(&worker->keys[i * MAC_KEY_SIZE], key, MAC_KEY_SIZE);
+            }
+            else
+            {
+                memset(&worker->keys[i * MAC_KEY_SIZE], 0, MAC_KEY_SIZE);
+                worker->statuses[i] = FLEET_STATUS_UNKNOWN;
+            }
+        }
+    }
+
+    if (!use_store)
+    {
+        derive_key_batch(count, options.master_key, worker->serial_numbers, options.slot, worker->keys);
+    }
+    nonce_batch(count, worker->rand_outs, worker->num_ins, worker->temp_keys);
+    mac_verify_batch(count, worker->keys, worker->temp_keys, worker->serial_numbers, options.slot,
+                     worker->responses, worker->results);
+
+    for (i = 0; i < count; i++)
+    {
+        if (worker->statuses[i] == FLEET_STATUS_OK && !worker->results[i])
+        {
+            worker->statuses[i] = FLEET_STATUS_MISMATCH;
+        }
+    }
+}
+
+//Function to answer the jobs of a batch, one datagram per run of jobs from the same sender
+static void worker_reply(verifier_worker *worker, size_t count)
+{
+    worker_metrics *metrics = &worker->metrics;
+    size_t i, pending = 0;
+    uint64_t now;
+
+    for (i = 0; i < count; i++)
+    {
+        const verifier_job *job = &worker->jobs[i];
+
+        memcpy(worker->replies[pending].id, job->record.id, sizeof(job->record.id));
+        worker->replies[pending++].status = worker->statuses[i];
+        if (i + 1 == count || pending == FLEET_DATAGRAM_RECORDS || job[1].socket != job->socket
+                || job[1].source.sin_port != job->source.sin_port || job[1].source.sin_addr.s_addr != job->source.sin_addr.s_addr)
+        {
+            sendto(job->socket, worker->replies, pending * sizeof(fleet_reply), 0, (const struct sockaddr*)&job->source, sizeof(job->source));
+            pending = 0;
+        }
+    }
+
+    now = fleet_time_nsec();
+    for (i = 0; i < count; i++)
+    {
+        unsigned int bucket = fleet_histogram_bucket(now - worker->jobs[i].received_nsec);
+
+        atomic_store_explicit(&metrics->latency[bucket], metrics->latency[bucket] + 1, memory_order_relaxed);
+        atomic_store_explicit(&metrics->statuses[worker->statuses[i]], metrics->statuses[worker->statuses[i]] + 1, memory_order_relaxed);
+    }
+    atomic_store_explicit(&metrics->batches, metrics->batches + 1, memory_order_relaxed);
+}
+
+//Function to print the records and latencies since the last call, or of the whole run
+static void print_metrics(double seconds, bool total)
+{
+    static uint64_t last_statuses[FLEET_STATUSES], last_batches, last_received, last_latency[FLEET_HISTOGRAM_BUCKETS];
+    uint64_t statuses[FLEET_STATUSES] = { 0 }, latency[FLEET_HISTOGRAM_BUCKETS] = { 0 };
+    uint64_t batches = 0, received = 0, malformed = 0, verified, status_sum[FLEET_STATUSES], latency_sum[FLEET_HISTOGRAM_BUCKETS];
+    unsigned int i, j;
+
+    for (i = 0; i < options.workers; i++)
+    {
+        for (j = 0; j < FLEET_STATUSES; j++)
+        {
+            statuses[j] += atomic_load_explicit(&workers[i].metrics.statuses[j], memory_order_relaxed);
+        }
+        for (j = 0; j < FLEET_HISTOGRAM_BUCKETS; j++)
+        {
+            latency[j] += atomic_load_explicit(&workers[i].metrics.latency[j], memory_order_relaxed);
+        }
+        batches += atomic_load_explicit(&workers[i].metrics.batches, memory_order_relaxed);
+    }
+    for (i = 0; i < options.receivers; i++)
+    {
+        received += atomic_load_explicit(&receivers[i].received, memory_order_relaxed);
+        statuses[FLEET_STATUS_BUSY] += atomic_load_explicit(&receivers[i].busy_count, memory_order_relaxed);
+        malformed += atomic_load_explicit(&receivers[i].malformed, memory_order_relaxed);
+    }
+
+    memcpy(status_sum, statuses, sizeof(statuses));
+    memcpy(latency_sum, latency, sizeof(latency));
+    if (!total)
+    {
+        for (j = 0; j < FLEET_STATUSES; j++)
+        {
+            statuses[j] -= last_statuses[j];
+        }
+        for (j = 0; j < FLEET_HISTOGRAM_BUCKETS; j++)
+        {
+            latency[j] -= last_latency[j];
+        }
+        batches -= last_batches;
+        received -= last_received;
+        memcpy(last_statuses, status_sum, sizeof(status_sum));
+        memcpy(last_latency, latency_sum, sizeof(latency_sum));
+        last_batches += batches;
+        last_received += received;
+    }
+
+    verified = statuses[FLEET_STATUS_OK] + statuses[FLEET_STATUS_MISMATCH] + statuses[FLEET_STATUS_UNKNOWN];
+    if (!total && received == 0 && verified == 0)
+    {
+        return;
+    }
+    printf("%s %10.0f rec/s %10.0f verified/s  ok %llu mismatch %llu unknown %llu busy %llu  batch %5.1f"
+           "  latency p50 %6.1f p99 %7.1f max %8.1f us\n",
+           total ? "total" : "     ", received / seconds, verified / seconds,
+           (unsigned long long)statuses[FLEET_STATUS_OK], (unsigned long long)statuses[FLEET_STATUS_MISMATCH],
+           (unsigned long long)statuses[FLEET_STATUS_UNKNOWN], (unsigned long long)statuses[FLEET_STATUS_BUSY],
+           batches ? (double)verified / batches : 0.0,
+           fleet_histogram_percentile(latency, 0.5) / 1e3, fleet_histogram_percentile(latency, 0.99) / 1e3,
+           fleet_histogram_percentile(latency, 1.0) / 1e3);
+    if (total && malformed)
+    {
+        printf("%llu malformed datagrams\n", (unsigned long long)malformed);
+    }
+    fflush(stdout);
+}
+
+static void handle_signal(int signal_number)
+{
+    (void)signal_number;
+    stop_requested = 1;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [-p port] [-w workers] [-r receivers] [-b batch] [-q queue size]\n"
+            "       [-k key store | -m master key] [-s slot] [-i interval] [-P path]\n"
+            "  -k  key store of key_store.py, default is to derive the keys from the master key\n"
+            "  -m  master key as 64 hex digits, default is the demo key of main.c\n"
+            "  -P  scalar, sse2x4, avx2x8 or sha-ni, default is the best the CPU runs\n", program);
+    exit(1);
+}
+
+static bool parse_hex(const char *text, uint8_t *data, size_t size)
+{
+    size_t i;
+
+    if (strlen(text) != 2 * size)
+    {
+        return false;
+    }
+    for (i = 0; i < size; i++)
+    {
+        unsigned int byte;
+
+        if (sscanf(text + 2 * i, "%2x", &byte) != 1)
+        {
+            return false;
+        }
+        data[i] = (uint8_t)byte;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    struct sockaddr_in address;
+    struct sigaction action;
+    struct timeval timeout = { 0, 100000 };
+    uint64_t started, last;
+    unsigned int i;
+    int option, path;
+
+    while ((option = getopt(argc, argv, "p:w:r:b:q:k:m:s:i:P:")) != -1)
+    {
+        switch (option)
+        {
+        case 'p': options.port = (uint16_t)atoi(optarg); break;
+        case 'w': options.workers = (unsigned int)atoi(optarg); break;
+        case 'r': options.receivers = (unsigned int)atoi(optarg); break;
+        case 'b': options.batch = (unsigned int)atoi(optarg); break;
+        case 'q': options.queue_size = (size_t)atol(optarg); break;
+        case 'k': options.store_file = optarg; break;
+        case 's': options.slot = (uint16_t)atoi(optarg); options.slot_set = true; break;
+        case 'i': options.interval = atof(optarg); break;
+        case 'm':
+            if (!parse_hex(optarg, options.master_key, sizeof(options.master_key)))
+            {
+                usage(argv[0]);
+            }
+            break;
+        case 'P':
+            for (path = SHA256_MB_AUTO + 1; path < SHA256_MB_PATHS; path++)
+            {
+                if (sha256_mb_name(path) && strcmp(optarg, sha256_mb_name(path)) == 0)
+                {
+                    options.path = path;
+                }
+            }
+            if (options.path == SHA256_MB_AUTO)
+            {
+                usage(argv[0]);
+            }
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (options.workers < 1 || options.workers > VERIFIER_MAX_WORKERS || options.receivers < 1
+            || options.receivers > VERIFIER_MAX_RECEIVERS || options.batch < 1 || options.batch > VERIFIER_MAX_BATCH
+            || options.queue_size < 2 || (options.queue_size & (options.queue_size - 1)) || options.interval <= 0)
+    {
+        usage(argv[0]);
+    }
+
+    path = sha256_mb_select(options.path);
+    if (path < 0)
+    {
+        fprintf(stderr, "error: the CPU does not run the %s path\n", sha256_mb_name(options.path));
+        return 1;
+    }
+    if (options.store_file)
+    {
+        if (!key_store_open(&store, options.store_file))
+        {
+            return 1;
+        }
+        use_store = true;
+        if (!options.slot_set)
+        {
+            options.slot = store.slot;
+        }
+    }
+
+    workers = aligned_alloc(VERIFIER_CACHE_LINE, options.workers * sizeof(verifier_worker));
+    receivers = aligned_alloc(VERIFIER_CACHE_LINE, options.receivers * sizeof(verifier_receiver));
+    if (workers == NULL || receivers == NULL || !queue_init(&queue, options.queue_size))
+    {
+        fprintf(stderr, "error: out of memory\n");
+        return 1;
+    }
+    memset(workers, 0, options.workers * sizeof(verifier_worker));
+    memset(receivers, 0, options.receivers * sizeof(verifier_receiver));
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(options.port);
+    for (i = 0; i < options.receivers; i++)
+    {
+        int enable = 1, buffer = 4 << 20;
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+        if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0
+                || bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0)
+        {
+            fprintf(stderr, "error: cannot bind UDP port %u: %s\n", options.port, strerror(errno));
+            return 1;
+        }
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        receivers[i].socket = fd;
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    for (i = 0; i < options.workers; i++)
+    {
+        pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+    }
+    for (i = 0; i < options.receivers; i++)
+    {
+        pthread_create(&receivers[i].thread, NULL, receiver_main, &receivers[i]);
+    }
+
+    printf("port %u, %u receivers, %u workers, batch %u, queue %zu, %s path, keys from %s, slot %u\n",
+           options.port, options.receivers, options.workers, options.batch, options.queue_size,
+           sha256_mb_name(path), use_store ? options.store_file : "the master key", options.slot);
+    fflush(stdout);
+
+    started = last = fleet_time_nsec();
+    while (!stop_requested)
+    {
+        struct timespec pause = { 0, 10000000 };
+        uint64_t now;
+
+        nanosleep(&pause, NULL);
+        now = fleet_time_nsec();
+        if (now - last >= options.interval * 1e9)
+        {
+            print_metrics((now - last) / 1e9, false);
+            last = now;
+        }
+    }
+
+    //Stop receiving, then let the workers empty the queue
+    atomic_store(&receiving, false);
+    for (i = 0; i < options.receivers; i++)
+    {
+        pthread_join(receivers[i].thread, NULL);
+    }
+    atomic_store(&working, false);
+    for (i = 0; i < options.workers; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+    print_metrics((fleet_time_nsec() - started) / 1e9, true);
+    return 0;
+}
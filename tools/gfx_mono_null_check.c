@@ -0,0 +1,431 @@
+/**
+ * \file
+ * \brief  Checks the null gfx_mono driver the host tools measure with
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux with
+ *
+ *   S=../firmware/samd21/src G=$S/ASF/common2/services/gfx_mono
+ *   cc -O2 -Ihost -I$S -I$S/config -I$S/ASF/sam0/utils -I$G -o gfx_mono_null_check \
+ *      gfx_mono_null_check.c $G/gfx_mono_null.c $G/gfx_mono_framebuffer.c \
+ *      $G/gfx_mono_generic.c $G/gfx_mono_text.c $G/sysfont.c
+ *
+ * display_list_check, display_asset_check and display_stream_check count
+ * SSD1306 traffic and compare display contents through gfx_mono_null.c, so
+ * this checks the driver itself: every access function through the
+ * gfx_mono macros, against a model of the framebuffer and of the bus
+ * statistics a SSD1306 in page addressing mode would have seen, and the
+ * PBM export. Random sequences of accesses follow the fixed cases.
+ *
+ * -p writes a PBM of a test pattern drawn with the generic primitives.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <asf.h>
+
+//Command bytes of a page and column address setup
+#define CHECK_ADDRESS_BYTES     3
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+            g_failures++; \
+        } \
+    } while (0)
+
+static uint32_t g_failures;
+static uint64_t g_random_state = 1;
+
+//What the driver should hold and have counted
+static uint8_t g_model[GFX_MONO_LCD_FRAMEBUFFER_SIZE];
+static struct gfx_mono_null_stats g_model_stats;
+
+static uint32_t check_random(uint32_t range)
+{
+    g_random_state ^= g_random_state >> 12;
+    g_random_state ^= g_random_state << 25;
+    g_random_state ^= g_random_state >> 27;
+    return (uint32_t)((g_random_state * 2685821657736338717ULL) >> 33) % range;
+}
+
+static void model_reset(void)
+{
+    memset(g_model, 0, sizeof(g_model));
+    memset(&g_model_stats, 0, sizeof(g_model_stats));
+}
+
+static void model_put_byte(uint8_t page, uint8_t column, uint8_t data)
+{
+    if (g_model[page * GFX_MONO_LCD_WIDTH + column] == data)
+    {
+        g_model_stats.skipped_bytes++;
+        return;
+    }
+    g_model[page * GFX_MONO_LCD_WIDTH + column] = data;
+    g_model_stats.transactions++;
+    g_model_stats.command_bytes += CHECK_ADDRESS_BYTES;
+    g_model_stats.data_bytes++;
+}
+
+static void model_mask_byte(uint8_t page, uint8_t column, uint8_t mask, uint8_t color)
+{
+    uint8_t data = g_model[page * GFX_MONO_LCD_WIDTH + column];
+
+    g_model_stats.read_bytes++;
+    if (color == GFX_PIXEL_SET)
+    {
+        data |= mask;
+    }
+    else if (color == GFX_PIXEL_CLR)
+    {
+        data &= ~mask;
+    }
+    else if (color == GFX_PIXEL_XOR)
+    {
+        data ^= mask;
+    }
+    model_put_byte(page, column, data);
+}
+
+static bool check_matches_model(void)
+{
+    uint8_t page_data[GFX_MONO_LCD_WIDTH];
+    uint8_t page;
+
+    for (page = 0; page < GFX_MONO_LCD_PAGES; page++)
+    {
+        //Straight from the framebuffer, the driver would count the read
+        gfx_mono_framebuffer_get_page(page_data, page, 0, GFX_MONO_LCD_WIDTH);
+        if (memcmp(page_data, &g_model[page * GFX_MONO_LCD_WIDTH], GFX_MONO_LCD_WIDTH) != 0)
+        {
+            return false;
+        }
+    }
+    return memcmp(gfx_mono_null_get_stats(), &g_model_stats, sizeof(g_model_stats)) == 0;
+}
+
+//Function to convert the model to a PBM the way the export should
+static void check_model_pbm(uint8_t *image)
+{
+    uint16_t length = sprintf((char *)image, "P4\n%u %u\n", GFX_MONO_LCD_WIDTH, GFX_MONO_LCD_HEIGHT);
+    uint16_t x, y;
+
+    memset(&image[length], 0, GFX_MONO_NULL_PBM_SIZE - length);
+    for (y = 0; y < GFX_MONO_LCD_HEIGHT; y++)
+    {
+        for (x = 0; x < GFX_MONO_LCD_WIDTH; x++)
+        {
+            if ((g_model[(y / 8) * GFX_MONO_LCD_WIDTH + x] >> (y % 8)) & 1)
+            {
+                image[length + y * (GFX_MONO_LCD_WIDTH / 8) + x / 8] |= 0x80 >> (x % 8);
+            }
+        }
+    }
+}
+
+static void check_fixed(void)
+{
+    static uint8_t image[GFX_MONO_NULL_PBM_SIZE + 1];
+    static uint8_t expected_image[GFX_MONO_NULL_PBM_SIZE];
+    const struct gfx_mono_null_stats *stats = gfx_mono_null_get_stats();
+    uint8_t page_data[GFX_MONO_LCD_WIDTH];
+    uint8_t i;
+
+    //Init clears the display and the statistics
+    gfx_mono_init();
+    gfx_mono_put_byte(1, 1, 0xAA);
+    gfx_mono_present();
+    gfx_mono_init();
+    model_reset();
+    CHECK(check_matches_model());
+
+    //A page write is one address setup and its data, whatever it contains
+    for (i = 0; i < 10; i++)
+    {
+        page_data[i] = i + 1;
+        g_model[2 * GFX_MONO_LCD_WIDTH + 100 + i] = i + 1;
+    }
+    gfx_mono_put_page(page_data, 2, 100, 10);
+    g_model_stats.transactions++;
+    g_model_stats.command_bytes += CHECK_ADDRESS_BYTES;
+    g_model_stats.data_bytes += 10;
+    CHECK(check_matches_model());
+    gfx_mono_put_page(page_data, 2, 100, 10);
+    g_model_stats.transactions++;
+    g_model_stats.command_bytes += CHECK_ADDRESS_BYTES;
+    g_model_stats.data_bytes += 10;
+    CHECK(check_matches_model());
+
+    memset(page_data, 0, sizeof(page_data));
+    gfx_mono_get_page(page_data, 2, 99, 12);
+    g_model_stats.read_bytes += 12;
+    CHECK(page_data[0] == 0 && page_data[1] == 1 && page_data[10] == 10 && page_data[11] == 0);
+    CHECK(check_matches_model());
+
+    //Bytes already displayed are not sent again
+    gfx_mono_put_byte(3, 127, 0x81);
+    model_put_byte(3, 127, 0x81);
+    gfx_mono_put_byte(3, 127, 0x81);
+    model_put_byte(3, 127, 0x81);
+    CHECK(stats->skipped_bytes == 1 && stats->data_bytes == 21);
+    CHECK(gfx_mono_get_byte(3, 127) == 0x81);
+    g_model_stats.read_bytes++;
+    CHECK(check_matches_model());
+
+    //Masked writes read the byte first
+    gfx_mono_mask_byte(0, 0, 0x0F, GFX_PIXEL_SET);
+    model_mask_byte(0, 0, 0x0F, GFX_PIXEL_SET);
+    gfx_mono_mask_byte(0, 0, 0x03, GFX_PIXEL_CLR);
+    model_mask_byte(0, 0, 0x03, GFX_PIXEL_CLR);
+    gfx_mono_mask_byte(0, 0, 0x11, GFX_PIXEL_XOR);
+    model_mask_byte(0, 0, 0x11, GFX_PIXEL_XOR);
+    gfx_mono_mask_byte(0, 0, 0x11, GFX_PIXEL_SET);
+    model_mask_byte(0, 0, 0x11, GFX_PIXEL_SET);
+    CHECK(g_model[0] == 0x1D && gfx_mono_null_get_stats()->skipped_bytes == 2);
+    CHECK(check_matches_model());
+
+    //Pixels, and those outside the screen are dropped without traffic
+    gfx_mono_draw_pixel(5, 13, GFX_PIXEL_SET);
+    model_mask_byte(1, 5, 1 << 5, GFX_PIXEL_SET);
+    gfx_mono_draw_pixel(GFX_MONO_LCD_WIDTH, 0, GFX_PIXEL_SET);
+    gfx_mono_draw_pixel(0, GFX_MONO_LCD_HEIGHT, GFX_PIXEL_SET);
+    CHECK(check_matches_model());
+    CHECK(gfx_mono_get_pixel(5, 13) != 0);
+    CHECK(gfx_mono_get_pixel(5, 12) == 0);
+    g_model_stats.read_bytes += 2;
+    CHECK(gfx_mono_get_pixel(GFX_MONO_LCD_WIDTH, 13) == 0);
+    CHECK(check_matches_model());
+
+    //A full framebuffer write is the four pages the SSD1306 driver sends
+    gfx_mono_put_framebuffer();
+    g_model_stats.transactions += GFX_MONO_LCD_PAGES;
+    g_model_stats.command_bytes += GFX_MONO_LCD_PAGES * CHECK_ADDRESS_BYTES;
+    g_model_stats.data_bytes += GFX_MONO_LCD_FRAMEBUFFER_SIZE;
+    CHECK(check_matches_model());
+
+    //Present only counts frames, the double buffer calls compile to nothing
+    gfx_mono_present();
+    gfx_mono_present_wait();
+    gfx_mono_set_flush_budget(16);
+    gfx_mono_set_compose_callback(NULL);
+    gfx_mono_invalidate(0, 0, GFX_MONO_LCD_WIDTH);
+    CHECK(!gfx_mono_flush());
+    g_model_stats.frames++;
+    CHECK(check_matches_model());
+
+    gfx_mono_null_reset_stats();
+    memset(&g_model_stats, 0, sizeof(g_model_stats));
+    CHECK(check_matches_model());
+
+    //PBM export, refused for a buffer one byte short
+    memset(image, 0xEE, sizeof(image));
+    CHECK(gfx_mono_null_export_pbm(image, GFX_MONO_NULL_PBM_SIZE - 1) == 0);
+    CHECK(image[0] == 0xEE);
+    CHECK(gfx_mono_null_export_pbm(image, sizeof(image)) == GFX_MONO_NULL_PBM_SIZE);
+    check_model_pbm(expected_image);
+    CHECK(memcmp(image, expected_image, GFX_MONO_NULL_PBM_SIZE) == 0);
+    CHECK(image[GFX_MONO_NULL_PBM_SIZE] == 0xEE);
+    CHECK(check_matches_model());
+}
+
+//Function to run random accesses through the driver and the model, returns false on the first difference
+static bool check_random_accesses(uint32_t count)
+{
+    uint8_t page_data[GFX_MONO_LCD_WIDTH];
+    uint8_t read_data[GFX_MONO_LCD_WIDTH];
+    uint8_t page, column, width, data, mask, color;
+    gfx_coord_t x, y;
+    uint32_t i;
+    uint8_t j;
+
+    gfx_mono_init();
+    model_reset();
+
+    for (i = 0; i < count; i++)
+    {
+        page = check_random(GFX_MONO_LCD_PAGES);
+        column = check_random(GFX_MONO_LCD_WIDTH);
+        //Mostly values already there, so skipped writes are covered
+        data = check_random(2) ? g_model[page * GFX_MONO_LCD_WIDTH + column] : (uint8_t)check_random(256);
+
+        switch (check_random(7))
+        {
+        case 0:
+            width = 1 + check_random(GFX_MONO_LCD_WIDTH - column);
+            for (j = 0; j < width; j++)
+            {
+                page_data[j] = (uint8_t)check_random(256);
+            }
+            gfx_mono_put_page(page_data, page, column, width);
+            memcpy(&g_model[page * GFX_MONO_LCD_WIDTH + column], page_data, width);
+            g_model_stats.transactions++;
+            g_model_stats.command_bytes += CHECK_ADDRESS_BYTES;
+            g_model_stats.data_bytes += width;
+            break;
+        case 1:
+            width = 1 + check_random(GFX_MONO_LCD_WIDTH - column);
+            gfx_mono_get_page(read_data, page, column, width);
+            g_model_stats.read_bytes += width;
+            if (memcmp(read_data, &g_model[page * GFX_MONO_LCD_WIDTH + column], width) != 0)
+            {
+                printf("access %u: page read differs\n", i);
+                return false;
+            }
+            break;
+        case 2:
+            gfx_mono_put_byte(page, column, data);
+            model_put_byte(page, column, data);
+            break;
+        case 3:
+            g_model_stats.read_bytes++;
+            if (gfx_mono_get_byte(page, column) != g_model[page * GFX_MONO_LCD_WIDTH + column])
+            {
+                printf("access %u: byte read differs\n", i);
+                return false;
+            }
+            break;
+        case 4:
+            mask = (uint8_t)check_random(256);
+            color = check_random(4);
+            gfx_mono_mask_byte(page, column, mask, color);
+            model_mask_byte(page, column, mask, color);
+            break;
+        case 5:
+            //A few past the edges to check they are dropped
+            x = check_random(GFX_MONO_LCD_WIDTH + 4);
+            y = check_random(GFX_MONO_LCD_HEIGHT + 4);
+            color = check_random(3);
+            gfx_mono_draw_pixel(x, y, color);
+            if ((x < GFX_MONO_LCD_WIDTH) && (y < GFX_MONO_LCD_HEIGHT))
+            {
+                model_mask_byte(y / 8, x, 1 << (y % 8), color);
+            }
+            break;
+        default:
+            x = check_random(GFX_MONO_LCD_WIDTH + 4);
+            y = check_random(GFX_MONO_LCD_HEIGHT + 4);
+            if ((x < GFX_MONO_LCD_WIDTH) && (y < GFX_MONO_LCD_HEIGHT))
+            {
+                g_model_stats.read_bytes++;
+                data = (g_model[(y / 8) * GFX_MONO_LCD_WIDTH + x] >> (y % 8)) & 1;
+            }
+            else
+            {
+                data = 0;
+            }
+            if ((gfx_mono_get_pixel(x, y) != 0) != (data != 0))
+            {
+                printf("access %u: pixel %u,%u differs\n", i, x, y);
+                return false;
+            }
+            break;
+        }
+
+        if (!check_matches_model())
+        {
+            printf("access %u: framebuffer or statistics differ from the model\n", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//Function to write a test pattern drawn with the generic primitives as a PBM
+static bool check_write_pattern(const char *file_name)
+{
+    static uint8_t image[GFX_MONO_NULL_PBM_SIZE];
+    const struct gfx_mono_null_stats *stats = gfx_mono_null_get_stats();
+    FILE *file;
+
+    gfx_mono_init();
+    gfx_mono_draw_rect(0, 0, GFX_MONO_LCD_WIDTH, GFX_MONO_LCD_HEIGHT, GFX_PIXEL_SET);
+    gfx_mono_draw_filled_circle(16, 16, 10, GFX_PIXEL_SET, GFX_QUADRANT0 | GFX_QUADRANT2);
+    gfx_mono_draw_line(32, 4, 44, 27, GFX_PIXEL_SET);
+    gfx_mono_draw_string("gfx_mono_null", 50, 12, &sysfont);
+    printf("pattern: %u address setups, %u command and %u data bytes, %u skipped, %u read\n",
+           stats->transactions, stats->command_bytes, stats->data_bytes, stats->skipped_bytes, stats->read_bytes);
+
+    file = fopen(file_name, "wb");
+    if ((file == NULL) || (fwrite(image, 1, gfx_mono_null_export_pbm(image, sizeof(image)), file) != sizeof(image)))
+    {
+        printf("cannot write %s\n", file_name);
+        if (file)
+        {
+            fclose(file);
+        }
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+static void print_usage(const char *name)
+{
+    printf("usage: %s [-n accesses] [-s seed] [-p pbm]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *pbm_name = NULL;
+    uint32_t accesses = 200000;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:s:p:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'n': accesses = (uint32_t)atoi(optarg); break;
+        case 's': g_random_state = strtoull(optarg, NULL, 0) + 1; break;
+        case 'p': pbm_name = optarg; break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+
+    check_fixed();
+    printf("fixed cases: %u failed\n", g_failures);
+    if (!check_random_accesses(accesses))
+    {
+        g_failures++;
+    }
+    else
+    {
+        printf("%u random accesses match the model\n", accesses);
+    }
+    if (pbm_name && !check_write_pattern(pbm_name))
+    {
+        g_failures++;
+    }
+
+    return (g_failures == 0) ? 0 : 1;
+}
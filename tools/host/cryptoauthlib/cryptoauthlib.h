@@ -0,0 +1,194 @@
+/**
+ * \file
+ * \brief  Host stand-in of the cryptoauthlib API used by the I2C HAL
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * The cryptoauthlib submodule is not part of this tree. The host tools that
+ * build hal_i2c_dma.c put this directory ahead of the firmware sources, so
+ * "cryptoauthlib.h" and "hal/atca_hal.h" resolve here. Types, values and
+ * defaults follow cryptoauthlib 2018. cryptoauthlib_sim.c has the command
+ * layer: one device, the ATCAPacket framing and the polling execution loop
+ * of atca_execute_command(), for the few atcab_* commands the tools run.
+ */
+
+#ifndef CRYPTOAUTHLIB_H_
+#define CRYPTOAUTHLIB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef enum
+{
+    ATCA_SUCCESS                = 0x00,
+    ATCA_CONFIG_ZONE_LOCKED     = 0x01,
+    ATCA_DATA_ZONE_LOCKED       = 0x02,
+    ATCA_WAKE_FAILED            = 0xD0,
+    ATCA_CHECKMAC_VERIFY_FAILED = 0xD1,
+    ATCA_PARSE_ERROR            = 0xD2,
+    ATCA_STATUS_CRC             = 0xD4,
+    ATCA_STATUS_UNKNOWN         = 0xD5,
+    ATCA_STATUS_ECC             = 0xD6,
+    ATCA_FUNC_FAIL              = 0xE0,
+    ATCA_GEN_FAIL               = 0xE1,
+    ATCA_BAD_PARAM              = 0xE2,
+    ATCA_INVALID_ID             = 0xE3,
+    ATCA_INVALID_SIZE           = 0xE4,
+    ATCA_RX_CRC_ERROR           = 0xE5,
+    ATCA_RX_FAIL                = 0xE6,
+    ATCA_RX_NO_RESPONSE         = 0xE7,
+    ATCA_RESYNC_WITH_WAKEUP     = 0xE8,
+    ATCA_PARITY_ERROR           = 0xE9,
+    ATCA_TX_TIMEOUT             = 0xEA,
+    ATCA_RX_TIMEOUT             = 0xEB,
+    ATCA_TOO_MANY_COMM_RETRIES  = 0xEC,
+    ATCA_SMALL_BUFFER           = 0xED,
+    ATCA_COMM_FAIL              = 0xF0,
+    ATCA_TIMEOUT                = 0xF1,
+    ATCA_BAD_OPCODE             = 0xF2,
+    ATCA_WAKE_SUCCESS           = 0xF3,
+    ATCA_EXECUTION_ERROR        = 0xF4,
+    ATCA_UNIMPLEMENTED          = 0xF5,
+    ATCA_ASSERT_FAILURE         = 0xF6,
+    ATCA_TX_FAIL                = 0xF7,
+    ATCA_NOT_LOCKED             = 0xF8,
+    ATCA_NO_DEVICES             = 0xF9,
+} ATCA_STATUS;
+
+typedef enum
+{
+    ATCA_I2C_IFACE,
+    ATCA_SWI_IFACE,
+    ATCA_UART_IFACE,
+    ATCA_SPI_IFACE,
+    ATCA_HID_IFACE,
+    ATCA_CUSTOM_IFACE,
+    ATCA_UNKNOWN_IFACE,
+} ATCAIfaceType;
+
+typedef enum
+{
+    ATSHA204A,
+    ATECC108A,
+    ATECC508A,
+    ATECC608A,
+    ATCA_DEV_UNKNOWN = 0x20
+} ATCADeviceType;
+
+typedef struct
+{
+    ATCAIfaceType iface_type;
+    ATCADeviceType devtype;
+    union
+    {
+        struct ATCAI2C
+        {
+            uint8_t slave_address;  //8-bit address
+            uint8_t bus;            //SERCOM instance
+            uint32_t baud;
+        } atcai2c;
+    };
+    uint16_t wake_delay;            //tWLO + tWHI in microseconds
+    int rx_retries;
+    void *cfg_data;
+} ATCAIfaceCfg;
+
+struct atca_iface
+{
+    ATCAIfaceCfg *mIfaceCFG;
+    void *hal_data;
+};
+typedef struct atca_iface *ATCAIface;
+
+//Polling of atca_execute_command() when ATCA_NO_POLL is not defined
+#define ATCA_POLLING_INIT_TIME_MSEC         1
+#define ATCA_POLLING_FREQUENCY_TIME_MSEC    2
+#define ATCA_POLLING_MAX_TIME_MSEC          2500
+
+#define ATCA_SERIAL_NUM_SIZE    9
+#define ATCA_KEY_SIZE           32
+#define ATCA_BLOCK_SIZE         32
+#define ATCA_WORD_SIZE          4
+#define ATCA_ZONE_CONFIG        0
+#define ATCA_ZONE_OTP           1
+#define ATCA_ZONE_DATA          2
+#define ATCA_ZONE_READWRITE_32  0x80
+#define NONCE_NUMIN_SIZE        20
+#define NONCE_MODE_SEED_UPDATE  0x00
+#define MAC_MODE_CHALLENGE      0x00
+#define MAC_MODE_BLOCK2_TEMPKEY 0x01
+#define MAC_SIZE                32
+#define RANDOM_NUM_SIZE         32
+#define INFO_SIZE               4
+
+#define ATCA_MAC                0x08
+#define ATCA_READ               0x02
+#define ATCA_NONCE              0x16
+#define ATCA_RANDOM             0x1B
+#define ATCA_INFO               0x30
+
+//Sizes of the command packet around its data, and of a status response
+#define ATCA_CMD_SIZE_MIN       7
+#define ATCA_RSP_SIZE_MIN       4
+#define ATCA_COUNT_IDX          0
+#define ATCA_RSP_DATA_IDX       1
+
+typedef struct
+{
+    uint8_t _reserved;      //Word address, set by the HAL
+    uint8_t txsize;
+    uint8_t opcode;
+    uint8_t param1;
+    uint16_t param2;
+    uint8_t data[130];      //Command data and CRC, then the response
+    uint8_t execTime;
+    uint16_t rxsize;
+} ATCAPacket;
+
+extern ATCAIfaceCfg cfg_ateccx08a_i2c_default;
+extern ATCAIfaceCfg cfg_atsha204a_i2c_default;
+
+ATCAIfaceCfg* atgetifacecfg(ATCAIface ca_iface);
+void* atgetifacehaldat(ATCAIface ca_iface);
+void atCRC(size_t length, const uint8_t *data, uint8_t *crc_le);
+
+ATCA_STATUS atcab_init(ATCAIfaceCfg *cfg);
+ATCA_STATUS atcab_release(void);
+ATCA_STATUS atcab_wakeup(void);
+ATCA_STATUS atcab_idle(void);
+ATCA_STATUS atcab_sleep(void);
+ATCA_STATUS atcab_info(uint8_t *revision);
+ATCA_STATUS atcab_random(uint8_t *rand_out);
+ATCA_STATUS atcab_read_zone(uint8_t zone, uint16_t slot, uint8_t block, uint8_t offset, uint8_t *data, uint8_t len);
+ATCA_STATUS atcab_read_serial_number(uint8_t *serial_number);
+ATCA_STATUS atcab_nonce_rand(const uint8_t *num_in, uint8_t *rand_out);
+ATCA_STATUS atcab_mac(uint8_t mode, uint16_t key_id, const uint8_t *challenge, uint8_t *digest);
+ATCA_STATUS atca_execute_command(ATCAPacket *packet);
+
+#include "hal/atca_hal.h"
+
+#endif /* CRYPTOAUTHLIB_H_ */
@@ -0,0 +1,335 @@
+/**
+ * \file
+ * \brief  Command layer of cryptoauthlib for the host tools
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#include <string.h>
+#include "cryptoauthlib.h"
+
+//Counts of the commands, with the count, opcode, parameters and CRC
+#define ATCA_CRC_SIZE           2
+#define INFO_COUNT              ATCA_CMD_SIZE_MIN
+#define RANDOM_COUNT            ATCA_CMD_SIZE_MIN
+#define READ_COUNT              ATCA_CMD_SIZE_MIN
+#define NONCE_COUNT_SHORT       (ATCA_CMD_SIZE_MIN + NONCE_NUMIN_SIZE)
+#define MAC_COUNT_SHORT         ATCA_CMD_SIZE_MIN
+#define MAC_COUNT_LONG          (ATCA_CMD_SIZE_MIN + ATCA_KEY_SIZE)
+
+ATCAIfaceCfg cfg_ateccx08a_i2c_default =
+{
+    .iface_type = ATCA_I2C_IFACE,
+    .devtype = ATECC508A,
+    .atcai2c = { .slave_address = 0xC0, .bus = 2, .baud = 400000 },
+    .wake_delay = 1500,
+    .rx_retries = 20,
+};
+
+ATCAIfaceCfg cfg_atsha204a_i2c_default =
+{
+    .iface_type = ATCA_I2C_IFACE,
+    .devtype = ATSHA204A,
+    .atcai2c = { .slave_address = 0xC8, .bus = 2, .baud = 400000 },
+    .wake_delay = 2560,
+    .rx_retries = 20,
+};
+
+static struct atca_iface g_iface;
+static bool g_initialized;
+
+ATCAIfaceCfg* atgetifacecfg(ATCAIface ca_iface)
+{
+    return ca_iface->mIfaceCFG;
+}
+
+void* atgetifacehaldat(ATCAIface ca_iface)
+{
+    return ca_iface->hal_data;
+}
+
+//CRC-16 of the CryptoAuth devices, polynomial 0x8005 over the bits LSB first, stored little endian
+void atCRC(size_t length, const uint8_t *data, uint8_t *crc_le)
+{
+    size_t counter;
+    uint16_t crc_register = 0;
+    uint16_t polynom = 0x8005;
+    uint8_t shift_register;
+    uint8_t data_bit, crc_bit;
+
+    for (counter = 0; counter < length; counter++)
+    {
+        for (shift_register = 0x01; shift_register > 0x00; shift_register <<= 1)
+        {
+            data_bit = (data[counter] & shift_register) ? 1 : 0;
+            crc_bit = crc_register >> 15;
+            crc_register <<= 1;
+            if (data_bit != crc_bit)
+            {
+                crc_register ^= polynom;
+            }
+        }
+    }
+    crc_le[0] = (uint8_t)(crc_register & 0x00FF);
+    crc_le[1] = (uint8_t)(crc_register >> 8);
+}
+
+static void atCalcCrc(ATCAPacket *packet)
+{
+    uint8_t length = packet->txsize - ATCA_CRC_SIZE;
+
+    atCRC(length, &packet->txsize, &packet->txsize + length);
+}
+
+static ATCA_STATUS atCheckCrc(const uint8_t *response)
+{
+    uint8_t count = response[ATCA_COUNT_IDX];
+    uint8_t crc[ATCA_CRC_SIZE];
+
+    if (count < ATCA_RSP_SIZE_MIN)
+    {
+        return ATCA_RX_FAIL;
+    }
+    atCRC(count - ATCA_CRC_SIZE, response, crc);
+    return (crc[0] == response[count - 2] && crc[1] == response[count - 1]) ? ATCA_SUCCESS : ATCA_RX_CRC_ERROR;
+}
+
+static ATCA_STATUS isATCAError(const uint8_t *data)
+{
+    if (data[0] != 0x04)
+    {
+        return ATCA_SUCCESS;
+    }
+
+    switch (data[1])
+    {
+    case 0x00: return ATCA_SUCCESS;
+    case 0x01: return ATCA_CHECKMAC_VERIFY_FAILED;
+    case 0x03: return ATCA_PARSE_ERROR;
+    case 0x05: return ATCA_STATUS_ECC;
+    case 0x0F: return ATCA_EXECUTION_ERROR;
+    case 0x11: return ATCA_WAKE_SUCCESS;
+    case 0xFF: return ATCA_STATUS_CRC;
+    default:   return ATCA_GEN_FAIL;
+    }
+}
+
+ATCA_STATUS atcab_init(ATCAIfaceCfg *cfg)
+{
+    ATCAHAL_t hal;
+    ATCA_STATUS status;
+
+    if (g_initialized)
+    {
+        atcab_release();
+    }
+
+    g_iface.mIfaceCFG = cfg;
+    if ((status = hal_i2c_init(&hal, cfg)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+    g_iface.hal_data = hal.hal_data;
+    g_initialized = true;
+
+    return hal_i2c_post_init(&g_iface);
+}
+
+ATCA_STATUS atcab_release(void)
+{
+    if (!g_initialized)
+    {
+        return ATCA_SUCCESS;
+    }
+    g_initialized = false;
+    return hal_i2c_release(g_iface.hal_data);
+}
+
+ATCA_STATUS atcab_wakeup(void)
+{
+    return hal_i2c_wake(&g_iface);
+}
+
+ATCA_STATUS atcab_idle(void)
+{
+    return hal_i2c_idle(&g_iface);
+}
+
+ATCA_STATUS atcab_sleep(void)
+{
+    return hal_i2c_sleep(&g_iface);
+}
+
+//Wakes the device, sends the command, polls for the response and idles the device, as cryptoauthlib 2018 does
+ATCA_STATUS atca_execute_command(ATCAPacket *packet)
+{
+    ATCA_STATUS status;
+    uint32_t max_delay_count = ATCA_POLLING_MAX_TIME_MSEC / ATCA_POLLING_FREQUENCY_TIME_MSEC;
+    uint16_t rxsize;
+
+    do
+    {
+        if ((status = hal_i2c_wake(&g_iface)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+        if ((status = hal_i2c_send(&g_iface, (uint8_t*)packet, packet->txsize)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+
+        atca_delay_ms(ATCA_POLLING_INIT_TIME_MSEC);
+        do
+        {
+            memset(packet->data, 0, sizeof(packet->data));
+            rxsize = sizeof(packet->data);
+            if ((status = hal_i2c_receive(&g_iface, packet->data, &rxsize)) == ATCA_SUCCESS)
+            {
+                break;
+            }
+            atca_delay_ms(ATCA_POLLING_FREQUENCY_TIME_MSEC);
+        }
+        while (max_delay_count-- > 0);
+        if (status != ATCA_SUCCESS)
+        {
+            break;
+        }
+
+        if ((status = atCheckCrc(packet->data)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+        status = isATCAError(packet->data);
+    }
+    while (0);
+
+    hal_i2c_idle(&g_iface);
+    return status;
+}
+
+static ATCA_STATUS atca_run(ATCAPacket *packet, uint8_t opcode, uint8_t param1, uint16_t param2, uint8_t txsize)
+{
+    packet->opcode = opcode;
+    packet->param1 = param1;
+    packet->param2 = param2;
+    packet->txsize = txsize;
+    atCalcCrc(packet);
+    return atca_execute_command(packet);
+}
+
+ATCA_STATUS atcab_info(uint8_t *revision)
+{
+    ATCAPacket packet;
+    ATCA_STATUS status;
+
+    if ((status = atca_run(&packet, ATCA_INFO, 0, 0, INFO_COUNT)) == ATCA_SUCCESS)
+    {
+        memcpy(revision, &packet.data[ATCA_RSP_DATA_IDX], INFO_SIZE);
+    }
+    return status;
+}
+
+ATCA_STATUS atcab_random(uint8_t *rand_out)
+{
+    ATCAPacket packet;
+    ATCA_STATUS status;
+
+    if ((status = atca_run(&packet, ATCA_RANDOM, 0, 0, RANDOM_COUNT)) == ATCA_SUCCESS)
+    {
+        memcpy(rand_out, &packet.data[ATCA_RSP_DATA_IDX], RANDOM_NUM_SIZE);
+    }
+    return status;
+}
+
+ATCA_STATUS atcab_read_zone(uint8_t zone, uint16_t slot, uint8_t block, uint8_t offset, uint8_t *data, uint8_t len)
+{
+    ATCAPacket packet;
+    ATCA_STATUS status;
+    uint16_t address;
+
+    if (len != ATCA_WORD_SIZE && len != ATCA_BLOCK_SIZE)
+    {
+        return ATCA_BAD_PARAM;
+    }
+
+    address = (uint16_t)((block << 3) | (offset & 0x07));
+    if ((zone & 0x03) == ATCA_ZONE_DATA)
+    {
+        address = (uint16_t)((slot << 3) | (offset & 0x07) | (block << 8));
+    }
+    if (len == ATCA_BLOCK_SIZE)
+    {
+        zone |= ATCA_ZONE_READWRITE_32;
+    }
+
+    if ((status = atca_run(&packet, ATCA_READ, zone, address, READ_COUNT)) == ATCA_SUCCESS)
+    {
+        memcpy(data, &packet.data[ATCA_RSP_DATA_IDX], len);
+    }
+    return status;
+}
+
+ATCA_STATUS atcab_read_serial_number(uint8_t *serial_number)
+{
+    uint8_t block[ATCA_BLOCK_SIZE];
+    ATCA_STATUS status;
+
+    if ((status = atcab_read_zone(ATCA_ZONE_CONFIG, 0, 0, 0, block, ATCA_BLOCK_SIZE)) == ATCA_SUCCESS)
+    {
+        memcpy(&serial_number[0], &block[0], 4);
+        memcpy(&serial_number[4], &block[8], 5);
+    }
+    return status;
+}
+
+ATCA_STATUS atcab_nonce_rand(const uint8_t *num_in, uint8_t *rand_out)
+{
+    ATCAPacket packet;
+    ATCA_STATUS status;
+
+    memcpy(packet.data, num_in, NONCE_NUMIN_SIZE);
+    if ((status = atca_run(&packet, ATCA_NONCE, NONCE_MODE_SEED_UPDATE, 0, NONCE_COUNT_SHORT)) == ATCA_SUCCESS &&
+        rand_out != NULL)
+    {
+        memcpy(rand_out, &packet.data[ATCA_RSP_DATA_IDX], RANDOM_NUM_SIZE);
+    }
+    return status;
+}
+
+ATCA_STATUS atcab_mac(uint8_t mode, uint16_t key_id, const uint8_t *challenge, uint8_t *digest)
+{
+    ATCAPacket packet;
+    ATCA_STATUS status;
+    uint8_t txsize = MAC_COUNT_SHORT;
+
+    if (!(mode & MAC_MODE_BLOCK2_TEMPKEY))
+    {
+        memcpy(packet.data, challenge, ATCA_KEY_SIZE);
+        txsize = MAC_COUNT_LONG;
+    }
+    if ((status = atca_run(&packet, ATCA_MAC, mode, key_id, txsize)) == ATCA_SUCCESS)
+    {
+        memcpy(digest, &packet.data[ATCA_RSP_DATA_IDX], MAC_SIZE);
+    }
+    return status;
+}
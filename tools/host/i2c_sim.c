@@ -0,0 +1,1278 @@
+/**
+ * \file
+ * \brief  Register level model of the CryptoAuth I2C bus for the host tools
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+
+//glibc defines these as well, the ASF definitions win for the firmware code
+#undef __always_inline
+#undef LITTLE_ENDIAN
+#include <asf.h>
+#include "cryptoauthlib.h"
+#include "reg_trap.h"
+#include "i2c_sim.h"
+#include "boot_sequence.h"
+
+#define SIM_GCLK_HZ             48000000UL
+#define SIM_TRISE_NSEC          215
+#define SIM_TWLO_NSEC           60000       //Shortest low time of SDA that wakes a device
+#define SIM_INPUT_SIZE          160         //Word address and the longest command packet
+#define SIM_OUTPUT_SIZE         160
+#define SIM_CONFIG_SIZE         128
+#define SIM_STACK_SIZE          (256 * 1024)
+#define SIM_STACK_PAINT         0xA5
+#define SIM_MAX_CHAIN           1000        //Handlers in a row before an interrupt is taken as stuck
+
+//BUSSTATE values of STATUS
+#define SIM_BUS_UNKNOWN         0
+#define SIM_BUS_IDLE            1
+#define SIM_BUS_OWNER           2
+
+//Word address values of the CryptoAuth I2C interface
+#define SIM_WORD_RESET          0x00
+#define SIM_WORD_SLEEP          0x01
+#define SIM_WORD_IDLE           0x02
+#define SIM_WORD_COMMAND        0x03
+
+//Status bits of STATUS that set INTFLAG.ERROR, they are cleared by writing one
+#define SIM_STATUS_ERRORS       (SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST | \
+                                 SERCOM_I2CM_STATUS_LOWTOUT | SERCOM_I2CM_STATUS_MEXTTOUT | \
+                                 SERCOM_I2CM_STATUS_SEXTTOUT | SERCOM_I2CM_STATUS_LENERR)
+
+#define SIM_DMAC_ID_RX          (SERCOM0_DMAC_ID_RX + 2 * I2C_SIM_BUS)
+#define SIM_DMAC_ID_TX          (SERCOM0_DMAC_ID_TX + 2 * I2C_SIM_BUS)
+
+typedef struct
+{
+    i2c_sim_device_config config;
+    i2c_sim_device state;
+    uint64_t wake_at;           //End of tWHI after a wake pulse
+    uint64_t watchdog_at;
+    uint64_t busy_until;        //End of the command executing
+    uint64_t command_at;        //End of the last command packet
+    bool response_waiting;      //Its response was not read yet
+    uint8_t input[SIM_INPUT_SIZE];
+    uint16_t input_length;
+    uint8_t output[SIM_OUTPUT_SIZE];
+    uint8_t output_length;
+    uint8_t output_index;
+    uint16_t raw_index;
+    uint8_t config_zone[SIM_CONFIG_SIZE];
+    uint32_t random;
+} sim_device;
+
+typedef struct
+{
+    uint32_t ctrla;
+    uint32_t ctrlb;             //CMD is executed when written and never kept
+    uint32_t baud;
+    uint32_t addr;
+    uint8_t inten;
+    uint8_t intflag;
+    uint16_t status;            //BUSSTATE is kept in busstate
+    uint8_t busstate;
+    uint8_t data;
+    bool reading;
+    sim_device *target;         //Device of the running transfer, NULL after an address NACK
+} sim_master;
+
+typedef struct
+{
+    uint8_t chctrla;
+    uint32_t chctrlb;
+    uint8_t inten;
+    uint8_t intflag;
+    uint16_t done;              //Beats moved since the channel was enabled
+} sim_channel;
+
+typedef struct
+{
+    uint16_t ctrl;
+    uint32_t baseaddr;
+    uint32_t wrbaddr;
+    uint8_t chid;
+    sim_channel channels[DMAC_CH_NUM];
+} sim_dmac;
+
+static sim_device g_devices[I2C_SIM_MAX_DEVICES];
+static uint8_t g_device_count;
+static sim_master g_master;
+static sim_dmac g_dmac;
+static uint32_t g_nvic_enabled;
+static uint32_t g_nvic_priority[8];
+static uint32_t g_critical;         //Nesting of cpu_irq_enter_critical()
+static uint32_t g_chain;
+static uint64_t g_now_nsec;
+static uint64_t g_start_nsec;       //START condition of the running transfer
+static uint64_t g_bus_nsec;
+static i2c_sim_stats g_stats;
+static bool g_mapped;
+
+static ucontext_t g_caller_context;
+static ucontext_t g_call_context;
+static uint8_t *g_call_stack;
+static void (*g_call_function)(void *argument);
+static void *g_call_argument;
+
+static void sim_error(const char *format, ...)
+{
+    va_list args;
+
+    g_stats.errors++;
+    fprintf(stderr, "i2c_sim: ");
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+}
+
+//Returns the SCL frequency set in BAUD, with the rise time the ASF driver assumes
+uint32_t i2c_sim_scl_hz(void)
+{
+    uint32_t baud = g_master.baud & SERCOM_I2CM_BAUD_BAUD_Msk;
+
+    return (uint32_t)(SIM_GCLK_HZ / (10 + 2 * baud + SIM_GCLK_HZ * (SIM_TRISE_NSEC * 1e-9)));
+}
+
+static uint64_t sim_bus_bits(uint32_t bits)
+{
+    uint64_t nsec = (uint64_t)bits * 1000000000ULL / i2c_sim_scl_hz();
+
+    g_now_nsec += nsec;
+    g_bus_nsec += nsec;
+    g_stats.bus_usec = g_bus_nsec / 1000;
+    return nsec;
+}
+
+/* CryptoAuth devices */
+
+static uint32_t sim_next_random(sim_device *device)
+{
+    device->random ^= device->random << 13;
+    device->random ^= device->random >> 17;
+    device->random ^= device->random << 5;
+    return device->random;
+}
+
+static void sim_respond(sim_device *device, const uint8_t *data, uint8_t length)
+{
+    device->output[0] = length + 3;
+    memcpy(&device->output[1], data, length);
+    atCRC(length + 1, device->output, &device->output[length + 1]);
+    device->output_length = length + 3;
+    device->output_index = 0;
+}
+
+static void sim_respond_status(sim_device *device, uint8_t status)
+{
+    sim_respond(device, &status, 1);
+}
+
+//Typical execution times of the ATECC508A datasheet, in microseconds
+static uint32_t sim_typical_usec(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case 0x02: return 100;      //Read
+    case 0x08: return 5000;     //MAC
+    case 0x11: return 13000;    //HMAC
+    case 0x12: return 7000;     //Write
+    case 0x15: return 5000;     //GenDig
+    case 0x16: return 100;      //Nonce
+    case 0x17: return 8000;     //Lock
+    case 0x1B: return 1000;     //Random
+    case 0x28: return 5000;     //CheckMac
+    case 0x30: return 100;      //Info
+    case 0x40: return 11000;    //GenKey
+    case 0x41: return 42000;    //Sign
+    case 0x45: return 38000;    //Verify
+    case 0x47: return 7000;     //SHA
+    default:   return 1000;
+    }
+}
+
+static void sim_execute(sim_device *device, const uint8_t *packet, uint16_t length)
+{
+    const uint8_t revisions[4][4] =
+    {
+        { 0x00, 0x00, 0x09, 0x04 },     //ATSHA204A
+        { 0x00, 0x00, 0x10, 0x05 },     //ATECC108A
+        { 0x00, 0x00, 0x50, 0x00 },     //ATECC508A
+        { 0x00, 0x00, 0x60, 0x02 },     //ATECC608A
+    };
+    uint8_t response[ATCA_BLOCK_SIZE];
+    uint8_t crc[2];
+    uint8_t opcode;
+    uint8_t param1;
+    uint16_t param2;
+    uint16_t offset;
+    uint8_t size;
+    uint8_t i;
+
+    atCRC(length >= 2 ? length - 2 : 0, packet, crc);
+    if (length < ATCA_CMD_SIZE_MIN || packet[ATCA_COUNT_IDX] != length ||
+        crc[0] != packet[length - 2] || crc[1] != packet[length - 1])
+    {
+        device->state.bad_packets++;
+        sim_respond_status(device, 0xFF);
+        return;
+    }
+
+    opcode = packet[1];
+    param1 = packet[2];
+    param2 = packet[3] | (packet[4] << 8);
+    device->state.commands++;
+    device->command_at = g_now_nsec;
+    device->response_waiting = true;
+    device->busy_until = g_now_nsec + 1000ULL * (device->config.exec_time != NULL ?
+                         device->config.exec_time(device->config.exec_context, (uint8_t)(device - g_devices), opcode) :
+                         sim_typical_usec(opcode));
+
+    switch (opcode)
+    {
+    case ATCA_INFO:
+        sim_respond(device, revisions[device->config.devtype & 0x03], INFO_SIZE);
+        break;
+
+    case ATCA_READ:
+        size = (param1 & ATCA_ZONE_READWRITE_32) ? ATCA_BLOCK_SIZE : ATCA_WORD_SIZE;
+        offset = ((param2 >> 3) & 0x1F) * ATCA_BLOCK_SIZE + (param2 & 0x07) * ATCA_WORD_SIZE;
+        memset(response, 0, sizeof(response));
+        if ((param1 & 0x03) == ATCA_ZONE_CONFIG && offset + size <= SIM_CONFIG_SIZE)
+        {
+            memcpy(response, &device->config_zone[offset], size);
+        }
+        sim_respond(device, response, size);
+        break;
+
+    case ATCA_RANDOM:
+    case ATCA_NONCE:
+        if (opcode == ATCA_NONCE && (param1 & 0x03) == 0x03)
+        {
+            //Pass-through, TempKey is the input
+            device->state.tempkey_valid = true;
+            sim_respond_status(device, 0x00);
+            break;
+        }
+        for (i = 0; i < RANDOM_NUM_SIZE; i++)
+        {
+            response[i] = (uint8_t)sim_next_random(device);
+        }
+        if (opcode == ATCA_NONCE)
+        {
+            device->state.tempkey_valid = true;
+        }
+        sim_respond(device, response, RANDOM_NUM_SIZE);
+        break;
+
+    case ATCA_MAC:
+        //Modes taking TempKey need a Nonce since the last sleep, idle keeps it
+        if ((param1 & 0x03) != 0 && !device->state.tempkey_valid)
+        {
+            sim_respond_status(device, 0x0F);
+            break;
+        }
+        for (i = 0; i < MAC_SIZE; i++)
+        {
+            response[i] = (uint8_t)sim_next_random(device) ^ (length > 5 + i + 2 ? packet[5 + i] : 0);
+        }
+        sim_respond(device, response, MAC_SIZE);
+        break;
+
+    default:
+        sim_respond_status(device, 0x00);
+        break;
+    }
+}
+
+static void sim_sleep(sim_device *device, i2c_sim_state state)
+{
+    device->state.state = state;
+    device->response_waiting = false;
+    device->output_length = 0;
+    device->output_index = 0;
+    if (state == I2C_SIM_SLEEP)
+    {
+        device->state.tempkey_valid = false;
+    }
+}
+
+//Function to bring the state of the devices up to the simulated time
+static void sim_update(void)
+{
+    sim_device *device;
+    const uint8_t wake_response[4] = { 0x11 };
+    uint8_t i;
+
+    for (i = 0; i < g_device_count; i++)
+    {
+        device = &g_devices[i];
+        if (device->config.kind != I2C_SIM_CRYPTOAUTH)
+        {
+            continue;
+        }
+        if (device->state.state == I2C_SIM_WAKING && g_now_nsec >= device->wake_at)
+        {
+            device->state.state = I2C_SIM_AWAKE;
+            device->state.wakes++;
+            device->watchdog_at = device->wake_at + 1000ULL * device->config.watchdog_usec;
+            device->busy_until = 0;
+            sim_respond(device, wake_response, 1);
+        }
+        if (device->state.state == I2C_SIM_AWAKE && g_now_nsec >= device->watchdog_at)
+        {
+            device->state.watchdog_sleeps++;
+            sim_sleep(device, I2C_SIM_SLEEP);
+        }
+    }
+}
+
+static void sim_wake_pulse(uint64_t low_nsec)
+{
+    uint8_t i;
+
+    if (low_nsec < SIM_TWLO_NSEC)
+    {
+        g_stats.short_pulses++;
+        return;
+    }
+
+    g_stats.wake_pulses++;
+    for (i = 0; i < g_device_count; i++)
+    {
+        if (g_devices[i].config.kind == I2C_SIM_CRYPTOAUTH &&
+            (g_devices[i].state.state == I2C_SIM_SLEEP || g_devices[i].state.state == I2C_SIM_IDLE))
+        {
+            g_devices[i].state.state = I2C_SIM_WAKING;
+            g_devices[i].wake_at = g_now_nsec + 1000ULL * g_devices[i].config.twhi_usec;
+        }
+    }
+}
+
+static bool sim_device_acks(sim_device *device, bool reading)
+{
+    if (device->config.kind == I2C_SIM_RAW)
+    {
+        if (reading)
+        {
+            device->raw_index = 0;
+        }
+        else
+        {
+            device->state.raw_length = 0;
+        }
+        return true;
+    }
+
+    if (device->state.state != I2C_SIM_AWAKE)
+    {
+        device->state.asleep_nacks++;
+        return false;
+    }
+    if (g_now_nsec < device->busy_until)
+    {
+        device->state.busy_nacks++;
+        return false;
+    }
+    if (!reading)
+    {
+        device->input_length = 0;
+    }
+    else if (device->response_waiting)
+    {
+        device->response_waiting = false;
+        device->state.response_wait_usec = (uint32_t)((g_start_nsec - device->command_at) / 1000);
+    }
+    return true;
+}
+
+static uint8_t sim_device_read(sim_device *device)
+{
+    if (device->config.kind == I2C_SIM_RAW)
+    {
+        return (device->raw_index < I2C_SIM_RAW_SIZE) ? device->state.raw_read[device->raw_index++] : 0xFF;
+    }
+    return (device->output_index < device->output_length) ? device->output[device->output_index++] : 0xFF;
+}
+
+//Returns false when the device NACKs the byte
+static bool sim_device_write(sim_device *device, uint8_t data)
+{
+    if (device->config.kind == I2C_SIM_RAW)
+    {
+        if ((device->config.nack_after != 0 && device->state.raw_length >= device->config.nack_after) ||
+            device->state.raw_length == I2C_SIM_RAW_SIZE)
+        {
+            return false;
+        }
+        device->state.raw[device->state.raw_length++] = data;
+        return true;
+    }
+
+    if (device->input_length == SIM_INPUT_SIZE)
+    {
+        return false;
+    }
+    device->input[device->input_length++] = data;
+    return true;
+}
+
+//Function to act on what a CryptoAuth device received when the STOP condition ends the write
+static void sim_device_stop(sim_device *device)
+{
+    if (device->config.kind != I2C_SIM_CRYPTOAUTH || device->input_length == 0)
+    {
+        return;
+    }
+
+    switch (device->input[0])
+    {
+    case SIM_WORD_RESET:
+        device->output_index = 0;
+        break;
+    case SIM_WORD_SLEEP:
+        device->state.sleeps++;
+        sim_sleep(device, I2C_SIM_SLEEP);
+        break;
+    case SIM_WORD_IDLE:
+        device->state.idles++;
+        sim_sleep(device, I2C_SIM_IDLE);
+        break;
+    case SIM_WORD_COMMAND:
+        sim_execute(device, &device->input[1], device->input_length - 1);
+        break;
+    default:
+        sim_error("word address 0x%02X written to 0x%02X", device->input[0], device->config.address);
+        break;
+    }
+    device->input_length = 0;
+}
+
+/* DMAC */
+
+static DmacDescriptor* sim_dmac_descriptor(uint8_t channel)
+{
+    return (DmacDescriptor*)(uintptr_t)(g_dmac.baseaddr + channel * sizeof(DmacDescriptor));
+}
+
+//Returns the enabled channel triggered by trigger, or -1
+static int sim_dmac_channel(uint8_t trigger)
+{
+    uint8_t i;
+
+    for (i = 0; i < DMAC_CH_NUM; i++)
+    {
+        if ((g_dmac.channels[i].chctrla & DMAC_CHCTRLA_ENABLE) &&
+            ((g_dmac.channels[i].chctrlb & DMAC_CHCTRLB_TRIGSRC_Msk) >> DMAC_CHCTRLB_TRIGSRC_Pos) == trigger)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+//Function to check the channel a length counter transfer relies on, when its address is written
+static bool sim_dmac_check(bool reading, uint8_t length)
+{
+    int channel = sim_dmac_channel(reading ? SIM_DMAC_ID_RX : SIM_DMAC_ID_TX);
+    uint32_t data_address = (uint32_t)(uintptr_t)&SERCOM2->I2CM.DATA.reg;
+    DmacDescriptor *descriptor;
+    uint16_t btctrl;
+    uint16_t expected;
+
+    if (!(g_dmac.ctrl & DMAC_CTRL_DMAENABLE) || channel < 0)
+    {
+        sim_error("ADDR.LENEN set without an enabled DMAC channel on the %s trigger", reading ? "RX" : "TX");
+        return false;
+    }
+
+    descriptor = sim_dmac_descriptor(channel);
+    btctrl = descriptor->BTCTRL.reg;
+    expected = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | (reading ? DMAC_BTCTRL_DSTINC : DMAC_BTCTRL_SRCINC);
+    if ((btctrl & (DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_Msk | DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_DSTINC)) != expected)
+    {
+        sim_error("descriptor BTCTRL 0x%04X for a %s", btctrl, reading ? "read" : "write");
+        return false;
+    }
+    if ((reading ? descriptor->SRCADDR.reg : descriptor->DSTADDR.reg) != data_address)
+    {
+        sim_error("descriptor does not point at the DATA register");
+        return false;
+    }
+    if (length == 0 || descriptor->BTCNT.reg != length)
+    {
+        sim_error("ADDR.LEN %u but the descriptor moves %u bytes", length, descriptor->BTCNT.reg);
+        return false;
+    }
+    return true;
+}
+
+//Function to move one byte between DATA and memory on a trigger, returns false when no channel takes it
+static bool sim_dmac_beat(bool reading, uint8_t *data)
+{
+    int channel = sim_dmac_channel(reading ? SIM_DMAC_ID_RX : SIM_DMAC_ID_TX);
+    sim_channel *state;
+    DmacDescriptor *descriptor;
+    uint8_t *memory;
+
+    if (!(g_dmac.ctrl & DMAC_CTRL_DMAENABLE) || channel < 0)
+    {
+        return false;
+    }
+
+    state = &g_dmac.channels[channel];
+    descriptor = sim_dmac_descriptor(channel);
+    //The incrementing address of a descriptor is the end of the block
+    memory = (uint8_t*)(uintptr_t)((reading ? descriptor->DSTADDR.reg : descriptor->SRCADDR.reg) -
+                                   descriptor->BTCNT.reg + state->done);
+    if (reading)
+    {
+        *memory = *data;
+    }
+    else
+    {
+        *data = *memory;
+    }
+
+    g_stats.dma_beats++;
+    if (++state->done == descriptor->BTCNT.reg)
+    {
+        state->intflag |= DMAC_CHINTFLAG_TCMPL;
+        state->chctrla &= ~DMAC_CHCTRLA_ENABLE;
+    }
+    return true;
+}
+
+static void sim_dmac_before(void *context, uint32_t offset, bool write)
+{
+    Dmac *regs = DMAC;
+    sim_channel *channel = &g_dmac.channels[g_dmac.chid];
+
+    (void)context;
+    (void)offset;
+    (void)write;
+    regs->CTRL.reg = g_dmac.ctrl;
+    regs->BASEADDR.reg = g_dmac.baseaddr;
+    regs->WRBADDR.reg = g_dmac.wrbaddr;
+    regs->CHID.reg = g_dmac.chid;
+    regs->CHCTRLA.reg = channel->chctrla;
+    regs->CHCTRLB.reg = channel->chctrlb;
+    regs->CHINTENCLR.reg = channel->inten;
+    regs->CHINTENSET.reg = channel->inten;
+    regs->CHINTFLAG.reg = channel->intflag;
+}
+
+static void sim_dmac_written(void *context, uint32_t offset)
+{
+    Dmac *regs = DMAC;
+    sim_channel *channel = &g_dmac.channels[g_dmac.chid];
+
+    (void)context;
+    switch (offset)
+    {
+    case offsetof(Dmac, CTRL):
+        if (regs->CTRL.reg & DMAC_CTRL_SWRST)
+        {
+            if (g_dmac.ctrl & DMAC_CTRL_DMAENABLE)
+            {
+                sim_error("DMAC reset while enabled");
+            }
+            memset(&g_dmac, 0, sizeof(g_dmac));
+        }
+        else
+        {
+            g_dmac.ctrl = regs->CTRL.reg;
+        }
+        break;
+    case offsetof(Dmac, BASEADDR):
+        g_dmac.baseaddr = regs->BASEADDR.reg;
+        break;
+    case offsetof(Dmac, WRBADDR):
+        g_dmac.wrbaddr = regs->WRBADDR.reg;
+        break;
+    case offsetof(Dmac, CHID):
+        g_dmac.chid = regs->CHID.reg & DMAC_CHID_ID_Msk;
+        if (g_dmac.chid >= DMAC_CH_NUM)
+        {
+            sim_error("CHID %u", g_dmac.chid);
+            g_dmac.chid = 0;
+        }
+        break;
+    case offsetof(Dmac, CHCTRLA):
+        if (regs->CHCTRLA.reg & DMAC_CHCTRLA_SWRST)
+        {
+            memset(channel, 0, sizeof(*channel));
+        }
+        else
+        {
+            if (!(channel->chctrla & DMAC_CHCTRLA_ENABLE))
+            {
+                channel->done = 0;
+            }
+            channel->chctrla = regs->CHCTRLA.reg;
+        }
+        break;
+    case offsetof(Dmac, CHCTRLB):
+        if (channel->chctrla & DMAC_CHCTRLA_ENABLE)
+        {
+            sim_error("CHCTRLB written while channel %u is enabled", g_dmac.chid);
+        }
+        channel->chctrlb = regs->CHCTRLB.reg;
+        break;
+    case offsetof(Dmac, CHINTENCLR):
+        channel->inten &= ~regs->CHINTENCLR.reg;
+        break;
+    case offsetof(Dmac, CHINTENSET):
+        channel->inten |= regs->CHINTENSET.reg;
+        break;
+    case offsetof(Dmac, CHINTFLAG):
+        channel->intflag &= ~regs->CHINTFLAG.reg;
+        break;
+    default:
+        break;
+    }
+}
+
+/* SERCOM2 in I2C master mode */
+
+static void sim_master_reset(void)
+{
+    memset(&g_master, 0, sizeof(g_master));
+}
+
+static void sim_nack(bool length_mode)
+{
+    g_master.status |= SERCOM_I2CM_STATUS_RXNACK;
+    g_master.intflag |= SERCOM_I2CM_INTFLAG_MB;
+    if (length_mode)
+    {
+        //The transfer ended before the length counter did, the bus is held for a STOP command
+        g_master.status |= SERCOM_I2CM_STATUS_LENERR;
+        g_master.intflag |= SERCOM_I2CM_INTFLAG_ERROR;
+    }
+}
+
+static void sim_stop(void)
+{
+    sim_bus_bits(1);
+    if (g_master.target != NULL && !g_master.reading)
+    {
+        sim_device_stop(g_master.target);
+    }
+    g_master.busstate = SIM_BUS_IDLE;
+    g_master.target = NULL;
+    g_master.reading = false;
+}
+
+static void sim_length_transfer(uint8_t length)
+{
+    uint8_t data = 0;
+    uint16_t i;
+
+    if (!sim_dmac_check(g_master.reading, length))
+    {
+        return;
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        if (g_master.reading)
+        {
+            data = sim_device_read(g_master.target);
+            sim_bus_bits(9);
+            g_stats.bytes++;
+            if (!sim_dmac_beat(true, &data))
+            {
+                sim_error("byte %u of %u read without a DMAC channel to take it", i + 1, length);
+                return;
+            }
+        }
+        else
+        {
+            if (!sim_dmac_beat(false, &data))
+            {
+                sim_error("byte %u of %u to write not given by the DMAC", i + 1, length);
+                return;
+            }
+            sim_bus_bits(9);
+            g_stats.bytes++;
+            if (!sim_device_write(g_master.target, data))
+            {
+                if (i + 1 < length)
+                {
+                    sim_nack(true);
+                }
+                else
+                {
+                    g_master.status |= SERCOM_I2CM_STATUS_RXNACK;
+                    g_master.intflag |= SERCOM_I2CM_INTFLAG_MB;
+                }
+                return;
+            }
+        }
+    }
+
+    //NACK of the last byte read and STOP are sent by the length counter
+    if (!g_master.reading)
+    {
+        g_master.intflag |= SERCOM_I2CM_INTFLAG_MB;
+    }
+    g_stats.length_transfers++;
+    sim_stop();
+}
+
+//Function to run what writing ADDR starts: START, the address byte and, with LENEN, the whole transfer
+static void sim_start(void)
+{
+    uint8_t address = g_master.addr & 0xFF;
+    bool length_mode = (g_master.addr & SERCOM_I2CM_ADDR_LENEN) != 0;
+    uint8_t i;
+
+    if (!(g_master.ctrla & SERCOM_I2CM_CTRLA_ENABLE))
+    {
+        sim_error("ADDR written with the SERCOM disabled");
+        return;
+    }
+    if (g_master.busstate != SIM_BUS_IDLE && g_master.busstate != SIM_BUS_OWNER)
+    {
+        sim_error("START with the bus state unknown");
+    }
+
+    sim_update();
+    g_stats.transfers++;
+    g_master.intflag &= ~(SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB | SERCOM_I2CM_INTFLAG_ERROR);
+    g_master.status &= ~(SERCOM_I2CM_STATUS_RXNACK | SIM_STATUS_ERRORS);
+    g_master.busstate = SIM_BUS_OWNER;
+    g_master.reading = (address & I2C_TRANSFER_READ) != 0;
+    g_master.target = NULL;
+
+    //SDA stays low through START and the eight zero bits of a write to address 0
+    g_start_nsec = g_now_nsec;
+    sim_bus_bits(1);
+    if (address == 0x00)
+    {
+        sim_wake_pulse(sim_bus_bits(8));
+        sim_bus_bits(1);
+        g_stats.bytes++;
+        sim_nack(length_mode);
+        return;
+    }
+    sim_bus_bits(9);
+    g_stats.bytes++;
+
+    for (i = 0; i < g_device_count; i++)
+    {
+        if (g_devices[i].config.address == (address & 0xFE))
+        {
+            g_master.target = &g_devices[i];
+        }
+    }
+    if (g_master.target == NULL || !sim_device_acks(g_master.target, g_master.reading))
+    {
+        g_master.target = NULL;
+        g_stats.address_nacks++;
+        sim_nack(length_mode);
+        return;
+    }
+
+    if (length_mode)
+    {
+        sim_length_transfer((g_master.addr & SERCOM_I2CM_ADDR_LEN_Msk) >> SERCOM_I2CM_ADDR_LEN_Pos);
+    }
+    else if (g_master.reading)
+    {
+        //Smart mode receives the first byte right after the address
+        g_master.data = sim_device_read(g_master.target);
+        sim_bus_bits(9);
+        g_stats.bytes++;
+        g_master.intflag |= SERCOM_I2CM_INTFLAG_SB;
+    }
+    else
+    {
+        g_master.intflag |= SERCOM_I2CM_INTFLAG_MB;
+    }
+}
+
+static void sim_command(uint8_t command)
+{
+    if (g_master.busstate != SIM_BUS_OWNER)
+    {
+        return;
+    }
+
+    g_master.intflag &= ~(SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB);
+    switch (command)
+    {
+    case 2:
+        if (g_master.reading && g_master.target != NULL && !(g_master.ctrlb & SERCOM_I2CM_CTRLB_ACKACT))
+        {
+            g_master.data = sim_device_read(g_master.target);
+            sim_bus_bits(9);
+            g_stats.bytes++;
+            g_master.intflag |= SERCOM_I2CM_INTFLAG_SB;
+        }
+        break;
+    case 3:
+        sim_stop();
+        break;
+    default:
+        sim_error("CTRLB.CMD %u is not modelled", command);
+        break;
+    }
+}
+
+//Function to run a read of DATA by the CPU, in smart mode it acknowledges and receives the next byte
+static void sim_data_read(void)
+{
+    g_stats.polled_bytes++;
+    if (g_master.busstate != SIM_BUS_OWNER || !g_master.reading || g_master.target == NULL)
+    {
+        return;
+    }
+
+    g_master.intflag &= ~SERCOM_I2CM_INTFLAG_SB;
+    if ((g_master.ctrlb & SERCOM_I2CM_CTRLB_SMEN) && !(g_master.ctrlb & SERCOM_I2CM_CTRLB_ACKACT))
+    {
+        g_master.data = sim_device_read(g_master.target);
+        sim_bus_bits(9);
+        g_stats.bytes++;
+        g_master.intflag |= SERCOM_I2CM_INTFLAG_SB;
+    }
+}
+
+static void sim_data_write(void)
+{
+    g_stats.polled_bytes++;
+    if (g_master.busstate != SIM_BUS_OWNER || g_master.reading || g_master.target == NULL)
+    {
+        sim_error("DATA written without an acknowledged write transfer");
+        return;
+    }
+
+    g_master.intflag &= ~SERCOM_I2CM_INTFLAG_MB;
+    sim_bus_bits(9);
+    g_stats.bytes++;
+    if (sim_device_write(g_master.target, g_master.data))
+    {
+        g_master.status &= ~SERCOM_I2CM_STATUS_RXNACK;
+    }
+    else
+    {
+        g_master.status |= SERCOM_I2CM_STATUS_RXNACK;
+    }
+    g_master.intflag |= SERCOM_I2CM_INTFLAG_MB;
+}
+
+static void sim_sercom_before(void *context, uint32_t offset, bool write)
+{
+    SercomI2cm *regs = &SERCOM2->I2CM;
+
+    (void)context;
+    regs->CTRLA.reg = g_master.ctrla;
+    regs->CTRLB.reg = g_master.ctrlb;
+    regs->BAUD.reg = g_master.baud;
+    regs->INTENCLR.reg = g_master.inten;
+    regs->INTENSET.reg = g_master.inten;
+    regs->INTFLAG.reg = g_master.intflag;
+    regs->STATUS.reg = g_master.status | SERCOM_I2CM_STATUS_BUSSTATE(g_master.busstate);
+    regs->ADDR.reg = g_master.addr;
+    regs->DATA.reg = g_master.data;
+
+    if (offset == offsetof(SercomI2cm, DATA) && !write)
+    {
+        sim_data_read();
+    }
+}
+
+static void sim_sercom_written(void *context, uint32_t offset)
+{
+    SercomI2cm *regs = &SERCOM2->I2CM;
+    uint32_t value;
+
+    (void)context;
+    switch (offset)
+    {
+    case offsetof(SercomI2cm, CTRLA):
+        value = regs->CTRLA.reg;
+        if (value & SERCOM_I2CM_CTRLA_SWRST)
+        {
+            sim_master_reset();
+            break;
+        }
+        //The bus monitor finds the bus idle right after the enable
+        if ((value & SERCOM_I2CM_CTRLA_ENABLE) && !(g_master.ctrla & SERCOM_I2CM_CTRLA_ENABLE))
+        {
+            g_master.busstate = SIM_BUS_IDLE;
+        }
+        else if (!(value & SERCOM_I2CM_CTRLA_ENABLE))
+        {
+            g_master.busstate = SIM_BUS_UNKNOWN;
+            g_master.target = NULL;
+        }
+        g_master.ctrla = value;
+        break;
+    case offsetof(SercomI2cm, CTRLB):
+        value = regs->CTRLB.reg;
+        g_master.ctrlb = value & ~SERCOM_I2CM_CTRLB_CMD_Msk;
+        if (value & SERCOM_I2CM_CTRLB_CMD_Msk)
+        {
+            sim_command((value & SERCOM_I2CM_CTRLB_CMD_Msk) >> SERCOM_I2CM_CTRLB_CMD_Pos);
+        }
+        break;
+    case offsetof(SercomI2cm, BAUD):
+        g_master.baud = regs->BAUD.reg;
+        break;
+    case offsetof(SercomI2cm, INTENCLR):
+        g_master.inten &= ~regs->INTENCLR.reg;
+        break;
+    case offsetof(SercomI2cm, INTENSET):
+        g_master.inten |= regs->INTENSET.reg;
+        break;
+    case offsetof(SercomI2cm, INTFLAG):
+        g_master.intflag &= ~regs->INTFLAG.reg;
+        break;
+    case offsetof(SercomI2cm, STATUS):
+        value = regs->STATUS.reg;
+        g_master.status &= ~(value & SIM_STATUS_ERRORS);
+        if (value & SERCOM_I2CM_STATUS_BUSSTATE_Msk)
+        {
+            g_master.busstate = (value & SERCOM_I2CM_STATUS_BUSSTATE_Msk) >> SERCOM_I2CM_STATUS_BUSSTATE_Pos;
+        }
+        break;
+    case offsetof(SercomI2cm, ADDR):
+        g_master.addr = regs->ADDR.reg;
+        sim_start();
+        break;
+    case offsetof(SercomI2cm, DATA):
+        g_master.data = regs->DATA.reg;
+        sim_data_write();
+        break;
+    default:
+        break;
+    }
+}
+
+/* NVIC and interrupts */
+
+static void sim_nvic_before(void *context, uint32_t offset, bool write)
+{
+    NVIC_Type *regs = NVIC;
+
+    (void)context;
+    (void)offset;
+    (void)write;
+    regs->ISER[0] = g_nvic_enabled;
+    regs->ICER[0] = g_nvic_enabled;
+    memcpy((void*)regs->IP, g_nvic_priority, sizeof(g_nvic_priority));
+}
+
+static void sim_nvic_written(void *context, uint32_t offset)
+{
+    NVIC_Type *regs = NVIC;
+
+    (void)context;
+    if (offset == offsetof(NVIC_Type, ISER))
+    {
+        g_nvic_enabled |= regs->ISER[0];
+    }
+    else if (offset == offsetof(NVIC_Type, ICER))
+    {
+        g_nvic_enabled &= ~regs->ICER[0];
+    }
+    else if (offset >= offsetof(NVIC_Type, IP))
+    {
+        memcpy(g_nvic_priority, (const void*)regs->IP, sizeof(g_nvic_priority));
+    }
+}
+
+static void sim_dmac_handler(void)
+{
+    g_stats.interrupts++;
+    DMAC_Handler();
+}
+
+static void sim_sercom2_handler(void)
+{
+    g_stats.interrupts++;
+    SERCOM2_Handler();
+}
+
+//Returns the handler of the pending interrupt with the lowest number, like the NVIC at equal priorities
+static reg_trap_handler_t sim_interrupt(void)
+{
+    reg_trap_handler_t handler = NULL;
+    uint8_t i;
+
+    if (g_critical != 0)
+    {
+        return NULL;
+    }
+
+    if (g_nvic_enabled & (1UL << DMAC_IRQn))
+    {
+        for (i = 0; i < DMAC_CH_NUM; i++)
+        {
+            if (g_dmac.channels[i].intflag & g_dmac.channels[i].inten)
+            {
+                handler = sim_dmac_handler;
+            }
+        }
+    }
+    if (handler == NULL && (g_nvic_enabled & (1UL << SERCOM2_IRQn)) && (g_master.intflag & g_master.inten))
+    {
+        handler = sim_sercom2_handler;
+    }
+
+    if (handler == NULL)
+    {
+        g_chain = 0;
+    }
+    else if (++g_chain > SIM_MAX_CHAIN)
+    {
+        fprintf(stderr, "i2c_sim: interrupt taken %u times in a row, its handler does not clear it\n", SIM_MAX_CHAIN);
+        exit(1);
+    }
+    return handler;
+}
+
+void cpu_irq_enter_critical(void)
+{
+    g_critical++;
+}
+
+void cpu_irq_leave_critical(void)
+{
+    if (g_critical > 0 && --g_critical == 0)
+    {
+        reg_trap_take_interrupt();
+    }
+}
+
+/* ASF functions of the clock and pin drivers, which are not linked */
+
+void system_gclk_chan_set_config(const uint8_t channel, struct system_gclk_chan_config *const config)
+{
+    (void)channel;
+    (void)config;
+}
+
+void system_gclk_chan_enable(const uint8_t channel)
+{
+    (void)channel;
+}
+
+void system_gclk_chan_disable(const uint8_t channel)
+{
+    (void)channel;
+}
+
+uint32_t system_gclk_chan_get_hz(const uint8_t channel)
+{
+    (void)channel;
+    return SIM_GCLK_HZ;
+}
+
+void system_pinmux_pin_set_config(const uint8_t gpio_pin, const struct system_pinmux_config *const config)
+{
+    (void)gpio_pin;
+    (void)config;
+}
+
+/* cryptoauthlib delays */
+
+void atca_delay_us(uint32_t delay)
+{
+    i2c_sim_delay_us(delay);
+}
+
+void atca_delay_10us(uint32_t delay)
+{
+    i2c_sim_delay_us(delay * 10);
+}
+
+void atca_delay_ms(uint32_t delay)
+{
+    i2c_sim_delay_us(delay * 1000);
+}
+
+/* SysTick clock of boot_sequence.c */
+
+//A read of SysTick takes a few CPU cycles, so a CPU waiting on the clock moves time along
+uint32_t boot_time_usec(void)
+{
+    g_now_nsec += 100;
+    return (uint32_t)(g_now_nsec / 1000);
+}
+
+/* Tool interface */
+
+//Function to map the registers on the first call, and to start over with an empty bus, time and statistics.
+//The registers keep what the firmware wrote, as its drivers keep their state between the runs of a tool.
+void i2c_sim_init(void)
+{
+    if (!g_mapped)
+    {
+        if ((uintptr_t)&g_master > UINT32_MAX)
+        {
+            fprintf(stderr, "i2c_sim: static data above 4 GB, link with -no-pie\n");
+            exit(1);
+        }
+        reg_trap_map((uintptr_t)SERCOM2, sizeof(SercomI2cm), sim_sercom_before, sim_sercom_written, NULL);
+        reg_trap_map((uintptr_t)DMAC, sizeof(Dmac), sim_dmac_before, sim_dmac_written, NULL);
+        reg_trap_map((uintptr_t)NVIC, sizeof(NVIC_Type), sim_nvic_before, sim_nvic_written, NULL);
+        reg_trap_map((uintptr_t)PM, sizeof(Pm), NULL, NULL, NULL);
+        reg_trap_map((uintptr_t)DSU, sizeof(Dsu), NULL, NULL, NULL);
+        reg_trap_set_interrupt(sim_interrupt);
+        g_mapped = true;
+    }
+
+    i2c_sim_remove_devices();
+    g_now_nsec = 0;
+    i2c_sim_reset_stats();
+}
+
+uint8_t i2c_sim_add_device(const i2c_sim_device_config *config)
+{
+    sim_device *device;
+
+    if (g_device_count == I2C_SIM_MAX_DEVICES)
+    {
+        fprintf(stderr, "i2c_sim: more than %u devices\n", I2C_SIM_MAX_DEVICES);
+        exit(1);
+    }
+
+    device = &g_devices[g_device_count];
+    memset(device, 0, sizeof(*device));
+    device->config = *config;
+    device->state.state = (config->kind == I2C_SIM_RAW) ? I2C_SIM_AWAKE : I2C_SIM_SLEEP;
+    device->random = 0x9E3779B9UL ^ ((uint32_t)config->address << 8) ^ g_device_count;
+
+    //Serial number at bytes 0 to 3 and 8 to 12, revision at 4 to 7, I2C address at 16
+    memcpy(&device->config_zone[0], config->serial_number, 4);
+    device->config_zone[6] = (config->devtype == ATSHA204A) ? 0x09 : (config->devtype == ATECC608A) ? 0x60 : 0x50;
+    memcpy(&device->config_zone[8], &config->serial_number[4], 5);
+    device->config_zone[14] = 0x01;
+    device->config_zone[16] = config->address;
+
+    return g_device_count++;
+}
+
+void i2c_sim_remove_devices(void)
+{
+    g_device_count = 0;
+    g_master.target = NULL;
+}
+
+i2c_sim_device* i2c_sim_get_device(uint8_t index)
+{
+    sim_update();
+    return (index < g_device_count) ? &g_devices[index].state : NULL;
+}
+
+//Function to fill in a CryptoAuth device with the wake and watchdog times of its datasheet
+void i2c_sim_default_config(i2c_sim_device_config *config, uint8_t address, uint8_t devtype)
+{
+    const uint8_t serial_number[ATCA_SERIAL_NUM_SIZE] = { 0x01, 0x23, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xEE };
+
+    memset(config, 0, sizeof(*config));
+    config->kind = I2C_SIM_CRYPTOAUTH;
+    config->address = address;
+    config->devtype = devtype;
+    config->twhi_usec = (devtype == ATSHA204A) ? 2500 : 1500;
+    config->watchdog_usec = 700000;     //Shortest tWATCHDOG
+    memcpy(config->serial_number, serial_number, sizeof(serial_number));
+    config->serial_number[2] = address;
+    config->serial_number[3] = devtype;
+}
+
+uint64_t i2c_sim_now(void)
+{
+    return g_now_nsec / 1000;
+}
+
+void i2c_sim_delay_us(uint32_t usec)
+{
+    g_now_nsec += 1000ULL * usec;
+}
+
+const i2c_sim_stats* i2c_sim_get_stats(void)
+{
+    return &g_stats;
+}
+
+void i2c_sim_reset_stats(void)
+{
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_bus_nsec = 0;
+}
+
+bool i2c_sim_bus_idle(void)
+{
+    return g_master.busstate != SIM_BUS_OWNER;
+}
+
+static void sim_call_entry(void)
+{
+    g_call_function(g_call_argument);
+}
+
+//Function to run function on a painted stack below 4 GB, returns the bytes of it that were used
+size_t i2c_sim_call(void (*function)(void *argument), void *argument)
+{
+    size_t untouched;
+
+    if (g_call_stack == NULL)
+    {
+        g_call_stack = mmap(NULL, SIM_STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT,
+                            -1, 0);
+        if (g_call_stack == MAP_FAILED)
+        {
+            fprintf(stderr, "i2c_sim: cannot map a stack below 4 GB\n");
+            exit(1);
+        }
+    }
+
+    memset(g_call_stack, SIM_STACK_PAINT, SIM_STACK_SIZE);
+    g_call_function = function;
+    g_call_argument = argument;
+    getcontext(&g_call_context);
+    g_call_context.uc_stack.ss_sp = g_call_stack;
+    g_call_context.uc_stack.ss_size = SIM_STACK_SIZE;
+    g_call_context.uc_link = &g_caller_context;
+    makecontext(&g_call_context, sim_call_entry, 0);
+    swapcontext(&g_caller_context, &g_call_context);
+
+    for (untouched = 0; untouched < SIM_STACK_SIZE && g_call_stack[untouched] == SIM_STACK_PAINT; untouched++)
+    {
+    }
+    return SIM_STACK_SIZE - untouched;
+}
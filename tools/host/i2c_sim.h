@@ -0,0 +1,137 @@
+/**
+ * \file
+ * \brief  Register level model of the CryptoAuth I2C bus for the host tools
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Models, behind host/reg_trap.c, the registers the I2C HAL of the firmware
+ * uses: SERCOM2 in I2C master mode with the length counter, the DMAC, the
+ * NVIC and the few PM and DSU registers of the ASF drivers. On the bus sit
+ * CryptoAuth devices with wake, sleep and idle, the execution time of their
+ * commands and the watchdog, and raw devices that keep what is written to
+ * them and return a programmed buffer.
+ *
+ * Time is simulated: it advances with the bus transfers at the SCL rate set
+ * in BAUD, with atca_delay_us() and by 100 ns for every read of the
+ * boot_time_usec() clock, so a run is repeatable. The DMAC moves
+ * the bytes of a transfer as soon as its address is written, and the
+ * interrupts are taken after the register access that raised them.
+ *
+ * The DMAC takes 32-bit addresses, so the tools are linked with -no-pie and
+ * run the firmware code with i2c_sim_call(), on a stack below 4 GB.
+ */
+
+#ifndef I2C_SIM_H_
+#define I2C_SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define I2C_SIM_MAX_DEVICES     8
+#define I2C_SIM_RAW_SIZE        512
+
+//SERCOM and bus index of the modelled I2C master, the bus of the Xplained Pro extension headers
+#define I2C_SIM_BUS             2
+
+typedef enum
+{
+    I2C_SIM_CRYPTOAUTH,
+    I2C_SIM_RAW,
+} i2c_sim_kind;
+
+typedef enum
+{
+    I2C_SIM_SLEEP,
+    I2C_SIM_IDLE,
+    I2C_SIM_WAKING,
+    I2C_SIM_AWAKE,
+} i2c_sim_state;
+
+//Returns the execution time of a command in microseconds
+typedef uint32_t (*i2c_sim_exec_time_t)(void *context, uint8_t device, uint8_t opcode);
+
+typedef struct
+{
+    i2c_sim_kind kind;
+    uint8_t address;                //8-bit address, like atcai2c.slave_address
+    uint8_t devtype;                //ATCADeviceType of a CryptoAuth device
+    uint32_t twhi_usec;             //From the end of the wake pulse to the wake response
+    uint32_t watchdog_usec;         //Awake time after which the device goes to sleep by itself
+    uint8_t serial_number[9];
+    i2c_sim_exec_time_t exec_time;  //NULL for the typical times of the ATECC508A datasheet
+    void *exec_context;
+    uint16_t nack_after;            //Raw device: data bytes acknowledged in a write, 0 for all
+} i2c_sim_device_config;
+
+typedef struct
+{
+    i2c_sim_state state;
+    uint32_t wakes;                 //Wakes from sleep or idle
+    uint32_t sleeps;                //Sleep word addresses received
+    uint32_t idles;                 //Idle word addresses received
+    uint32_t watchdog_sleeps;       //Times the watchdog put the device to sleep
+    uint32_t commands;              //Commands executed
+    uint32_t busy_nacks;            //Addresses refused while a command executed
+    uint32_t asleep_nacks;          //Addresses refused while asleep or waking
+    uint32_t bad_packets;           //Commands with a wrong count or CRC
+    uint32_t response_wait_usec;    //Last command to the START of the read of its response
+    bool tempkey_valid;             //Nonce ran and the device did not sleep since
+    uint8_t raw[I2C_SIM_RAW_SIZE];  //Raw device: bytes of the last write
+    uint16_t raw_length;
+    uint8_t raw_read[I2C_SIM_RAW_SIZE];
+} i2c_sim_device;
+
+typedef struct
+{
+    uint64_t transfers;             //START conditions
+    uint64_t bytes;                 //Bytes on the bus, address bytes included
+    uint64_t bus_usec;              //Time the bus was driven
+    uint32_t address_nacks;         //Addresses no device acknowledged
+    uint32_t wake_pulses;           //SDA held low long enough to wake the devices
+    uint32_t short_pulses;          //Writes to address 0 too fast to be a wake pulse
+    uint32_t length_transfers;      //Transfers ended by the SERCOM length counter
+    uint32_t dma_beats;             //Bytes moved by the DMAC
+    uint32_t polled_bytes;          //Data bytes moved by the CPU through DATA
+    uint32_t interrupts;            //Handlers entered
+    uint32_t errors;                //Misuse of the registers, reported when found
+} i2c_sim_stats;
+
+void i2c_sim_init(void);
+uint8_t i2c_sim_add_device(const i2c_sim_device_config *config);
+void i2c_sim_remove_devices(void);
+i2c_sim_device* i2c_sim_get_device(uint8_t index);
+void i2c_sim_default_config(i2c_sim_device_config *config, uint8_t address, uint8_t devtype);
+
+uint64_t i2c_sim_now(void);
+void i2c_sim_delay_us(uint32_t usec);
+const i2c_sim_stats* i2c_sim_get_stats(void);
+void i2c_sim_reset_stats(void);
+uint32_t i2c_sim_scl_hz(void);
+bool i2c_sim_bus_idle(void);
+
+size_t i2c_sim_call(void (*function)(void *argument), void *argument);
+
+#endif /* I2C_SIM_H_ */
@@ -0,0 +1,298 @@
+/**
+ * \file
+ * \brief  Traps the accesses of firmware code to simulated peripheral registers
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "reg_trap.h"
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "reg_trap.c single steps x86-64 instructions with Linux signals"
+#endif
+
+//Trap flag of RFLAGS, the CPU raises SIGTRAP after the next instruction
+#define RT_TRAP_FLAG        0x100
+
+//Page fault error code bit set for writes
+#define RT_ERROR_WRITE      0x2
+
+#define RT_SIGNAL_STACK_SIZE        (64 * 1024)
+#define RT_INTERRUPT_STACK_SIZE     (64 * 1024)
+
+typedef struct
+{
+    uint8_t *registers;
+    size_t size;
+    uint8_t *pages;                     //Pages holding the registers, shared with other regions
+    size_t pages_size;
+    reg_trap_before_t before;
+    reg_trap_written_t written;
+    void *context;
+} rt_region;
+
+static rt_region g_regions[REG_TRAP_MAX_REGIONS];
+static uint8_t g_region_count;
+static rt_region *g_pending;            //Region of the instruction being single stepped
+static uint32_t g_pending_offset;
+static bool g_pending_write;
+static uint64_t g_accesses;
+static reg_trap_interrupt_t g_interrupt;
+static volatile bool g_in_interrupt;
+static uint8_t g_signal_stack[RT_SIGNAL_STACK_SIZE];
+static uint8_t g_interrupt_stack[RT_INTERRUPT_STACK_SIZE] __attribute__((aligned(16)));
+
+//Where the interrupted code continues, read by rt_interrupt_entry
+uint64_t g_rt_return_rip;
+uint64_t g_rt_return_rsp;
+static reg_trap_handler_t g_handler;
+
+void rt_interrupt(void);
+void rt_interrupt_entry(void);
+
+/*
+ * Runs on the interrupt stack. The caller saved registers, the flags and the
+ * SSE state are kept for the interrupted code, the handler keeps the others.
+ * Ten pushes keep the stack aligned for the call.
+ */
+__asm__(
+    "    .text\n"
+    "    .globl rt_interrupt_entry\n"
+    "    .type rt_interrupt_entry, @function\n"
+    "rt_interrupt_entry:\n"
+    "    pushfq\n"
+    "    push %rax\n"
+    "    push %rcx\n"
+    "    push %rdx\n"
+    "    push %rsi\n"
+    "    push %rdi\n"
+    "    push %r8\n"
+    "    push %r9\n"
+    "    push %r10\n"
+    "    push %r11\n"
+    "    sub $512, %rsp\n"
+    "    fxsave (%rsp)\n"
+    "    call rt_interrupt\n"
+    "    fxrstor (%rsp)\n"
+    "    add $512, %rsp\n"
+    "    pop %r11\n"
+    "    pop %r10\n"
+    "    pop %r9\n"
+    "    pop %r8\n"
+    "    pop %rdi\n"
+    "    pop %rsi\n"
+    "    pop %rdx\n"
+    "    pop %rcx\n"
+    "    pop %rax\n"
+    "    popfq\n"
+    "    mov g_rt_return_rsp(%rip), %rsp\n"
+    "    jmp *g_rt_return_rip(%rip)\n"
+    "    .size rt_interrupt_entry, .-rt_interrupt_entry\n"
+);
+
+//Pending interrupts are taken one after the other before the interrupted code continues, like tail chaining
+void rt_interrupt(void)
+{
+    g_in_interrupt = true;
+    do
+    {
+        g_handler();
+    }
+    while ((g_handler = g_interrupt()) != NULL);
+    g_in_interrupt = false;
+}
+
+static void rt_default(int signal_number)
+{
+    //Not a register access, crash the way the tool would have without the trap
+    signal(signal_number, SIG_DFL);
+}
+
+static void rt_segv(int signal_number, siginfo_t *info, void *ucontext)
+{
+    ucontext_t *context = ucontext;
+    uint8_t *address = info->si_addr;
+    rt_region *region = NULL;
+    uint8_t i;
+
+    for (i = 0; i < g_region_count; i++)
+    {
+        if ((address >= g_regions[i].registers) && (address < g_regions[i].registers + g_regions[i].size))
+        {
+            region = &g_regions[i];
+        }
+    }
+    if ((region == NULL) || (g_pending != NULL))
+    {
+        rt_default(signal_number);
+        return;
+    }
+
+    mprotect(region->pages, region->pages_size, PROT_READ | PROT_WRITE);
+    g_pending = region;
+    g_pending_offset = (uint32_t)(address - region->registers);
+    g_pending_write = (context->uc_mcontext.gregs[REG_ERR] & RT_ERROR_WRITE) != 0;
+    g_accesses++;
+    if (region->before)
+    {
+        region->before(region->context, g_pending_offset, g_pending_write);
+    }
+    context->uc_mcontext.gregs[REG_EFL] |= RT_TRAP_FLAG;
+}
+
+static void rt_trap(int signal_number, siginfo_t *info, void *ucontext)
+{
+    ucontext_t *context = ucontext;
+    rt_region *region = g_pending;
+
+    (void)info;
+    if (region == NULL)
+    {
+        rt_default(signal_number);
+        return;
+    }
+
+    if (g_pending_write && region->written)
+    {
+        region->written(region->context, g_pending_offset);
+    }
+    mprotect(region->pages, region->pages_size, PROT_NONE);
+    g_pending = NULL;
+    context->uc_mcontext.gregs[REG_EFL] &= ~RT_TRAP_FLAG;
+
+    if ((g_interrupt != NULL) && !g_in_interrupt && ((g_handler = g_interrupt()) != NULL))
+    {
+        g_rt_return_rip = (uint64_t)context->uc_mcontext.gregs[REG_RIP];
+        g_rt_return_rsp = (uint64_t)context->uc_mcontext.gregs[REG_RSP];
+        context->uc_mcontext.gregs[REG_RSP] = (greg_t)(g_interrupt_stack + RT_INTERRUPT_STACK_SIZE);
+        context->uc_mcontext.gregs[REG_RIP] = (greg_t)rt_interrupt_entry;
+    }
+}
+
+//Function to map a region of registers at address, or anywhere for 0, returns the first register.
+//Regions at fixed addresses may share pages, like the SERCOM instances do
+void* reg_trap_map(uintptr_t address, size_t size, reg_trap_before_t before, reg_trap_written_t written,
+                   void *context)
+{
+    struct sigaction action;
+    stack_t signal_stack;
+    rt_region *region;
+    uintptr_t page = address & ~(uintptr_t)0xFFF;
+    size_t pages_size = ((address - page) + size + 0xFFF) & ~(size_t)0xFFF;
+    uintptr_t offset;
+    void *base;
+
+    if (g_region_count == REG_TRAP_MAX_REGIONS)
+    {
+        fprintf(stderr, "reg_trap: more than %u regions\n", REG_TRAP_MAX_REGIONS);
+        exit(1);
+    }
+
+    if (address == 0)
+    {
+        base = mmap(NULL, pages_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED)
+        {
+            fprintf(stderr, "reg_trap: cannot map %zu bytes of registers\n", size);
+            exit(1);
+        }
+        page = address = (uintptr_t)base;
+    }
+    else
+    {
+        for (offset = 0; offset < pages_size; offset += 0x1000)
+        {
+            base = mmap((void *)(page + offset), 0x1000, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                        -1, 0);
+            if ((base == MAP_FAILED) && (errno == EEXIST))
+            {
+                continue;
+            }
+            if (base != (void *)(page + offset))
+            {
+                fprintf(stderr, "reg_trap: cannot map registers at 0x%08lX\n", (unsigned long)address);
+                exit(1);
+            }
+        }
+    }
+
+    if (g_region_count == 0)
+    {
+        signal_stack.ss_sp = g_signal_stack;
+        signal_stack.ss_size = sizeof(g_signal_stack);
+        signal_stack.ss_flags = 0;
+        sigaltstack(&signal_stack, NULL);
+
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = rt_segv;
+        action.sa_flags = SA_SIGINFO | SA_NODEFER | SA_ONSTACK;
+        sigaction(SIGSEGV, &action, NULL);
+        action.sa_sigaction = rt_trap;
+        sigaction(SIGTRAP, &action, NULL);
+    }
+
+    region = &g_regions[g_region_count++];
+    region->registers = (uint8_t *)address;
+    region->size = size;
+    region->pages = (uint8_t *)page;
+    region->pages_size = pages_size;
+    region->before = before;
+    region->written = written;
+    region->context = context;
+
+    return (void *)address;
+}
+
+//Function to get the number of register accesses trapped so far
+uint64_t reg_trap_accesses(void)
+{
+    return g_accesses;
+}
+
+//Function to set the callback asked for an interrupt after every trapped instruction
+void reg_trap_set_interrupt(reg_trap_interrupt_t interrupt)
+{
+    g_interrupt = interrupt;
+}
+
+//Function to take the pending interrupts now, for the models of the instructions that unmask them
+void reg_trap_take_interrupt(void)
+{
+    if ((g_interrupt != NULL) && !g_in_interrupt && ((g_handler = g_interrupt()) != NULL))
+    {
+        rt_interrupt();
+    }
+}
+
+bool reg_trap_in_interrupt(void)
+{
+    return g_in_interrupt;
+}
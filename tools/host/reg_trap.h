@@ -0,0 +1,76 @@
+/**
+ * \file
+ * \brief  Traps the accesses of firmware code to simulated peripheral registers
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Register level stand-ins for the host tools: a region of memory holds the
+ * registers of a peripheral model and is kept inaccessible, so every load
+ * or store the firmware code makes to it faults. reg_trap.c opens the
+ * region, lets the model refresh the registers the access sees, single
+ * steps the instruction and hands the model what was written.
+ *
+ * After a trapped instruction the model may have an interrupt to take. The
+ * handler then runs on an interrupt stack of its own, with every register
+ * of the interrupted code kept, and the code continues where it stopped.
+ * Handlers are not nested, and the signal handlers run on a stack of their
+ * own as well, so the stack of the firmware code only holds its own frames.
+ *
+ * Only for Linux on x86-64, the tools that use it say so in their build
+ * command.
+ */
+
+#ifndef REG_TRAP_H_
+#define REG_TRAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define REG_TRAP_MAX_REGIONS    8
+
+/*
+ * Called before every access with the region open, the model stores the
+ * register contents the access has to see. For a read-modify-write
+ * instruction it is called once, with write set.
+ */
+typedef void (*reg_trap_before_t)(void *context, uint32_t offset, bool write);
+
+//Called after a write, the model reads the value written and stores the new register contents
+typedef void (*reg_trap_written_t)(void *context, uint32_t offset);
+
+typedef void (*reg_trap_handler_t)(void);
+
+//Called after a trapped instruction outside an interrupt handler, returns the handler to run or NULL
+typedef reg_trap_handler_t (*reg_trap_interrupt_t)(void);
+
+void* reg_trap_map(uintptr_t address, size_t size, reg_trap_before_t before, reg_trap_written_t written,
+                   void *context);
+uint64_t reg_trap_accesses(void);
+void reg_trap_set_interrupt(reg_trap_interrupt_t interrupt);
+void reg_trap_take_interrupt(void);
+bool reg_trap_in_interrupt(void);
+
+#endif /* REG_TRAP_H_ */
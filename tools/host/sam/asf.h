@@ -0,0 +1,53 @@
+/**
+ * \file
+ * \brief  Register level stand-in of the firmware asf.h
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * The tools built on host/i2c_sim.c put this directory ahead of
+ * firmware/samd21/src. The headers are the real ASF ones, of the drivers the
+ * CryptoAuth I2C HAL uses; the registers behind them are modelled by
+ * i2c_sim.c.
+ */
+
+#ifndef ASF_H
+#define ASF_H
+
+#include <compiler.h>
+#include <status_codes.h>
+#include <board.h>
+#include <interrupt.h>
+#include <parts.h>
+#include <sercom.h>
+#include <sercom_interrupt.h>
+#include <i2c_common.h>
+#include <i2c_master.h>
+#include <clock.h>
+#include <gclk.h>
+#include <system.h>
+#include <pinmux.h>
+#include <system_interrupt.h>
+
+#endif // ASF_H
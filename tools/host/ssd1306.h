@@ -0,0 +1,160 @@
+/**
+ * \file
+ * \brief  Host stand-in for the SSD1306 component, a simulated controller
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Replaces the ASF ssd1306.h and the SPI driver below it when the gfx_mono
+ * driver of gfx_mono_ug_2832hsweg04.c is built on the host. Commands and
+ * data go to a model of the controller in ssd1306_sim.c, which keeps its
+ * display RAM and the bytes written to it.
+ *
+ * SPI write jobs complete right away unless ssd1306_sim_defer_jobs() is set,
+ * then the caller ends them with ssd1306_sim_complete_job() to look at a
+ * frame while it is still being sent.
+ */
+
+#ifndef SSD1306_H_INCLUDED
+#define SSD1306_H_INCLUDED
+
+#include <compiler.h>
+#include <status_codes.h>
+
+//Configuration of conf_ssd1306.h on the Xplained Pro
+#define CONFIG_SSD1306_FRAMEBUFFER
+#define CONFIG_SSD1306_DOUBLE_BUFFER
+#define SSD1306_CLOCK_SPEED         1000000UL
+
+#ifndef SPI_CALLBACK_MODE
+#define SPI_CALLBACK_MODE           true
+#endif
+
+#define SSD1306_DC_PIN              1
+#define SSD1306_CS_PIN              2
+
+//Chip select and D/C# hooks of conf_ssd1306.h
+#define SSD1306_CS_SELECT()         ssd1306_sim_set_pin(SSD1306_CS_PIN, false)
+#define SSD1306_CS_DESELECT()       ssd1306_sim_set_pin(SSD1306_CS_PIN, true)
+#define SSD1306_DC_COMMAND()        ssd1306_sim_set_pin(SSD1306_DC_PIN, false)
+#define SSD1306_DC_DATA()           ssd1306_sim_set_pin(SSD1306_DC_PIN, true)
+
+#define SSD1306_CMD_SET_LOW_COL(column)             (0x00 | (column))
+#define SSD1306_CMD_SET_HIGH_COL(column)            (0x10 | (column))
+#define SSD1306_CMD_SET_MEMORY_ADDRESSING_MODE      0x20
+#define SSD1306_CMD_SET_COLUMN_ADDRESS              0x21
+#define SSD1306_CMD_SET_PAGE_ADDRESS                0x22
+#define SSD1306_CMD_SET_START_LINE(line)            (0x40 | (line))
+#define SSD1306_CMD_SET_PAGE_START_ADDRESS(page)    (0xB0 | (page))
+#define SSD1306_CMD_COL_ADD_SET_MSB(column)         (0x10 | (column))
+#define SSD1306_CMD_COL_ADD_SET_LSB(column)         (0x00 | (column))
+#define SSD1306_CMD_SET_DISPLAY_START_LINE(line)    (0x40 | (line))
+
+//Geometry of the display RAM
+#define SSD1306_SIM_COLUMNS         128
+#define SSD1306_SIM_PAGES           4
+
+struct spi_module
+{
+    bool selected;
+};
+
+struct spi_slave_inst
+{
+    uint8_t ss_pin;
+};
+
+enum spi_callback
+{
+    SPI_CALLBACK_BUFFER_TRANSMITTED,
+    SPI_CALLBACK_N,
+};
+
+typedef void (*spi_callback_t)(struct spi_module *const module);
+
+typedef struct
+{
+    uint32_t commands;          //Command bytes
+    uint32_t data_bytes;        //Display data bytes
+    uint32_t jobs;              //SPI write jobs
+    uint32_t largest_job;       //Bytes of the longest write job
+    uint32_t errors;            //Commands or jobs started while a job was running, data outside a window
+} ssd1306_sim_stats;
+
+extern struct spi_module ssd1306_master;
+extern struct spi_slave_inst ssd1306_slave;
+
+void ssd1306_init(void);
+void ssd1306_init_start(void);
+void ssd1306_configure(void);
+
+//The simulated controller needs no reset pulse
+#define SSD1306_RESET_USEC          10
+
+static inline void ssd1306_reset_release(void)
+{
+}
+void ssd1306_write_command(uint8_t command);
+void ssd1306_write_data(uint8_t data);
+
+static inline uint8_t ssd1306_read_data(void)
+{
+    return 0;
+}
+
+static inline void ssd1306_set_page_address(uint8_t address)
+{
+    ssd1306_write_command(SSD1306_CMD_SET_PAGE_START_ADDRESS(address & 0x0F));
+}
+
+static inline void ssd1306_set_column_address(uint8_t address)
+{
+    address &= 0x7F;
+    ssd1306_write_command(SSD1306_CMD_COL_ADD_SET_MSB(address >> 4));
+    ssd1306_write_command(SSD1306_CMD_COL_ADD_SET_LSB(address & 0x0F));
+}
+
+static inline void ssd1306_set_display_start_line_address(uint8_t address)
+{
+    ssd1306_write_command(SSD1306_CMD_SET_DISPLAY_START_LINE(address & 0x3F));
+}
+
+enum status_code spi_select_slave(struct spi_module *const module, struct spi_slave_inst *const slave,
+                                  bool select);
+enum status_code spi_write_buffer_job(struct spi_module *const module, uint8_t *tx_data, uint16_t length);
+void spi_register_callback(struct spi_module *const module, spi_callback_t callback_func,
+                           enum spi_callback callback_type);
+void spi_enable_callback(struct spi_module *const module, enum spi_callback callback_type);
+
+void ssd1306_sim_set_pin(uint8_t pin, bool level);
+void ssd1306_sim_defer_jobs(bool defer);
+bool ssd1306_sim_job_running(void);
+void ssd1306_sim_complete_job(void);
+const uint8_t* ssd1306_sim_get_ram(void);
+const uint8_t* ssd1306_sim_get_written(void);
+void ssd1306_sim_clear_written(void);
+const ssd1306_sim_stats* ssd1306_sim_get_stats(void);
+void ssd1306_sim_reset_stats(void);
+
+#endif /* SSD1306_H_INCLUDED */
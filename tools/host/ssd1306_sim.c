@@ -0,0 +1,343 @@
+/**
+ * \file
+ * \brief  Simulated SSD1306 controller behind the host stand-in ssd1306.h
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#include <string.h>
+#include "ssd1306.h"
+
+//Command bytes followed by arguments, and how many
+#define SIM_ARGUMENTS(command) \
+    (((command) == 0x21 || (command) == 0x22) ? 2 : \
+     ((command) == 0x20 || (command) == 0x81 || (command) == 0x8D || (command) == 0xA8 || \
+      (command) == 0xD3 || (command) == 0xD5 || (command) == 0xD9 || (command) == 0xDA || \
+      (command) == 0xDB) ? 1 : 0)
+
+#define SIM_MODE_HORIZONTAL     0
+#define SIM_MODE_PAGE           2
+
+typedef struct
+{
+    uint8_t ram[SSD1306_SIM_PAGES * SSD1306_SIM_COLUMNS];
+    uint8_t written[SSD1306_SIM_PAGES * SSD1306_SIM_COLUMNS];
+    uint8_t mode;
+    uint8_t column_start, column_end;
+    uint8_t page_start, page_end;
+    uint8_t column, page;
+    uint8_t command[3];         //Command waiting for its arguments
+    uint8_t command_length;
+    bool cs_low;
+    bool dc_high;
+    const uint8_t *job_data;    //Write job not completed yet
+    uint16_t job_length;
+    uint8_t job_copy[SSD1306_SIM_PAGES * SSD1306_SIM_COLUMNS];
+    bool defer_jobs;
+    spi_callback_t callback;
+    bool callback_enabled;
+    ssd1306_sim_stats stats;
+} ssd1306_sim;
+
+struct spi_module ssd1306_master;
+struct spi_slave_inst ssd1306_slave;
+
+static ssd1306_sim g_sim;
+
+static void sim_execute(const uint8_t *command)
+{
+    switch (command[0])
+    {
+    case 0x20:
+        g_sim.mode = command[1] & 0x03;
+        break;
+    case 0x21:
+        g_sim.column_start = command[1] & 0x7F;
+        g_sim.column_end = command[2] & 0x7F;
+        g_sim.column = g_sim.column_start;
+        break;
+    case 0x22:
+        g_sim.page_start = command[1] & 0x07;
+        g_sim.page_end = command[2] & 0x07;
+        g_sim.page = g_sim.page_start;
+        break;
+    default:
+        if (command[0] < 0x10)
+        {
+            g_sim.column = (g_sim.column & 0xF0) | command[0];
+        }
+        else if (command[0] < 0x20)
+        {
+            g_sim.column = (g_sim.column & 0x0F) | ((command[0] & 0x07) << 4);
+        }
+        else if ((command[0] & 0xF8) == 0xB0)
+        {
+            g_sim.page = command[0] & 0x07;
+        }
+        break;
+    }
+}
+
+static void sim_command(uint8_t command)
+{
+    g_sim.stats.commands++;
+    g_sim.command[g_sim.command_length++] = command;
+    if (g_sim.command_length > SIM_ARGUMENTS(g_sim.command[0]))
+    {
+        sim_execute(g_sim.command);
+        g_sim.command_length = 0;
+    }
+}
+
+static void sim_data(uint8_t data)
+{
+    uint16_t offset = g_sim.page * SSD1306_SIM_COLUMNS + g_sim.column;
+
+    g_sim.stats.data_bytes++;
+    if (g_sim.page >= SSD1306_SIM_PAGES)
+    {
+        //Rows the 32 row panel does not have
+        g_sim.stats.errors++;
+    }
+    else
+    {
+        g_sim.ram[offset] = data;
+        if (g_sim.written[offset] != UINT8_MAX)
+        {
+            g_sim.written[offset]++;
+        }
+    }
+
+    if (g_sim.mode == SIM_MODE_PAGE)
+    {
+        g_sim.column = (g_sim.column + 1) & 0x7F;
+    }
+    else if (g_sim.column++ == g_sim.column_end)
+    {
+        g_sim.column = g_sim.column_start;
+        g_sim.page = (g_sim.page == g_sim.page_end) ? g_sim.page_start : g_sim.page + 1;
+    }
+}
+
+//Function to check that a byte can go to the controller now, chip select low and no job running
+static bool sim_can_send(void)
+{
+    if (g_sim.job_data != NULL || !(g_sim.cs_low || ssd1306_master.selected))
+    {
+        g_sim.stats.errors++;
+        return false;
+    }
+    return true;
+}
+
+//Function to reset the controller, the display RAM comes up with random contents
+void ssd1306_init(void)
+{
+    uint32_t state = 0x12345678;
+    uint16_t i;
+
+    memset(&g_sim, 0, sizeof(g_sim));
+    for (i = 0; i < sizeof(g_sim.ram); i++)
+    {
+        state = state * 1103515245 + 12345;
+        g_sim.ram[i] = state >> 24;
+    }
+    g_sim.mode = SIM_MODE_PAGE;
+    g_sim.column_end = SSD1306_SIM_COLUMNS - 1;
+    g_sim.page_end = 7;
+    ssd1306_master.selected = false;
+}
+
+//Function to reset the controller like ssd1306_init(), the caller skips the reset timing
+void ssd1306_init_start(void)
+{
+    ssd1306_init();
+}
+
+//Function standing in for the configuration commands, the simulated controller is always set up
+void ssd1306_configure(void)
+{
+}
+
+void ssd1306_write_command(uint8_t command)
+{
+    SSD1306_CS_SELECT();
+    SSD1306_DC_COMMAND();
+    if (sim_can_send())
+    {
+        sim_command(command);
+    }
+    SSD1306_CS_DESELECT();
+}
+
+void ssd1306_write_data(uint8_t data)
+{
+    SSD1306_CS_SELECT();
+    SSD1306_DC_DATA();
+    if (sim_can_send())
+    {
+        sim_data(data);
+    }
+    SSD1306_CS_DESELECT();
+}
+
+void ssd1306_sim_set_pin(uint8_t pin, bool level)
+{
+    if (pin == SSD1306_CS_PIN)
+    {
+        g_sim.cs_low = !level;
+    }
+    else if (pin == SSD1306_DC_PIN)
+    {
+        g_sim.dc_high = level;
+    }
+}
+
+enum status_code spi_select_slave(struct spi_module *const module, struct spi_slave_inst *const slave,
+                                  bool select)
+{
+    (void)slave;
+    module->selected = select;
+    return STATUS_OK;
+}
+
+enum status_code spi_write_buffer_job(struct spi_module *const module, uint8_t *tx_data, uint16_t length)
+{
+    if (length == 0)
+    {
+        return STATUS_ERR_INVALID_ARG;
+    }
+    if (g_sim.job_data != NULL)
+    {
+        g_sim.stats.errors++;
+        return STATUS_BUSY;
+    }
+    if (!module->selected || !g_sim.dc_high)
+    {
+        g_sim.stats.errors++;
+    }
+
+    if (length > sizeof(g_sim.job_copy))
+    {
+        g_sim.stats.errors++;
+        length = sizeof(g_sim.job_copy);
+    }
+    g_sim.job_data = tx_data;
+    g_sim.job_length = length;
+    memcpy(g_sim.job_copy, tx_data, length);
+    g_sim.stats.jobs++;
+    if (length > g_sim.stats.largest_job)
+    {
+        g_sim.stats.largest_job = length;
+    }
+
+    if (!g_sim.defer_jobs)
+    {
+        ssd1306_sim_complete_job();
+    }
+    return STATUS_OK;
+}
+
+void spi_register_callback(struct spi_module *const module, spi_callback_t callback_func,
+                           enum spi_callback callback_type)
+{
+    (void)module;
+    if (callback_type == SPI_CALLBACK_BUFFER_TRANSMITTED)
+    {
+        g_sim.callback = callback_func;
+    }
+}
+
+void spi_enable_callback(struct spi_module *const module, enum spi_callback callback_type)
+{
+    (void)module;
+    if (callback_type == SPI_CALLBACK_BUFFER_TRANSMITTED)
+    {
+        g_sim.callback_enabled = true;
+    }
+}
+
+void ssd1306_sim_defer_jobs(bool defer)
+{
+    g_sim.defer_jobs = defer;
+}
+
+bool ssd1306_sim_job_running(void)
+{
+    return g_sim.job_data != NULL;
+}
+
+//Function to shift out the running job and call the transmitted callback, like the SPI interrupt
+void ssd1306_sim_complete_job(void)
+{
+    const uint8_t *data = g_sim.job_data;
+    uint16_t i;
+
+    if (data == NULL)
+    {
+        return;
+    }
+
+    //The buffer is read as the bytes go out, so it must not change while the job runs
+    if (memcmp(data, g_sim.job_copy, g_sim.job_length) != 0)
+    {
+        g_sim.stats.errors++;
+    }
+    for (i = 0; i < g_sim.job_length; i++)
+    {
+        sim_data(g_sim.job_copy[i]);
+    }
+    g_sim.job_data = NULL;
+
+    if (g_sim.callback != NULL && g_sim.callback_enabled)
+    {
+        g_sim.callback(&ssd1306_master);
+    }
+}
+
+const uint8_t* ssd1306_sim_get_ram(void)
+{
+    return g_sim.ram;
+}
+
+//Function to get how often each byte of the display RAM was written since the last clear
+const uint8_t* ssd1306_sim_get_written(void)
+{
+    return g_sim.written;
+}
+
+void ssd1306_sim_clear_written(void)
+{
+    memset(g_sim.written, 0, sizeof(g_sim.written));
+}
+
+const ssd1306_sim_stats* ssd1306_sim_get_stats(void)
+{
+    return &g_sim.stats;
+}
+
+void ssd1306_sim_reset_stats(void)
+{
+    memset(&g_sim.stats, 0, sizeof(g_sim.stats));
+}
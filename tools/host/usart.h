@@ -0,0 +1,59 @@
+/**
+ * \file
+ * \brief  Host stand-in for the ASF USART driver the console uses
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Replaces the ASF usart.h when display_stream.c is built on the host. The
+ * console USART of usart_sim.c keeps everything written to it for the caller
+ * to take with usart_sim_take(), and reads the bytes queued with
+ * usart_sim_queue().
+ */
+
+#ifndef USART_H_INCLUDED
+#define USART_H_INCLUDED
+
+#include <compiler.h>
+#include <status_codes.h>
+
+#define USART_SIM_BUFFER_SIZE   4096
+
+struct usart_module
+{
+    uint8_t tx[USART_SIM_BUFFER_SIZE];
+    uint16_t tx_length;
+    uint8_t rx[USART_SIM_BUFFER_SIZE];
+    uint16_t rx_head, rx_tail;
+    uint32_t overflows;
+};
+
+enum status_code usart_write_buffer_wait(struct usart_module *const module, const uint8_t *tx_data, uint16_t length);
+enum status_code usart_read_wait(struct usart_module *const module, uint16_t *const rx_data);
+
+uint16_t usart_sim_take(uint8_t *buffer, uint16_t size);
+void usart_sim_queue(uint8_t data);
+uint32_t usart_sim_overflows(void);
+
+#endif // USART_H_INCLUDED
@@ -0,0 +1,92 @@
+/**
+ * \file
+ * \brief  Console USART stand-in for host builds of the firmware
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#include <string.h>
+#include "usart.h"
+
+static struct usart_module g_console;
+
+
+struct usart_module* console_get_usart(void)
+{
+    return &g_console;
+}
+
+
+enum status_code usart_write_buffer_wait(struct usart_module *const module, const uint8_t *tx_data, uint16_t length)
+{
+    if (length > USART_SIM_BUFFER_SIZE - module->tx_length)
+    {
+        module->overflows++;
+        length = USART_SIM_BUFFER_SIZE - module->tx_length;
+    }
+    memcpy(&module->tx[module->tx_length], tx_data, length);
+    module->tx_length += length;
+
+    return STATUS_OK;
+}
+
+
+enum status_code usart_read_wait(struct usart_module *const module, uint16_t *const rx_data)
+{
+    if (module->rx_head == module->rx_tail)
+    {
+        return STATUS_BUSY;
+    }
+    *rx_data = module->rx[module->rx_tail];
+    module->rx_tail = (module->rx_tail + 1) % USART_SIM_BUFFER_SIZE;
+
+    return STATUS_OK;
+}
+
+
+//Function to take the bytes written to the console since the last call
+uint16_t usart_sim_take(uint8_t *buffer, uint16_t size)
+{
+    uint16_t length = min(size, g_console.tx_length);
+
+    memcpy(buffer, g_console.tx, length);
+    memmove(g_console.tx, &g_console.tx[length], g_console.tx_length - length);
+    g_console.tx_length -= length;
+
+    return length;
+}
+
+
+//Function to queue a byte for the firmware to read from the console
+void usart_sim_queue(uint8_t data)
+{
+    g_console.rx[g_console.rx_head] = data;
+    g_console.rx_head = (g_console.rx_head + 1) % USART_SIM_BUFFER_SIZE;
+}
+
+
+uint32_t usart_sim_overflows(void)
+{
+    return g_console.overflows;
+}
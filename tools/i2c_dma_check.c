@@ -0,0 +1,462 @@
+/**
+ * \file
+ * \brief  Checks the DMA transfers and device discovery of hal_i2c_dma.c on a simulated bus
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux x86-64 with
+ *
+ *   S=../firmware/samd21/src D=$S/ASF/sam0/drivers
+ *   cc -O2 -no-pie -Wno-pointer-to-int-cast -D__SAMD21J18A__ -DBOARD=SAMD21_XPLAINED_PRO \
+ *      -DI2C_MASTER_CALLBACK_MODE=false \
+ *      -Ihost/sam -Ihost/cryptoauthlib -I$S -I$S/config -I$S/ASF/common/boards -I$S/ASF/sam0/boards \
+ *      -I$S/ASF/sam0/boards/samd21_xplained_pro -I$S/ASF/sam0/utils -I$S/ASF/sam0/utils/header_files \
+ *      -I$S/ASF/sam0/utils/preprocessor -I$S/ASF/sam0/utils/cmsis/samd21/include \
+ *      -I$S/ASF/sam0/utils/cmsis/samd21/source -I$S/ASF/thirdparty/CMSIS/Include \
+ *      -I$D/sercom -I$D/sercom/i2c -I$D/port -I$D/system -I$D/system/pinmux -I$D/system/clock \
+ *      -I$D/system/clock/clock_samd21_r21_da -I$D/system/interrupt \
+ *      -I$D/system/interrupt/system_interrupt_samd21 -I$D/system/power/power_sam_d_r \
+ *      -I$D/system/reset/reset_sam_d_r -I$S/ASF/common/utils \
+ *      -o i2c_dma_check i2c_dma_check.c host/i2c_sim.c host/reg_trap.c host/cryptoauthlib/cryptoauthlib_sim.c \
+ *      $S/hal_i2c_dma.c $S/cmd_timing.c $D/sercom/i2c/i2c_sam0/i2c_master.c \
+ *      $D/sercom/sercom.c $D/sercom/sercom_interrupt.c
+ *
+ * hal_i2c_dma.c, the ASF I2C master driver and the SERCOM interrupt
+ * dispatch are built unchanged and run on the register model of
+ * host/i2c_sim.c; the cryptoauthlib submodule is not part of this tree, so
+ * host/cryptoauthlib stands in for it. The HAL hands the DMAC 32-bit
+ * addresses, hence -no-pie and the pointer cast warnings left out. The
+ * checks are:
+ *
+ *   - write and read jobs of 1 to 255 bytes: ADDR.LEN matches the DMAC
+ *     descriptor, the bytes land in order without touching the guard bytes
+ *     around the buffer, the length counter sends the STOP condition, the
+ *     CPU moves no data byte and the callback is called once with STATUS_OK
+ *   - an address NACK, a data NACK before the last byte (LENERR), a zero
+ *     length and a job started while one is running end with the status
+ *     the HAL documents and leave the bus idle
+ *   - Info, Random and the serial number read through cryptoauthlib
+ *   - hal_i2c_discover_devices() with no device, each device alone, two and
+ *     three of them: one wake pulse, each found device gets the default
+ *     configuration of its type and is asleep afterwards
+ *
+ * Misuse of the registers the model finds, like a length that does not
+ * match the descriptor, is reported by the model and fails the run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include "host/reg_trap.h"
+#include "host/i2c_sim.h"
+
+//glibc defines these as well, the ASF definitions win for the firmware code
+#undef __always_inline
+#undef LITTLE_ENDIAN
+#include "hal_i2c_dma.h"
+
+#define CHECK_RAW_ADDRESS       0xA0        //8-bit address of the raw device
+#define CHECK_ABSENT_ADDRESS    0xB0
+#define CHECK_GUARD_SIZE        8
+#define CHECK_GUARD             0x5C
+
+typedef struct
+{
+    uint32_t baud;
+    uint32_t failures;
+} check_context;
+
+static const uint8_t g_lengths[] = { 1, 2, 4, 7, 35, 84, 155, 254, 255 };
+
+static uint32_t g_done_count;
+static enum status_code g_done_status;
+
+static void print_usage(const char *name)
+{
+    printf("Usage: %s [-b baud]\n", name);
+    printf("  -b  I2C clock of the HAL and jobs, 100000 to 1000000 (default 400000)\n");
+}
+
+static void check_done(enum status_code status)
+{
+    g_done_count++;
+    g_done_status = status;
+}
+
+static const char* check_status_name(enum status_code status)
+{
+    switch (status)
+    {
+    case STATUS_ERR_BAD_ADDRESS: return "STATUS_ERR_BAD_ADDRESS";
+    case STATUS_ERR_INVALID_ARG: return "STATUS_ERR_INVALID_ARG";
+    default: return "other";
+    }
+}
+
+static bool check_fail(check_context *context, const char *name, const char *reason)
+{
+    printf("%-44s FAIL %s\n", name, reason);
+    context->failures++;
+    return false;
+}
+
+static void check_pass(const char *name, const char *details)
+{
+    printf("%-44s ok   %s\n", name, details);
+}
+
+//Returns the I2C master of an initialized bus, the first member of the HAL bus structure
+static struct i2c_master_module* check_module(ATCAHAL_t *hal)
+{
+    return (struct i2c_master_module*)hal->hal_data;
+}
+
+static ATCAIfaceCfg check_cfg(check_context *context, uint8_t address, ATCADeviceType devtype)
+{
+    ATCAIfaceCfg cfg = (devtype == ATSHA204A) ? cfg_atsha204a_i2c_default : cfg_ateccx08a_i2c_default;
+
+    cfg.devtype = devtype;
+    cfg.atcai2c.slave_address = address;
+    cfg.atcai2c.baud = context->baud;
+    return cfg;
+}
+
+static bool check_job(check_context *context, struct i2c_master_module *module, bool reading, uint8_t length)
+{
+    uint8_t buffer[CHECK_GUARD_SIZE + HAL_I2C_DMA_MAX_LENGTH + CHECK_GUARD_SIZE];
+    uint8_t *data = &buffer[CHECK_GUARD_SIZE];
+    i2c_sim_device *device = i2c_sim_get_device(0);
+    const i2c_sim_stats *stats = i2c_sim_get_stats();
+    enum status_code status;
+    char name[48];
+    char details[80];
+    uint16_t i;
+
+    snprintf(name, sizeof(name), "%s job of %u bytes", reading ? "read" : "write", length);
+    memset(buffer, CHECK_GUARD, sizeof(buffer));
+    for (i = 0; i < length; i++)
+    {
+        data[i] = (uint8_t)(i * 29 + length);
+        device->raw_read[i] = (uint8_t)(i * 53 + 7);
+    }
+    i2c_sim_reset_stats();
+    g_done_count = 0;
+
+    status = reading ? hal_i2c_dma_read_job(module, CHECK_RAW_ADDRESS >> 1, data, length, check_done) :
+             hal_i2c_dma_write_job(module, CHECK_RAW_ADDRESS >> 1, data, length, check_done);
+    if (status != STATUS_OK)
+    {
+        return check_fail(context, name, "not started");
+    }
+    if (hal_i2c_dma_is_busy() || g_done_count != 1 || g_done_status != STATUS_OK)
+    {
+        return check_fail(context, name, "callback not called once with STATUS_OK");
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        if (reading ? (data[i] != device->raw_read[i]) : (device->raw[i] != data[i]))
+        {
+            return check_fail(context, name, "data differs");
+        }
+    }
+    if (!reading && device->raw_length != length)
+    {
+        return check_fail(context, name, "device received a different length");
+    }
+    for (i = 0; i < CHECK_GUARD_SIZE; i++)
+    {
+        if (buffer[i] != CHECK_GUARD || data[length + i] != CHECK_GUARD)
+        {
+            return check_fail(context, name, "guard bytes overwritten");
+        }
+    }
+    if (stats->length_transfers != 1 || stats->dma_beats != length || stats->polled_bytes != 0 ||
+        stats->bytes != length + 1u || !i2c_sim_bus_idle())
+    {
+        return check_fail(context, name, "not one length counter transfer moved by the DMAC");
+    }
+
+    snprintf(details, sizeof(details), "%3lu bus bytes, %2u interrupts, %5lu us", (unsigned long)stats->bytes,
+             stats->interrupts, (unsigned long)stats->bus_usec);
+    check_pass(name, details);
+    return true;
+}
+
+//Function to check a job ending with an error status, and the bus released afterwards
+static bool check_job_error(check_context *context, struct i2c_master_module *module, const char *name,
+                            uint8_t address, bool reading, uint8_t length, enum status_code expected)
+{
+    uint8_t data[HAL_I2C_DMA_MAX_LENGTH] = { 0 };
+    enum status_code status;
+    char details[80];
+
+    i2c_sim_reset_stats();
+    g_done_count = 0;
+    status = reading ? hal_i2c_dma_read_job(module, address >> 1, data, length, check_done) :
+             hal_i2c_dma_write_job(module, address >> 1, data, length, check_done);
+
+    if (expected == STATUS_ERR_INVALID_ARG)
+    {
+        if (status != expected || g_done_count != 0 || i2c_sim_get_stats()->transfers != 0)
+        {
+            return check_fail(context, name, "not refused");
+        }
+    }
+    else if (status != STATUS_OK || hal_i2c_dma_is_busy() || g_done_count != 1 || g_done_status != expected)
+    {
+        return check_fail(context, name, "callback status differs");
+    }
+    if (!i2c_sim_bus_idle())
+    {
+        return check_fail(context, name, "bus not released");
+    }
+
+    snprintf(details, sizeof(details), "%s, %u interrupts", check_status_name(expected),
+             i2c_sim_get_stats()->interrupts);
+    check_pass(name, details);
+    return true;
+}
+
+//Function to start a job while the interrupts are masked, a second one must be refused until the first ends
+static bool check_job_busy(check_context *context, struct i2c_master_module *module)
+{
+    const char *name = "job started while one is running";
+    uint8_t data[4] = { 1, 2, 3, 4 };
+    enum status_code first;
+    enum status_code second;
+    bool busy;
+
+    g_done_count = 0;
+    cpu_irq_enter_critical();
+    first = hal_i2c_dma_write_job(module, CHECK_RAW_ADDRESS >> 1, data, sizeof(data), check_done);
+    second = hal_i2c_dma_write_job(module, CHECK_RAW_ADDRESS >> 1, data, sizeof(data), check_done);
+    busy = hal_i2c_dma_is_busy();
+    cpu_irq_leave_critical();
+
+    if (first != STATUS_OK || second != STATUS_BUSY || !busy)
+    {
+        return check_fail(context, name, "second job not refused");
+    }
+    if (hal_i2c_dma_is_busy() || g_done_count != 1 || g_done_status != STATUS_OK)
+    {
+        return check_fail(context, name, "first job not finished when the interrupts were unmasked");
+    }
+
+    check_pass(name, "STATUS_BUSY, the first one finishes after the critical section");
+    return true;
+}
+
+static void check_jobs(void *argument)
+{
+    check_context *context = argument;
+    ATCAIfaceCfg cfg = check_cfg(context, CHECK_RAW_ADDRESS, ATECC508A);
+    i2c_sim_device_config config;
+    struct i2c_master_module *module;
+    ATCAHAL_t hal;
+    uint8_t i;
+
+    i2c_sim_init();
+    memset(&config, 0, sizeof(config));
+    config.kind = I2C_SIM_RAW;
+    config.address = CHECK_RAW_ADDRESS;
+    i2c_sim_add_device(&config);
+    config.address = CHECK_RAW_ADDRESS + 2;
+    config.nack_after = 5;
+    i2c_sim_add_device(&config);
+
+    if (hal_i2c_init(&hal, &cfg) != ATCA_SUCCESS)
+    {
+        check_fail(context, "hal_i2c_init", "failed");
+        return;
+    }
+    module = check_module(&hal);
+
+    for (i = 0; i < sizeof(g_lengths); i++)
+    {
+        check_job(context, module, false, g_lengths[i]);
+    }
+    for (i = 0; i < sizeof(g_lengths); i++)
+    {
+        check_job(context, module, true, g_lengths[i]);
+    }
+
+    check_job_error(context, module, "write to an absent address", CHECK_ABSENT_ADDRESS, false, 8,
+                    STATUS_ERR_BAD_ADDRESS);
+    check_job_error(context, module, "read from an absent address", CHECK_ABSENT_ADDRESS, true, 8,
+                    STATUS_ERR_BAD_ADDRESS);
+    check_job_error(context, module, "write NACKed after 5 of 10 bytes", CHECK_RAW_ADDRESS + 2, false, 10,
+                    STATUS_ERR_BAD_ADDRESS);
+    check_job_error(context, module, "write of 0 bytes", CHECK_RAW_ADDRESS, false, 0, STATUS_ERR_INVALID_ARG);
+    check_job_error(context, module, "read of 0 bytes", CHECK_RAW_ADDRESS, true, 0, STATUS_ERR_INVALID_ARG);
+    check_job_busy(context, module);
+    check_job(context, module, false, 16);
+
+    hal_i2c_release(hal.hal_data);
+}
+
+static void check_commands(void *argument)
+{
+    check_context *context = argument;
+    ATCAIfaceCfg cfg = check_cfg(context, 0xC0, ATECC608A);
+    const uint8_t expected_revision[INFO_SIZE] = { 0x00, 0x00, 0x60, 0x02 };
+    i2c_sim_device_config config;
+    uint8_t revision[INFO_SIZE];
+    uint8_t random[RANDOM_NUM_SIZE];
+    uint8_t serial_number[ATCA_SERIAL_NUM_SIZE];
+    const i2c_sim_stats *stats;
+    i2c_sim_device *device;
+    char details[80];
+
+    i2c_sim_init();
+    i2c_sim_default_config(&config, 0xC0, ATECC608A);
+    i2c_sim_add_device(&config);
+    device = i2c_sim_get_device(0);
+
+    if (atcab_init(&cfg) != ATCA_SUCCESS || atcab_info(revision) != ATCA_SUCCESS ||
+        memcmp(revision, expected_revision, sizeof(revision)) != 0)
+    {
+        check_fail(context, "Info command", "wrong revision");
+        return;
+    }
+    check_pass("Info command", "revision 00 00 60 02");
+
+    if (atcab_random(random) != ATCA_SUCCESS || atcab_read_serial_number(serial_number) != ATCA_SUCCESS ||
+        memcmp(serial_number, config.serial_number, sizeof(serial_number)) != 0)
+    {
+        check_fail(context, "Random and serial number", "failed");
+        return;
+    }
+    stats = i2c_sim_get_stats();
+    if (device->commands != 3 || device->bad_packets != 0 || stats->dma_beats == 0)
+    {
+        check_fail(context, "Random and serial number", "commands not sent by the DMAC");
+        return;
+    }
+    snprintf(details, sizeof(details), "3 commands, %u DMA bytes, %u CPU bytes, %lu us", stats->dma_beats,
+             stats->polled_bytes, (unsigned long)i2c_sim_now());
+    check_pass("Random and serial number", details);
+
+    atcab_release();
+}
+
+static void check_discover(void *argument)
+{
+    static const struct
+    {
+        const char *name;
+        uint8_t count;
+        uint8_t addresses[HAL_I2C_DISCOVER_MAX];
+        ATCADeviceType devtypes[HAL_I2C_DISCOVER_MAX];
+    } cases[] =
+    {
+        { "no device",                     0, { 0 },                { ATECC508A } },
+        { "ATECCx08A at 0xC0",             1, { 0xC0 },             { ATECC508A } },
+        { "ATSHA204A at 0xC8",             1, { 0xC8 },             { ATSHA204A } },
+        { "ATECC608A at 0x6A",             1, { 0x6A },             { ATECC608A } },
+        { "0xC0 and 0x6A",                 2, { 0xC0, 0x6A },       { ATECC508A, ATECC608A } },
+        { "0xC0, 0xC8 and 0x6A",           3, { 0xC0, 0xC8, 0x6A }, { ATECC508A, ATSHA204A, ATECC608A } },
+    };
+    check_context *context = argument;
+    ATCAIfaceCfg cfg[HAL_I2C_DISCOVER_MAX];
+    ATCAIfaceCfg expected;
+    i2c_sim_device_config config;
+    char name[48];
+    char details[80];
+    int found;
+    uint8_t c;
+    uint8_t i;
+    bool ok;
+
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        snprintf(name, sizeof(name), "discover, %s", cases[c].name);
+        i2c_sim_init();
+        for (i = 0; i < cases[c].count; i++)
+        {
+            i2c_sim_default_config(&config, cases[c].addresses[i], cases[c].devtypes[i]);
+            i2c_sim_add_device(&config);
+        }
+
+        memset(cfg, 0, sizeof(cfg));
+        ok = (hal_i2c_discover_devices(I2C_SIM_BUS, cfg, &found) == ATCA_SUCCESS) && (found == cases[c].count);
+        for (i = 0; ok && i < cases[c].count; i++)
+        {
+            expected = (cases[c].devtypes[i] == ATSHA204A) ? cfg_atsha204a_i2c_default : cfg_ateccx08a_i2c_default;
+            ok = cfg[i].devtype == cases[c].devtypes[i] && cfg[i].atcai2c.slave_address == cases[c].addresses[i] &&
+                 cfg[i].atcai2c.bus == I2C_SIM_BUS && cfg[i].atcai2c.baud == expected.atcai2c.baud &&
+                 cfg[i].wake_delay == expected.wake_delay && cfg[i].iface_type == ATCA_I2C_IFACE &&
+                 i2c_sim_get_device(i)->state == I2C_SIM_SLEEP && i2c_sim_get_device(i)->sleeps == 1;
+        }
+        if (!ok || i2c_sim_get_stats()->wake_pulses != 1 || i2c_sim_get_stats()->errors != 0)
+        {
+            check_fail(context, name, "devices or their configuration differ");
+            continue;
+        }
+        snprintf(details, sizeof(details), "%d found, 1 wake pulse, %lu us", found, (unsigned long)i2c_sim_now());
+        check_pass(name, details);
+    }
+
+    if (hal_i2c_discover_devices(MAX_I2C_BUSES, cfg, &found) != ATCA_BAD_PARAM || found != 0)
+    {
+        check_fail(context, "discover on a bus out of range", "not ATCA_BAD_PARAM");
+    }
+    else
+    {
+        check_pass("discover on a bus out of range", "ATCA_BAD_PARAM");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    check_context context = { .baud = 400000, .failures = 0 };
+    int option;
+
+    while ((option = getopt(argc, argv, "b:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'b': context.baud = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+    if (context.baud < 100000 || context.baud > 1000000)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("I2C at %lu Hz\n\n", (unsigned long)context.baud);
+    i2c_sim_call(check_jobs, &context);
+    i2c_sim_call(check_commands, &context);
+    i2c_sim_call(check_discover, &context);
+
+    context.failures += i2c_sim_get_stats()->errors;
+    printf("\n%lu register accesses trapped, %u failed\n", (unsigned long)reg_trap_accesses(), context.failures);
+    return (context.failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,291 @@
+/**
+ * \file
+ * \brief  Checks the address-only bus scan of hal_i2c_dma.c on a simulated bus
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux x86-64 with
+ *
+ *   S=../firmware/samd21/src D=$S/ASF/sam0/drivers
+ *   cc -O2 -no-pie -Wno-pointer-to-int-cast -D__SAMD21J18A__ -DBOARD=SAMD21_XPLAINED_PRO \
+ *      -DI2C_MASTER_CALLBACK_MODE=false \
+ *      -Ihost/sam -Ihost/cryptoauthlib -I$S -I$S/config -I$S/ASF/common/boards -I$S/ASF/sam0/boards \
+ *      -I$S/ASF/sam0/boards/samd21_xplained_pro -I$S/ASF/sam0/utils -I$S/ASF/sam0/utils/header_files \
+ *      -I$S/ASF/sam0/utils/preprocessor -I$S/ASF/sam0/utils/cmsis/samd21/include \
+ *      -I$S/ASF/sam0/utils/cmsis/samd21/source -I$S/ASF/thirdparty/CMSIS/Include \
+ *      -I$D/sercom -I$D/sercom/i2c -I$D/port -I$D/system -I$D/system/pinmux -I$D/system/clock \
+ *      -I$D/system/clock/clock_samd21_r21_da -I$D/system/interrupt \
+ *      -I$D/system/interrupt/system_interrupt_samd21 -I$D/system/power/power_sam_d_r \
+ *      -I$D/system/reset/reset_sam_d_r -I$S/ASF/common/utils \
+ *      -o i2c_scan_check i2c_scan_check.c host/i2c_sim.c host/reg_trap.c \
+ *      host/cryptoauthlib/cryptoauthlib_sim.c $S/hal_i2c_dma.c $S/cmd_timing.c \
+ *      $D/sercom/i2c/i2c_sam0/i2c_master.c $D/sercom/sercom.c $D/sercom/sercom_interrupt.c
+ *
+ * hal_i2c_dma.c runs unchanged on the bus model of host/i2c_sim.c, with
+ * host/cryptoauthlib standing in for the library, which is not part of this
+ * tree. hal_i2c_scan() runs over the whole 7-bit range and over the
+ * candidate list of detect_crypto_device(), with no device, one device,
+ * several CryptoAuth devices and a plain I2C device that needs no wake, and
+ * candidates that are absent. Every scan has to find exactly the devices
+ * present, in address order, with one wake pulse, and put the devices it
+ * found back to sleep. A scan limited to fewer addresses than there are
+ * devices has to stop at the limit. The wake pulse also reaches the
+ * devices the scan does not address; they have to be asleep once the
+ * watchdog has run out, as after any wake.
+ *
+ * For the candidate list the scan is compared with what it replaced in
+ * detect_crypto_device(): atcab_init() and an Info command per candidate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include "host/reg_trap.h"
+#include "host/i2c_sim.h"
+
+//glibc defines these as well, the ASF definitions win for the firmware code
+#undef __always_inline
+#undef LITTLE_ENDIAN
+#include "hal_i2c_dma.h"
+
+//Candidate list of detect_crypto_device(), ECC608A_DEFAULT_ADDRESS and ECC608A_ADDRESS
+#define CHECK_DEFAULT_ADDRESS   0xC0
+#define CHECK_CONFIGURED_ADDRESS 0x6A
+#define CHECK_RAW_ADDRESS       0xA0
+#define CHECK_MAX_DEVICES       4
+//tWATCHDOG of the device model after the longest tWHI
+#define CHECK_WATCHDOG_USEC     (700000 + 2500)
+
+typedef struct
+{
+    uint32_t baud;
+    uint32_t failures;
+} check_context;
+
+typedef struct
+{
+    const char *name;
+    bool candidates;            //Scan the list of detect_crypto_device() instead of the whole range
+    uint8_t found_max;
+    uint8_t count;
+    uint8_t addresses[CHECK_MAX_DEVICES];
+    uint8_t expected_count;
+    uint8_t expected[CHECK_MAX_DEVICES];
+} check_case;
+
+static const uint8_t g_candidates[] = { CHECK_DEFAULT_ADDRESS, CHECK_CONFIGURED_ADDRESS };
+
+static const check_case g_cases[] =
+{
+    { "range, no device",             false, 8, 0, { 0 },                      0, { 0 } },
+    { "range, 0xC0",                  false, 8, 1, { 0xC0 },                   1, { 0xC0 } },
+    { "range, 0x6A",                  false, 8, 1, { 0x6A },                   1, { 0x6A } },
+    { "range, 0xC0 0xC8 0x6A",        false, 8, 3, { 0xC0, 0xC8, 0x6A },       3, { 0x6A, 0xC0, 0xC8 } },
+    { "range, plain device 0xA0",     false, 8, 2, { 0xC0, CHECK_RAW_ADDRESS }, 2, { 0xA0, 0xC0 } },
+    { "range, first 2 of 3",          false, 2, 3, { 0xC0, 0xC8, 0x6A },       2, { 0x6A, 0xC0 } },
+    { "list, no device",              true,  1, 0, { 0 },                      0, { 0 } },
+    { "list, default address",        true,  1, 1, { 0xC0 },                   1, { 0xC0 } },
+    { "list, configured address",     true,  1, 1, { 0x6A },                   1, { 0x6A } },
+    { "list, other device only",      true,  1, 1, { 0xC8 },                   0, { 0 } },
+    { "list, both, first kept",       true,  1, 2, { 0x6A, 0xC0 },             1, { 0xC0 } },
+    { "list, both",                   true,  2, 2, { 0x6A, 0xC0 },             2, { 0xC0, 0x6A } },
+};
+
+static void print_usage(const char *name)
+{
+    printf("Usage: %s [-b baud]\n", name);
+    printf("  -b  I2C clock of the HAL, 100000 to 1000000 (default 400000)\n");
+}
+
+static bool check_fail(check_context *context, const char *name, const char *reason)
+{
+    printf("%-32s FAIL %s\n", name, reason);
+    context->failures++;
+    return false;
+}
+
+static ATCAIfaceCfg check_cfg(check_context *context)
+{
+    ATCAIfaceCfg cfg = cfg_ateccx08a_i2c_default;
+
+    cfg.atcai2c.baud = context->baud;
+    return cfg;
+}
+
+//Function to put the devices of a case on the bus, the ones at CHECK_RAW_ADDRESS need no wake
+static void check_devices(const check_case *test)
+{
+    i2c_sim_device_config config;
+    uint8_t i;
+
+    i2c_sim_init();
+    for (i = 0; i < test->count; i++)
+    {
+        i2c_sim_default_config(&config, test->addresses[i], (test->addresses[i] == 0xC8) ? ATSHA204A : ATECC608A);
+        if (test->addresses[i] == CHECK_RAW_ADDRESS)
+        {
+            config.kind = I2C_SIM_RAW;
+        }
+        i2c_sim_add_device(&config);
+    }
+}
+
+static bool check_scan(check_context *context, const check_case *test)
+{
+    ATCAIfaceCfg cfg = check_cfg(context);
+    const i2c_sim_stats *stats;
+    const i2c_sim_device *device;
+    uint8_t found[CHECK_MAX_DEVICES + 1];
+    uint64_t now;
+    uint8_t count;
+    uint8_t i;
+
+    check_devices(test);
+    memset(found, 0, sizeof(found));
+    count = hal_i2c_scan(&cfg, test->candidates ? g_candidates : NULL, sizeof(g_candidates), found, test->found_max);
+    stats = i2c_sim_get_stats();
+
+    if (count != test->expected_count || memcmp(found, test->expected, count) != 0 || found[count] != 0)
+    {
+        return check_fail(context, test->name, "addresses found differ");
+    }
+    if (stats->wake_pulses != 1 || stats->errors != 0 || !i2c_sim_bus_idle())
+    {
+        return check_fail(context, test->name, "not one wake pulse, or the bus left busy");
+    }
+    for (i = 0; i < test->count; i++)
+    {
+        device = i2c_sim_get_device(i);
+        if (test->addresses[i] != CHECK_RAW_ADDRESS && memchr(found, test->addresses[i], count) != NULL &&
+            device->state != I2C_SIM_SLEEP)
+        {
+            return check_fail(context, test->name, "device found and left awake");
+        }
+    }
+    now = i2c_sim_now();
+
+    //The wake pulse reached the devices the scan did not address too, their watchdog puts them back to sleep
+    i2c_sim_delay_us(CHECK_WATCHDOG_USEC);
+    for (i = 0; i < test->count; i++)
+    {
+        device = i2c_sim_get_device(i);
+        if (test->addresses[i] != CHECK_RAW_ADDRESS && device->state != I2C_SIM_SLEEP)
+        {
+            return check_fail(context, test->name, "device not asleep after the watchdog");
+        }
+    }
+
+    printf("%-32s ok   %u found, %u addresses NACKed, %lu us\n", test->name, count, stats->address_nacks,
+           (unsigned long)now);
+    return true;
+}
+
+//Function to find the device of the candidate list the way detect_crypto_device() did before the scan
+static void check_init_per_candidate(check_context *context, const check_case *test, uint64_t *usec,
+                                     uint32_t *wake_pulses)
+{
+    ATCAIfaceCfg cfg = check_cfg(context);
+    uint8_t revision[INFO_SIZE];
+    uint8_t i;
+
+    check_devices(test);
+    for (i = 0; i < sizeof(g_candidates); i++)
+    {
+        cfg.atcai2c.slave_address = g_candidates[i];
+        if (atcab_init(&cfg) == ATCA_SUCCESS && atcab_info(revision) == ATCA_SUCCESS)
+        {
+            break;
+        }
+    }
+    atcab_release();
+    *usec = i2c_sim_now();
+    *wake_pulses = i2c_sim_get_stats()->wake_pulses;
+}
+
+static void check_all(void *argument)
+{
+    check_context *context = argument;
+    ATCAIfaceCfg cfg = check_cfg(context);
+    uint32_t wake_pulses;
+    uint64_t scan_usec;
+    uint64_t init_usec;
+    uint8_t found;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(g_cases) / sizeof(g_cases[0]); i++)
+    {
+        check_scan(context, &g_cases[i]);
+    }
+
+    printf("\n%-26s %10s %10s %12s\n", "candidate list", "scan us", "init us", "init wakes");
+    for (i = 0; i < sizeof(g_cases) / sizeof(g_cases[0]); i++)
+    {
+        if (!g_cases[i].candidates || g_cases[i].found_max != 1)
+        {
+            continue;
+        }
+        check_devices(&g_cases[i]);
+        hal_i2c_scan(&cfg, g_candidates, sizeof(g_candidates), &found, 1);
+        scan_usec = i2c_sim_now();
+        check_init_per_candidate(context, &g_cases[i], &init_usec, &wake_pulses);
+
+        printf("%-26s %10lu %10lu %12u\n", g_cases[i].name + 6, (unsigned long)scan_usec, (unsigned long)init_usec,
+               wake_pulses);
+        if (scan_usec >= init_usec)
+        {
+            check_fail(context, g_cases[i].name, "scan not faster than an init per candidate");
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    check_context context = { .baud = 400000, .failures = 0 };
+    int option;
+
+    while ((option = getopt(argc, argv, "b:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'b': context.baud = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+    if (context.baud < 100000 || context.baud > 1000000)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("I2C at %lu Hz\n\n", (unsigned long)context.baud);
+    i2c_sim_call(check_all, &context);
+
+    context.failures += i2c_sim_get_stats()->errors;
+    printf("\n%lu register accesses trapped, %u failed\n", (unsigned long)reg_trap_accesses(), context.failures);
+    return (context.failures == 0) ? 0 : 1;
+}
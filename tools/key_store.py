@@ -0,0 +1,342 @@
+##
+# \file
+#
+# \brief Memory mapped key store indexed by serial number
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# Layout, all multi byte fields little endian:
+#
+#   magic "KSTO", version (1 byte), key slot (1 byte), serial number size
+#   (1 byte), key size (1 byte), record count (4 bytes), index size as a
+#   power of two (1 byte), 3 reserved bytes
+#   index: 2^bits 4 byte entries, record number + 1 or 0 for a free bucket
+#   records: serial number, key, in insertion order
+#
+# The index is an open addressing table with linear probing, kept at most
+# 3/4 full. A store is opened with mmap, so opening does not depend on the
+# number of records and a lookup touches one or two index entries and one
+# record. Records are appended after the last one and the record count in
+# the header is written last; index entries pointing past the count belong
+# to an interrupted append and count as free.
+import os
+import sys
+import mmap
+import time
+import struct
+import argparse
+import tempfile
+
+import key_table
+
+MAGIC = b"KSTO"
+VERSION = 1
+HEADER = struct.Struct("<4sBBBBIB3x")
+COUNT_OFFSET = 8
+ENTRY_SIZE = 4
+MIN_INDEX_BITS = 4
+MAX_INDEX_BITS = 31
+HASH_MULTIPLIER = 0x9E3779B97F4A7C15
+
+class KeyStoreError(Exception):
+	pass
+
+def index_bits_for(count):
+	bits = MIN_INDEX_BITS
+	while (1 << bits) * 3 < count * 4:
+		bits += 1
+	if bits > MAX_INDEX_BITS:
+		raise KeyStoreError("too many records")
+	return bits
+
+# Fibonacci hashing of the serial number, SN[0:1] and SN[8] are the same
+# on every device so all bytes are folded in before taking the top bits
+def bucket_of(serial_number, bits):
+	value = int.from_bytes(serial_number, "little")
+	value = (value ^ (value >> 64)) & 0xFFFFFFFFFFFFFFFF
+	return ((value * HASH_MULTIPLIER) & 0xFFFFFFFFFFFFFFFF) >> (64 - bits)
+
+class KeyStore(object):
+	def __init__(self, file_name, writable=False):
+		if sys.byteorder != "little":
+			raise KeyStoreError("the index is mapped in host byte order, a little endian host is needed")
+		self.file_name = file_name
+		self.writable = writable
+		self.file = open(file_name, "r+b" if writable else "rb")
+		try:
+			self._map()
+		except:
+			self.file.close()
+			raise
+
+	def _map(self):
+		size = os.fstat(self.file.fileno()).st_size
+		if size < HEADER.size:
+			raise KeyStoreError("truncated header")
+		self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_WRITE if self.writable else mmap.ACCESS_READ)
+		magic, version, self.slot, self.serial_number_size, self.key_size, self.count, self.bits = HEADER.unpack_from(self.map)
+		if magic != MAGIC or version != VERSION:
+			self.map.close()
+			raise KeyStoreError("not a version %u key store" % VERSION)
+		self.record_size = self.serial_number_size + self.key_size
+		self.mask = (1 << self.bits) - 1
+		self.records_offset = HEADER.size + (ENTRY_SIZE << self.bits)
+		if size < self.records_offset + self.count * self.record_size:
+			self.map.close()
+			raise KeyStoreError("truncated records")
+		self.view = memoryview(self.map)
+		self.index = self.view[HEADER.size:self.records_offset].cast("I")
+
+	def _unmap(self):
+		self.index.release()
+		self.view.release()
+		self.map.close()
+
+	def close(self):
+		if self.file:
+			self._unmap()
+			self.file.close()
+			self.file = None
+
+	def __enter__(self):
+		return self
+
+	def __exit__(self, *exception):
+		self.close()
+
+	def __len__(self):
+		return self.count
+
+	def _find(self, serial_number):
+		bucket = bucket_of(serial_number, self.bits)
+		while True:
+			entry = self.index[bucket]
+			if entry == 0 or entry > self.count:
+				return bucket, None
+			offset = self.records_offset + (entry - 1) * self.record_size
+			if self.view[offset:offset + self.serial_number_size] == serial_number:
+				return bucket, offset
+			bucket = (bucket + 1) & self.mask
+
+	# Returns the key as a view into the mapping, valid until the store is
+	# closed and released before closing, or None
+	def lookup(self, serial_number):
+		_, offset = self._find(serial_number)
+		if offset is None:
+			return None
+		return self.view[offset + self.serial_number_size:offset + self.record_size]
+
+	def records(self):
+		for offset in range(self.records_offset, self.records_offset + self.count * self.record_size, self.record_size):
+			yield (bytes(self.view[offset:offset + self.serial_number_size]),
+					bytes(self.view[offset + self.serial_number_size:offset + self.record_size]))
+
+	# Adds the records in place, or rebuilds the store with a larger index
+	# when it would get more than 3/4 full. Returns the number of new records.
+	def append(self, records):
+		if not self.writable:
+			raise KeyStoreError("store is opened read only")
+		records = list(records)
+		if index_bits_for(self.count + len(records)) > self.bits:
+			return self._rebuild(records)
+
+		# Drop what an interrupted append left behind
+		for bucket in range(len(self.index)):
+			if self.index[bucket] > self.count:
+				self.index[bucket] = 0
+
+		self._unmap()
+		self.file.truncate(self.records_offset + (self.count + len(records)) * self.record_size)
+		self._map()
+
+		count = self.count
+		for serial_number, key in records:
+			self._check(serial_number, key)
+			bucket, offset = self._find_pending(serial_number, count)
+			if offset is None:
+				offset = self.records_offset + count * self.record_size
+				self.view[offset:offset + self.serial_number_size] = serial_number
+				count += 1
+				self.index[bucket] = count
+			self.view[offset + self.serial_number_size:offset + self.record_size] = key
+		self.map.flush()
+
+		added = count - self.count
+		self.count = count
+		struct.pack_into("<I", self.map, COUNT_OFFSET, count)
+		self.map.flush()
+		self._unmap()
+		self.file.truncate(self.records_offset + count * self.record_size)
+		self._map()
+		return added
+
+	# _find() including the records of the append in progress
+	def _find_pending(self, serial_number, count):
+		committed = self.count
+		self.count = count
+		try:
+			return self._find(serial_number)
+		finally:
+			self.count = committed
+
+	def _check(self, serial_number, key):
+		if len(serial_number) != self.serial_number_size or len(key) != self.key_size:
+			raise KeyStoreError("records have a %u byte serial number and a %u byte key"
+					% (self.serial_number_size, self.key_size))
+
+	def _rebuild(self, records):
+		count = self.count
+		directory = os.path.dirname(os.path.abspath(self.file_name))
+		handle, temporary = tempfile.mkstemp(dir=directory, suffix=".tmp")
+		os.close(handle)
+		os.chmod(temporary, os.stat(self.file_name).st_mode & 0o777)
+		try:
+			total = build(temporary, self.slot, self._merge(records), count + len(records),
+					self.serial_number_size, self.key_size)
+		except:
+			os.remove(temporary)
+			raise
+		self.close()
+		os.replace(temporary, self.file_name)
+		self.file = open(self.file_name, "r+b")
+		self._map()
+		return total - count
+
+	def _merge(self, records):
+		for record in self.records():
+			yield record
+		for record in records:
+			yield record
+
+# Writes a store for up to count records, the last key wins for duplicate
+# serial numbers. Returns the number of records stored.
+def build(file_name, slot, records, count, serial_number_size=9, key_size=32):
+	bits = index_bits_for(count)
+	with open(file_name, "wb") as output_file:
+		output_file.write(HEADER.pack(MAGIC, VERSION, slot, serial_number_size, key_size, 0, bits))
+		output_file.truncate(HEADER.size + (ENTRY_SIZE << bits))
+	with KeyStore(file_name, writable=True) as store:
+		store.append(records)
+		return len(store)
+
+def parse_serial_number(text):
+	serial_number = bytes.fromhex(text)
+	if len(serial_number) != 9:
+		raise ValueError("serial numbers have 9 bytes")
+	return serial_number
+
+def synthetic_records(count, seed=0):
+	# Random keys, the lookup cost does not depend on their value
+	for index in range(count):
+		yield bytes((0x01, 0x23)) + (index + seed).to_bytes(6, "big") + bytes((0xEE,)), os.urandom(32)
+
+def benchmark(counts, lookups, directory):
+	print("%10s %10s %10s %12s %12s %12s" % ("records", "size MB", "build s", "open ms", "lookups/s", "misses/s"))
+	for count in counts:
+		file_name = os.path.join(directory, "benchmark_%u.ksto" % count)
+		started = time.time()
+		build(file_name, 6, synthetic_records(count), count)
+		built = time.time() - started
+
+		started = time.time()
+		store = KeyStore(file_name)
+		opened = time.time() - started
+
+		step = max(1, count // lookups)
+		hits = [bytes((0x01, 0x23)) + (index * step % count).to_bytes(6, "big") + bytes((0xEE,)) for index in range(lookups)]
+		misses = [bytes((0x01, 0x23)) + (count + index).to_bytes(6, "big") + bytes((0xEE,)) for index in range(lookups)]
+		started = time.time()
+		for serial_number in hits:
+			if store.lookup(serial_number) is None:
+				raise KeyStoreError("%s not found" % serial_number.hex())
+		hit_rate = lookups / (time.time() - started)
+		started = time.time()
+		for serial_number in misses:
+			if store.lookup(serial_number) is not None:
+				raise KeyStoreError("%s found" % serial_number.hex())
+		miss_rate = lookups / (time.time() - started)
+
+		size = os.path.getsize(file_name)
+		store.close()
+		os.remove(file_name)
+		print("%10u %10.1f %10.1f %12.3f %12.0f %12.0f" % (count, size / 1e6, built, opened * 1e3, hit_rate, miss_rate))
+
+def main():
+	parser = argparse.ArgumentParser(description="This script builds and "
+			"queries memory mapped key stores, indexed by serial number, "
+			"from the key tables keygen.py writes.")
+	subparsers = parser.add_subparsers(dest="command")
+
+	build_parser = subparsers.add_parser("build", help="build a store from a key table")
+	build_parser.add_argument("table", help="key table")
+	build_parser.add_argument("-o", "--output", dest="store", default="keys.ksto",
+			help="store to write, default is keys.ksto")
+
+	append_parser = subparsers.add_parser("append", help="add the records of a key table to a store")
+	append_parser.add_argument("store", help="key store")
+	append_parser.add_argument("table", help="key table")
+
+	lookup_parser = subparsers.add_parser("lookup", help="print the keys of serial numbers")
+	lookup_parser.add_argument("store", help="key store")
+	lookup_parser.add_argument("serial_numbers", nargs="+", metavar="SN", help="serial number as 18 hex digits")
+
+	benchmark_parser = subparsers.add_parser("benchmark", help="time opening and lookups of synthetic stores")
+	benchmark_parser.add_argument("--counts", dest="counts", default="1000000,10000000",
+			help="comma separated store sizes, default is 1000000,10000000")
+	benchmark_parser.add_argument("--lookups", dest="lookups", type=int, default=200000,
+			help="lookups per size, default is 200000")
+	benchmark_parser.add_argument("--directory", dest="directory", default=tempfile.gettempdir(),
+			help="where to put the stores")
+
+	arguments = parser.parse_args()
+
+	try:
+		if arguments.command == "build":
+			slot, records = key_table.read(arguments.table)
+			count = build(arguments.store, slot, records, len(records))
+			print("%u records written to %s" % (count, arguments.store))
+		elif arguments.command == "append":
+			slot, records = key_table.read(arguments.table)
+			with KeyStore(arguments.store, writable=True) as store:
+				if slot != store.slot:
+					raise KeyStoreError("the table is for slot %u, the store for slot %u" % (slot, store.slot))
+				added = store.append(records)
+				print("%u records added, %u in %s" % (added, len(store), arguments.store))
+		elif arguments.command == "lookup":
+			with KeyStore(arguments.store) as store:
+				for text in arguments.serial_numbers:
+					key = store.lookup(parse_serial_number(text))
+					print("%s %s" % (text, key.hex() if key is not None else "not found"))
+					if key is not None:
+						key.release()
+		elif arguments.command == "benchmark":
+			benchmark([int(count) for count in arguments.counts.split(",")], arguments.lookups, arguments.directory)
+		else:
+			parser.print_usage()
+	except (IOError, ValueError, key_table.KeyTableError, KeyStoreError) as e:
+		print("error: %s" % (str(e)))
+		sys.exit(1)
+
+if __name__ == "__main__":
+	main()
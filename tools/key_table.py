@@ -0,0 +1,76 @@
+##
+# \file
+#
+# \brief Binary table of diversified keys sorted by serial number
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# Layout, all multi byte fields little endian:
+#
+#   magic "KTBL", version (1 byte), key slot (1 byte), serial number size
+#   (1 byte), key size (1 byte), record count (4 bytes), CRC-32 of the
+#   records (4 bytes)
+#   records: serial number, key, sorted by serial number without duplicates
+#
+# Fixed size sorted records let a reader find a board by binary search
+# without loading the table.
+import struct
+import zlib
+
+MAGIC = b"KTBL"
+VERSION = 1
+HEADER = struct.Struct("<4sBBBBII")
+
+class KeyTableError(Exception):
+	pass
+
+def write(file_name, slot, records, serial_number_size=9, key_size=32):
+	records = sorted(dict(records).items())
+	body = b"".join(serial_number + key for serial_number, key in records)
+	with open(file_name, "wb") as output_file:
+		output_file.write(HEADER.pack(MAGIC, VERSION, slot, serial_number_size, key_size,
+				len(records), zlib.crc32(body) & 0xFFFFFFFF))
+		output_file.write(body)
+	return len(records)
+
+def read_header(data):
+	if len(data) < HEADER.size:
+		raise KeyTableError("truncated header")
+	magic, version, slot, serial_number_size, key_size, count, crc = HEADER.unpack_from(data)
+	if magic != MAGIC or version != VERSION:
+		raise KeyTableError("not a version %u key table" % VERSION)
+	if len(data) < HEADER.size + count * (serial_number_size + key_size):
+		raise KeyTableError("truncated records")
+	return slot, serial_number_size, key_size, count, crc
+
+def read(file_name, check_crc=True):
+	with open(file_name, "rb") as input_file:
+		data = input_file.read()
+	slot, serial_number_size, key_size, count, crc = read_header(data)
+	record_size = serial_number_size + key_size
+	body = data[HEADER.size:HEADER.size + count * record_size]
+	if check_crc and zlib.crc32(body) & 0xFFFFFFFF != crc:
+		raise KeyTableError("CRC mismatch")
+	return slot, [(body[offset:offset + serial_number_size], body[offset + serial_number_size:offset + record_size])
+			for offset in range(0, len(body), record_size)]
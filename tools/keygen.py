@@ -0,0 +1,219 @@
+##
+# \file
+#
+# \brief Derive the diversified keys of a batch of serial numbers in parallel
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# Every key is the DeriveKey result of device_provision(): SHA-256 over the
+# master key, the command parameters, the serial number and a TempKey of the
+# serial number padded with zeros. Serial numbers are read as 18 hex digits
+# per line, or generated, and split into chunks for a pool of worker
+# processes. hashlib holds the interpreter lock for messages this short, so
+# processes scale where threads would not. The keys go to a key table, see
+# key_table.py.
+#
+# --crosscheck compiles atcah_derive_key() of the cryptoauthlib submodule on
+# the host and compares it with this derivation for random serial numbers.
+import os
+import sys
+import time
+import ctypes
+import argparse
+import tempfile
+import subprocess
+import multiprocessing
+
+import atca_host
+import key_table
+
+CHUNK_SIZE = 4096
+
+CRYPTOAUTHLIB_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+		"..", "firmware", "samd21", "src", "cryptoauthlib")
+
+# Same parameters as device_provision()
+CROSSCHECK_SOURCE = r"""
+#include <string.h>
+#include "cryptoauthlib.h"
+#include "host/atca_host.h"
+
+int derive(const uint8_t *parent_key, const uint8_t *sn, uint16_t slot, uint8_t *key)
+{
+    atca_temp_key_t temp_key;
+    struct atca_derive_key_in_out params;
+
+    memset(&temp_key, 0, sizeof(temp_key));
+    temp_key.valid = 1;
+    memcpy(temp_key.value, sn, ATCA_SERIAL_NUM_SIZE);
+
+    params.mode = 0;
+    params.target_key_id = slot;
+    params.parent_key = parent_key;
+    params.sn = sn;
+    params.target_key = key;
+    params.temp_key = &temp_key;
+
+    return atcah_derive_key(&params);
+}
+"""
+
+CROSSCHECK_FILES = ("lib/host/atca_host.c", "lib/crypto/atca_crypto_sw_sha2.c",
+		"lib/crypto/hashes/sha2_routines.c")
+
+def derive_chunk(arguments):
+	master_key, slot, serial_numbers = arguments
+	return b"".join(atca_host.derive_key(master_key, serial_numbers[offset:offset + atca_host.SERIAL_NUMBER_SIZE], slot)
+			for offset in range(0, len(serial_numbers), atca_host.SERIAL_NUMBER_SIZE))
+
+def derive_keys(master_key, slot, serial_numbers, workers):
+	size = atca_host.SERIAL_NUMBER_SIZE
+	chunks = [(master_key, slot, b"".join(serial_numbers[start:start + CHUNK_SIZE]))
+			for start in range(0, len(serial_numbers), CHUNK_SIZE)]
+	if workers == 1:
+		results = map(derive_chunk, chunks)
+	else:
+		pool = multiprocessing.Pool(workers)
+		results = pool.map(derive_chunk, chunks)
+		pool.close()
+		pool.join()
+	keys = []
+	for (_, _, chunk), result in zip(chunks, results):
+		for index in range(len(chunk) // size):
+			keys.append((chunk[index * size:(index + 1) * size],
+					result[index * atca_host.KEY_SIZE:(index + 1) * atca_host.KEY_SIZE]))
+	return keys
+
+def read_serial_numbers(input_file):
+	serial_numbers = []
+	for number, line in enumerate(input_file, 1):
+		line = line.split("#")[0].strip()
+		if not line:
+			continue
+		serial_number = bytes.fromhex(line)
+		if len(serial_number) != atca_host.SERIAL_NUMBER_SIZE:
+			raise ValueError("line %u: serial numbers have %u bytes" % (number, atca_host.SERIAL_NUMBER_SIZE))
+		serial_numbers.append(serial_number)
+	return serial_numbers
+
+def generate_serial_numbers(count):
+	# SN[0:1] and SN[8] are fixed on CryptoAuth devices
+	return [bytes((0x01, 0x23)) + index.to_bytes(6, "big") + bytes((0xEE,)) for index in range(count)]
+
+def benchmark(master_key, slot, count, max_workers):
+	serial_numbers = generate_serial_numbers(count)
+	base = None
+	for workers in range(1, max_workers + 1):
+		started = time.time()
+		derive_keys(master_key, slot, serial_numbers, workers)
+		elapsed = time.time() - started
+		base = base or elapsed
+		print("%2u workers: %8.0f keys/s, speedup %.2f" % (workers, count / elapsed, base / elapsed))
+
+def crosscheck(master_key, slot, directory, count):
+	directory = os.path.abspath(directory)
+	sources = [os.path.join(directory, file_name) for file_name in CROSSCHECK_FILES]
+	missing = [source for source in sources if not os.path.exists(source)]
+	if missing:
+		raise IOError("%s not found, is the cryptoauthlib submodule checked out?" % missing[0])
+
+	build = tempfile.mkdtemp()
+	harness = os.path.join(build, "crosscheck.c")
+	library = os.path.join(build, "crosscheck.so")
+	with open(harness, "w") as output_file:
+		output_file.write(CROSSCHECK_SOURCE)
+	subprocess.check_call(["cc", "-shared", "-fPIC", "-O2", "-DATCA_HAL_I2C", "-I" + os.path.join(directory, "lib"),
+			"-o", library, harness] + sources)
+
+	derive = ctypes.CDLL(library).derive
+	derive.argtypes = (ctypes.c_char_p, ctypes.c_char_p, ctypes.c_uint16, ctypes.c_char_p)
+	key = ctypes.create_string_buffer(atca_host.KEY_SIZE)
+	for _ in range(count):
+		serial_number = bytes((0x01, 0x23)) + os.urandom(6) + bytes((0xEE,))
+		if derive(master_key, serial_number, slot, key) != 0:
+			raise ValueError("atcah_derive_key() failed")
+		if key.raw != atca_host.derive_key(master_key, serial_number, slot):
+			raise ValueError("keys differ for %s" % serial_number.hex())
+	print("%u keys match atcah_derive_key()" % count)
+
+def main():
+	parser = argparse.ArgumentParser(description="This script derives the "
+			"diversified keys device_provision() writes, for a batch of "
+			"serial numbers, in a pool of worker processes, and writes "
+			"them to a key table sorted by serial number.")
+	parser.add_argument("input", nargs="?", metavar="SERIALS",
+			help="file with one serial number per line as 18 hex digits, - for stdin")
+	parser.add_argument("-o", "--output", dest="output", default="keys.ktbl",
+			help="key table to write, default is keys.ktbl")
+	parser.add_argument("-g", "--generate", dest="generate", type=int, default=0,
+			metavar="COUNT", help="derive keys for COUNT generated serial numbers")
+	parser.add_argument("-j", "--jobs", dest="workers", type=int,
+			default=multiprocessing.cpu_count(), help="worker processes, default is one per CPU")
+	parser.add_argument("-s", "--slot", dest="slot", type=int, default=atca_host.AUTH_KEY_SLOT,
+			help="key slot, default is %u" % atca_host.AUTH_KEY_SLOT)
+	parser.add_argument("-k", "--master-key", dest="master_key",
+			help="master key as 64 hex digits, default is the demo key of main.c")
+	parser.add_argument("--benchmark", dest="benchmark", type=int, default=0, metavar="COUNT",
+			help="time COUNT derivations with 1 to JOBS workers and exit")
+	parser.add_argument("--crosscheck", dest="crosscheck", type=int, default=0, metavar="COUNT",
+			help="compare COUNT keys with atcah_derive_key() compiled on the host and exit")
+	parser.add_argument("--cryptoauthlib", dest="cryptoauthlib", default=CRYPTOAUTHLIB_DIR,
+			help="cryptoauthlib source tree for --crosscheck")
+
+	arguments = parser.parse_args()
+
+	try:
+		master_key = bytes.fromhex(arguments.master_key) if arguments.master_key else atca_host.MASTER_KEY
+		if len(master_key) != atca_host.KEY_SIZE:
+			raise ValueError("the master key has %u bytes" % atca_host.KEY_SIZE)
+
+		if arguments.benchmark:
+			benchmark(master_key, arguments.slot, arguments.benchmark, arguments.workers)
+			return
+		if arguments.crosscheck:
+			crosscheck(master_key, arguments.slot, arguments.cryptoauthlib, arguments.crosscheck)
+			return
+
+		if arguments.generate:
+			serial_numbers = generate_serial_numbers(arguments.generate)
+		elif arguments.input == "-":
+			serial_numbers = read_serial_numbers(sys.stdin)
+		elif arguments.input:
+			with open(arguments.input) as input_file:
+				serial_numbers = read_serial_numbers(input_file)
+		else:
+			parser.print_usage()
+			sys.exit()
+
+		started = time.time()
+		keys = derive_keys(master_key, arguments.slot, serial_numbers, arguments.workers)
+		count = key_table.write(arguments.output, arguments.slot, keys)
+	except (IOError, ValueError, subprocess.CalledProcessError) as e:
+		print("error: %s" % (str(e)))
+		sys.exit(1)
+
+	print("%u keys written to %s in %.2f s" % (count, arguments.output, time.time() - started))
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,223 @@
+##
+# \file
+#
+# \brief Verify batches of device MAC responses with multi-buffer SHA-256
+#
+# \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+#
+# \page License
+#
+# Subject to your compliance with these terms, you may use Microchip software
+# and any derivatives exclusively with Microchip products. It is your
+# responsibility to comply with third party license terms applicable to your
+# use of third party software (including open source software) that may
+# accompany Microchip software.
+#
+# THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+# EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+# WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+# PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+# SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+# OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+# MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+# FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+# LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+# THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+# THIS SOFTWARE.
+#
+#
+# A verifier checks that a board answered its challenge with the MAC that
+# symmetric_authenticate() makes the device calculate: SHA-256 over the
+# diversified key, the TempKey of the Nonce command and the command
+# parameters. sha256_mb.c hashes batches of these messages in SIMD lanes or
+# with the SHA extensions, picked at load time from CPUID; this module
+# builds it with the host compiler and wraps it with ctypes.
+#
+# --selftest compares every path the CPU runs with hashlib and atca_host.py,
+# --benchmark measures MACs per second on each of them.
+import os
+import sys
+import time
+import ctypes
+import hashlib
+import argparse
+import tempfile
+import subprocess
+
+import atca_host
+
+SOURCE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "sha256_mb.c")
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "sha256_mb.h")
+
+PATH_AUTO = 0
+PATHS = {1: "scalar", 2: "sse2x4", 3: "avx2x8", 4: "sha-ni"}
+
+class MacVerifyError(Exception):
+	pass
+
+def build(compiler="cc"):
+	# One build per version of the source, shared by all users of the machine's temp directory
+	sources = hashlib.sha256()
+	for file_name in (SOURCE, HEADER):
+		with open(file_name, "rb") as source_file:
+			sources.update(source_file.read())
+	digest = sources.hexdigest()[:16]
+	library = os.path.join(tempfile.gettempdir(), "sha256_mb_%s.so" % digest)
+	if not os.path.exists(library):
+		partial = "%s.%u" % (library, os.getpid())
+		try:
+			subprocess.check_call([compiler, "-O2", "-shared", "-fPIC", "-o", partial, SOURCE])
+		except (OSError, subprocess.CalledProcessError) as e:
+			raise MacVerifyError("cannot build %s: %s" % (SOURCE, e))
+		os.replace(partial, library)
+	return library
+
+class MacVerifier(object):
+	def __init__(self, path=PATH_AUTO, library=None):
+		self.library = ctypes.CDLL(library or build())
+		self.library.sha256_mb_select.argtypes = (ctypes.c_int,)
+		self.library.sha256_mb_supported.argtypes = (ctypes.c_int,)
+		self.library.sha256_mb_hash.argtypes = (ctypes.c_char_p, ctypes.c_size_t, ctypes.c_size_t, ctypes.c_char_p)
+		self.library.sha256_mb_hash.restype = None
+		self.library.derive_key_batch.argtypes = (ctypes.c_size_t, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_uint16, ctypes.c_char_p)
+		self.library.derive_key_batch.restype = None
+		self.library.nonce_batch.argtypes = (ctypes.c_size_t, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p)
+		self.library.nonce_batch.restype = None
+		self.library.mac_batch.argtypes = (ctypes.c_size_t, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p,
+				ctypes.c_uint16, ctypes.c_char_p)
+		self.library.mac_batch.restype = None
+		self.library.mac_verify_batch.argtypes = (ctypes.c_size_t, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p,
+				ctypes.c_uint16, ctypes.c_char_p, ctypes.c_char_p)
+		self.library.mac_verify_batch.restype = ctypes.c_size_t
+		self.select(path)
+
+	# The path is a process wide setting of the library
+	def select(self, path):
+		selected = self.library.sha256_mb_select(path)
+		if selected < 0:
+			raise MacVerifyError("the CPU does not run the %s path" % PATHS.get(path, str(path)))
+		self.path = selected
+		return PATHS[selected]
+
+	def supported(self):
+		return [path for path in sorted(PATHS) if self.library.sha256_mb_supported(path)]
+
+	def sha256(self, messages):
+		size = len(messages[0]) if messages else 0
+		if any(len(message) != size for message in messages):
+			raise MacVerifyError("messages of a batch have the same length")
+		digests = ctypes.create_string_buffer(32 * len(messages))
+		self.library.sha256_mb_hash(b"".join(messages), size, len(messages), digests)
+		return [digests.raw[offset:offset + 32] for offset in range(0, len(digests.raw), 32)]
+
+	def derive_keys(self, parent_key, serial_numbers, slot=atca_host.AUTH_KEY_SLOT):
+		keys = ctypes.create_string_buffer(32 * len(serial_numbers))
+		self.library.derive_key_batch(len(serial_numbers), parent_key, b"".join(serial_numbers), slot, keys)
+		return [keys.raw[offset:offset + 32] for offset in range(0, len(keys.raw), 32)]
+
+	def nonces(self, rand_outs, num_ins):
+		temp_keys = ctypes.create_string_buffer(32 * len(rand_outs))
+		self.library.nonce_batch(len(rand_outs), b"".join(rand_outs), b"".join(num_ins), temp_keys)
+		return [temp_keys.raw[offset:offset + 32] for offset in range(0, len(temp_keys.raw), 32)]
+
+	def macs(self, keys, temp_keys, serial_numbers, slot=atca_host.AUTH_KEY_SLOT):
+		macs = ctypes.create_string_buffer(32 * len(keys))
+		self.library.mac_batch(len(keys), b"".join(keys), b"".join(temp_keys), b"".join(serial_numbers), slot, macs)
+		return [macs.raw[offset:offset + 32] for offset in range(0, len(macs.raw), 32)]
+
+	# Returns one bool per response
+	def verify(self, keys, temp_keys, serial_numbers, responses, slot=atca_host.AUTH_KEY_SLOT):
+		count = len(keys)
+		if not len(temp_keys) == len(serial_numbers) == len(responses) == count:
+			raise MacVerifyError("one key, TempKey, serial number and response per board")
+		results = ctypes.create_string_buffer(count)
+		self.library.mac_verify_batch(count, b"".join(keys), b"".join(temp_keys), b"".join(serial_numbers), slot,
+				b"".join(responses), results)
+		return [result == 1 for result in results.raw]
+
+def random_boards(count):
+	serial_numbers = [bytes((0x01, 0x23)) + os.urandom(6) + bytes((0xEE,)) for _ in range(count)]
+	keys = [atca_host.derive_key(atca_host.MASTER_KEY, serial_number) for serial_number in serial_numbers]
+	rand_outs = [os.urandom(32) for _ in range(count)]
+	num_ins = [os.urandom(atca_host.NUM_IN_SIZE) for _ in range(count)]
+	return serial_numbers, keys, rand_outs, num_ins
+
+def selftest(verifier):
+	serial_numbers, keys, rand_outs, num_ins = random_boards(37)
+	temp_keys = [atca_host.nonce_temp_key(rand_out, num_in) for rand_out, num_in in zip(rand_outs, num_ins)]
+	macs = [atca_host.mac_temp_key(key, temp_key, serial_number)
+			for key, temp_key, serial_number in zip(keys, temp_keys, serial_numbers)]
+
+	for path in verifier.supported():
+		name = verifier.select(path)
+		# Every padding case, and batches that leave lanes unused
+		for size in range(0, 200):
+			for count in (1, 3, 8, 13):
+				messages = [os.urandom(size) for _ in range(count)]
+				if verifier.sha256(messages) != [hashlib.sha256(message).digest() for message in messages]:
+					raise MacVerifyError("%s: SHA-256 of %u byte messages differs from hashlib" % (name, size))
+		for count in range(1, len(keys) + 1):
+			if verifier.derive_keys(atca_host.MASTER_KEY, serial_numbers[:count]) != keys[:count]:
+				raise MacVerifyError("%s: key differs from atca_host.derive_key()" % name)
+			if verifier.nonces(rand_outs[:count], num_ins[:count]) != temp_keys[:count]:
+				raise MacVerifyError("%s: TempKey differs from atca_host.nonce_temp_key()" % name)
+			if verifier.macs(keys[:count], temp_keys[:count], serial_numbers[:count]) != macs[:count]:
+				raise MacVerifyError("%s: MAC differs from atca_host.mac_temp_key()" % name)
+		responses = list(macs)
+		responses[5] = bytes((responses[5][0] ^ 0x01,)) + responses[5][1:]
+		if verifier.verify(keys, temp_keys, serial_numbers, responses) != [index != 5 for index in range(len(keys))]:
+			raise MacVerifyError("%s: wrong verification results" % name)
+		print("%s: ok" % name)
+	verifier.select(PATH_AUTO)
+
+def benchmark(verifier, count, rounds):
+	serial_numbers, keys, rand_outs, num_ins = random_boards(count)
+	temp_keys = [atca_host.nonce_temp_key(rand_out, num_in) for rand_out, num_in in zip(rand_outs, num_ins)]
+	responses = [atca_host.mac_temp_key(key, temp_key, serial_number)
+			for key, temp_key, serial_number in zip(keys, temp_keys, serial_numbers)]
+
+	started = time.time()
+	for _ in range(rounds):
+		for key, temp_key, serial_number, response in zip(keys, temp_keys, serial_numbers, responses):
+			atca_host.mac_temp_key(key, temp_key, serial_number) == response
+	print("%-8s %10.0f MACs/s" % ("hashlib", count * rounds / (time.time() - started)))
+
+	# The buffers are joined once, as a verifier reading them from a socket would have them
+	arguments = [b"".join(keys), b"".join(temp_keys), b"".join(serial_numbers), atca_host.AUTH_KEY_SLOT, b"".join(responses)]
+	results = ctypes.create_string_buffer(count)
+	for path in verifier.supported():
+		name = verifier.select(path)
+		started = time.time()
+		for _ in range(rounds):
+			if verifier.library.mac_verify_batch(count, *(arguments + [results])) != count:
+				raise MacVerifyError("%s: responses did not verify" % name)
+		print("%-8s %10.0f MACs/s" % (name, count * rounds / (time.time() - started)))
+	verifier.select(PATH_AUTO)
+
+def main():
+	parser = argparse.ArgumentParser(description="This script checks the "
+			"multi-buffer SHA-256 library the verifier uses against the "
+			"firmware's MAC calculation and measures its throughput on each "
+			"instruction set path the CPU runs.")
+	parser.add_argument("--selftest", dest="selftest", action="store_true",
+			help="compare every path with hashlib and atca_host.py")
+	parser.add_argument("--benchmark", dest="benchmark", type=int, default=0, metavar="COUNT",
+			help="verify batches of COUNT responses on every path")
+	parser.add_argument("--rounds", dest="rounds", type=int, default=20,
+			help="batches per path for --benchmark, default is 20")
+
+	arguments = parser.parse_args()
+
+	try:
+		verifier = MacVerifier()
+		print("paths: %s, selected %s" % (", ".join(PATHS[path] for path in verifier.supported()), PATHS[verifier.path]))
+		if arguments.selftest:
+			selftest(verifier)
+		if arguments.benchmark:
+			benchmark(verifier, arguments.benchmark, arguments.rounds)
+	except MacVerifyError as e:
+		print("error: %s" % (str(e)))
+		sys.exit(1)
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,308 @@
+/**
+ * \file
+ * \brief  Measures the bytes copied and the stack used per command by the packet path of hal_i2c_dma.c
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux x86-64 with
+ *
+ *   S=../firmware/samd21/src D=$S/ASF/sam0/drivers
+ *   cc -O2 -no-pie -Wno-pointer-to-int-cast -D__SAMD21J18A__ -DBOARD=SAMD21_XPLAINED_PRO \
+ *      -DI2C_MASTER_CALLBACK_MODE=false \
+ *      -Ihost/sam -Ihost/cryptoauthlib -I$S -I$S/config -I$S/ASF/common/boards -I$S/ASF/sam0/boards \
+ *      -I$S/ASF/sam0/boards/samd21_xplained_pro -I$S/ASF/sam0/utils -I$S/ASF/sam0/utils/header_files \
+ *      -I$S/ASF/sam0/utils/preprocessor -I$S/ASF/sam0/utils/cmsis/samd21/include \
+ *      -I$S/ASF/sam0/utils/cmsis/samd21/source -I$S/ASF/thirdparty/CMSIS/Include \
+ *      -I$D/sercom -I$D/sercom/i2c -I$D/port -I$D/system -I$D/system/pinmux -I$D/system/clock \
+ *      -I$D/system/clock/clock_samd21_r21_da -I$D/system/interrupt \
+ *      -I$D/system/interrupt/system_interrupt_samd21 -I$D/system/power/power_sam_d_r \
+ *      -I$D/system/reset/reset_sam_d_r -I$S/ASF/common/utils \
+ *      -o packet_path_check packet_path_check.c host/i2c_sim.c host/reg_trap.c \
+ *      host/cryptoauthlib/cryptoauthlib_sim.c $S/hal_i2c_dma.c $S/cmd_timing.c \
+ *      $D/sercom/i2c/i2c_sam0/i2c_master.c $D/sercom/sercom.c $D/sercom/sercom_interrupt.c
+ *
+ * hal_i2c_dma.c runs unchanged on the bus model of host/i2c_sim.c, with
+ * host/cryptoauthlib standing in for the library, which is not part of this
+ * tree. Each command is built in an ATCAPacket as the command layer of
+ * cryptoauthlib builds it and goes through hal_i2c_wake(), hal_i2c_send(),
+ * the polling of hal_i2c_receive() and hal_i2c_idle(), offering the whole
+ * ATCAPacket data buffer for the response like atca_execute_command().
+ *
+ * For every command it counts the bytes the DMAC and the CPU moved from the
+ * send to the response, the wake and idle left out, and the bytes of the
+ * caller buffer written, against the size offered. The command has to be
+ * sent from the packet itself, with the word address in its reserved byte,
+ * and the response read straight into the caller buffer, nothing past the
+ * count it announces, with no byte moved by the CPU. The stack column is
+ * the high-water mark of the whole command on the host, the ATCAPacket of
+ * the tool included; it compares commands with each other, not with the
+ * Cortex-M0+.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include "host/reg_trap.h"
+#include "host/i2c_sim.h"
+
+//glibc defines these as well, the ASF definitions win for the firmware code
+#undef __always_inline
+#undef LITTLE_ENDIAN
+#include "hal_i2c_dma.h"
+
+#define CHECK_GUARD             0x5C
+#define CHECK_CRC_SIZE          2
+
+typedef struct
+{
+    const char *name;
+    uint8_t opcode;
+    uint8_t param1;
+    uint16_t param2;
+    uint8_t data_length;        //Command data between param2 and the CRC
+    uint8_t response_length;    //Count byte, data and CRC
+} check_command;
+
+typedef struct
+{
+    uint32_t baud;
+    uint32_t failures;
+    struct atca_iface iface;
+    const check_command *command;
+    ATCA_STATUS status;
+    bool in_place;              //The word address went into the reserved byte of the packet
+    uint32_t dma_beats;         //Bytes the DMAC moved from the send to the response
+    uint32_t polled_bytes;      //Bytes the CPU moved through DATA in that time
+    uint16_t buffer_written;    //Bytes of the caller buffer that differ from the guard
+} check_context;
+
+//The commands of the firmware in the order symmetric_authenticate() and provisioning use them
+static const check_command g_commands[] =
+{
+    { "Info",                 ATCA_INFO,   0x00,        0x0000, 0,                7 },
+    { "Read config word",     ATCA_READ,   0x00,        0x0015, 0,                7 },
+    { "Read serial number",   ATCA_READ,   0x80,        0x0000, 0,                35 },
+    { "Random",               ATCA_RANDOM, 0x00,        0x0000, 0,                35 },
+    { "Nonce",                ATCA_NONCE,  0x00,        0x0000, NONCE_NUMIN_SIZE, 35 },
+    { "MAC on TempKey",       ATCA_MAC,    0x01,        0x0000, 0,                35 },
+    { "MAC with challenge",   ATCA_MAC,    0x00,        0x0000, ATCA_KEY_SIZE,    35 },
+};
+
+static void print_usage(const char *name)
+{
+    printf("Usage: %s [-b baud]\n", name);
+    printf("  -b  I2C clock of the HAL, 100000 to 1000000 (default 400000)\n");
+}
+
+static bool check_fail(check_context *context, const char *reason)
+{
+    printf("%-20s FAIL %s\n", context->command->name, reason);
+    context->failures++;
+    return false;
+}
+
+//Function to build a command like the command layer of cryptoauthlib, the CRC behind the data
+static void check_build(const check_command *command, ATCAPacket *packet)
+{
+    uint8_t length;
+
+    memset(packet, CHECK_GUARD, sizeof(*packet));
+    packet->txsize = (uint8_t)(ATCA_CMD_SIZE_MIN + command->data_length);
+    packet->opcode = command->opcode;
+    packet->param1 = command->param1;
+    packet->param2 = command->param2;
+    memset(packet->data, 0x33, command->data_length);
+
+    length = packet->txsize - CHECK_CRC_SIZE;
+    atCRC(length, &packet->txsize, &packet->txsize + length);
+}
+
+//Function to run one command through the HAL like atca_execute_command(), on the stack of i2c_sim_call()
+static void check_run(void *argument)
+{
+    check_context *context = argument;
+    uint32_t max_delay_count = ATCA_POLLING_MAX_TIME_MSEC / ATCA_POLLING_FREQUENCY_TIME_MSEC;
+    const i2c_sim_stats *stats = i2c_sim_get_stats();
+    ATCAPacket packet;
+    uint16_t rxsize;
+    uint16_t i;
+
+    check_build(context->command, &packet);
+    context->in_place = false;
+    context->buffer_written = 0;
+    context->dma_beats = 0;
+    context->polled_bytes = 0;
+
+    do
+    {
+        if ((context->status = hal_i2c_wake(&context->iface)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+        context->dma_beats = stats->dma_beats;
+        context->polled_bytes = stats->polled_bytes;
+        if ((context->status = hal_i2c_send(&context->iface, (uint8_t*)&packet, packet.txsize)) != ATCA_SUCCESS)
+        {
+            break;
+        }
+        context->in_place = (packet._reserved == 0x03);
+
+        atca_delay_ms(ATCA_POLLING_INIT_TIME_MSEC);
+        do
+        {
+            //The guard shows which bytes the HAL wrote, where atca_execute_command() clears the buffer
+            memset(packet.data, CHECK_GUARD, sizeof(packet.data));
+            rxsize = sizeof(packet.data);
+            if ((context->status = hal_i2c_receive(&context->iface, packet.data, &rxsize)) == ATCA_SUCCESS)
+            {
+                break;
+            }
+            atca_delay_ms(ATCA_POLLING_FREQUENCY_TIME_MSEC);
+        }
+        while (max_delay_count-- > 0);
+        context->dma_beats = stats->dma_beats - context->dma_beats;
+        context->polled_bytes = stats->polled_bytes - context->polled_bytes;
+    }
+    while (0);
+    hal_i2c_idle(&context->iface);
+
+    for (i = 0; i < sizeof(packet.data); i++)
+    {
+        if (packet.data[i] != CHECK_GUARD)
+        {
+            context->buffer_written = i + 1;
+        }
+    }
+}
+
+static void check_init(void *argument)
+{
+    check_context *context = argument;
+    ATCAHAL_t hal;
+
+    if (hal_i2c_init(&hal, context->iface.mIfaceCFG) != ATCA_SUCCESS)
+    {
+        context->status = ATCA_COMM_FAIL;
+        return;
+    }
+    context->iface.hal_data = hal.hal_data;
+    context->status = hal_i2c_post_init(&context->iface);
+}
+
+static void check_release(void *argument)
+{
+    check_context *context = argument;
+
+    hal_i2c_release(context->iface.hal_data);
+}
+
+int main(int argc, char **argv)
+{
+    check_context context = { .baud = 400000, .failures = 0 };
+    ATCAIfaceCfg cfg = cfg_ateccx08a_i2c_default;
+    i2c_sim_device_config config;
+    const i2c_sim_stats *stats = i2c_sim_get_stats();
+    const i2c_sim_device *device;
+    uint32_t dma_beats;
+    uint32_t polled_bytes;
+    size_t stack;
+    int option;
+    uint8_t i;
+
+    while ((option = getopt(argc, argv, "b:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'b': context.baud = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+    if (context.baud < 100000 || context.baud > 1000000)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    i2c_sim_init();
+    i2c_sim_default_config(&config, 0xC0, ATECC608A);
+    i2c_sim_add_device(&config);
+    device = i2c_sim_get_device(0);
+    cfg.devtype = ATECC608A;
+    cfg.atcai2c.baud = context.baud;
+    context.iface.mIfaceCFG = &cfg;
+    context.command = &g_commands[0];
+    i2c_sim_call(check_init, &context);
+    if (context.status != ATCA_SUCCESS)
+    {
+        check_fail(&context, "init failed");
+        return 1;
+    }
+
+    printf("I2C at %lu Hz, %u byte response buffer offered\n\n", (unsigned long)context.baud,
+           (unsigned)sizeof(((ATCAPacket*)NULL)->data));
+    printf("%-20s %6s %6s | %6s %6s %6s | %6s\n", "command", "sent", "resp", "DMA", "CPU", "buffer", "stack");
+    for (i = 0; i < sizeof(g_commands) / sizeof(g_commands[0]); i++)
+    {
+        context.command = &g_commands[i];
+        stack = i2c_sim_call(check_run, &context);
+        dma_beats = context.dma_beats;
+        polled_bytes = context.polled_bytes;
+
+        printf("%-20s %6u %6u | %6u %6u %6u | %6lu\n", context.command->name,
+               ATCA_CMD_SIZE_MIN + context.command->data_length + 1, context.command->response_length, dma_beats,
+               polled_bytes, context.buffer_written, (unsigned long)stack);
+
+        if (context.status != ATCA_SUCCESS)
+        {
+            check_fail(&context, "command failed");
+        }
+        else if (!context.in_place)
+        {
+            check_fail(&context, "word address not in the reserved byte of the packet");
+        }
+        else if (polled_bytes != 0 ||
+                 dma_beats != (uint32_t)(ATCA_CMD_SIZE_MIN + context.command->data_length + 1 +
+                                         context.command->response_length))
+        {
+            check_fail(&context, "bytes not moved by the DMAC from and to the packet");
+        }
+        else if (context.buffer_written != context.command->response_length)
+        {
+            check_fail(&context, "caller buffer written past the response");
+        }
+    }
+    i2c_sim_call(check_release, &context);
+
+    if (device->bad_packets != 0)
+    {
+        context.failures++;
+    }
+    context.failures += stats->errors;
+    printf("\n%lu register accesses trapped, %u failed\n", (unsigned long)reg_trap_accesses(), context.failures);
+    return (context.failures == 0) ? 0 : 1;
+}
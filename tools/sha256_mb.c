@@ -0,0 +1,538 @@
+/**
+ * \file
+ * \brief  Multi-buffer SHA-256 for verifying batches of device MAC responses
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Host library of mac_verify.py and fleet_verifier.c, built with
+ *
+ *   cc -O2 -shared -fPIC -o sha256_mb.so sha256_mb.c
+ *
+ * The MAC of symmetric_authenticate() is SHA-256 over an 88 byte message
+ * and the TempKey of the Nonce command before it SHA-256 over 55 bytes.
+ * Messages of the same length are hashed in lanes: 8 per AVX2 register, 4
+ * per SSE2 register, or one at a time with the SHA extensions or in plain
+ * C. The path is selected from CPUID when the library is loaded and can be
+ * forced with sha256_mb_select().
+ */
+
+
+#include <string.h>
+#include "sha256_mb.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#include <cpuid.h>
+#define SHA256_MB_X86
+#endif
+
+#define SHA256_BLOCK_SIZE           64
+#define SHA256_MB_MAX_LANES         8
+
+#define DERIVE_KEY_MESSAGE_SIZE     96
+#define MAC_MESSAGE_SIZE            88
+#define NONCE_MESSAGE_SIZE          55
+#define MAC_BATCH_SIZE              64
+
+#define OPCODE_DERIVE_KEY           0x1C
+#define OPCODE_MAC                  0x08
+#define OPCODE_NONCE                0x16
+#define MAC_MODE_BLOCK2_TEMPKEY     0x01
+
+typedef void (*sha256_mb_compress)(uint32_t *state, const uint8_t *const *blocks);
+
+struct sha256_mb_path
+{
+    const char *name;
+    size_t lanes;
+    sha256_mb_compress compress;
+};
+
+static const uint32_t sha256_k[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t sha256_init[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static void compress_scalar(uint32_t *state, const uint8_t *const *blocks);
+#ifdef SHA256_MB_X86
+static void compress_sse2(uint32_t *state, const uint8_t *const *blocks);
+static void compress_avx2(uint32_t *state, const uint8_t *const *blocks);
+static void compress_shani(uint32_t *state, const uint8_t *const *blocks);
+#endif
+static int path_supported(int path);
+static void hash_lanes(const struct sha256_mb_path *path, const uint8_t *messages, size_t size, size_t count, uint8_t *digests);
+
+static const struct sha256_mb_path sha256_mb_paths[SHA256_MB_PATHS] =
+{
+    [SHA256_MB_SCALAR] = { "scalar", 1, compress_scalar },
+#ifdef SHA256_MB_X86
+    [SHA256_MB_SSE2] = { "sse2x4", 4, compress_sse2 },
+    [SHA256_MB_AVX2] = { "avx2x8", 8, compress_avx2 },
+    [SHA256_MB_SHANI] = { "sha-ni", 1, compress_shani },
+#endif
+};
+
+//Best path first
+static const int sha256_mb_preference[] = { SHA256_MB_SHANI, SHA256_MB_AVX2, SHA256_MB_SSE2, SHA256_MB_SCALAR };
+
+static const struct sha256_mb_path *sha256_mb_active;
+
+static inline uint32_t load_be32(const uint8_t *data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+static inline void store_be32(uint8_t *data, uint32_t value)
+{
+    data[0] = (uint8_t)(value >> 24);
+    data[1] = (uint8_t)(value >> 16);
+    data[2] = (uint8_t)(value >> 8);
+    data[3] = (uint8_t)value;
+}
+
+#define ROTR32(x, n)    (((x) >> (n)) | ((x) << (32 - (n))))
+
+//Function to compress one block of one message, state[word]
+static void compress_scalar(uint32_t *state, const uint8_t *const *blocks)
+{
+    uint32_t w[64];
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    int t;
+
+    for (t = 0; t < 16; t++)
+    {
+        w[t] = load_be32(blocks[0] + 4 * t);
+    }
+    for (t = 16; t < 64; t++)
+    {
+        uint32_t s0 = ROTR32(w[t - 15], 7) ^ ROTR32(w[t - 15], 18) ^ (w[t - 15] >> 3);
+        uint32_t s1 = ROTR32(w[t - 2], 17) ^ ROTR32(w[t - 2], 19) ^ (w[t - 2] >> 10);
+        w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+    }
+
+    for (t = 0; t < 64; t++)
+    {
+        uint32_t t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[t] + w[t];
+        uint32_t t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+#ifdef SHA256_MB_X86
+
+/*
+ * The SIMD paths run the scalar rounds on vectors holding the same word of
+ * every lane, state[word * lanes + lane]. The message words are gathered
+ * from the blocks of the lanes while loading.
+ */
+#define SHA256_MB_ROUNDS(VEC, ADD, AND, ANDNOT, XOR, OR, SRLI, SLLI, SET1, LOAD, STORE, LOAD_W, LANES)      \
+    do                                                                                                      \
+    {                                                                                                       \
+        VEC w[16], v[8], t1, t2, s0, s1;                                                                    \
+        int t, i;                                                                                           \
+        for (i = 0; i < 8; i++)                                                                             \
+        {                                                                                                   \
+            v[i] = LOAD(&state[i * LANES]);                                                                 \
+        }                                                                                                   \
+        for (t = 0; t < 64; t++)                                                                            \
+        {                                                                                                   \
+            if (t < 16)                                                                                     \
+            {                                                                                               \
+                w[t] = LOAD_W(4 * t);                                                                       \
+            }                                                                                               \
+            else                                                                                            \
+            {                                                                                               \
+                VEC w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];                                           \
+                s0 = XOR(XOR(ROTR(w15, 7), ROTR(w15, 18)), SRLI(w15, 3));                                   \
+                s1 = XOR(XOR(ROTR(w2, 17), ROTR(w2, 19)), SRLI(w2, 10));                                    \
+                w[t & 15] = ADD(ADD(w[t & 15], s0), ADD(w[(t - 7) & 15], s1));                              \
+            }                                                                                               \
+            s1 = XOR(XOR(ROTR(v[4], 6), ROTR(v[4], 11)), ROTR(v[4], 25));                                   \
+            t1 = ADD(ADD(v[7], s1), ADD(XOR(AND(v[4], v[5]), ANDNOT(v[4], v[6])),                           \
+                    ADD(SET1((int)sha256_k[t]), w[t & 15])));                                               \
+            s0 = XOR(XOR(ROTR(v[0], 2), ROTR(v[0], 13)), ROTR(v[0], 22));                                   \
+            t2 = ADD(s0, XOR(XOR(AND(v[0], v[1]), AND(v[0], v[2])), AND(v[1], v[2])));                      \
+            v[7] = v[6];                                                                                    \
+            v[6] = v[5];                                                                                    \
+            v[5] = v[4];                                                                                    \
+            v[4] = ADD(v[3], t1);                                                                           \
+            v[3] = v[2];                                                                                    \
+            v[2] = v[1];                                                                                    \
+            v[1] = v[0];                                                                                    \
+            v[0] = ADD(t1, t2);                                                                             \
+        }                                                                                                   \
+        for (i = 0; i < 8; i++)                                                                             \
+        {                                                                                                   \
+            STORE(&state[i * LANES], ADD(LOAD(&state[i * LANES]), v[i]));                                   \
+        }                                                                                                   \
+    } while (0)
+
+#define SSE2_LOAD(p)        _mm_loadu_si128((const __m128i*)(p))
+#define SSE2_STORE(p, x)    _mm_storeu_si128((__m128i*)(p), (x))
+#define SSE2_LOAD_W(o)      _mm_setr_epi32((int)load_be32(blocks[0] + (o)), (int)load_be32(blocks[1] + (o)), \
+                                    (int)load_be32(blocks[2] + (o)), (int)load_be32(blocks[3] + (o)))
+
+//Function to compress one block each of 4 messages
+__attribute__((target("sse2")))
+static void compress_sse2(uint32_t *state, const uint8_t *const *blocks)
+{
+#define ROTR(x, n)  _mm_or_si128(_mm_srli_epi32((x), (n)), _mm_slli_epi32((x), 32 - (n)))
+    SHA256_MB_ROUNDS(__m128i, _mm_add_epi32, _mm_and_si128, _mm_andnot_si128, _mm_xor_si128, _mm_or_si128,
+            _mm_srli_epi32, _mm_slli_epi32, _mm_set1_epi32, SSE2_LOAD, SSE2_STORE, SSE2_LOAD_W, 4);
+#undef ROTR
+}
+
+#define AVX2_LOAD(p)        _mm256_loadu_si256((const __m256i*)(p))
+#define AVX2_STORE(p, x)    _mm256_storeu_si256((__m256i*)(p), (x))
+#define AVX2_LOAD_W(o)      _mm256_setr_epi32((int)load_be32(blocks[0] + (o)), (int)load_be32(blocks[1] + (o)), \
+                                    (int)load_be32(blocks[2] + (o)), (int)load_be32(blocks[3] + (o)),          \
+                                    (int)load_be32(blocks[4] + (o)), (int)load_be32(blocks[5] + (o)),          \
+                                    (int)load_be32(blocks[6] + (o)), (int)load_be32(blocks[7] + (o)))
+
+//Function to compress one block each of 8 messages
+__attribute__((target("avx2")))
+static void compress_avx2(uint32_t *state, const uint8_t *const *blocks)
+{
+#define ROTR(x, n)  _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+    SHA256_MB_ROUNDS(__m256i, _mm256_add_epi32, _mm256_and_si256, _mm256_andnot_si256, _mm256_xor_si256, _mm256_or_si256,
+            _mm256_srli_epi32, _mm256_slli_epi32, _mm256_set1_epi32, AVX2_LOAD, AVX2_STORE, AVX2_LOAD_W, 8);
+#undef ROTR
+}
+
+//Function to compress one block of one message with the SHA extensions
+__attribute__((target("sha,ssse3,sse4.1")))
+static void compress_shani(uint32_t *state, const uint8_t *const *blocks)
+{
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i w[4], message, state0, state1, saved0, saved1, swapped;
+    int j;
+
+    //sha256rnds2 works on ABEF and CDGH
+    swapped = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B);
+    state0 = _mm_alignr_epi8(swapped, state1, 8);
+    state1 = _mm_blend_epi16(state1, swapped, 0xF0);
+    saved0 = state0;
+    saved1 = state1;
+
+    for (j = 0; j < 16; j++)
+    {
+        if (j < 4)
+        {
+            w[j] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks[0] + 16 * j)), byte_swap);
+        }
+        else
+        {
+            w[j & 3] = _mm_sha256msg2_epu32(
+                    _mm_add_epi32(_mm_sha256msg1_epu32(w[j & 3], w[(j + 1) & 3]), _mm_alignr_epi8(w[(j + 3) & 3], w[(j + 2) & 3], 4)),
+                    w[(j + 3) & 3]);
+        }
+        message = _mm_add_epi32(w[j & 3], _mm_loadu_si128((const __m128i*)&sha256_k[4 * j]));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(message, 0x0E));
+    }
+
+    state0 = _mm_add_epi32(state0, saved0);
+    state1 = _mm_add_epi32(state1, saved1);
+    swapped = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    _mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(swapped, state1, 0xF0));
+    _mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(state1, swapped, 8));
+}
+
+#endif
+
+//Function to check if the CPU runs a path
+static int path_supported(int path)
+{
+#ifdef SHA256_MB_X86
+    unsigned int eax, ebx, ecx, edx;
+#endif
+
+    switch (path)
+    {
+    case SHA256_MB_SCALAR:
+        return 1;
+#ifdef SHA256_MB_X86
+    case SHA256_MB_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case SHA256_MB_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case SHA256_MB_SHANI:
+        //CPUID.(EAX=7,ECX=0):EBX bit 29
+        if (!__builtin_cpu_supports("sse4.1") || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        {
+            return 0;
+        }
+        return (ebx >> 29) & 1;
+#endif
+    default:
+        return 0;
+    }
+}
+
+//Function to hash up to one path's lanes of messages, unused lanes repeat the first message
+static void hash_lanes(const struct sha256_mb_path *path, const uint8_t *messages, size_t size, size_t count, uint8_t *digests)
+{
+    uint32_t state[8 * SHA256_MB_MAX_LANES];
+    uint8_t tail[SHA256_MB_MAX_LANES][2 * SHA256_BLOCK_SIZE];
+    const uint8_t *blocks[SHA256_MB_MAX_LANES];
+    size_t full_blocks = size / SHA256_BLOCK_SIZE;
+    size_t rest = size % SHA256_BLOCK_SIZE;
+    size_t tail_blocks = rest + 9 > SHA256_BLOCK_SIZE ? 2 : 1;
+    uint64_t bits = (uint64_t)size * 8;
+    size_t lane, block, i;
+
+    for (lane = 0; lane < path->lanes; lane++)
+    {
+        const uint8_t *message = messages + (lane < count ? lane : 0) * size;
+
+        memset(tail[lane], 0, sizeof(tail[lane]));
+        memcpy(tail[lane], message + full_blocks * SHA256_BLOCK_SIZE, rest);
+        tail[lane][rest] = 0x80;
+        for (i = 0; i < 8; i++)
+        {
+            tail[lane][tail_blocks * SHA256_BLOCK_SIZE - 1 - i] = (uint8_t)(bits >> (8 * i));
+            state[i * path->lanes + lane] = sha256_init[i];
+        }
+    }
+
+    for (block = 0; block < full_blocks + tail_blocks; block++)
+    {
+        for (lane = 0; lane < path->lanes; lane++)
+        {
+            if (block < full_blocks)
+            {
+                blocks[lane] = messages + (lane < count ? lane : 0) * size + block * SHA256_BLOCK_SIZE;
+            }
+            else
+            {
+                blocks[lane] = tail[lane] + (block - full_blocks) * SHA256_BLOCK_SIZE;
+            }
+        }
+        path->compress(state, blocks);
+    }
+
+    for (lane = 0; lane < count; lane++)
+    {
+        for (i = 0; i < 8; i++)
+        {
+            store_be32(digests + lane * SHA256_DIGEST_SIZE + 4 * i, state[i * path->lanes + lane]);
+        }
+    }
+}
+
+//Function to select the path by id, SHA256_MB_AUTO selects the best one the CPU runs. Returns the id or -1.
+int sha256_mb_select(int path)
+{
+    size_t i;
+
+    if (path == SHA256_MB_AUTO)
+    {
+        for (i = 0; i < sizeof(sha256_mb_preference) / sizeof(sha256_mb_preference[0]); i++)
+        {
+            if (path_supported(sha256_mb_preference[i]))
+            {
+                path = sha256_mb_preference[i];
+                break;
+            }
+        }
+    }
+    if (path <= SHA256_MB_AUTO || path >= SHA256_MB_PATHS || !path_supported(path))
+    {
+        return -1;
+    }
+    sha256_mb_active = &sha256_mb_paths[path];
+    return path;
+}
+
+int sha256_mb_supported(int path)
+{
+    return path > SHA256_MB_AUTO && path < SHA256_MB_PATHS && path_supported(path);
+}
+
+const char *sha256_mb_name(int path)
+{
+    return path > SHA256_MB_AUTO && path < SHA256_MB_PATHS ? sha256_mb_paths[path].name : NULL;
+}
+
+//Function to hash count messages of size bytes each, stored one after the other
+void sha256_mb_hash(const uint8_t *messages, size_t size, size_t count, uint8_t *digests)
+{
+    const struct sha256_mb_path *path = sha256_mb_active;
+    size_t done, lanes;
+
+    if (path == NULL)
+    {
+        sha256_mb_select(SHA256_MB_AUTO);
+        path = sha256_mb_active;
+    }
+
+    for (done = 0; done < count; done += lanes)
+    {
+        lanes = count - done < path->lanes ? count - done : path->lanes;
+        hash_lanes(path, messages + done * size, size, lanes, digests + done * SHA256_DIGEST_SIZE);
+    }
+}
+
+//Function to calculate the keys device_provision() derives from the parent key and the serial numbers
+void derive_key_batch(size_t count, const uint8_t *parent_key, const uint8_t *serial_numbers, uint16_t slot, uint8_t *keys)
+{
+    uint8_t messages[MAC_BATCH_SIZE][DERIVE_KEY_MESSAGE_SIZE];
+    size_t done, batch, i;
+
+    for (done = 0; done < count; done += batch)
+    {
+        batch = count - done < MAC_BATCH_SIZE ? count - done : MAC_BATCH_SIZE;
+        for (i = 0; i < batch; i++)
+        {
+            uint8_t *message = messages[i];
+            const uint8_t *serial_number = serial_numbers + (done + i) * MAC_SERIAL_NUMBER_SIZE;
+
+            //Parent key, opcode, mode, param2, SN[8], SN[0:1], 25 zeros, TempKey of the serial number padded with zeros
+            memset(message, 0, DERIVE_KEY_MESSAGE_SIZE);
+            memcpy(message, parent_key, MAC_KEY_SIZE);
+            message[32] = OPCODE_DERIVE_KEY;
+            message[33] = 0x00;
+            message[34] = (uint8_t)slot;
+            message[35] = (uint8_t)(slot >> 8);
+            message[36] = serial_number[8];
+            message[37] = serial_number[0];
+            message[38] = serial_number[1];
+            memcpy(message + 64, serial_number, MAC_SERIAL_NUMBER_SIZE);
+        }
+        sha256_mb_hash(messages[0], DERIVE_KEY_MESSAGE_SIZE, batch, keys + done * MAC_KEY_SIZE);
+    }
+}
+
+//Function to calculate the TempKey of Nonce commands in random mode: SHA-256(RandOut, NumIn, 0x16, 0x00, 0x00)
+void nonce_batch(size_t count, const uint8_t *rand_outs, const uint8_t *num_ins, uint8_t *temp_keys)
+{
+    uint8_t messages[MAC_BATCH_SIZE][NONCE_MESSAGE_SIZE];
+    size_t done, batch, i;
+
+    for (done = 0; done < count; done += batch)
+    {
+        batch = count - done < MAC_BATCH_SIZE ? count - done : MAC_BATCH_SIZE;
+        for (i = 0; i < batch; i++)
+        {
+            uint8_t *message = messages[i];
+
+            memcpy(message, rand_outs + (done + i) * NONCE_RAND_OUT_SIZE, NONCE_RAND_OUT_SIZE);
+            memcpy(message + NONCE_RAND_OUT_SIZE, num_ins + (done + i) * NONCE_NUM_IN_SIZE, NONCE_NUM_IN_SIZE);
+            message[52] = OPCODE_NONCE;
+            message[53] = 0x00;
+            message[54] = 0x00;
+        }
+        sha256_mb_hash(messages[0], NONCE_MESSAGE_SIZE, batch, temp_keys + done * SHA256_DIGEST_SIZE);
+    }
+}
+
+//Function to calculate the responses of MAC commands in mode 0x01 like atcah_mac() does
+void mac_batch(size_t count, const uint8_t *keys, const uint8_t *temp_keys, const uint8_t *serial_numbers, uint16_t slot, uint8_t *macs)
+{
+    uint8_t messages[MAC_BATCH_SIZE][MAC_MESSAGE_SIZE];
+    size_t done, batch, i;
+
+    for (done = 0; done < count; done += batch)
+    {
+        batch = count - done < MAC_BATCH_SIZE ? count - done : MAC_BATCH_SIZE;
+        for (i = 0; i < batch; i++)
+        {
+            uint8_t *message = messages[i];
+            const uint8_t *serial_number = serial_numbers + (done + i) * MAC_SERIAL_NUMBER_SIZE;
+
+            //Key, TempKey, opcode, mode, param2, 11 zeros for OTP[0:10], SN[8], 4 zeros for SN[4:7], SN[0:1], 2 zeros for SN[2:3]
+            memset(message, 0, MAC_MESSAGE_SIZE);
+            memcpy(message, keys + (done + i) * MAC_KEY_SIZE, MAC_KEY_SIZE);
+            memcpy(message + 32, temp_keys + (done + i) * SHA256_DIGEST_SIZE, SHA256_DIGEST_SIZE);
+            message[64] = OPCODE_MAC;
+            message[65] = MAC_MODE_BLOCK2_TEMPKEY;
+            message[66] = (uint8_t)slot;
+            message[67] = (uint8_t)(slot >> 8);
+            message[79] = serial_number[8];
+            message[84] = serial_number[0];
+            message[85] = serial_number[1];
+        }
+        sha256_mb_hash(messages[0], MAC_MESSAGE_SIZE, batch, macs + done * SHA256_DIGEST_SIZE);
+    }
+}
+
+//Function to check MAC responses, results[i] is 1 for a match. Returns the number of matches.
+size_t mac_verify_batch(size_t count, const uint8_t *keys, const uint8_t *temp_keys, const uint8_t *serial_numbers, uint16_t slot,
+                        const uint8_t *responses, uint8_t *results)
+{
+    uint8_t macs[MAC_BATCH_SIZE * SHA256_DIGEST_SIZE];
+    size_t done, batch, i, j, matches = 0;
+
+    for (done = 0; done < count; done += batch)
+    {
+        batch = count - done < MAC_BATCH_SIZE ? count - done : MAC_BATCH_SIZE;
+        mac_batch(batch, keys + done * MAC_KEY_SIZE, temp_keys + done * SHA256_DIGEST_SIZE,
+                  serial_numbers + done * MAC_SERIAL_NUMBER_SIZE, slot, macs);
+        for (i = 0; i < batch; i++)
+        {
+            uint8_t difference = 0;
+
+            //Compare all bytes, the time does not depend on where a response differs
+            for (j = 0; j < SHA256_DIGEST_SIZE; j++)
+            {
+                difference |= macs[i * SHA256_DIGEST_SIZE + j] ^ responses[(done + i) * SHA256_DIGEST_SIZE + j];
+            }
+            results[done + i] = difference == 0;
+            matches += difference == 0;
+        }
+    }
+    return matches;
+}
@@ -0,0 +1,64 @@
+/**
+ * \file
+ * \brief  Multi-buffer SHA-256 for verifying batches of device MAC responses
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+
+#ifndef SHA256_MB_H_
+#define SHA256_MB_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SHA256_DIGEST_SIZE          32
+
+#define MAC_KEY_SIZE                32
+#define MAC_SERIAL_NUMBER_SIZE      9
+#define NONCE_RAND_OUT_SIZE         32
+#define NONCE_NUM_IN_SIZE           20
+
+enum sha256_mb_path_id
+{
+    SHA256_MB_AUTO = 0,
+    SHA256_MB_SCALAR,
+    SHA256_MB_SSE2,
+    SHA256_MB_AVX2,
+    SHA256_MB_SHANI,
+    SHA256_MB_PATHS
+};
+
+//The selected path is process wide, select it before starting threads
+int sha256_mb_select(int path);
+int sha256_mb_supported(int path);
+const char *sha256_mb_name(int path);
+void sha256_mb_hash(const uint8_t *messages, size_t size, size_t count, uint8_t *digests);
+
+void derive_key_batch(size_t count, const uint8_t *parent_key, const uint8_t *serial_numbers, uint16_t slot, uint8_t *keys);
+void nonce_batch(size_t count, const uint8_t *rand_outs, const uint8_t *num_ins, uint8_t *temp_keys);
+void mac_batch(size_t count, const uint8_t *keys, const uint8_t *temp_keys, const uint8_t *serial_numbers, uint16_t slot, uint8_t *macs);
+size_t mac_verify_batch(size_t count, const uint8_t *keys, const uint8_t *temp_keys, const uint8_t *serial_numbers, uint16_t slot,
+                        const uint8_t *responses, uint8_t *results);
+
+#endif /* SHA256_MB_H_ */
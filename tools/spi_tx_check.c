@@ -0,0 +1,369 @@
+/**
+ * \file
+ * \brief  Counts the SERCOM register accesses of the SPI write paths of the OLED
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux x86-64 with
+ *
+ *   S=../firmware/samd21/src D=$S/ASF/sam0/drivers
+ *   cc -O2 -D__SAMD21J18A__ -DSPI_CALLBACK_MODE=true -I$S -I$S/config -I$S/ASF/sam0/utils \
+ *      -I$S/ASF/sam0/utils/header_files -I$S/ASF/sam0/utils/preprocessor \
+ *      -I$S/ASF/sam0/utils/cmsis/samd21/include -I$S/ASF/sam0/utils/cmsis/samd21/source \
+ *      -I$S/ASF/thirdparty/CMSIS/Include \
+ *      -I$D/sercom -I$D/sercom/spi -I$D/port -I$D/system -I$D/system/pinmux -I$D/system/clock \
+ *      -I$D/system/clock/clock_samd21_r21_da -I$D/system/interrupt \
+ *      -I$D/system/interrupt/system_interrupt_samd21 -I$D/system/power/power_sam_d_r \
+ *      -I$D/system/reset/reset_sam_d_r -I$S/ASF/common/utils \
+ *      -ffunction-sections -Wl,--gc-sections -o spi_tx_check spi_tx_check.c host/reg_trap.c $D/sercom/spi/spi.c
+ *
+ * The real ASF headers are used here, not the host stand-ins, and the
+ * linker drops the parts of spi.c that would need the clock and pin
+ * drivers. spi_write_buffer_wait() of spi.c runs, with the receiver enabled
+ * and disabled, on a model of a SERCOM in SPI master mode whose registers
+ * are trapped with host/reg_trap.c, so every register access is counted.
+ *
+ * The model runs on a clock of CPU cycles: every register access costs -c
+ * cycles (6 by default, a load or store over the APB bridge and the loop
+ * around it), and a character takes 8 SPI clocks of the 48 MHz CPU clock,
+ * at SSD1306_CLOCK_SPEED or the clock given with -f. At 1 MHz both settings
+ * spend most of a character polling INTFLAG; at higher clocks the accesses
+ * per character bound the throughput. The data register holds one character
+ * while another one is shifted out. Each setting must send the buffer
+ * unchanged and return only after the last character is shifted out.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include "host/reg_trap.h"
+
+//glibc defines these as well, the ASF definitions win for the firmware code
+#undef __always_inline
+#undef LITTLE_ENDIAN
+#include "spi.h"
+
+#define CHECK_CPU_HZ            48000000UL
+#define CHECK_SPI_HZ            1000000UL           //SSD1306_CLOCK_SPEED of conf_ssd1306.h
+#define CHECK_MAX_LENGTH        1024
+
+//Offsets of the SercomSpi registers
+#define SIM_INTFLAG             0x18
+#define SIM_STATUS              0x1A
+#define SIM_DATA                0x28
+
+typedef struct
+{
+    uint64_t intflag_reads;
+    uint64_t intflag_writes;
+    uint64_t status_accesses;
+    uint64_t data_writes;
+    uint64_t data_reads;
+    uint64_t other;
+} sim_counts;
+
+typedef struct
+{
+    SercomSpi *regs;
+    uint64_t now;                       //CPU cycles
+    uint32_t access_cycles;
+    uint32_t character_cycles;
+    bool receiver_enabled;
+    bool shifting;
+    uint64_t shift_end;
+    uint8_t shift_data;
+    bool data_full;
+    uint8_t data;
+    uint8_t rx_count;                   //Characters in the two level receive buffer
+    bool txc;
+    bool overflow;
+    uint32_t lost;                      //Characters written over one still waiting
+    uint8_t sent[CHECK_MAX_LENGTH];
+    uint16_t sent_length;
+    sim_counts counts;
+} spi_sim;
+
+static spi_sim g_sim;
+
+static void sim_update(spi_sim *sim)
+{
+    while (sim->shifting && (sim->now >= sim->shift_end))
+    {
+        if (sim->sent_length < CHECK_MAX_LENGTH)
+        {
+            sim->sent[sim->sent_length++] = sim->shift_data;
+        }
+        if (sim->receiver_enabled)
+        {
+            if (sim->rx_count < 2)
+            {
+                sim->rx_count++;
+            }
+            else
+            {
+                sim->overflow = true;
+            }
+        }
+        if (sim->data_full)
+        {
+            sim->shift_data = sim->data;
+            sim->shift_end += sim->character_cycles;
+            sim->data_full = false;
+        }
+        else
+        {
+            sim->shifting = false;
+            sim->txc = true;
+        }
+    }
+}
+
+static void sim_store(spi_sim *sim)
+{
+    sim->regs->INTFLAG.reg = (sim->data_full ? 0 : SERCOM_SPI_INTFLAG_DRE) | (sim->txc ? SERCOM_SPI_INTFLAG_TXC : 0) |
+                             (sim->rx_count ? SERCOM_SPI_INTFLAG_RXC : 0);
+    sim->regs->STATUS.reg = sim->overflow ? SERCOM_SPI_STATUS_BUFOVF : 0;
+    sim->regs->DATA.reg = 0xFF;
+}
+
+static void sim_before(void *context, uint32_t offset, bool write)
+{
+    spi_sim *sim = context;
+
+    sim->now += sim->access_cycles;
+    sim_update(sim);
+    sim_store(sim);
+
+    if (offset == SIM_INTFLAG)
+    {
+        if (write)
+        {
+            sim->counts.intflag_writes++;
+        }
+        else
+        {
+            sim->counts.intflag_reads++;
+        }
+    }
+    else if ((offset >= SIM_STATUS) && (offset < SIM_STATUS + 2))
+    {
+        sim->counts.status_accesses++;
+    }
+    else if ((offset >= SIM_DATA) && (offset < SIM_DATA + 4))
+    {
+        if (write)
+        {
+            sim->counts.data_writes++;
+        }
+        else
+        {
+            sim->counts.data_reads++;
+            if (sim->rx_count)
+            {
+                sim->rx_count--;
+            }
+        }
+    }
+    else
+    {
+        sim->counts.other++;
+    }
+}
+
+static void sim_written(void *context, uint32_t offset)
+{
+    spi_sim *sim = context;
+    uint8_t value;
+
+    if ((offset >= SIM_DATA) && (offset < SIM_DATA + 4))
+    {
+        value = (uint8_t)sim->regs->DATA.reg;
+        sim->txc = false;
+        if (!sim->shifting)
+        {
+            sim->shifting = true;
+            sim->shift_data = value;
+            sim->shift_end = sim->now + sim->character_cycles;
+        }
+        else
+        {
+            if (sim->data_full)
+            {
+                sim->lost++;
+            }
+            sim->data_full = true;
+            sim->data = value;
+        }
+    }
+    else if (offset == SIM_INTFLAG)
+    {
+        if (sim->regs->INTFLAG.reg & SERCOM_SPI_INTFLAG_TXC)
+        {
+            sim->txc = false;
+        }
+    }
+    else if ((offset >= SIM_STATUS) && (offset < SIM_STATUS + 2))
+    {
+        if (sim->regs->STATUS.reg & SERCOM_SPI_STATUS_BUFOVF)
+        {
+            sim->overflow = false;
+        }
+    }
+    sim_store(sim);
+}
+
+typedef enum
+{
+    PATH_GENERIC_RX,        //spi_write_buffer_wait() with the receiver enabled, before the OLED disabled it
+    PATH_GENERIC,           //spi_write_buffer_wait() with the receiver disabled, as ssd1306.c configures it
+    PATH_COUNT
+} check_path;
+
+static const char *const g_path_names[PATH_COUNT] =
+{
+    "spi_write_buffer_wait, receiver on",
+    "spi_write_buffer_wait",
+};
+
+//Function to write a buffer with one of the settings, returns false if it was not sent correctly
+static bool check_write(check_path path, const uint8_t *buffer, uint16_t length, sim_counts *counts,
+                        uint64_t *cycles)
+{
+    struct spi_module module;
+    enum status_code status;
+    uint64_t start;
+
+    memset(&module, 0, sizeof(module));
+    module.hw = (Sercom *)g_sim.regs;
+    module.mode = SPI_MODE_MASTER;
+    module.character_size = SPI_CHARACTER_SIZE_8BIT;
+    module.receiver_enabled = (path == PATH_GENERIC_RX);
+    module.status = STATUS_OK;
+
+    g_sim.receiver_enabled = module.receiver_enabled;
+    g_sim.sent_length = 0;
+    g_sim.lost = 0;
+    g_sim.rx_count = 0;
+    g_sim.overflow = false;
+    g_sim.txc = false;
+    memset(&g_sim.counts, 0, sizeof(g_sim.counts));
+    start = g_sim.now;
+
+    //The model runs in the signal handler, so the state must not be cached across the call
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    status = spi_write_buffer_wait(&module, buffer, length);
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+    *counts = g_sim.counts;
+    *cycles = g_sim.now - start;
+    if ((status != STATUS_OK) || g_sim.shifting || g_sim.data_full)
+    {
+        printf("%s: returned %d before the last of %u characters was sent\n", g_path_names[path], status, length);
+        return false;
+    }
+    if ((g_sim.sent_length != length) || (memcmp(g_sim.sent, buffer, length) != 0) || g_sim.lost)
+    {
+        printf("%s: sent %u of %u characters, %u lost\n", g_path_names[path], g_sim.sent_length, length, g_sim.lost);
+        return false;
+    }
+    if (g_sim.overflow)
+    {
+        printf("%s: receive buffer overflow\n", g_path_names[path]);
+        return false;
+    }
+    return true;
+}
+
+static void print_usage(const char *name)
+{
+    printf("usage: %s [-c cycles per register access] [-f SPI clock in Hz]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    static const uint16_t lengths[] = { 1, 3, 128, 512 };
+    uint8_t buffer[CHECK_MAX_LENGTH];
+    sim_counts counts;
+    uint64_t cycles;
+    uint32_t failures = 0;
+    uint8_t path;
+    uint8_t i;
+    uint16_t j;
+    unsigned long spi_hz = CHECK_SPI_HZ;
+    int option;
+
+    g_sim.access_cycles = 6;
+    while ((option = getopt(argc, argv, "c:f:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'c': g_sim.access_cycles = (uint32_t)atoi(optarg); break;
+        case 'f': spi_hz = strtoul(optarg, NULL, 0); break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+    if ((g_sim.access_cycles == 0) || (spi_hz == 0) || (spi_hz > CHECK_CPU_HZ / 2))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    g_sim.character_cycles = (uint32_t)(8 * CHECK_CPU_HZ / spi_hz);
+    g_sim.regs = reg_trap_map(0, sizeof(SercomSpi), sim_before, sim_written, &g_sim);
+    for (j = 0; j < sizeof(buffer); j++)
+    {
+        buffer[j] = (uint8_t)(j * 37 + 11);
+    }
+
+    printf("SPI at %lu Hz, %u CPU cycles per character, %u per register access\n\n", spi_hz,
+           g_sim.character_cycles, g_sim.access_cycles);
+    printf("%-36s %6s | %-41s | %8s %6s\n", "", "", "register accesses per character", "cycles", "bus");
+    printf("%-36s %6s | %7s %7s %7s %7s %7s | %8s %6s\n", "path", "length", "INTFLAG", "DATA wr", "DATA rd", "STATUS",
+           "total", "per char", "busy");
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+    {
+        for (path = 0; path < PATH_COUNT; path++)
+        {
+            if (!check_write(path, buffer, lengths[i], &counts, &cycles))
+            {
+                failures++;
+                continue;
+            }
+            printf("%-36s %6u | %7.2f %7.2f %7.2f %7.2f %7.2f | %8.1f %5.0f%%\n", g_path_names[path], lengths[i],
+                   (double)counts.intflag_reads / lengths[i], (double)counts.data_writes / lengths[i],
+                   (double)counts.data_reads / lengths[i], (double)counts.status_accesses / lengths[i],
+                   (double)(counts.intflag_reads + counts.intflag_writes + counts.data_writes + counts.data_reads +
+                            counts.status_accesses + counts.other) / lengths[i],
+                   (double)cycles / lengths[i], 100.0 * g_sim.character_cycles * lengths[i] / cycles);
+        }
+    }
+
+    printf("\n%lu register accesses trapped, %u failed\n", (unsigned long)reg_trap_accesses(), failures);
+    return (failures == 0) ? 0 : 1;
+}
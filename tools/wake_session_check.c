@@ -0,0 +1,485 @@
+/**
+ * \file
+ * \brief  Counts the wake pulses and bus time of an authentication with and without a HAL session
+ *
+ * \copyright (c) 2018 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip software
+ * and any derivatives exclusively with Microchip products. It is your
+ * responsibility to comply with third party license terms applicable to your
+ * use of third party software (including open source software) that may
+ * accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+ * EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+ * WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+ * PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT,
+ * SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE
+ * OF ANY KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+ * MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+ * FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL
+ * LIABILITY ON ALL CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED
+ * THE AMOUNT OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR
+ * THIS SOFTWARE.
+ */
+
+/*
+ * Built on Linux x86-64 with
+ *
+ *   S=../firmware/samd21/src D=$S/ASF/sam0/drivers
+ *   cc -O2 -no-pie -Wno-pointer-to-int-cast -D__SAMD21J18A__ -DBOARD=SAMD21_XPLAINED_PRO \
+ *      -DI2C_MASTER_CALLBACK_MODE=false \
+ *      -Ihost/sam -Ihost/cryptoauthlib -I$S -I$S/config -I$S/ASF/common/boards -I$S/ASF/sam0/boards \
+ *      -I$S/ASF/sam0/boards/samd21_xplained_pro -I$S/ASF/sam0/utils -I$S/ASF/sam0/utils/header_files \
+ *      -I$S/ASF/sam0/utils/preprocessor -I$S/ASF/sam0/utils/cmsis/samd21/include \
+ *      -I$S/ASF/sam0/utils/cmsis/samd21/source -I$S/ASF/thirdparty/CMSIS/Include \
+ *      -I$D/sercom -I$D/sercom/i2c -I$D/port -I$D/system -I$D/system/pinmux -I$D/system/clock \
+ *      -I$D/system/clock/clock_samd21_r21_da -I$D/system/interrupt \
+ *      -I$D/system/interrupt/system_interrupt_samd21 -I$D/system/power/power_sam_d_r \
+ *      -I$D/system/reset/reset_sam_d_r -I$S/ASF/common/utils \
+ *      -o wake_session_check wake_session_check.c host/i2c_sim.c host/reg_trap.c \
+ *      host/cryptoauthlib/cryptoauthlib_sim.c $S/hal_i2c_dma.c $S/cmd_timing.c \
+ *      $D/sercom/i2c/i2c_sam0/i2c_master.c $D/sercom/sercom.c $D/sercom/sercom_interrupt.c
+ *
+ * hal_i2c_dma.c runs unchanged on the bus model of host/i2c_sim.c, with
+ * host/cryptoauthlib standing in for the library, which is not part of this
+ * tree. An authentication is the Read of the serial number, the Nonce and
+ * the MAC on TempKey that symmetric_authenticate() sends, on an ATECC608A
+ * and on an ATSHA204A. It runs once with every command waking and idling
+ * the device, as cryptoauthlib does, and once inside hal_i2c_session_begin()
+ * and hal_i2c_session_end() like authenticate_application(). The bus model
+ * counts the wake pulses and the time the bus is driven.
+ *
+ * A session has to send one wake pulse and one idle per authentication and
+ * less bus time than the commands on their own. A last session runs Nonce
+ * and MAC pairs for longer than the watchdog of the device: the HAL has to
+ * restart the watchdog with an idle and wake, so no MAC loses its TempKey.
+ * A session that waits away from the bus for longer than the watchdog, like
+ * factory mode waiting on the UART, has to wake the device again for its
+ * next command.
+ *
+ * The boot path of an unprovisioned ATECC608A is run last: the session
+ * opened by hal_i2c_wake_start() and hal_i2c_wake_poll(), the scan of
+ * detect_crypto_device() that puts the device to sleep, and a command that
+ * has to wake it again. Both wake functions have to refuse a bus out of
+ * range or released with ATCA_BAD_PARAM.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include "host/reg_trap.h"
+#include "host/i2c_sim.h"
+
+//glibc defines these as well, the ASF definitions win for the firmware code
+#undef __always_inline
+#undef LITTLE_ENDIAN
+#include "hal_i2c_dma.h"
+
+//Time the application leaves between two authentications
+#define CHECK_AUTH_INTERVAL_USEC    100000
+
+//Longest wait for the wake response of the early wake pulse, BOOT_WAKE_TIMEOUT_USEC of main.c
+#define CHECK_BOOT_WAKE_USEC        5000
+
+typedef struct
+{
+    const char *name;
+    uint8_t address;
+    ATCADeviceType devtype;
+} check_device;
+
+typedef struct
+{
+    uint32_t runs;
+    uint32_t failures;
+    const check_device *device;
+    ATCAIfaceCfg cfg;
+} check_context;
+
+typedef struct
+{
+    uint32_t wake_pulses;
+    uint32_t hal_wake_pulses;
+    uint32_t idles;
+    uint64_t bytes;
+    uint64_t bus_usec;
+    uint64_t usec;
+} check_totals;
+
+static const check_device g_devices[] =
+{
+    { "ATECC608A", 0xC0, ATECC608A },
+    { "ATSHA204A", 0xC8, ATSHA204A },
+};
+
+static void print_usage(const char *name)
+{
+    printf("Usage: %s [-n runs]\n", name);
+    printf("  -n  authentications with and without a session on each device (default 20)\n");
+}
+
+static bool check_fail(check_context *context, const char *name, const char *reason)
+{
+    printf("%-30s FAIL %s\n", name, reason);
+    context->failures++;
+    return false;
+}
+
+//Function to send the commands of symmetric_authenticate(), the host side of the MAC is left out
+static ATCA_STATUS check_authenticate(uint8_t *digest)
+{
+    uint8_t serial_number[ATCA_SERIAL_NUM_SIZE];
+    uint8_t num_in[NONCE_NUMIN_SIZE];
+    uint8_t rand_out[RANDOM_NUM_SIZE];
+    ATCA_STATUS status;
+
+    memset(num_in, 0x5A, sizeof(num_in));
+    if ((status = atcab_read_serial_number(serial_number)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+    if ((status = atcab_nonce_rand(num_in, rand_out)) != ATCA_SUCCESS)
+    {
+        return status;
+    }
+    return atcab_mac(MAC_MODE_BLOCK2_TEMPKEY, 0, NULL, digest);
+}
+
+//Function to take the counters of the bus model and the HAL at the start of a measurement
+static void check_snapshot(check_totals *totals, const i2c_sim_device *device)
+{
+    const i2c_sim_stats *stats = i2c_sim_get_stats();
+
+    totals->wake_pulses = stats->wake_pulses;
+    totals->hal_wake_pulses = hal_i2c_get_wake_pulses();
+    totals->idles = device->idles;
+    totals->bytes = stats->bytes;
+    totals->bus_usec = stats->bus_usec;
+    totals->usec = i2c_sim_now();
+}
+
+//Function to turn a snapshot into the counts since it was taken
+static void check_delta(check_totals *totals, const i2c_sim_device *device)
+{
+    const i2c_sim_stats *stats = i2c_sim_get_stats();
+
+    totals->wake_pulses = stats->wake_pulses - totals->wake_pulses;
+    totals->hal_wake_pulses = hal_i2c_get_wake_pulses() - totals->hal_wake_pulses;
+    totals->idles = device->idles - totals->idles;
+    totals->bytes = stats->bytes - totals->bytes;
+    totals->bus_usec = stats->bus_usec - totals->bus_usec;
+    totals->usec = i2c_sim_now() - totals->usec;
+}
+
+//Function to run the authentications of one mode and print their cost per authentication
+static bool check_mode(check_context *context, bool session, check_totals *totals)
+{
+    const i2c_sim_device *device = i2c_sim_get_device(0);
+    const char *mode = session ? "session" : "per command";
+    uint8_t digest[MAC_SIZE];
+    char name[48];
+    uint32_t run;
+    ATCA_STATUS status;
+
+    snprintf(name, sizeof(name), "%s %s", context->device->name, mode);
+    check_snapshot(totals, device);
+    for (run = 0; run < context->runs; run++)
+    {
+        if (session)
+        {
+            hal_i2c_session_begin();
+        }
+        status = check_authenticate(digest);
+        if (session && status == ATCA_SUCCESS)
+        {
+            status = hal_i2c_session_end(false);
+        }
+        if (status != ATCA_SUCCESS)
+        {
+            hal_i2c_session_end(false);
+            return check_fail(context, name, "authentication failed");
+        }
+        if (device->state != I2C_SIM_IDLE)
+        {
+            return check_fail(context, name, "device not idle after the authentication");
+        }
+        i2c_sim_delay_us(CHECK_AUTH_INTERVAL_USEC);
+    }
+    check_delta(totals, device);
+
+    printf("%-10s %-11s %5u | %6.2f %6.2f | %6lu %8lu %8lu\n", context->device->name, mode, context->runs,
+           (double)totals->wake_pulses / context->runs, (double)totals->idles / context->runs,
+           (unsigned long)(totals->bytes / context->runs), (unsigned long)(totals->bus_usec / context->runs),
+           (unsigned long)(totals->usec / context->runs - CHECK_AUTH_INTERVAL_USEC));
+
+    if (totals->hal_wake_pulses != totals->wake_pulses)
+    {
+        return check_fail(context, name, "hal_i2c_get_wake_pulses() differs from the bus");
+    }
+    if (session && (totals->wake_pulses != context->runs || totals->idles != context->runs))
+    {
+        return check_fail(context, name, "not one wake pulse and one idle per authentication");
+    }
+    return true;
+}
+
+//Function to put the device of the context alone on the bus and initialize cryptoauthlib for it
+static bool check_init(check_context *context, i2c_sim_device_config *config)
+{
+    ATCAIfaceCfg *cfg = &context->cfg;
+
+    i2c_sim_init();
+    i2c_sim_default_config(config, context->device->address, context->device->devtype);
+    i2c_sim_add_device(config);
+
+    *cfg = (context->device->devtype == ATSHA204A) ? cfg_atsha204a_i2c_default : cfg_ateccx08a_i2c_default;
+    cfg->devtype = context->device->devtype;
+    cfg->atcai2c.slave_address = context->device->address;
+    if (atcab_init(cfg) != ATCA_SUCCESS)
+    {
+        return check_fail(context, context->device->name, "init failed");
+    }
+    return true;
+}
+
+static void check_sessions(void *argument)
+{
+    check_context *context = argument;
+    i2c_sim_device_config config;
+    check_totals single;
+    check_totals session;
+    char name[48];
+
+    if (!check_init(context, &config))
+    {
+        return;
+    }
+
+    snprintf(name, sizeof(name), "%s session", context->device->name);
+    if (check_mode(context, false, &single) && check_mode(context, true, &session) &&
+        (session.bus_usec >= single.bus_usec || session.usec >= single.usec))
+    {
+        check_fail(context, name, "not faster than waking for every command");
+    }
+    if (i2c_sim_get_device(0)->bad_packets != 0)
+    {
+        check_fail(context, name, "bad command packets");
+    }
+    atcab_release();
+}
+
+//Function to keep one session busy for twice the watchdog time, the HAL has to restart the watchdog
+//with an idle and wake before it puts the device to sleep and TempKey is lost
+static void check_watchdog(void *argument)
+{
+    check_context *context = argument;
+    const i2c_sim_device *device = i2c_sim_get_device(0);
+    i2c_sim_device_config config;
+    uint8_t num_in[NONCE_NUMIN_SIZE];
+    uint8_t digest[MAC_SIZE];
+    char name[48];
+    check_totals totals;
+    uint32_t pairs = 0;
+    ATCA_STATUS status = ATCA_SUCCESS;
+
+    if (!check_init(context, &config))
+    {
+        return;
+    }
+
+    snprintf(name, sizeof(name), "%s watchdog", context->device->name);
+    memset(num_in, 0xA5, sizeof(num_in));
+    check_snapshot(&totals, device);
+    hal_i2c_session_begin();
+    while (status == ATCA_SUCCESS && i2c_sim_now() - totals.usec < 2ULL * config.watchdog_usec)
+    {
+        if ((status = atcab_nonce_rand(num_in, NULL)) == ATCA_SUCCESS)
+        {
+            status = atcab_mac(MAC_MODE_BLOCK2_TEMPKEY, 0, NULL, digest);
+        }
+        pairs++;
+    }
+    hal_i2c_session_end(false);
+    check_delta(&totals, device);
+    atcab_release();
+
+    if (status != ATCA_SUCCESS || device->watchdog_sleeps != 0)
+    {
+        check_fail(context, name, "the watchdog put the device to sleep");
+        return;
+    }
+    if (totals.wake_pulses < 2 || totals.wake_pulses > totals.usec / (HAL_I2C_SESSION_MAX_MSEC * 1000UL) + 1)
+    {
+        check_fail(context, name, "not one idle and wake per HAL_I2C_SESSION_MAX_MSEC");
+        return;
+    }
+    printf("%-30s ok   %lu Nonce and MAC pairs in %lu ms, %u wake pulses\n", name, (unsigned long)pairs,
+           (unsigned long)(totals.usec / 1000), totals.wake_pulses);
+}
+
+//Function to leave the bus alone inside a session for longer than the watchdog, the HAL counts that time
+//on the clock and has to wake the device again for the next command
+static void check_gap(void *argument)
+{
+    check_context *context = argument;
+    const i2c_sim_device *device = i2c_sim_get_device(0);
+    i2c_sim_device_config config;
+    uint8_t serial_number[ATCA_SERIAL_NUM_SIZE];
+    char name[48];
+    check_totals totals;
+    ATCA_STATUS status;
+
+    if (!check_init(context, &config))
+    {
+        return;
+    }
+
+    snprintf(name, sizeof(name), "%s gap in a session", context->device->name);
+    check_snapshot(&totals, device);
+    hal_i2c_session_begin();
+    if ((status = atcab_read_serial_number(serial_number)) == ATCA_SUCCESS)
+    {
+        i2c_sim_delay_us(config.watchdog_usec + CHECK_AUTH_INTERVAL_USEC);
+        status = atcab_read_serial_number(serial_number);
+    }
+    hal_i2c_session_end(false);
+    check_delta(&totals, device);
+    atcab_release();
+
+    if (status != ATCA_SUCCESS || totals.wake_pulses != 2)
+    {
+        check_fail(context, name, "no wake after the watchdog put the device to sleep");
+        return;
+    }
+    printf("%-30s ok   %lu ms away from the bus, %u wake pulses\n", name,
+           (unsigned long)((config.watchdog_usec + CHECK_AUTH_INTERVAL_USEC) / 1000), totals.wake_pulses);
+}
+
+//Function to run the boot path of an unprovisioned ATECC608A: the early wake opens a session, the scan of
+//detect_crypto_device() puts the device to sleep and the next command has to wake it again
+static void check_boot_scan(void *argument)
+{
+    check_context *context = argument;
+    const uint8_t candidates[] = { 0xC0, 0x6A };
+    const char *name = "wake, scan and command";
+    ATCAIfaceCfg cfg = cfg_ateccx08a_i2c_default;
+    ATCAIfaceCfg bad_cfg;
+    i2c_sim_device_config config;
+    const i2c_sim_device *device;
+    uint8_t serial_number[ATCA_SERIAL_NUM_SIZE];
+    uint8_t address = 0;
+    uint64_t start;
+    ATCA_STATUS status;
+
+    i2c_sim_init();
+    i2c_sim_default_config(&config, 0xC0, ATECC608A);
+    i2c_sim_add_device(&config);
+    device = i2c_sim_get_device(0);
+    cfg.devtype = ATECC608A;
+    if (atcab_init(&cfg) != ATCA_SUCCESS)
+    {
+        check_fail(context, name, "init failed");
+        return;
+    }
+
+    hal_i2c_session_begin();
+    start = i2c_sim_now();
+    if ((status = hal_i2c_wake_start(&cfg)) == ATCA_SUCCESS)
+    {
+        while ((status = hal_i2c_wake_poll(&cfg)) == ATCA_RX_NO_RESPONSE &&
+               i2c_sim_now() - start < CHECK_BOOT_WAKE_USEC)
+        {
+            atca_delay_us(100);
+        }
+    }
+    if (status != ATCA_SUCCESS)
+    {
+        hal_i2c_session_end(false);
+        check_fail(context, name, "early wake failed");
+        return;
+    }
+
+    if (hal_i2c_scan(&cfg, candidates, sizeof(candidates), &address, 1) != 1 || address != 0xC0)
+    {
+        hal_i2c_session_end(false);
+        check_fail(context, name, "scan did not find the device");
+        return;
+    }
+    status = atcab_read_serial_number(serial_number);
+    hal_i2c_session_end(false);
+    if (status != ATCA_SUCCESS || memcmp(serial_number, config.serial_number, sizeof(serial_number)) != 0)
+    {
+        check_fail(context, name, "command after the scan failed");
+        return;
+    }
+    if (device->state != I2C_SIM_IDLE || i2c_sim_get_stats()->wake_pulses != 3)
+    {
+        check_fail(context, name, "not woken again after the scan, or left awake");
+        return;
+    }
+    printf("%-30s ok   3 wake pulses, device idle\n", name);
+
+    bad_cfg = cfg;
+    bad_cfg.atcai2c.bus = MAX_I2C_BUSES;
+    if (hal_i2c_wake_start(&bad_cfg) != ATCA_BAD_PARAM || hal_i2c_wake_poll(&bad_cfg) != ATCA_BAD_PARAM)
+    {
+        check_fail(context, "wake on a bus out of range", "not ATCA_BAD_PARAM");
+    }
+    atcab_release();
+    if (hal_i2c_wake_start(&cfg) != ATCA_BAD_PARAM || hal_i2c_wake_poll(&cfg) != ATCA_BAD_PARAM)
+    {
+        check_fail(context, "wake on a released bus", "not ATCA_BAD_PARAM");
+    }
+    else
+    {
+        printf("%-30s ok   ATCA_BAD_PARAM\n", "wake on a bad or released bus");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    check_context context = { .runs = 20, .failures = 0 };
+    int option;
+    uint8_t i;
+
+    while ((option = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'n': context.runs = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default: print_usage(argv[0]); return (option == 'h') ? 0 : 1;
+        }
+    }
+    if (context.runs == 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("per authentication: serial number Read, Nonce and MAC\n\n");
+    printf("%-10s %-11s %5s | %6s %6s | %6s %8s %8s\n", "device", "mode", "runs", "wakes", "idles", "bytes",
+           "bus us", "time us");
+    for (i = 0; i < sizeof(g_devices) / sizeof(g_devices[0]); i++)
+    {
+        context.device = &g_devices[i];
+        i2c_sim_call(check_sessions, &context);
+    }
+    printf("\n");
+    for (i = 0; i < sizeof(g_devices) / sizeof(g_devices[0]); i++)
+    {
+        context.device = &g_devices[i];
+        i2c_sim_call(check_watchdog, &context);
+        i2c_sim_call(check_gap, &context);
+    }
+    i2c_sim_call(check_boot_scan, &context);
+
+    context.failures += i2c_sim_get_stats()->errors;
+    printf("\n%lu register accesses trapped, %u failed\n", (unsigned long)reg_trap_accesses(), context.failures);
+    return (context.failures == 0) ? 0 : 1;
+}